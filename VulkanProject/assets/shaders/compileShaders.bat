@@ -1,7 +1,13 @@
 C:/VulkanSDK/1.3.290.0/Bin/glslc.exe shader.vert -o vert.spv
+C:/VulkanSDK/1.3.290.0/Bin/glslc.exe -DDRAW_CONSTANTS shader.vert -o drawConstantsVert.spv
 C:/VulkanSDK/1.3.290.0/Bin/glslc.exe shader.frag -o frag.spv
+C:/VulkanSDK/1.3.290.0/Bin/glslc.exe -DBINDLESS shader.frag -o bindlessFrag.spv
 
 C:/VulkanSDK/1.3.290.0/Bin/glslc.exe secondPass.vert -o secondPassVert.spv
 C:/VulkanSDK/1.3.290.0/Bin/glslc.exe secondPass.frag -o secondPassFrag.spv
 
+C:/VulkanSDK/1.3.290.0/Bin/glslc.exe meshletCull.comp -o meshletCull.spv
+
+C:/VulkanSDK/1.3.290.0/Bin/glslc.exe shadow.vert -o shadowVert.spv
+
 pause
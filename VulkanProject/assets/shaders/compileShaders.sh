@@ -0,0 +1,16 @@
+#!/bin/sh
+# Same as compileShaders.bat for Linux and macOS (glslc of the Vulkan SDK or the PATH)
+cd "$(dirname "$0")"
+GLSLC="${VULKAN_SDK:+$VULKAN_SDK/bin/}glslc"
+
+$GLSLC shader.vert -o vert.spv
+$GLSLC -DDRAW_CONSTANTS shader.vert -o drawConstantsVert.spv
+$GLSLC shader.frag -o frag.spv
+$GLSLC -DBINDLESS shader.frag -o bindlessFrag.spv
+
+$GLSLC secondPass.vert -o secondPassVert.spv
+$GLSLC secondPass.frag -o secondPassFrag.spv
+
+$GLSLC meshletCull.comp -o meshletCull.spv
+
+$GLSLC shadow.vert -o shadowVert.spv
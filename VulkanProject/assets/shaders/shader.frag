@@ -1,5 +1,11 @@
 #version 450
 
+// BINDLESS (compiled with -DBINDLESS): the material of the draw is read from the material table and its textures from
+// the global texture array instead of the texture array of the material
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 //================================
 // INPUT
 
@@ -7,22 +13,98 @@ layout(location = 0) in vec3 fragPosition;
 layout(location = 1) in vec3 fragNormal;
 layout(location = 2) in vec2 fragTexCoord;
 
+//================================
+// SPECIALIZATION CONSTANTS (set by the pipeline variant)
+
+// Material textures (TextureType bits) in the order albedo, specular, normal and custom
+layout(constant_id = 1) const uint TEXTURE_TYPES = 1;
+layout(constant_id = 2) const uint TEXTURE_COUNT = 1;
+layout(constant_id = 3) const float SHININESS = 20.0;
+// Every light for every fragment instead of the lights of the fragment cluster (reference path)
+layout(constant_id = 4) const bool BRUTE_FORCE_LIGHTS = false;
+
+const bool HAS_ALBEDO = (TEXTURE_TYPES & 1u) != 0u;
+const bool HAS_SPECULAR = (TEXTURE_TYPES & 2u) != 0u;
+const uint SPECULAR_TEXTURE = HAS_ALBEDO ? 1u : 0u;
+
 //================================
 // UNIFORM
 
 layout(set = 0, binding = 1) uniform sampler texSampler;
-layout(set = 0, binding = 2) uniform texture2D textures[2];
 
+#ifdef BINDLESS
+// Textures are indices in the global array (-1 if the material has not that texture) and the finer levels than minLod
+// are not resident (streamed textures)
+struct Material{
+    int albedoTexture;
+    int specularTexture;
+    int normalTexture;
+    float shininess;
+    float minLod;
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer Materials {
+    Material materials[];
+} materialTable;
+
+layout(set = 1, binding = 0) uniform texture2D bindlessTextures[];
+
+// The material index follows the matrices of the vertex shader (MATERIAL_PUSH_CONSTANT_OFFSET)
+layout(push_constant) uniform Draw {
+    layout(offset = 112) uint materialIndex;
+} draw;
+#else
+layout(set = 0, binding = 2) uniform texture2D textures[TEXTURE_COUNT];
+#endif
+
+// Lights in world space: xyz position and radius in w, first shadow tile in color.w (-1 without shadows) and cosine
+// of the spot cone in direction.w (-1 for point lights)
 struct Light{
-    vec3 pos;
-    vec3 color;
-    vec3 direction;
+    vec4 positionRadius;
+    vec4 color;
+    vec4 direction;
 };
 
-#define LIGHT_COUNT 2
-layout(set = 0, binding = 3) uniform LightUBO {
-    Light lights[LIGHT_COUNT];
-} lightUBO;
+layout(std430, set = 0, binding = 3) readonly buffer Lights {
+    uint lightCount;
+    Light lights[];
+} lightBuffer;
+
+// Froxel grid: screen tiles and logarithmic depth slices (x = offset, y = count in the light index list)
+layout(std430, set = 0, binding = 4) readonly buffer Clusters {
+    uvec4 gridSize;
+    vec4 viewport; // width, height, near plane, far plane
+    mat4 inverseView;
+    uvec2 cells[];
+} clusters;
+
+layout(std430, set = 0, binding = 5) readonly buffer LightIndices {
+    uint indices[];
+} lightIndices;
+
+// Directional light with cascaded shadow maps (w of the direction is 0 if there is no directional light)
+const uint SHADOW_CASCADE_COUNT = 4;
+
+layout(set = 0, binding = 6) uniform Shadows {
+    mat4 cascadeViewProjections[SHADOW_CASCADE_COUNT];
+    vec4 cascadeSplits;
+    vec4 lightDirection;
+    vec4 lightColor;
+} shadows;
+
+layout(set = 0, binding = 7) uniform sampler2DArrayShadow shadowMap;
+
+// Shadow atlas of point (a tile per cube face: +X, -X, +Y, -Y, +Z, -Z) and spot lights
+struct ShadowTile{
+    mat4 viewProjection;
+    vec4 atlasRect; // xy offset and z size in atlas coordinates, w tangent of the half fov
+};
+
+layout(std430, set = 0, binding = 8) readonly buffer ShadowTiles {
+    ShadowTile tiles[];
+} shadowTiles;
+
+layout(set = 0, binding = 9) uniform sampler2DShadow shadowAtlas;
 
 //================================
 // OUTPUT
@@ -31,36 +113,173 @@ layout(location = 0) out vec4 outColor;
 
 
 vec3 AMBIENT_COLOR = vec3(0.15);
-float SHININESS = 20.0f;
+
+// Blinn-Phong exponent of the material
+float shininess = SHININESS;
+
+// Fraction of a point or spot light that reaches the position (3x3 PCF inside the atlas tile)
+float atlasShadowFactor(Light light, vec3 position, vec3 normal, float distance){
+    uint tileIndex = uint(light.color.w);
+    if(light.direction.w <= -1.0){
+        // cube face of the major axis
+        vec3 fromLight = position - light.positionRadius.xyz;
+        vec3 axis = abs(fromLight);
+        if(axis.x >= axis.y && axis.x >= axis.z) tileIndex += fromLight.x > 0.0 ? 0u : 1u;
+        else if(axis.y >= axis.z) tileIndex += fromLight.y > 0.0 ? 2u : 3u;
+        else tileIndex += fromLight.z > 0.0 ? 4u : 5u;
+    }
+    ShadowTile tile = shadowTiles.tiles[tileIndex];
+
+    // normal offset proportional to the texel size at the distance of the light
+    float atlasSize = float(textureSize(shadowAtlas, 0).x);
+    float texelSize = 2.0 * distance * tile.atlasRect.w / (tile.atlasRect.z * atlasSize);
+    vec4 shadowPosition = tile.viewProjection * vec4(position + normal * texelSize, 1.0);
+    vec3 coords = shadowPosition.xyz / shadowPosition.w;
+    vec2 uv = tile.atlasRect.xy + (coords.xy * 0.5 + 0.5) * tile.atlasRect.z;
+
+    // the samples must not read the neighbour tiles
+    vec2 texel = vec2(1.0 / atlasSize);
+    vec2 minUv = tile.atlasRect.xy + texel;
+    vec2 maxUv = tile.atlasRect.xy + tile.atlasRect.z - texel;
+    float lit = 0.0;
+    for(int x = -1; x <= 1; x++){
+        for(int y = -1; y <= 1; y++){
+            lit += texture(shadowAtlas, vec3(clamp(uv + vec2(x, y) * texel, minUv, maxUv), coords.z));
+        }
+    }
+    return lit / 9.0;
+}
+
+// Blinn-Phong contribution of a light with a smooth falloff to zero at its radius (and at the border of the spot cone)
+vec3 shade(Light light, vec3 position, vec3 color, float specularIntensity, vec3 normal, vec3 viewDir){
+    vec3 toLight = light.positionRadius.xyz - position;
+    float distance = length(toLight);
+    float falloff = clamp(1.0 - distance / light.positionRadius.w, 0.0, 1.0);
+    if(falloff == 0.0) return vec3(0.0);
+
+    vec3 lightDir = toLight / distance;
+
+    // spot cone
+    if(light.direction.w > -1.0){
+        float cosine = dot(-lightDir, normalize(light.direction.xyz));
+        falloff *= smoothstep(light.direction.w, mix(light.direction.w, 1.0, 0.1), cosine);
+        if(falloff == 0.0) return vec3(0.0);
+    }
+
+    // diffuse
+    float diff = max(dot(lightDir, normal), 0.0);
+    vec3 diffuse = diff * light.color.rgb;
+
+    // specular
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess) * specularIntensity;
+    vec3 specular = light.color.rgb * spec;
+
+    vec3 lighting = ((color * diffuse) + specular) * falloff * falloff;
+    if(light.color.w >= 0.0){
+        lighting *= atlasShadowFactor(light, position, normal, distance);
+    }
+    return lighting;
+}
+
+// Fraction of the directional light that reaches the position (3x3 PCF in the cascade of the view depth)
+float shadowFactor(vec3 position, vec3 normal, float viewDepth){
+    uint cascade = 0;
+    for(uint i = 0; i < SHADOW_CASCADE_COUNT - 1; i++){
+        if(viewDepth > shadows.cascadeSplits[i]) cascade = i + 1;
+    }
+
+    // normal offset proportional to the texel size of the cascade
+    mat4 viewProjection = shadows.cascadeViewProjections[cascade];
+    float inverseRadius = length(vec3(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0]));
+    float texelSize = 2.0 / (inverseRadius * float(textureSize(shadowMap, 0).x));
+    vec4 shadowPosition = viewProjection * vec4(position + normal * texelSize, 1.0);
+    vec3 coords = shadowPosition.xyz / shadowPosition.w;
+    vec2 uv = coords.xy * 0.5 + 0.5;
+
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for(int x = -1; x <= 1; x++){
+        for(int y = -1; y <= 1; y++){
+            lit += texture(shadowMap, vec4(uv + vec2(x, y) * texel, float(cascade), coords.z));
+        }
+    }
+    return lit / 9.0;
+}
+
+// Blinn-Phong contribution of the directional light
+vec3 shadeDirectional(vec3 position, vec3 color, float specularIntensity, vec3 normal, vec3 viewDir, float viewDepth){
+    vec3 lightDir = -shadows.lightDirection.xyz;
+
+    float diff = max(dot(lightDir, normal), 0.0);
+    if(diff == 0.0) return vec3(0.0);
+
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess) * specularIntensity;
+
+    vec3 lighting = (color * diff + spec) * shadows.lightColor.rgb;
+    return lighting * shadowFactor(position, normal, viewDepth);
+}
+
+#ifdef BINDLESS
+// Sample from the min LOD or a coarser level (the shared sampler cannot clamp each texture, so the derivatives are
+// scaled up to that level)
+vec4 sampleFromLod(sampler2D tex, vec2 uv, float minLod) {
+    float scale = exp2(max(minLod - textureQueryLod(tex, uv).y, 0.0));
+    return textureGrad(tex, uv, dFdx(uv) * scale, dFdy(uv) * scale);
+}
+#endif
 
 void main() {
 
-    vec3 color = texture(sampler2D(textures[0], texSampler), fragTexCoord).rgb;
-    vec3 normal = normalize(fragNormal);
-    vec3 viewDir = normalize(-fragPosition); // cameraPos - pos -> cameraPos = center of the space
+#ifdef BINDLESS
+    // the material index is the same for the whole draw
+    Material material = materialTable.materials[draw.materialIndex];
+    shininess = material.shininess;
+    vec3 color = material.albedoTexture >= 0 ?
+        sampleFromLod(sampler2D(bindlessTextures[material.albedoTexture], texSampler), fragTexCoord, material.minLod).rgb :
+        vec3(1.0);
+    float specularIntensity = material.specularTexture >= 0 ?
+        sampleFromLod(sampler2D(bindlessTextures[material.specularTexture], texSampler), fragTexCoord, material.minLod).r :
+        1.0;
+#else
+    vec3 color = HAS_ALBEDO ? texture(sampler2D(textures[0], texSampler), fragTexCoord).rgb : vec3(1.0);
+    float specularIntensity = HAS_SPECULAR ? texture(sampler2D(textures[SPECULAR_TEXTURE], texSampler), fragTexCoord).r : 1.0;
+#endif
+    // the lights are in world space (only the changed ones are written each frame)
+    mat4 inverseView = clusters.inverseView;
+    vec3 position = (inverseView * vec4(fragPosition, 1.0)).xyz;
+    vec3 normal = normalize(mat3(inverseView) * fragNormal);
+    vec3 viewDir = normalize(inverseView[3].xyz - position);
 
     // ambient
     vec3 ambient = AMBIENT_COLOR * color;
 
     vec3 result = ambient;
-    for(int i = 0; i < LIGHT_COUNT; i++){
-        Light light = lightUBO.lights[i];
-
-        vec3 lightDir = normalize(light.pos - fragPosition);
-    
-        // diffuse
-        float diff = max(dot(lightDir, normal), 0.0);
-        vec3 diffuse = diff * light.color;
 
-        // specular
-        vec3 reflectDir = reflect(-lightDir, normal);
-
-        vec3 halfwayDir = normalize(lightDir + viewDir);
+    if(shadows.lightDirection.w > 0.0){
+        result += shadeDirectional(position, color, specularIntensity, normal, viewDir, -fragPosition.z);
+    }
 
-        float spec = pow(max(dot(normal, halfwayDir), 0.0), SHININESS);
-        vec3 specular = light.color * spec;
+    if(BRUTE_FORCE_LIGHTS){
+        // reference path: every light for every fragment
+        for(uint i = 0; i < lightBuffer.lightCount; i++){
+            result += shade(lightBuffer.lights[i], position, color, specularIntensity, normal, viewDir);
+        }
+    }
+    else{
+        // only the lights assigned to the cluster of the fragment
+        uvec3 gridSize = clusters.gridSize.xyz;
+        float near = clusters.viewport.z;
+        float far = clusters.viewport.w;
+        uvec2 tile = min(uvec2(gl_FragCoord.xy / clusters.viewport.xy * vec2(gridSize.xy)), gridSize.xy - 1);
+        uint slice = uint(clamp(log(-fragPosition.z / near) / log(far / near) * float(gridSize.z), 0.0, float(gridSize.z - 1)));
+        uvec2 cell = clusters.cells[(slice * gridSize.y + tile.y) * gridSize.x + tile.x];
 
-        result += (color * diffuse) + specular;
+        for(uint i = 0; i < cell.y; i++){
+            result += shade(lightBuffer.lights[lightIndices.indices[cell.x + i]], position, color, specularIntensity, normal, viewDir);
+        }
     }
     outColor = vec4(result, 1.0);
 }
@@ -1,12 +1,32 @@
 #version 450
 
+// DRAW_CONSTANTS (compiled with -DDRAW_CONSTANTS): the view and projection are shared by every draw of the frame and
+// the model matrices are pushed before each draw instead of a uniform buffer per model
+#ifdef DRAW_CONSTANTS
+layout(binding = 0) uniform CameraBufferObject {
+    mat4 view;
+    mat4 proj;
+} camera;
+
+// Model matrix includes the dequantization, normal matrix is the inverse transpose of the world matrix
+layout(push_constant) uniform Draw {
+    mat4 model;
+    mat3 normalMatrix;
+} draw;
+#else
 layout(binding = 0) uniform UniformBufferObject {
     mat4 modelView;
     mat4 invTrans_modelView;
     mat4 proj;
 } ubo;
+#endif
+
+// Vertex layout (set by the pipeline variant)
+layout(constant_id = 0) const bool PACKED_VERTEX = false;
 
-layout(location = 0) in vec3 inPosition;
+// Float vertex: position and normal. Packed vertex: quantized position (modelView includes the dequantization) and
+// octahedral normal (the missing components of the attribute formats are filled by the input assembly)
+layout(location = 0) in vec4 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoord;
 
@@ -14,10 +34,29 @@ layout(location = 0) out vec3 fragPosition;
 layout(location = 1) out vec3 fragNormal;
 layout(location = 2) out vec2 fragTexCoord;
 
+vec3 decodeOctahedral(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0.0) {
+        normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(normal);
+}
+
 void main() {
-    vec4 positionTemp = ubo.modelView * vec4(inPosition, 1.0);
+    vec3 position = inPosition.xyz;
+    vec3 normal = PACKED_VERTEX ? decodeOctahedral(inNormal.xy) : inNormal;
+
+#ifdef DRAW_CONSTANTS
+    // the view is a rigid transform (its rotation is its own inverse transpose)
+    vec4 positionTemp = camera.view * (draw.model * vec4(position, 1.0));
+    fragNormal = mat3(camera.view) * (draw.normalMatrix * normal);
+    mat4 proj = camera.proj;
+#else
+    vec4 positionTemp = ubo.modelView * vec4(position, 1.0);
+    fragNormal = (ubo.invTrans_modelView * vec4(normal, 0.0f)).xyz;
+    mat4 proj = ubo.proj;
+#endif
     fragPosition = positionTemp.xyz;
-    fragNormal = (ubo.invTrans_modelView * vec4(inNormal, 0.0f)).xyz;
     fragTexCoord = inTexCoord;
-    gl_Position = ubo.proj * positionTemp;
+    gl_Position = proj * positionTemp;
 }
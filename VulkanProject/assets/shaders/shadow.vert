@@ -0,0 +1,13 @@
+#version 450
+
+// Cascade view projection * model (includes the dequantization of packed vertices)
+layout(push_constant) uniform PushConstants {
+    mat4 lightModelViewProjection;
+} push;
+
+// Only the position: the packed and float vertex layouts share location 0
+layout(location = 0) in vec3 inPosition;
+
+void main() {
+    gl_Position = push.lightModelViewProjection * vec4(inPosition, 1.0);
+}
@@ -0,0 +1,365 @@
+#include "asset/blockCompression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+
+	const uint32_t BLOCK_DIMENSION = 4;
+	const uint32_t BLOCK_TEXELS = BLOCK_DIMENSION * BLOCK_DIMENSION;
+
+	// Interpolation weights of the 4 bit indices of BC7 (out of 64)
+	const uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct Block {
+		float texels[BLOCK_TEXELS][4];
+	};
+
+	size_t getBlockSize(TextureCompression compression) {
+		switch (compression) {
+		case TEXTURE_COMPRESSION_BC1: return 8;
+		case TEXTURE_COMPRESSION_BC3:
+		case TEXTURE_COMPRESSION_BC5:
+		case TEXTURE_COMPRESSION_BC7: return 16;
+		default: return 0;
+		}
+	}
+
+	// Texels of the block (clamped to the image)
+	Block loadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY) {
+		Block block;
+		for (uint32_t y = 0; y < BLOCK_DIMENSION; y++) {
+			uint32_t sourceY = std::min(blockY * BLOCK_DIMENSION + y, height - 1);
+			for (uint32_t x = 0; x < BLOCK_DIMENSION; x++) {
+				uint32_t sourceX = std::min(blockX * BLOCK_DIMENSION + x, width - 1);
+				const uint8_t* texel = rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+				for (int c = 0; c < 4; c++) {
+					block.texels[y * BLOCK_DIMENSION + x][c] = texel[c];
+				}
+			}
+		}
+		return block;
+	}
+
+	// Endpoints at the extremes of the texels along their principal axis (power iteration on the covariance)
+	void findEndpoints(const Block& block, int channels, float start[4], float end[4]) {
+		float mean[4] = {};
+		for (const auto& texel : block.texels) {
+			for (int c = 0; c < channels; c++) mean[c] += texel[c] / BLOCK_TEXELS;
+		}
+
+		float covariance[4][4] = {};
+		for (const auto& texel : block.texels) {
+			for (int i = 0; i < channels; i++) {
+				for (int j = 0; j < channels; j++) {
+					covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+				}
+			}
+		}
+
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[4] = {};
+			float length = 0.0f;
+			for (int i = 0; i < channels; i++) {
+				for (int j = 0; j < channels; j++) next[i] += covariance[i][j] * axis[j];
+				length = std::max(length, std::abs(next[i]));
+			}
+			// flat block (every texel on the mean)
+			if (length < 1e-6f) break;
+			for (int i = 0; i < channels; i++) axis[i] = next[i] / length;
+		}
+
+		float minT = 0.0f, maxT = 0.0f;
+		for (const auto& texel : block.texels) {
+			float t = 0.0f;
+			for (int c = 0; c < channels; c++) t += (texel[c] - mean[c]) * axis[c];
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		float axisLength2 = 0.0f;
+		for (int c = 0; c < channels; c++) axisLength2 += axis[c] * axis[c];
+		for (int c = 0; c < channels; c++) {
+			start[c] = std::clamp(mean[c] + axis[c] * minT / axisLength2, 0.0f, 255.0f);
+			end[c] = std::clamp(mean[c] + axis[c] * maxT / axisLength2, 0.0f, 255.0f);
+		}
+	}
+
+	float distance2(const float* a, const float* b, int channels) {
+		float sum = 0.0f;
+		for (int c = 0; c < channels; c++) sum += (a[c] - b[c]) * (a[c] - b[c]);
+		return sum;
+	}
+
+	//--------------------------------------------------------
+	// BC1 (two RGB565 endpoints and 2 bit indices)
+
+	uint16_t packColor565(const float color[3]) {
+		uint16_t r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+		uint16_t g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+		uint16_t b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void unpackColor565(uint16_t packed, float color[3]) {
+		uint32_t r = (packed >> 11) & 0x1f;
+		uint32_t g = (packed >> 5) & 0x3f;
+		uint32_t b = packed & 0x1f;
+		color[0] = static_cast<float>((r << 3) | (r >> 2));
+		color[1] = static_cast<float>((g << 2) | (g >> 4));
+		color[2] = static_cast<float>((b << 3) | (b >> 2));
+	}
+
+	void compressBC1(const Block& block, uint8_t* output) {
+		float start[4], end[4];
+		findEndpoints(block, 3, start, end);
+
+		// 4 color mode (first endpoint greater)
+		uint16_t color0 = packColor565(end);
+		uint16_t color1 = packColor565(start);
+		if (color0 < color1) std::swap(color0, color1);
+
+		float palette[4][3];
+		unpackColor565(color0, palette[0]);
+		unpackColor565(color1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1) {
+			for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+				uint32_t best = 0;
+				float bestError = distance2(block.texels[i], palette[0], 3);
+				for (uint32_t p = 1; p < 4; p++) {
+					float error = distance2(block.texels[i], palette[p], 3);
+					if (error < bestError) {
+						bestError = error;
+						best = p;
+					}
+				}
+				indices |= best << (2 * i);
+			}
+		}
+
+		memcpy(output, &color0, 2);
+		memcpy(output + 2, &color1, 2);
+		memcpy(output + 4, &indices, 4);
+	}
+
+	//--------------------------------------------------------
+	// BC4 (a channel with two 8 bit endpoints and 3 bit indices)
+
+	void compressBC4(const Block& block, int channel, uint8_t* output) {
+		float minValue = 255.0f, maxValue = 0.0f;
+		for (const auto& texel : block.texels) {
+			minValue = std::min(minValue, texel[channel]);
+			maxValue = std::max(maxValue, texel[channel]);
+		}
+
+		// 8 value mode (first endpoint greater)
+		uint8_t value0 = static_cast<uint8_t>(std::lround(maxValue));
+		uint8_t value1 = static_cast<uint8_t>(std::lround(minValue));
+
+		float palette[8];
+		palette[0] = value0;
+		palette[1] = value1;
+		for (int i = 2; i < 8; i++) {
+			palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1]) / 7.0f;
+		}
+
+		uint64_t indices = 0;
+		if (value0 != value1) {
+			for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+				uint64_t best = 0;
+				float bestError = std::abs(block.texels[i][channel] - palette[0]);
+				for (uint64_t p = 1; p < 8; p++) {
+					float error = std::abs(block.texels[i][channel] - palette[p]);
+					if (error < bestError) {
+						bestError = error;
+						best = p;
+					}
+				}
+				indices |= best << (3 * i);
+			}
+		}
+
+		output[0] = value0;
+		output[1] = value1;
+		for (int i = 0; i < 6; i++) {
+			output[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+		}
+	}
+
+	//--------------------------------------------------------
+	// BC7 (mode 6: a subset with 7 bit RGBA endpoints, a p-bit each and 4 bit indices)
+
+	// Fields of the block from the least significant bit
+	class BitWriter {
+	public:
+		explicit BitWriter(uint8_t* output) : output(output) {
+			memset(output, 0, 16);
+		}
+
+		void write(uint32_t value, uint32_t bits) {
+			for (uint32_t i = 0; i < bits; i++, position++) {
+				if (value & (1u << i)) output[position / 8] |= static_cast<uint8_t>(1u << (position % 8));
+			}
+		}
+
+	private:
+		uint8_t* output;
+		uint32_t position = 0;
+	};
+
+	// Endpoint with the p-bit that quantizes it best (each channel is 7 bits and the shared p-bit)
+	void quantizeEndpointBC7(const float endpoint[4], uint32_t quantized[4], uint32_t& pBit) {
+		float bestError = -1.0f;
+		for (uint32_t p = 0; p < 2; p++) {
+			uint32_t values[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++) {
+				values[c] = static_cast<uint32_t>(std::clamp(std::lround((endpoint[c] - p) / 2.0f), 0L, 127L));
+				float expanded = static_cast<float>((values[c] << 1) | p);
+				error += (expanded - endpoint[c]) * (expanded - endpoint[c]);
+			}
+			if (bestError < 0.0f || error < bestError) {
+				bestError = error;
+				pBit = p;
+				std::copy(values, values + 4, quantized);
+			}
+		}
+	}
+
+	void compressBC7(const Block& block, uint8_t* output) {
+		float start[4], end[4];
+		findEndpoints(block, 4, start, end);
+
+		uint32_t endpoints[2][4];
+		uint32_t pBits[2];
+		quantizeEndpointBC7(start, endpoints[0], pBits[0]);
+		quantizeEndpointBC7(end, endpoints[1], pBits[1]);
+
+		float expanded[2][4];
+		for (int e = 0; e < 2; e++) {
+			for (int c = 0; c < 4; c++) expanded[e][c] = static_cast<float>((endpoints[e][c] << 1) | pBits[e]);
+		}
+		float palette[16][4];
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) {
+				uint32_t e0 = static_cast<uint32_t>(expanded[0][c]), e1 = static_cast<uint32_t>(expanded[1][c]);
+				palette[i][c] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * e0 + BC7_WEIGHTS[i] * e1 + 32) >> 6);
+			}
+		}
+
+		uint32_t indices[BLOCK_TEXELS];
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+			indices[i] = 0;
+			float bestError = distance2(block.texels[i], palette[0], 4);
+			for (uint32_t p = 1; p < 16; p++) {
+				float error = distance2(block.texels[i], palette[p], 4);
+				if (error < bestError) {
+					bestError = error;
+					indices[i] = p;
+				}
+			}
+		}
+
+		// the most significant bit of the first index is implicitly 0 (swap the endpoints if it is not)
+		if (indices[0] >= 8) {
+			std::swap(endpoints[0], endpoints[1]);
+			std::swap(pBits[0], pBits[1]);
+			for (auto& index : indices) index = 15 - index;
+		}
+
+		BitWriter writer(output);
+		writer.write(1u << 6, 7);
+		for (int c = 0; c < 4; c++) {
+			writer.write(endpoints[0][c], 7);
+			writer.write(endpoints[1][c], 7);
+		}
+		writer.write(pBits[0], 1);
+		writer.write(pBits[1], 1);
+		writer.write(indices[0], 3);
+		for (uint32_t i = 1; i < BLOCK_TEXELS; i++) {
+			writer.write(indices[i], 4);
+		}
+	}
+}
+
+
+VkFormat getCompressedFormat(TextureCompression compression, bool srgb) {
+	switch (compression) {
+	case TEXTURE_COMPRESSION_NONE: return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+	case TEXTURE_COMPRESSION_BC1: return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	case TEXTURE_COMPRESSION_BC3: return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+	case TEXTURE_COMPRESSION_BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+	case TEXTURE_COMPRESSION_BC7: return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+	}
+	throw std::runtime_error("unknown texture compression");
+}
+
+bool isBlockCompressedFormat(VkFormat format) {
+	switch (format) {
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+		return true;
+	default:
+		return false;
+	}
+}
+
+size_t getCompressedSize(TextureCompression compression, uint32_t width, uint32_t height) {
+	if (compression == TEXTURE_COMPRESSION_NONE) {
+		return static_cast<size_t>(width) * height * 4;
+	}
+	size_t blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	size_t blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	return blocksX * blocksY * getBlockSize(compression);
+}
+
+std::vector<uint8_t> compressImage(const uint8_t* rgba, uint32_t width, uint32_t height, TextureCompression compression) {
+	std::vector<uint8_t> output(getCompressedSize(compression, width, height));
+	if (compression == TEXTURE_COMPRESSION_NONE) {
+		memcpy(output.data(), rgba, output.size());
+		return output;
+	}
+
+	uint32_t blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	uint32_t blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	size_t blockSize = getBlockSize(compression);
+	uint8_t* blockOutput = output.data();
+
+	for (uint32_t blockY = 0; blockY < blocksY; blockY++) {
+		for (uint32_t blockX = 0; blockX < blocksX; blockX++, blockOutput += blockSize) {
+			Block block = loadBlock(rgba, width, height, blockX, blockY);
+			switch (compression) {
+			case TEXTURE_COMPRESSION_BC1:
+				compressBC1(block, blockOutput);
+				break;
+			case TEXTURE_COMPRESSION_BC3:
+				compressBC4(block, 3, blockOutput);
+				compressBC1(block, blockOutput + 8);
+				break;
+			case TEXTURE_COMPRESSION_BC5:
+				compressBC4(block, 0, blockOutput);
+				compressBC4(block, 1, blockOutput + 8);
+				break;
+			default:
+				compressBC7(block, blockOutput);
+				break;
+			}
+		}
+	}
+	return output;
+}
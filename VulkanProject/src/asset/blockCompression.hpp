@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+
+// Block compressed formats of the baked textures (4x4 texel blocks)
+enum TextureCompression {
+	TEXTURE_COMPRESSION_NONE,	// RGBA8
+	TEXTURE_COMPRESSION_BC1,	// RGB, 8 bytes per block
+	TEXTURE_COMPRESSION_BC3,	// RGBA (BC1 color and BC4 alpha), 16 bytes per block
+	TEXTURE_COMPRESSION_BC5,	// RG (two BC4 channels, for two channel normal maps), 16 bytes per block
+	TEXTURE_COMPRESSION_BC7		// RGBA (mode 6 only), 16 bytes per block
+};
+
+
+// Vulkan format of the compressed texture (sRGB for color textures, BC5 has no sRGB format)
+VkFormat getCompressedFormat(TextureCompression compression, bool srgb);
+
+// The format is one of the BC formats of the compressed textures
+bool isBlockCompressedFormat(VkFormat format);
+
+// Size of the compressed image (rows of 4x4 blocks, the last ones padded)
+size_t getCompressedSize(TextureCompression compression, uint32_t width, uint32_t height);
+
+// Compress the RGBA8 image (the texels of the edge blocks outside the image repeat the last row and column)
+std::vector<uint8_t> compressImage(const uint8_t* rgba, uint32_t width, uint32_t height, TextureCompression compression);
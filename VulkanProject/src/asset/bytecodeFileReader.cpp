@@ -4,6 +4,17 @@
 #include <iostream>
 #include <fstream>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 std::vector<char> readFile(const std::string& filename) {
 
@@ -25,3 +36,62 @@ std::vector<char> readFile(const std::string& filename) {
 	file.close();
 	return buffer;
 }
+
+MappedFile mapFile(const std::string& filename) {
+	MappedFile mapped;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("failed to open file");
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		throw std::runtime_error("failed to map file");
+	}
+
+	// the view keeps the mapping alive after the handles are closed
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (mapping != nullptr) CloseHandle(mapping);
+	CloseHandle(file);
+	if (data == nullptr) {
+		throw std::runtime_error("failed to map file");
+	}
+	mapped.size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw std::runtime_error("failed to open file");
+	}
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+		close(file);
+		throw std::runtime_error("failed to map file");
+	}
+
+	// the mapping is kept after the descriptor is closed
+	void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED) {
+		throw std::runtime_error("failed to map file");
+	}
+	mapped.size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+	mapped.data = static_cast<const char*>(data);
+	return mapped;
+}
+
+void unmapFile(MappedFile& file) {
+	if (file.data == nullptr) return;
+#ifdef _WIN32
+	UnmapViewOfFile(file.data);
+#else
+	munmap(const_cast<char*>(file.data), file.size);
+#endif
+	file.data = nullptr;
+	file.size = 0;
+}
@@ -6,4 +6,15 @@
 #include <vector>
 
 
+// Read-only view of a whole file mapped in memory (page aligned)
+struct MappedFile {
+	const char* data = nullptr;
+	size_t size = 0;
+};
+
+
 std::vector<char> readFile(const std::string& filename);
+
+// Map the file without copying it (throw if it can not be opened or is empty)
+MappedFile mapFile(const std::string& filename);
+void unmapFile(MappedFile& file);
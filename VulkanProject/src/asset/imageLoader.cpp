@@ -1,5 +1,6 @@
 #include "ImageLoader.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
@@ -16,4 +17,27 @@ RawImage loadImageFromFile(const std::string& path) {
     std::cout << image.width << "x" << image.height << std::endl;
 
     return image;
-}
\ No newline at end of file
+}
+
+RawImage loadImageInfo(const std::string& path) {
+    RawImage image;
+
+    if (!stbi_info(path.c_str(), &image.width, &image.height, nullptr)) {
+        throw std::runtime_error("failed to read texture image info");
+    }
+    image.size = image.width * image.height * 4/*bytes per pixel*/;
+
+    return image;
+}
+
+void loadImageFromFile(const std::string& path, void* destination, size_t size) {
+    int width, height;
+    stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, nullptr, STBI_rgb_alpha);
+    if (!pixels) throw std::runtime_error("failed to load texture image");
+
+    // the file could change after its info was read
+    bool sizeMatches = static_cast<size_t>(width) * height * 4 == size;
+    if (sizeMatches) memcpy(destination, pixels, size);
+    stbi_image_free(pixels);
+    if (!sizeMatches) throw std::runtime_error("texture image size changed while loading");
+}
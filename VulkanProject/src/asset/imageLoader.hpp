@@ -17,3 +17,9 @@ struct RawImage {
 
 
 RawImage loadImageFromFile(const std::string& path);
+
+// Dimensions and RGBA size of the image file without decoding it (no pixels)
+RawImage loadImageInfo(const std::string& path);
+
+// Decode the image file as RGBA into the destination (size is the expected RGBA size, usable from any thread)
+void loadImageFromFile(const std::string& path, void* destination, size_t size);
@@ -0,0 +1,234 @@
+#include "asset/ktxFile.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+
+namespace {
+
+	const uint8_t KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+	// Header and index of the file (the level index follows)
+	struct KtxHeader {
+		uint8_t identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+	static_assert(sizeof(KtxHeader) == 80, "KTX2 header must be 80 bytes");
+
+	struct KtxLevel {
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	//--------------------------------------------------------
+	// DATA FORMAT DESCRIPTOR (Khronos basic block)
+
+	const uint32_t DFD_MODEL_RGBSDA = 1;
+	const uint32_t DFD_MODEL_BC1A = 128;
+	const uint32_t DFD_MODEL_BC3 = 130;
+	const uint32_t DFD_MODEL_BC5 = 132;
+	const uint32_t DFD_MODEL_BC7 = 134;
+
+	const uint32_t DFD_PRIMARIES_BT709 = 1;
+	const uint32_t DFD_TRANSFER_LINEAR = 1;
+	const uint32_t DFD_TRANSFER_SRGB = 2;
+
+	const uint32_t DFD_CHANNEL_RED = 0;
+	const uint32_t DFD_CHANNEL_GREEN = 1;
+	const uint32_t DFD_CHANNEL_BLUE = 2;
+	const uint32_t DFD_CHANNEL_ALPHA = 15;
+	const uint32_t DFD_QUALIFIER_LINEAR = 0x10;
+
+	struct DfdSample {
+		uint32_t bitOffset;
+		uint32_t bitLength;
+		uint32_t channel;
+	};
+
+	struct DfdFormat {
+		uint32_t model;
+		bool srgb;
+		bool compressed;
+		uint32_t blockSize;
+		std::vector<DfdSample> samples;
+	};
+
+	DfdFormat describeFormat(VkFormat format) {
+		switch (format) {
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_R8G8B8A8_UNORM:
+			return { DFD_MODEL_RGBSDA, format == VK_FORMAT_R8G8B8A8_SRGB, false, 4,
+				{ { 0, 8, DFD_CHANNEL_RED }, { 8, 8, DFD_CHANNEL_GREEN }, { 16, 8, DFD_CHANNEL_BLUE }, { 24, 8, DFD_CHANNEL_ALPHA } } };
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			return { DFD_MODEL_BC1A, format == VK_FORMAT_BC1_RGB_SRGB_BLOCK, true, 8, { { 0, 64, 0 } } };
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+			return { DFD_MODEL_BC3, format == VK_FORMAT_BC3_SRGB_BLOCK, true, 16,
+				{ { 0, 64, DFD_CHANNEL_ALPHA }, { 64, 64, 0 } } };
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			return { DFD_MODEL_BC5, false, true, 16, { { 0, 64, DFD_CHANNEL_RED }, { 64, 64, DFD_CHANNEL_GREEN } } };
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+			return { DFD_MODEL_BC7, format == VK_FORMAT_BC7_SRGB_BLOCK, true, 16, { { 0, 128, 0 } } };
+		default:
+			throw std::runtime_error("texture format is not supported by the KTX2 writer");
+		}
+	}
+
+	std::vector<uint32_t> createDataFormatDescriptor(VkFormat format) {
+		DfdFormat description = describeFormat(format);
+		uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(description.samples.size());
+
+		std::vector<uint32_t> words;
+		words.push_back(4 + blockSize);
+		words.push_back(0);		// Khronos vendor, basic descriptor type
+		words.push_back(2 | (blockSize << 16));		// version 2
+		words.push_back(description.model | (DFD_PRIMARIES_BT709 << 8) |
+			((description.srgb ? DFD_TRANSFER_SRGB : DFD_TRANSFER_LINEAR) << 16));
+		words.push_back(description.compressed ? (3 | (3 << 8)) : 0);		// 4x4 or 1x1 texel blocks
+		words.push_back(description.blockSize);
+		words.push_back(0);
+
+		for (const auto& sample : description.samples) {
+			// alpha is linear in sRGB formats
+			uint32_t qualifiers = description.srgb && sample.channel == DFD_CHANNEL_ALPHA ? DFD_QUALIFIER_LINEAR : 0;
+			words.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | ((sample.channel | qualifiers) << 24));
+			words.push_back(0);
+			words.push_back(0);
+			words.push_back(sample.bitLength >= 32 ? UINT32_MAX : (1u << sample.bitLength) - 1);
+		}
+		return words;
+	}
+
+	uint64_t alignOffset(uint64_t offset, uint64_t alignment) {
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+}
+
+
+void writeKtxFile(const std::string& path, VkFormat format, uint32_t width, uint32_t height,
+	const std::vector<std::vector<uint8_t>>& levels) {
+
+	std::vector<uint32_t> dataFormatDescriptor = createDataFormatDescriptor(format);
+	uint32_t levelCount = static_cast<uint32_t>(levels.size());
+
+	KtxHeader header{};
+	std::copy(std::begin(KTX_IDENTIFIER), std::end(KTX_IDENTIFIER), header.identifier);
+	header.vkFormat = static_cast<uint32_t>(format);
+	header.typeSize = 1;
+	header.pixelWidth = width;
+	header.pixelHeight = height;
+	header.faceCount = 1;
+	header.levelCount = levelCount;
+	header.dfdByteOffset = static_cast<uint32_t>(sizeof(KtxHeader) + sizeof(KtxLevel) * levelCount);
+	header.dfdByteLength = static_cast<uint32_t>(dataFormatDescriptor.size() * sizeof(uint32_t));
+
+	// levels are stored from the smallest one, aligned to the texel block size (and 4 bytes)
+	uint64_t levelAlignment = std::max<uint64_t>(describeFormat(format).blockSize, 4);
+	std::vector<KtxLevel> levelIndex(levelCount);
+	uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+	for (uint32_t i = levelCount; i-- > 0;) {
+		offset = alignOffset(offset, levelAlignment);
+		levelIndex[i] = { offset, levels[i].size(), levels[i].size() };
+		offset += levels[i].size();
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open KTX2 file for writing");
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(levelIndex.data()), sizeof(KtxLevel) * levelCount);
+	file.write(reinterpret_cast<const char*>(dataFormatDescriptor.data()), header.dfdByteLength);
+
+	for (uint32_t i = levelCount; i-- > 0;) {
+		file.seekp(static_cast<std::streamoff>(levelIndex[i].byteOffset));
+		file.write(reinterpret_cast<const char*>(levels[i].data()), levels[i].size());
+	}
+	if (!file) {
+		throw std::runtime_error("failed to write KTX2 file");
+	}
+}
+
+KtxInfo readKtxInfo(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open KTX2 file");
+	}
+
+	KtxHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || !std::equal(std::begin(KTX_IDENTIFIER), std::end(KTX_IDENTIFIER), header.identifier)) {
+		throw std::runtime_error("invalid KTX2 file");
+	}
+	if (header.supercompressionScheme != 0 || header.pixelDepth != 0 || header.layerCount > 1 ||
+		header.faceCount != 1 || header.levelCount == 0) {
+		throw std::runtime_error("KTX2 file is not a 2D texture without supercompression");
+	}
+
+	std::vector<KtxLevel> levelIndex(header.levelCount);
+	file.read(reinterpret_cast<char*>(levelIndex.data()), sizeof(KtxLevel) * header.levelCount);
+	if (!file) {
+		throw std::runtime_error("invalid KTX2 level index");
+	}
+
+	KtxInfo info;
+	info.format = static_cast<VkFormat>(header.vkFormat);
+	info.width = header.pixelWidth;
+	info.height = header.pixelHeight;
+	info.levelCount = header.levelCount;
+	for (const auto& level : levelIndex) {
+		info.fileOffsets.push_back(level.byteOffset);
+		info.levelSizes.push_back(level.byteLength);
+		info.dataOffsets.push_back(info.dataSize);
+		info.dataSize = static_cast<size_t>(alignOffset(info.dataSize + level.byteLength, KTX_LEVEL_ALIGNMENT));
+	}
+	return info;
+}
+
+void readKtxLevels(const std::string& path, const KtxInfo& info, void* destination, uint32_t firstLevel) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open KTX2 file");
+	}
+
+	// smallest levels first (in file order)
+	char* data = static_cast<char*>(destination) - info.dataOffsets[firstLevel];
+	for (uint32_t i = info.levelCount; i-- > firstLevel;) {
+		file.seekg(static_cast<std::streamoff>(info.fileOffsets[i]));
+		file.read(data + info.dataOffsets[i], static_cast<std::streamsize>(info.levelSizes[i]));
+	}
+	if (!file) {
+		throw std::runtime_error("failed to read KTX2 levels");
+	}
+}
+
+void readKtxLevel(const std::string& path, const KtxInfo& info, uint32_t level, void* destination) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open KTX2 file");
+	}
+
+	file.seekg(static_cast<std::streamoff>(info.fileOffsets[level]));
+	file.read(static_cast<char*>(destination), static_cast<std::streamsize>(info.levelSizes[level]));
+	if (!file) {
+		throw std::runtime_error("failed to read KTX2 level");
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Alignment of the levels read in memory (valid offsets of buffer to image copies of every supported format)
+const size_t KTX_LEVEL_ALIGNMENT = 16;
+
+// 2D texture of a KTX2 file (no supercompression)
+struct KtxInfo {
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t levelCount = 0;
+
+	// levels in the file (level 0 first)
+	std::vector<uint64_t> fileOffsets;
+	std::vector<uint64_t> levelSizes;
+
+	// levels when read in memory (aligned, level 0 first)
+	std::vector<size_t> dataOffsets;
+	size_t dataSize = 0;
+};
+
+
+// Write the mip levels (level 0 first) of a 2D texture as a KTX2 file
+void writeKtxFile(const std::string& path, VkFormat format, uint32_t width, uint32_t height,
+	const std::vector<std::vector<uint8_t>>& levels);
+
+// Read the header and level index of the KTX2 file
+KtxInfo readKtxInfo(const std::string& path);
+
+// Read the levels of the KTX2 file from the first one into the destination, at their data offsets from the offset of
+// the first level (usable from any thread)
+void readKtxLevels(const std::string& path, const KtxInfo& info, void* destination, uint32_t firstLevel = 0);
+
+// Read a level of the KTX2 file into the destination (usable from any thread)
+void readKtxLevel(const std::string& path, const KtxInfo& info, uint32_t level, void* destination);
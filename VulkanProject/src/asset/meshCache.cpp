@@ -0,0 +1,118 @@
+#include "asset/meshCache.hpp"
+
+#include <fstream>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+
+namespace {
+
+	const uint32_t MESH_CACHE_MAGIC = 0x4853454d; // "MESH"
+	// Increase when the stored data or its processing changes
+	const uint32_t MESH_CACHE_VERSION = 5;
+
+	struct MeshCacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		int64_t sourceTime;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t lodCount;
+		uint32_t subsetCount;
+		uint32_t indexType;
+		uint32_t meshletCount;
+		uint32_t meshletIndexCount;
+		BoundingSphere bounds;
+	};
+
+	std::string cachePath(const std::string& modelPath) {
+		return modelPath + ".meshcache";
+	}
+
+	int64_t sourceTime(const std::string& modelPath) {
+		std::error_code error;
+		auto time = std::filesystem::last_write_time(modelPath, error);
+		return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+	}
+
+	template<typename T>
+	bool readArray(std::ifstream& file, std::vector<T>& data, uint32_t count) {
+		data.resize(count);
+		file.read(reinterpret_cast<char*>(data.data()), sizeof(T) * count);
+		return static_cast<bool>(file);
+	}
+
+	template<typename T>
+	void writeArray(std::ofstream& file, const std::vector<T>& data) {
+		file.write(reinterpret_cast<const char*>(data.data()), sizeof(T) * data.size());
+	}
+}
+
+
+bool readMeshCache(const std::string& modelPath, ModelData& modelData) {
+	std::ifstream file(cachePath(modelPath), std::ios::binary);
+	if (!file.is_open()) return false;
+
+	MeshCacheHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION ||
+		header.sourceTime != sourceTime(modelPath) || header.lodCount == 0 || header.lodCount > MAX_LOD_COUNT)
+		return false;
+
+	ModelData cached;
+	if (!readArray(file, cached.vertices, header.vertexCount) ||
+		!readArray(file, cached.indices, header.indexCount) ||
+		!readArray(file, cached.lods, header.lodCount) ||
+		!readArray(file, cached.subsets, header.subsetCount) ||
+		!readArray(file, cached.meshlets, header.meshletCount) ||
+		!readArray(file, cached.meshletIndices, header.meshletIndexCount))
+		return false;
+	cached.indexType = static_cast<VkIndexType>(header.indexType);
+	cached.bounds = header.bounds;
+
+	modelData = std::move(cached);
+	return true;
+}
+
+void writeMeshCache(const std::string& modelPath, const ModelData& modelData) {
+	// written to a file of this thread and renamed when complete, so the loads of the same model in other threads never
+	// read or write a partial cache
+	std::string temporaryPath = cachePath(modelPath) + "." +
+		std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		std::cout << "Mesh cache: cannot write " << cachePath(modelPath) << std::endl;
+		return;
+	}
+
+	MeshCacheHeader header{};
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.sourceTime = sourceTime(modelPath);
+	header.vertexCount = static_cast<uint32_t>(modelData.vertices.size());
+	header.indexCount = static_cast<uint32_t>(modelData.indices.size());
+	header.lodCount = static_cast<uint32_t>(modelData.lods.size());
+	header.subsetCount = static_cast<uint32_t>(modelData.subsets.size());
+	header.indexType = static_cast<uint32_t>(modelData.indexType);
+	header.meshletCount = static_cast<uint32_t>(modelData.meshlets.size());
+	header.meshletIndexCount = static_cast<uint32_t>(modelData.meshletIndices.size());
+	header.bounds = modelData.bounds;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	writeArray(file, modelData.vertices);
+	writeArray(file, modelData.indices);
+	writeArray(file, modelData.lods);
+	writeArray(file, modelData.subsets);
+	writeArray(file, modelData.meshlets);
+	writeArray(file, modelData.meshletIndices);
+	file.close();
+
+	std::error_code error;
+	if (file) std::filesystem::rename(temporaryPath, cachePath(modelPath), error);
+	if (!file || error) {
+		std::cout << "Mesh cache: cannot write " << cachePath(modelPath) << std::endl;
+		std::filesystem::remove(temporaryPath, error);
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+#include "asset/modelLoader.hpp"
+
+
+// Read the processed mesh data stored next to the model file. Return false if there is no valid cache
+// (missing, older than the model file or written with another format version)
+bool readMeshCache(const std::string& modelPath, ModelData& modelData);
+
+// Store the processed mesh data next to the model file to skip the processing in future loads
+void writeMeshCache(const std::string& modelPath, const ModelData& modelData);
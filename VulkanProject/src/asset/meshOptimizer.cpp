@@ -0,0 +1,325 @@
+#include "asset/meshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+	//--------------------------------------------------------
+	// VERTEX SCORE PARAMETERS (values proposed by Tom Forsyth)
+	const uint32_t FORSYTH_CACHE_SIZE = 32;
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	const uint32_t NO_TRIANGLE = UINT32_MAX;
+
+
+	// Score of a vertex given its position in the cache (-1 if it is not cached) and the triangles that still use it
+	float vertexScore(int cachePosition, uint32_t remainingTriangles) {
+		if (remainingTriangles == 0) return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			// the vertices of the last triangle get a fixed score to avoid favouring strips
+			if (cachePosition < 3) {
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else {
+				float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+
+		// boost the vertices with few triangles left to avoid leaving isolated triangles behind
+		score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	// Number of vertices transformed with a FIFO post-transform cache
+	size_t countTransformedVertices(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+		// a vertex is cached if it was transformed less than cacheSize transformations ago
+		std::vector<size_t> transformedAt(vertexCount, 0);
+		size_t timestamp = cacheSize + 1;
+		size_t transformed = 0;
+
+		for (uint32_t index : indices) {
+			if (timestamp - transformedAt[index] > cacheSize) {
+				transformedAt[index] = timestamp++;
+				transformed++;
+			}
+		}
+		return transformed;
+	}
+
+	// Consecutive triangles of the index list drawn as a unit by the overdraw optimization
+	struct TriangleCluster {
+		size_t firstIndex;
+		size_t indexCount;
+		float sortKey;
+	};
+}
+
+
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount) {
+	size_t triangleCount = indices.size() / 3;
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	if (triangleCount == 0) return result;
+
+	//--------------------------------------------------------
+	// TRIANGLES OF EACH VERTEX
+
+	std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+	for (uint32_t index : indices) remainingTriangles[index]++;
+
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + remainingTriangles[v];
+
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	//--------------------------------------------------------
+	// INITIAL SCORES
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) vertexScores[v] = vertexScore(-1, remainingTriangles[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	uint32_t bestTriangle = 0;
+	for (size_t t = 0; t < triangleCount; t++) {
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if (triangleScores[t] > triangleScores[bestTriangle]) bestTriangle = static_cast<uint32_t>(t);
+	}
+
+	//--------------------------------------------------------
+	// EMIT THE TRIANGLE WITH THE BEST SCORE AND UPDATE THE CACHE
+
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::vector<uint32_t> cache, newCache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+	size_t nextUnemitted = 0;
+
+	while (bestTriangle != NO_TRIANGLE) {
+		const uint32_t* triangle = &indices[bestTriangle * 3];
+		result.insert(result.end(), triangle, triangle + 3);
+		emitted[bestTriangle] = 1;
+
+		// the vertices of the triangle go to the front of the cache
+		newCache.assign(triangle, triangle + 3);
+		for (uint32_t vertex : cache) {
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) newCache.push_back(vertex);
+		}
+
+		// remove the triangle from the lists of its vertices
+		for (int k = 0; k < 3; k++) {
+			uint32_t vertex = triangle[k];
+			uint32_t* begin = &adjacency[offsets[vertex]];
+			uint32_t* end = begin + remainingTriangles[vertex];
+			std::swap(*std::find(begin, end, bestTriangle), *(end - 1));
+			remainingTriangles[vertex]--;
+		}
+
+		// update the scores of the vertices in the cache (and the ones that just left it)
+		for (size_t i = 0; i < newCache.size(); i++) {
+			uint32_t vertex = newCache[i];
+			cachePosition[vertex] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+
+			float score = vertexScore(cachePosition[vertex], remainingTriangles[vertex]);
+			float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			for (uint32_t k = offsets[vertex]; k < offsets[vertex] + remainingTriangles[vertex]; k++) {
+				triangleScores[adjacency[k]] += delta;
+			}
+		}
+
+		if (newCache.size() > FORSYTH_CACHE_SIZE) newCache.resize(FORSYTH_CACHE_SIZE);
+		std::swap(cache, newCache);
+
+		// next triangle: the best one using a cached vertex
+		bestTriangle = NO_TRIANGLE;
+		float bestScore = -1.0f;
+		for (uint32_t vertex : cache) {
+			for (uint32_t k = offsets[vertex]; k < offsets[vertex] + remainingTriangles[vertex]; k++) {
+				uint32_t candidate = adjacency[k];
+				if (triangleScores[candidate] > bestScore) {
+					bestScore = triangleScores[candidate];
+					bestTriangle = candidate;
+				}
+			}
+		}
+
+		// dead end: continue with any triangle left
+		if (bestTriangle == NO_TRIANGLE) {
+			while (nextUnemitted < triangleCount && emitted[nextUnemitted]) nextUnemitted++;
+			if (nextUnemitted < triangleCount) bestTriangle = static_cast<uint32_t>(nextUnemitted);
+		}
+	}
+
+	return result;
+}
+
+std::vector<uint32_t> optimizeOverdraw(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+	float threshold) {
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return indices;
+
+	//--------------------------------------------------------
+	// CLUSTERS
+	// A new cluster starts where the cache order restarts (the three vertices of a triangle miss the cache), so
+	// sorting the clusters barely changes the cache efficiency
+
+	std::vector<TriangleCluster> clusters;
+	{
+		std::vector<size_t> transformedAt(vertices.size(), 0);
+		size_t timestamp = VERTEX_CACHE_SIZE + 1;
+		size_t clusterStart = 0;
+
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			int misses = 0;
+			for (int k = 0; k < 3; k++) {
+				uint32_t index = indices[i + k];
+				if (timestamp - transformedAt[index] > VERTEX_CACHE_SIZE) {
+					transformedAt[index] = timestamp++;
+					misses++;
+				}
+			}
+			if (misses == 3 && i > clusterStart) {
+				clusters.push_back({ clusterStart, i - clusterStart, 0.0f });
+				clusterStart = i;
+			}
+		}
+		clusters.push_back({ clusterStart, indices.size() - clusterStart, 0.0f });
+	}
+	if (clusters.size() == 1) return indices;
+
+	//--------------------------------------------------------
+	// SORT KEY: how much the cluster faces outwards from the mesh center
+
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		glm::vec3 a = vertices[indices[i]].pos, b = vertices[indices[i + 1]].pos, c = vertices[indices[i + 2]].pos;
+		float area = glm::length(glm::cross(b - a, c - a));
+		meshCenter += (a + b + c) * (area / 3.0f);
+		meshArea += area;
+	}
+	if (meshArea > 0.0f) meshCenter /= meshArea;
+
+	for (TriangleCluster& cluster : clusters) {
+		glm::vec3 center(0.0f);
+		glm::vec3 normal(0.0f);
+		float clusterArea = 0.0f;
+		for (size_t i = cluster.firstIndex; i < cluster.firstIndex + cluster.indexCount; i += 3) {
+			glm::vec3 a = vertices[indices[i]].pos, b = vertices[indices[i + 1]].pos, c = vertices[indices[i + 2]].pos;
+			glm::vec3 areaNormal = glm::cross(b - a, c - a);
+			float area = glm::length(areaNormal);
+			center += (a + b + c) * (area / 3.0f);
+			normal += areaNormal;
+			clusterArea += area;
+		}
+
+		float normalLength = glm::length(normal);
+		if (clusterArea > 0.0f && normalLength > 0.0f) {
+			center /= clusterArea;
+			cluster.sortKey = glm::dot(center - meshCenter, normal / normalLength);
+		}
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(),
+		[](const TriangleCluster& a, const TriangleCluster& b) { return a.sortKey > b.sortKey; });
+
+	//--------------------------------------------------------
+	// RESULT (only if the cache efficiency is still acceptable)
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (const TriangleCluster& cluster : clusters) {
+		result.insert(result.end(), indices.begin() + cluster.firstIndex,
+			indices.begin() + cluster.firstIndex + cluster.indexCount);
+	}
+
+	if (computeAcmr(result, vertices.size()) > computeAcmr(indices, vertices.size()) * threshold) return indices;
+	return result;
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (uint32_t& index : indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = static_cast<uint32_t>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices = std::move(reordered);
+}
+
+float computeAcmr(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	if (indices.size() < 3) return 0.0f;
+	return static_cast<float>(countTransformedVertices(indices, vertexCount, cacheSize)) / (indices.size() / 3);
+}
+
+float computeAtvr(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	std::vector<uint8_t> used(vertexCount, 0);
+	size_t usedCount = 0;
+	for (uint32_t index : indices) {
+		if (!used[index]) {
+			used[index] = 1;
+			usedCount++;
+		}
+	}
+	if (usedCount == 0) return 0.0f;
+	return static_cast<float>(countTransformedVertices(indices, vertexCount, cacheSize)) / usedCount;
+}
+
+bool splitByVertexWindow(const std::vector<uint32_t>& indices, uint32_t firstIndex, uint32_t indexCount,
+	uint32_t windowSize, std::vector<MeshSubset>& subsets) {
+
+	if (indexCount == 0) return true;
+
+	MeshSubset subset;
+	subset.firstIndex = firstIndex;
+	uint32_t minVertex = UINT32_MAX;
+	uint32_t maxVertex = 0;
+
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i += 3) {
+		uint32_t triangleMin = std::min(indices[i], std::min(indices[i + 1], indices[i + 2]));
+		uint32_t triangleMax = std::max(indices[i], std::max(indices[i + 1], indices[i + 2]));
+		if (triangleMax - triangleMin >= windowSize) return false;
+
+		// start a new subset when the window would grow too much
+		uint32_t newMin = std::min(minVertex, triangleMin);
+		uint32_t newMax = std::max(maxVertex, triangleMax);
+		if (subset.indexCount > 0 && newMax - newMin >= windowSize) {
+			subset.vertexOffset = static_cast<int32_t>(minVertex);
+			subsets.push_back(subset);
+
+			subset.firstIndex = i;
+			subset.indexCount = 0;
+			newMin = triangleMin;
+			newMax = triangleMax;
+		}
+
+		minVertex = newMin;
+		maxVertex = newMax;
+		subset.indexCount += 3;
+	}
+
+	subset.vertexOffset = static_cast<int32_t>(minVertex);
+	subsets.push_back(subset);
+	return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "render/vertex/Vertex.hpp"
+#include "render/vertex/Mesh.hpp"
+
+
+// Size of the post-transform vertex cache simulated to measure the index order
+const uint32_t VERTEX_CACHE_SIZE = 16;
+
+
+// Reorder the triangles to reuse the vertices still in the post-transform cache (Forsyth's algorithm)
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount);
+
+// Reorder clusters of a cache optimized index list so the outer surfaces are drawn first and hide the ones behind
+// them. The cache order is kept if the result is worse than threshold times its ACMR
+std::vector<uint32_t> optimizeOverdraw(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+	float threshold);
+
+// Reorder the vertices in the order they are first used by the indices (unused vertices are removed)
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// Average cache miss ratio: transformed vertices per triangle (between 0.5 and 3, lower is better)
+float computeAcmr(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// Average transform to vertex ratio: transformed vertices per used vertex (1 is optimal)
+float computeAtvr(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// Split a range of a triangle list in consecutive subsets whose vertices fit in windows of windowSize vertices (the
+// vertex offset of each subset is the first vertex of its window). Return false if a triangle does not fit in a window
+bool splitByVertexWindow(const std::vector<uint32_t>& indices, uint32_t firstIndex, uint32_t indexCount,
+	uint32_t windowSize, std::vector<MeshSubset>& subsets);
@@ -0,0 +1,328 @@
+#include "asset/meshSimplifier.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <cmath>
+
+
+namespace {
+
+	// Weight of the planes that keep the borders of open meshes in place
+	const double BORDER_WEIGHT = 10.0;
+	// Minimum cosine between a triangle normal before and after a collapse (avoid flipped triangles)
+	const float MIN_NORMAL_COSINE = 0.25f;
+
+	const uint8_t VERTEX_MANIFOLD = 0;
+	const uint8_t VERTEX_BORDER = 1;
+	const uint8_t VERTEX_NON_MANIFOLD = 2;
+
+	// Symmetric 4x4 matrix that accumulates the squared distances to a set of planes
+	// (only the upper triangle is stored)
+	struct Quadric {
+		double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+		double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+		double a22 = 0.0, a23 = 0.0;
+		double a33 = 0.0;
+		double weight = 0.0;
+
+		void addPlane(glm::vec3 normal, float distance, double planeWeight) {
+			double a = normal.x, b = normal.y, c = normal.z, d = distance;
+			a00 += planeWeight * a * a; a01 += planeWeight * a * b; a02 += planeWeight * a * c; a03 += planeWeight * a * d;
+			a11 += planeWeight * b * b; a12 += planeWeight * b * c; a13 += planeWeight * b * d;
+			a22 += planeWeight * c * c; a23 += planeWeight * c * d;
+			a33 += planeWeight * d * d;
+			weight += planeWeight;
+		}
+
+		void add(const Quadric& other) {
+			a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+			a11 += other.a11; a12 += other.a12; a13 += other.a13;
+			a22 += other.a22; a23 += other.a23;
+			a33 += other.a33;
+			weight += other.weight;
+		}
+
+		// Weighted mean of the squared distances from the point to the planes
+		double evaluate(glm::vec3 point) const {
+			double x = point.x, y = point.y, z = point.z;
+			double result =
+				a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+				a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y +
+				a22 * z * z + 2.0 * a23 * z +
+				a33;
+			return weight > 0.0 ? std::fabs(result) / weight : 0.0;
+		}
+	};
+
+	// Collapse of the position 'from' into the position 'to'
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	uint64_t edgeKey(uint32_t a, uint32_t b) {
+		if (a > b) std::swap(a, b);
+		return (static_cast<uint64_t>(a) << 32) | b;
+	}
+
+	glm::vec3 triangleNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+		return glm::cross(b - a, c - a);
+	}
+}
+
+
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+	size_t targetIndexCount, float maxError, float& resultError) {
+
+	std::vector<uint32_t> result = indices;
+	resultError = 0.0f;
+
+	uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+	if (result.size() <= targetIndexCount || vertexCount == 0) return result;
+
+	//--------------------------------------------------------
+	// POSITION REMAP
+	// Vertices split by their normal or texture coordinates (seams) share the position: the collapses
+	// are done by position and all the vertices of a position (wedges) are moved together
+
+	std::vector<uint32_t> positionRemap(vertexCount);
+	std::vector<uint32_t> nextWedge(vertexCount); // cyclic list of the vertices with the same position
+	{
+		std::unordered_map<glm::vec3, uint32_t> firstVertex;
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			uint32_t first = firstVertex.emplace(vertices[v].pos, v).first->second;
+			positionRemap[v] = first;
+			if (first == v) {
+				nextWedge[v] = v;
+			}
+			else {
+				nextWedge[v] = nextWedge[first];
+				nextWedge[first] = v;
+			}
+		}
+	}
+
+	auto position = [&](uint32_t index) { return vertices[positionRemap[index]].pos; };
+
+	//--------------------------------------------------------
+	// QUADRICS (triangle planes weighted by area and planes perpendicular to the borders)
+
+	std::vector<Quadric> quadrics(vertexCount);
+	std::unordered_map<uint64_t, uint32_t> positionEdges;
+
+	for (size_t i = 0; i < result.size(); i += 3) {
+		for (int k = 0; k < 3; k++) {
+			positionEdges[edgeKey(positionRemap[result[i + k]], positionRemap[result[i + (k + 1) % 3]])]++;
+		}
+	}
+
+	for (size_t i = 0; i < result.size(); i += 3) {
+		glm::vec3 p[3] = { position(result[i]), position(result[i + 1]), position(result[i + 2]) };
+		glm::vec3 normal = triangleNormal(p[0], p[1], p[2]);
+		float doubleArea = glm::length(normal);
+		if (doubleArea == 0.0f) continue;
+		normal /= doubleArea;
+
+		for (int k = 0; k < 3; k++) {
+			uint32_t a = positionRemap[result[i + k]];
+			uint32_t b = positionRemap[result[i + (k + 1) % 3]];
+			quadrics[a].addPlane(normal, -glm::dot(normal, p[k]), doubleArea * 0.5);
+
+			// border edge: plane that contains the edge and is perpendicular to the triangle
+			if (positionEdges[edgeKey(a, b)] == 1) {
+				glm::vec3 edge = p[(k + 1) % 3] - p[k];
+				float edgeLength = glm::length(edge);
+				if (edgeLength == 0.0f) continue;
+				glm::vec3 borderNormal = glm::normalize(glm::cross(edge, normal));
+				double borderWeight = BORDER_WEIGHT * edgeLength * edgeLength;
+				quadrics[a].addPlane(borderNormal, -glm::dot(borderNormal, p[k]), borderWeight);
+				quadrics[b].addPlane(borderNormal, -glm::dot(borderNormal, p[k]), borderWeight);
+			}
+		}
+	}
+
+	//--------------------------------------------------------
+	// COLLAPSE PASSES
+	// Each pass sorts all the candidate collapses by cost and applies the cheapest ones that do not touch
+	// the neighbourhood of a previous collapse of the same pass
+
+	size_t triangleCount = result.size() / 3;
+	size_t targetTriangleCount = targetIndexCount / 3;
+	double maxCost = static_cast<double>(maxError) * maxError;
+	double appliedCost = 0.0;
+
+	std::vector<uint32_t> collapseTarget(vertexCount);
+	std::vector<uint8_t> locked(vertexCount);
+	std::vector<uint8_t> used(vertexCount);
+	std::vector<uint8_t> vertexKind(vertexCount);
+
+	while (triangleCount > targetTriangleCount) {
+
+		//----------------------------
+		// TRIANGLES AROUND EACH POSITION
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (uint32_t index : result) offsets[positionRemap[index] + 1]++;
+		for (uint32_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+
+		std::vector<uint32_t> adjacency(result.size());
+		{
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < result.size(); i++) {
+				adjacency[fill[positionRemap[result[i]]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		//----------------------------
+		// EDGES AND VERTEX CLASSIFICATION
+		std::unordered_set<uint64_t> vertexEdges;
+		positionEdges.clear();
+		std::fill(used.begin(), used.end(), 0);
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (int k = 0; k < 3; k++) {
+				uint32_t a = result[i + k];
+				uint32_t b = result[i + (k + 1) % 3];
+				vertexEdges.insert(edgeKey(a, b));
+				positionEdges[edgeKey(positionRemap[a], positionRemap[b])]++;
+				used[a] = 1;
+			}
+		}
+
+		std::fill(vertexKind.begin(), vertexKind.end(), VERTEX_MANIFOLD);
+		for (const auto& [key, count] : positionEdges) {
+			uint32_t a = static_cast<uint32_t>(key >> 32);
+			uint32_t b = static_cast<uint32_t>(key & 0xffffffff);
+			uint8_t kind = count == 1 ? VERTEX_BORDER : (count > 2 ? VERTEX_NON_MANIFOLD : VERTEX_MANIFOLD);
+			vertexKind[a] = std::max(vertexKind[a], kind);
+			vertexKind[b] = std::max(vertexKind[b], kind);
+		}
+
+		//----------------------------
+		// CANDIDATES SORTED BY COST
+		std::vector<Collapse> collapses;
+		collapses.reserve(result.size() * 2);
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (int k = 0; k < 3; k++) {
+				uint32_t a = positionRemap[result[i + k]];
+				uint32_t b = positionRemap[result[i + (k + 1) % 3]];
+
+				Quadric merged = quadrics[a];
+				merged.add(quadrics[b]);
+				collapses.push_back({ a, b, merged.evaluate(vertices[b].pos) });
+				collapses.push_back({ b, a, merged.evaluate(vertices[a].pos) });
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(),
+			[](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+		//----------------------------
+		// APPLY THE VALID COLLAPSES
+		for (uint32_t v = 0; v < vertexCount; v++) collapseTarget[v] = v;
+		std::fill(locked.begin(), locked.end(), 0);
+		size_t collapseCount = 0;
+		std::vector<std::pair<uint32_t, uint32_t>> wedgePartners;
+
+		for (const Collapse& collapse : collapses) {
+			if (triangleCount <= targetTriangleCount || collapse.cost > maxCost) break;
+			if (locked[collapse.from] || locked[collapse.to]) continue;
+
+			// topology: borders can only slide along themselves
+			if (vertexKind[collapse.from] == VERTEX_NON_MANIFOLD || vertexKind[collapse.to] == VERTEX_NON_MANIFOLD) continue;
+			if (vertexKind[collapse.from] == VERTEX_BORDER &&
+				positionEdges[edgeKey(collapse.from, collapse.to)] != 1) continue;
+
+			// seams: every used wedge of the position must have an edge with a wedge of the target position
+			wedgePartners.clear();
+			bool seamPreserved = true;
+			uint32_t wedge = collapse.from;
+			do {
+				if (used[wedge]) {
+					uint32_t partner = wedge;
+					uint32_t candidate = collapse.to;
+					do {
+						if (used[candidate] && vertexEdges.count(edgeKey(wedge, candidate))) {
+							partner = candidate;
+							break;
+						}
+						candidate = nextWedge[candidate];
+					} while (candidate != collapse.to);
+
+					if (partner == wedge) {
+						seamPreserved = false;
+						break;
+					}
+					wedgePartners.push_back({ wedge, partner });
+				}
+				wedge = nextWedge[wedge];
+			} while (wedge != collapse.from);
+			if (!seamPreserved) continue;
+
+			// geometry: the triangles that remain must not flip
+			glm::vec3 targetPosition = vertices[collapse.to].pos;
+			bool flipped = false;
+			size_t removedTriangles = 0;
+			for (uint32_t k = offsets[collapse.from]; k < offsets[collapse.from + 1]; k++) {
+				uint32_t triangle = adjacency[k];
+				uint32_t corners[3] = {
+					positionRemap[result[triangle * 3]],
+					positionRemap[result[triangle * 3 + 1]],
+					positionRemap[result[triangle * 3 + 2]] };
+				if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to) {
+					removedTriangles++;
+					continue;
+				}
+
+				glm::vec3 before[3], after[3];
+				for (int c = 0; c < 3; c++) {
+					before[c] = vertices[corners[c]].pos;
+					after[c] = corners[c] == collapse.from ? targetPosition : before[c];
+				}
+				glm::vec3 normalBefore = triangleNormal(before[0], before[1], before[2]);
+				glm::vec3 normalAfter = triangleNormal(after[0], after[1], after[2]);
+				float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+				if (glm::dot(normalBefore, normalAfter) <= MIN_NORMAL_COSINE * lengths) {
+					flipped = true;
+					break;
+				}
+			}
+			if (flipped) continue;
+
+			// apply and lock the neighbourhood until the next pass
+			for (const auto& [from, to] : wedgePartners) collapseTarget[from] = to;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+
+			for (uint32_t k = offsets[collapse.from]; k < offsets[collapse.from + 1]; k++) {
+				uint32_t triangle = adjacency[k];
+				for (int c = 0; c < 3; c++) locked[positionRemap[result[triangle * 3 + c]]] = 1;
+			}
+			locked[collapse.to] = 1;
+
+			triangleCount -= std::min(removedTriangles, triangleCount);
+			appliedCost = std::max(appliedCost, collapse.cost);
+			collapseCount++;
+		}
+
+		if (collapseCount == 0) break;
+
+		//----------------------------
+		// REMAP THE INDICES AND REMOVE DEGENERATE TRIANGLES
+		size_t writeIndex = 0;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			uint32_t a = collapseTarget[result[i]];
+			uint32_t b = collapseTarget[result[i + 1]];
+			uint32_t c = collapseTarget[result[i + 2]];
+			if (positionRemap[a] == positionRemap[b] || positionRemap[b] == positionRemap[c] ||
+				positionRemap[c] == positionRemap[a]) continue;
+
+			result[writeIndex++] = a;
+			result[writeIndex++] = b;
+			result[writeIndex++] = c;
+		}
+		result.resize(writeIndex);
+		triangleCount = result.size() / 3;
+	}
+
+	resultError = static_cast<float>(std::sqrt(appliedCost));
+	return result;
+}
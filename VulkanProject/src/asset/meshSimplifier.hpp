@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "render/vertex/Vertex.hpp"
+
+
+// Simplify a triangle list collapsing edges ordered by their quadric error until the index count is at most
+// targetIndexCount, the error would exceed maxError or no more collapses are possible.
+// The vertices are not modified: the returned indices reference the same vertex list.
+// resultError receives the deviation of the simplified mesh from the original one (in model units)
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+	size_t targetIndexCount, float maxError, float& resultError);
@@ -0,0 +1,108 @@
+#include "asset/meshletBuilder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+	// Bounding sphere and normal cone of the triangles of the meshlet
+	void computeMeshletBounds(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& meshletIndices,
+		Meshlet& meshlet) {
+
+		uint32_t first = meshlet.firstIndex;
+		uint32_t last = meshlet.firstIndex + meshlet.triangleCount * 3;
+
+		//--------------------------------------------
+		// SPHERE (centered in the bounding box)
+		glm::vec3 minCorner = vertices[meshletIndices[first]].pos;
+		glm::vec3 maxCorner = minCorner;
+		for (uint32_t i = first; i < last; i++) {
+			minCorner = glm::min(minCorner, vertices[meshletIndices[i]].pos);
+			maxCorner = glm::max(maxCorner, vertices[meshletIndices[i]].pos);
+		}
+		meshlet.center = (minCorner + maxCorner) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (uint32_t i = first; i < last; i++) {
+			meshlet.radius = std::max(meshlet.radius, glm::length(vertices[meshletIndices[i]].pos - meshlet.center));
+		}
+
+		//--------------------------------------------
+		// NORMAL CONE (axis: average triangle normal, angle: the widest triangle normal)
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.triangleCount);
+		glm::vec3 axis(0.0f);
+		for (uint32_t i = first; i < last; i += 3) {
+			glm::vec3 a = vertices[meshletIndices[i]].pos;
+			glm::vec3 b = vertices[meshletIndices[i + 1]].pos;
+			glm::vec3 c = vertices[meshletIndices[i + 2]].pos;
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			float area = glm::length(normal);
+			if (area == 0.0f) continue;
+
+			normals.push_back(normal / area);
+			axis += normals.back();
+		}
+
+		meshlet.coneCutoff = 1.0f;
+		float axisLength = glm::length(axis);
+		if (normals.empty() || axisLength == 0.0f) return;
+		meshlet.coneAxis = axis / axisLength;
+
+		float minCosine = 1.0f;
+		for (const glm::vec3& normal : normals) {
+			minCosine = std::min(minCosine, glm::dot(normal, meshlet.coneAxis));
+		}
+
+		// the cone can only cull if all the normals are in the same hemisphere
+		if (minCosine > 0.0f) {
+			meshlet.coneCutoff = std::sqrt(1.0f - minCosine * minCosine);
+		}
+	}
+}
+
+
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+	std::vector<uint32_t>& meshletIndices) {
+
+	std::vector<Meshlet> meshlets;
+	meshletIndices.clear();
+	meshletIndices.reserve(indices.size());
+	if (indices.empty()) return meshlets;
+
+	// vertices of the meshlet being built
+	std::vector<uint32_t> meshletOf(vertices.size(), UINT32_MAX);
+	uint32_t vertexCount = 0;
+	Meshlet meshlet;
+
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		uint32_t newVertices = 0;
+		for (int k = 0; k < 3; k++) {
+			if (meshletOf[indices[i + k]] != meshlets.size()) newVertices++;
+		}
+
+		// close the meshlet if the triangle does not fit
+		if (vertexCount + newVertices > MESHLET_MAX_VERTICES || meshlet.triangleCount == MESHLET_MAX_TRIANGLES) {
+			computeMeshletBounds(vertices, meshletIndices, meshlet);
+			meshlets.push_back(meshlet);
+
+			meshlet = Meshlet{};
+			meshlet.firstIndex = static_cast<uint32_t>(meshletIndices.size());
+			vertexCount = 0;
+		}
+
+		for (int k = 0; k < 3; k++) {
+			uint32_t index = indices[i + k];
+			if (meshletOf[index] != meshlets.size()) {
+				meshletOf[index] = static_cast<uint32_t>(meshlets.size());
+				vertexCount++;
+			}
+			meshletIndices.push_back(index);
+		}
+		meshlet.triangleCount++;
+	}
+
+	computeMeshletBounds(vertices, meshletIndices, meshlet);
+	meshlets.push_back(meshlet);
+	return meshlets;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "render/vertex/Vertex.hpp"
+#include "render/vertex/Mesh.hpp"
+
+
+// Group consecutive triangles of the index list in meshlets of up to MESHLET_MAX_VERTICES vertices and
+// MESHLET_MAX_TRIANGLES triangles (a cache optimized order gives compact meshlets) and compute their bounding
+// spheres and normal cones. meshletIndices receives the triangles of each meshlet one after another
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+	std::vector<uint32_t>& meshletIndices);
@@ -1,82 +1,258 @@
 #include "modelLoader.hpp"
 
 #include <iostream>
+#include <chrono>
+#include <limits>
 #include <tiny_obj_loader.h>
 
+#include "asset/meshSimplifier.hpp"
+#include "asset/meshOptimizer.hpp"
+#include "asset/meshletBuilder.hpp"
+#include "asset/meshCache.hpp"
 
-ModelData loadModelFromFile(std::string& modelPath) {
 
-	ModelData modelData;
-	//--------------------------------------------------------
-	// Load obj file
+namespace {
+
+	// Fraction of the triangles of the previous level of detail kept by the next one
+	const float LOD_REDUCTION = 0.5f;
+	// Smaller levels of detail are not worth an extra draw range
+	const size_t MIN_LOD_TRIANGLES = 64;
+	// A level of detail is discarded if the simplification cannot reduce the previous one at least this much
+	const float MIN_LOD_GAIN = 0.9f;
+	// Maximum ACMR increase accepted by the overdraw optimization
+	const float OVERDRAW_CACHE_THRESHOLD = 1.05f;
+	// Splitting a level of detail in more draws than this is not worth the saved index bandwidth
+	const size_t MAX_SUBSETS_PER_LOD = 8;
+	// Meshes with fewer triangles are culled as a whole
+	const size_t MIN_MESHLET_TRIANGLES = 16384;
+
 
-	tinyobj::ObjReader reader;
-	tinyobj::ObjReaderConfig reader_config;
+	// Read the vertices and indices of an OBJ file (duplicated vertices are merged)
+	ModelData parseObjFile(std::string& modelPath) {
 
-	if (!reader.ParseFromFile(modelPath, reader_config)) {
-		if (!reader.Error().empty()) {
-			throw std::runtime_error(reader.Error());
+		ModelData modelData;
+		//--------------------------------------------------------
+		// Load obj file
+
+		tinyobj::ObjReader reader;
+		tinyobj::ObjReaderConfig reader_config;
+
+		if (!reader.ParseFromFile(modelPath, reader_config)) {
+			if (!reader.Error().empty()) {
+				throw std::runtime_error(reader.Error());
+			}
 		}
+
+		if (!reader.Warning().empty()) {
+			std::cout << "TinyObjLoader: " << reader.Warning();
+		}
+
+		auto& attrib = reader.GetAttrib();
+		auto& shapes = reader.GetShapes();
+
+		//--------------------------------------------------------
+		// Fill in the model with the loaded data
+
+		std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+
+		// SHAPES LOOP
+		for (const auto& shape : shapes) {
+			// FACES LOOP
+			for (const auto& index : shape.mesh.indices) {
+
+				Vertex vertex{};
+
+				//-------------------------
+				// POSITION
+				vertex.pos = {
+					attrib.vertices[3 * index.vertex_index + 0],
+					attrib.vertices[3 * index.vertex_index + 1],
+					attrib.vertices[3 * index.vertex_index + 2]
+				};
+
+				//-------------------------
+				// NORMAL
+				if (index.normal_index >= 0) {
+					vertex.normal = {
+						attrib.normals[3 * index.normal_index + 0],
+						attrib.normals[3 * index.normal_index + 1],
+						attrib.normals[3 * index.normal_index + 2]
+					};
+				}
+
+				//-------------------------
+				// TEXTURE COORDINATES
+				if (index.texcoord_index >= 0) {
+					// flip vertical component for correct visualization (OBJ to Vulkan conversion)
+					vertex.texCoord = {
+						attrib.texcoords[2 * index.texcoord_index + 0],
+						1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+					};
+				}
+
+				//-------------------------
+				// check if the vertex already exists and store the index
+				if (uniqueVertices.count(vertex) == 0) {
+					uniqueVertices[vertex] = static_cast<uint32_t>(modelData.vertices.size());
+					modelData.vertices.push_back(vertex);
+				}
+
+				modelData.indices.push_back(uniqueVertices[vertex]);
+			}
+		}
+
+		return modelData;
 	}
 
-	if (!reader.Warning().empty()) {
-		std::cout << "TinyObjLoader: " << reader.Warning();
+	// Sphere centered in the bounding box of the vertices
+	BoundingSphere computeBounds(const std::vector<Vertex>& vertices) {
+		BoundingSphere bounds;
+		if (vertices.empty()) return bounds;
+
+		glm::vec3 minCorner = vertices[0].pos;
+		glm::vec3 maxCorner = vertices[0].pos;
+		for (const Vertex& vertex : vertices) {
+			minCorner = glm::min(minCorner, vertex.pos);
+			maxCorner = glm::max(maxCorner, vertex.pos);
+		}
+
+		bounds.center = (minCorner + maxCorner) * 0.5f;
+		for (const Vertex& vertex : vertices) {
+			bounds.radius = std::max(bounds.radius, glm::length(vertex.pos - bounds.center));
+		}
+		return bounds;
 	}
 
-	auto& attrib = reader.GetAttrib();
-	auto& shapes = reader.GetShapes();
+	// Append the simplified versions of the full resolution mesh to the index list
+	void generateLods(ModelData& modelData) {
+		std::vector<uint32_t> fullResolution = modelData.indices;
+		modelData.lods.clear();
+		modelData.lods.push_back({ 0, static_cast<uint32_t>(fullResolution.size()), 0.0f });
 
-	//--------------------------------------------------------
-	// Fill in the model with the loaded data
+		auto start = std::chrono::high_resolution_clock::now();
+		size_t targetIndexCount = fullResolution.size();
+		for (uint32_t lod = 1; lod < MAX_LOD_COUNT; lod++) {
+			targetIndexCount = static_cast<size_t>(targetIndexCount * LOD_REDUCTION) / 3 * 3;
+			if (targetIndexCount / 3 < MIN_LOD_TRIANGLES) break;
 
-	std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+			// always simplify the full resolution mesh so the error is measured against it
+			float error = 0.0f;
+			std::vector<uint32_t> lodIndices = simplifyMesh(modelData.vertices, fullResolution, targetIndexCount,
+				std::numeric_limits<float>::max(), error);
 
-	// SHAPES LOOP
-	for (const auto& shape : shapes) {
-		// FACES LOOP
-		for (const auto& index : shape.mesh.indices) {
+			const MeshLod& previous = modelData.lods.back();
+			if (lodIndices.empty() || lodIndices.size() > previous.indexCount * MIN_LOD_GAIN) break;
 
-			Vertex vertex{};
+			MeshLod meshLod;
+			meshLod.firstIndex = static_cast<uint32_t>(modelData.indices.size());
+			meshLod.indexCount = static_cast<uint32_t>(lodIndices.size());
+			// the selection expects the error to grow with the level
+			meshLod.error = std::max(error, previous.error);
+			modelData.lods.push_back(meshLod);
+			modelData.indices.insert(modelData.indices.end(), lodIndices.begin(), lodIndices.end());
+		}
 
-			//-------------------------
-			// POSITION
-			vertex.pos = {
-				attrib.vertices[3 * index.vertex_index + 0],
-				attrib.vertices[3 * index.vertex_index + 1],
-				attrib.vertices[3 * index.vertex_index + 2]
-			};
+		auto end = std::chrono::high_resolution_clock::now();
+		modelData.stats.lodTime = std::chrono::duration<float, std::milli>(end - start).count();
+	}
 
-			//-------------------------
-			// NORMAL
-			if (index.normal_index >= 0) {
-				vertex.normal = {
-					attrib.normals[3 * index.normal_index + 0],
-					attrib.normals[3 * index.normal_index + 1],
-					attrib.normals[3 * index.normal_index + 2]
-				};
+	// Use 16 bit indices if the vertices fit or if the levels of detail can be split in a few subsets with vertex
+	// windows that fit. The indices are made relative to their subsets
+	void chooseIndexType(ModelData& modelData) {
+		std::vector<MeshSubset> subsets;
+		std::vector<MeshLod> lods = modelData.lods;
+		bool shortIndices = true;
+
+		for (MeshLod& lod : lods) {
+			lod.firstSubset = static_cast<uint32_t>(subsets.size());
+			if (modelData.vertices.size() <= SHORT_INDEX_VERTEX_LIMIT) {
+				subsets.push_back({ lod.firstIndex, lod.indexCount, 0 });
+			}
+			else if (!splitByVertexWindow(modelData.indices, lod.firstIndex, lod.indexCount, SHORT_INDEX_VERTEX_LIMIT, subsets) ||
+				subsets.size() - lod.firstSubset > MAX_SUBSETS_PER_LOD) {
+				shortIndices = false;
+				break;
 			}
+			lod.subsetCount = static_cast<uint32_t>(subsets.size()) - lod.firstSubset;
+		}
 
-			//-------------------------
-			// TEXTURE COORDINATES
-			if (index.texcoord_index >= 0) {
-				// flip vertical component for correct visualization (OBJ to Vulkan conversion)
-				vertex.texCoord = {
-					attrib.texcoords[2 * index.texcoord_index + 0],
-					1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-				};
+		// 32 bit indices: a single subset per level of detail
+		if (!shortIndices) {
+			subsets.clear();
+			lods = modelData.lods;
+			for (MeshLod& lod : lods) {
+				lod.firstSubset = static_cast<uint32_t>(subsets.size());
+				lod.subsetCount = 1;
+				subsets.push_back({ lod.firstIndex, lod.indexCount, 0 });
 			}
+		}
 
-			//-------------------------
-			// check if the vertex already exists and store the index
-			if (uniqueVertices.count(vertex) == 0) {
-				uniqueVertices[vertex] = static_cast<uint32_t>(modelData.vertices.size());
-				modelData.vertices.push_back(vertex);
+		for (const MeshSubset& subset : subsets) {
+			for (uint32_t i = subset.firstIndex; i < subset.firstIndex + subset.indexCount; i++) {
+				modelData.indices[i] -= static_cast<uint32_t>(subset.vertexOffset);
 			}
+		}
+
+		modelData.lods = std::move(lods);
+		modelData.subsets = std::move(subsets);
+		modelData.indexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	}
 
-			modelData.indices.push_back(uniqueVertices[vertex]);
+	// Reorder the triangles of every level of detail for the vertex cache and overdraw and then the vertices for
+	// the vertex fetch. Finally choose the index width splitting the mesh if needed
+	void optimizeMesh(ModelData& modelData) {
+		MeshLod fullResolution = modelData.lods[0];
+		std::vector<uint32_t> originalIndices(modelData.indices.begin() + fullResolution.firstIndex,
+			modelData.indices.begin() + fullResolution.firstIndex + fullResolution.indexCount);
+		size_t vertexCount = modelData.vertices.size();
+		modelData.stats.acmrBefore = computeAcmr(originalIndices, vertexCount);
+		modelData.stats.atvrBefore = computeAtvr(originalIndices, vertexCount);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (const MeshLod& lod : modelData.lods) {
+			auto first = modelData.indices.begin() + lod.firstIndex;
+			std::vector<uint32_t> lodIndices(first, first + lod.indexCount);
+
+			lodIndices = optimizeVertexCache(lodIndices, vertexCount);
+			lodIndices = optimizeOverdraw(modelData.vertices, lodIndices, OVERDRAW_CACHE_THRESHOLD);
+			std::copy(lodIndices.begin(), lodIndices.end(), first);
+		}
+		optimizeVertexFetch(modelData.vertices, modelData.indices);
+		std::vector<uint32_t> optimizedIndices(modelData.indices.begin() + fullResolution.firstIndex,
+			modelData.indices.begin() + fullResolution.firstIndex + fullResolution.indexCount);
+		chooseIndexType(modelData);
+		auto end = std::chrono::high_resolution_clock::now();
+		modelData.stats.optimizeTime = std::chrono::duration<float, std::milli>(end - start).count();
+		modelData.stats.acmrAfter = computeAcmr(optimizedIndices, vertexCount);
+		modelData.stats.atvrAfter = computeAtvr(optimizedIndices, vertexCount);
+
+		// meshlets of dense meshes (built from the cache optimized order)
+		modelData.meshlets.clear();
+		modelData.meshletIndices.clear();
+		if (optimizedIndices.size() / 3 >= MIN_MESHLET_TRIANGLES) {
+			auto meshletStart = std::chrono::high_resolution_clock::now();
+			modelData.meshlets = buildMeshlets(modelData.vertices, optimizedIndices, modelData.meshletIndices);
+			auto meshletEnd = std::chrono::high_resolution_clock::now();
+			modelData.stats.meshletTime = std::chrono::duration<float, std::milli>(meshletEnd - meshletStart).count();
 		}
 	}
+}
+
+
+ModelData loadModelFromFile(std::string& modelPath) {
+
+	// the cached data is already processed
+	ModelData modelData;
+	if (readMeshCache(modelPath, modelData)) {
+		modelData.stats.cached = true;
+		return modelData;
+	}
+
+	modelData = parseObjFile(modelPath);
+	modelData.bounds = computeBounds(modelData.vertices);
+	generateLods(modelData);
+	optimizeMesh(modelData);
 
-	std::cout << "Model loaded: " << modelData.vertices.size() << " vertices" << std::endl;
+	writeMeshCache(modelPath, modelData);
 	return modelData;
 }
@@ -1,12 +1,24 @@
 #pragma once
 
 #include "scene/Model.hpp"
+#include "render/vertex/Mesh.hpp"
 
 
 struct ModelData {
 	std::vector<Vertex> vertices;
+	// Indices of all the levels of detail one after another (the first one is the full resolution mesh)
 	std::vector<uint32_t> indices;
+	std::vector<MeshLod> lods;
+	std::vector<MeshSubset> subsets;
+	// Width of the indices in the GPU buffer (the indices are relative to the vertex offset of their subset)
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	// Clusters of the full resolution mesh (only for dense meshes) and their indices relative to the vertex buffer
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> meshletIndices;
+	BoundingSphere bounds;
+	MeshStats stats;
 };
 
 
+// Load a model and generate its levels of detail. The result is cached next to the model file
 ModelData loadModelFromFile(std::string& modelPath);
@@ -0,0 +1,258 @@
+#include "asset/spirvReflection.hpp"
+
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace {
+
+	const uint32_t SPIRV_MAGIC = 0x07230203;
+	const size_t SPIRV_HEADER_WORDS = 5;
+
+	// Opcodes
+	const uint32_t OP_ENTRY_POINT = 15;
+	const uint32_t OP_TYPE_IMAGE = 25;
+	const uint32_t OP_TYPE_SAMPLER = 26;
+	const uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+	const uint32_t OP_TYPE_ARRAY = 28;
+	const uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+	const uint32_t OP_TYPE_STRUCT = 30;
+	const uint32_t OP_TYPE_POINTER = 32;
+	const uint32_t OP_CONSTANT = 43;
+	const uint32_t OP_SPEC_CONSTANT = 50;
+	const uint32_t OP_VARIABLE = 59;
+	const uint32_t OP_DECORATE = 71;
+
+	// Decorations
+	const uint32_t DECORATION_BLOCK = 2;
+	const uint32_t DECORATION_BUFFER_BLOCK = 3;
+	const uint32_t DECORATION_BINDING = 33;
+	const uint32_t DECORATION_DESCRIPTOR_SET = 34;
+
+	// Storage classes
+	const uint32_t STORAGE_UNIFORM_CONSTANT = 0;
+	const uint32_t STORAGE_UNIFORM = 2;
+	const uint32_t STORAGE_PUSH_CONSTANT = 9;
+	const uint32_t STORAGE_STORAGE_BUFFER = 12;
+
+	// Image dimensions
+	const uint32_t DIM_BUFFER = 5;
+	const uint32_t DIM_SUBPASS_DATA = 6;
+
+	// Result of the instructions that matter for the bindings
+	struct SpirvId {
+		uint32_t opcode = 0;
+		uint32_t operands[3] = {};	// type dependent
+		uint32_t set = 0;
+		uint32_t binding = UINT32_MAX;
+		bool block = false;
+		bool bufferBlock = false;
+		bool specConstant = false;
+	};
+
+	VkShaderStageFlags getStage(uint32_t executionModel) {
+		switch (executionModel) {
+		case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+		default: return 0;
+		}
+	}
+
+	const char* getTypeName(VkDescriptorType type) {
+		switch (type) {
+		case VK_DESCRIPTOR_TYPE_SAMPLER: return "sampler";
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: return "combined image sampler";
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE: return "sampled image";
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE: return "storage image";
+		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER: return "uniform texel buffer";
+		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER: return "storage texel buffer";
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER: return "uniform buffer";
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: return "storage buffer";
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: return "input attachment";
+		default: return "unknown";
+		}
+	}
+}
+
+
+ShaderReflection reflectSpirv(const uint32_t* code, size_t wordCount) {
+	if (wordCount < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC) {
+		throw std::runtime_error("invalid spir-v module");
+	}
+
+	//--------------------------------------------------------
+	// READ THE INSTRUCTIONS
+
+	ShaderReflection reflection;
+	std::unordered_map<uint32_t, SpirvId> ids;
+	std::vector<uint32_t> variables;
+
+	size_t offset = SPIRV_HEADER_WORDS;
+	while (offset < wordCount) {
+		uint32_t opcode = code[offset] & 0xffff;
+		uint32_t length = code[offset] >> 16;
+		if (length == 0 || offset + length > wordCount) {
+			throw std::runtime_error("invalid spir-v instruction");
+		}
+		const uint32_t* words = code + offset;
+
+		switch (opcode) {
+		case OP_ENTRY_POINT:
+			reflection.stages |= getStage(words[1]);
+			break;
+		case OP_DECORATE:
+			if (words[2] == DECORATION_DESCRIPTOR_SET) ids[words[1]].set = words[3];
+			else if (words[2] == DECORATION_BINDING) ids[words[1]].binding = words[3];
+			else if (words[2] == DECORATION_BLOCK) ids[words[1]].block = true;
+			else if (words[2] == DECORATION_BUFFER_BLOCK) ids[words[1]].bufferBlock = true;
+			break;
+		case OP_TYPE_IMAGE:
+			// dimension and sampled (1 sampled, 2 storage)
+			ids[words[1]].opcode = opcode;
+			ids[words[1]].operands[0] = words[3];
+			ids[words[1]].operands[1] = words[7];
+			break;
+		case OP_TYPE_SAMPLER:
+		case OP_TYPE_STRUCT:
+			ids[words[1]].opcode = opcode;
+			break;
+		case OP_TYPE_SAMPLED_IMAGE:
+		case OP_TYPE_RUNTIME_ARRAY:
+			// element type
+			ids[words[1]].opcode = opcode;
+			ids[words[1]].operands[0] = words[2];
+			break;
+		case OP_TYPE_ARRAY:
+			// element type and length constant
+			ids[words[1]].opcode = opcode;
+			ids[words[1]].operands[0] = words[2];
+			ids[words[1]].operands[1] = words[3];
+			break;
+		case OP_TYPE_POINTER:
+			// storage class and pointee type
+			ids[words[1]].opcode = opcode;
+			ids[words[1]].operands[0] = words[2];
+			ids[words[1]].operands[1] = words[3];
+			break;
+		case OP_CONSTANT:
+		case OP_SPEC_CONSTANT:
+			// first word of the value
+			ids[words[2]].opcode = opcode;
+			ids[words[2]].operands[0] = length > 3 ? words[3] : 0;
+			ids[words[2]].specConstant = opcode == OP_SPEC_CONSTANT;
+			break;
+		case OP_VARIABLE:
+			// pointer type and storage class
+			ids[words[2]].opcode = opcode;
+			ids[words[2]].operands[0] = words[1];
+			ids[words[2]].operands[1] = words[3];
+			variables.push_back(words[2]);
+			break;
+		}
+		offset += length;
+	}
+
+	//--------------------------------------------------------
+	// RESOURCE VARIABLES
+
+	for (uint32_t id : variables) {
+		const SpirvId& variable = ids[id];
+		uint32_t storageClass = variable.operands[1];
+		if (storageClass == STORAGE_PUSH_CONSTANT) {
+			reflection.usesPushConstants = true;
+			continue;
+		}
+		if (storageClass != STORAGE_UNIFORM_CONSTANT && storageClass != STORAGE_UNIFORM &&
+			storageClass != STORAGE_STORAGE_BUFFER) continue;
+
+		ShaderBinding binding{};
+		binding.set = variable.set;
+		binding.binding = variable.binding;
+		binding.count = 1;
+
+		// arrays of descriptors
+		const SpirvId* type = &ids[ids[variable.operands[0]].operands[1]];
+		if (type->opcode == OP_TYPE_ARRAY) {
+			const SpirvId& length = ids[type->operands[1]];
+			binding.count = length.operands[0];
+			binding.specializedCount = length.specConstant;
+			type = &ids[type->operands[0]];
+		}
+		else if (type->opcode == OP_TYPE_RUNTIME_ARRAY) {
+			binding.count = 0;
+			type = &ids[type->operands[0]];
+		}
+
+		// descriptor type
+		if (type->opcode == OP_TYPE_SAMPLER) {
+			binding.type = VK_DESCRIPTOR_TYPE_SAMPLER;
+		}
+		else if (type->opcode == OP_TYPE_SAMPLED_IMAGE) {
+			const SpirvId& image = ids[type->operands[0]];
+			binding.type = image.operands[0] == DIM_BUFFER ?
+				VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		}
+		else if (type->opcode == OP_TYPE_IMAGE) {
+			bool storage = type->operands[1] == 2;
+			if (type->operands[0] == DIM_SUBPASS_DATA) binding.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			else if (type->operands[0] == DIM_BUFFER) binding.type = storage ?
+				VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			else binding.type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+		else if (type->opcode == OP_TYPE_STRUCT) {
+			// old style storage buffers are uniform blocks decorated as buffer blocks
+			bool storageBuffer = storageClass == STORAGE_STORAGE_BUFFER || type->bufferBlock;
+			binding.type = storageBuffer ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		}
+		else {
+			continue;
+		}
+
+		if (binding.binding == UINT32_MAX) {
+			throw std::runtime_error("spir-v resource without binding decoration");
+		}
+		reflection.bindings.push_back(binding);
+	}
+
+	return reflection;
+}
+
+void validateDescriptorSetLayout(const std::vector<std::vector<VkDescriptorSetLayoutBinding>>& setLayoutBindings,
+	const std::vector<const ShaderReflection*>& shaders, const std::string& pipelineName) {
+
+	auto fail = [&pipelineName](const ShaderBinding& binding, const std::string& problem) {
+		throw std::runtime_error("descriptor set layout of the " + pipelineName + " pipeline does not match its shaders: set " +
+			std::to_string(binding.set) + " binding " + std::to_string(binding.binding) + " " + problem);
+	};
+
+	for (const ShaderReflection* shader : shaders) {
+		for (const ShaderBinding& binding : shader->bindings) {
+
+			const VkDescriptorSetLayoutBinding* layoutBinding = nullptr;
+			if (binding.set < setLayoutBindings.size()) {
+				for (const auto& candidate : setLayoutBindings[binding.set]) {
+					if (candidate.binding == binding.binding) layoutBinding = &candidate;
+				}
+			}
+			if (layoutBinding == nullptr) {
+				fail(binding, "is not in the layout");
+			}
+
+			if (layoutBinding->descriptorType != binding.type) {
+				fail(binding, std::string("is a ") + getTypeName(binding.type) + " in the shader and a " +
+					getTypeName(layoutBinding->descriptorType) + " in the layout");
+			}
+			if (!binding.specializedCount && layoutBinding->descriptorCount < binding.count) {
+				fail(binding, "has " + std::to_string(binding.count) + " descriptors in the shader and " +
+					std::to_string(layoutBinding->descriptorCount) + " in the layout");
+			}
+			if ((layoutBinding->stageFlags & shader->stages) != shader->stages) {
+				fail(binding, "is not visible to every stage that uses it");
+			}
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Descriptor declared by a shader
+struct ShaderBinding {
+	uint32_t set;
+	uint32_t binding;
+	VkDescriptorType type;
+	uint32_t count;				// 0 for runtime arrays
+	bool specializedCount;		// array sized by a specialization constant (count is its default value)
+};
+
+// Interface of a SPIR-V module read from its instructions
+struct ShaderReflection {
+	VkShaderStageFlags stages = 0;
+	std::vector<ShaderBinding> bindings;
+	bool usesPushConstants = false;
+};
+
+
+// Stages, descriptor bindings and push constant usage of a SPIR-V module (throw if it is not valid SPIR-V)
+ShaderReflection reflectSpirv(const uint32_t* code, size_t wordCount);
+
+// Check that the layout bindings of each set (indexed by set number) declare every binding of the shaders with the same
+// type, enough descriptors and their stages (throw describing the first mismatch)
+void validateDescriptorSetLayout(const std::vector<std::vector<VkDescriptorSetLayoutBinding>>& setLayoutBindings,
+	const std::vector<const ShaderReflection*>& shaders, const std::string& pipelineName);
@@ -0,0 +1,243 @@
+#include "asset/textureBaker.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+#include "asset/imageLoader.hpp"
+#include "asset/ktxFile.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define TEXTURE_BAKER_SSE
+#endif
+
+
+namespace {
+
+	// Kaiser window (alpha) and radius in texels of the source level
+	const float KAISER_ALPHA = 4.0f;
+	const int KAISER_RADIUS = 3;
+
+	// Linear values of the encoded ones in the conversion table
+	const int LINEAR_TO_SRGB_STEPS = 4096;
+
+	// Taps of the filter along an axis (the same for every texel of a 2x reduction)
+	struct FilterTaps {
+		std::vector<int> offsets;		// from twice the destination coordinate
+		std::vector<float> weights;		// normalized
+	};
+
+	// Modified Bessel function of the first kind (order 0)
+	float besselI0(float x) {
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 16; k++) {
+			term *= (x / (2.0f * k)) * (x / (2.0f * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	FilterTaps createFilterTaps(MipFilter filter) {
+		FilterTaps taps;
+		if (filter == MIP_FILTER_BOX) {
+			taps.offsets = { 0, 1 };
+			taps.weights = { 0.5f, 0.5f };
+			return taps;
+		}
+
+		// the destination texel is centered between source texels 2x and 2x + 1
+		const float pi = 3.14159265358979f;
+		float sum = 0.0f;
+		for (int offset = 1 - KAISER_RADIUS; offset <= KAISER_RADIUS; offset++) {
+			float distance = offset - 0.5f;
+			float x = distance / 2.0f;
+			float sinc = std::sin(pi * x) / (pi * x);
+			float window = distance / KAISER_RADIUS;
+			float kaiser = besselI0(KAISER_ALPHA * std::sqrt(std::max(0.0f, 1.0f - window * window))) / besselI0(KAISER_ALPHA);
+			taps.offsets.push_back(offset);
+			taps.weights.push_back(sinc * kaiser);
+			sum += sinc * kaiser;
+		}
+		for (auto& weight : taps.weights) weight /= sum;
+		return taps;
+	}
+
+	//--------------------------------------------------------
+	// COLOR SPACE CONVERSIONS
+
+	const std::array<float, 256>& getSrgbToLinearTable() {
+		static const std::array<float, 256> table = []() {
+			std::array<float, 256> values;
+			for (int i = 0; i < 256; i++) {
+				float c = i / 255.0f;
+				values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return values;
+		}();
+		return table;
+	}
+
+	const std::array<uint8_t, LINEAR_TO_SRGB_STEPS + 1>& getLinearToSrgbTable() {
+		static const std::array<uint8_t, LINEAR_TO_SRGB_STEPS + 1> table = []() {
+			std::array<uint8_t, LINEAR_TO_SRGB_STEPS + 1> values;
+			for (int i = 0; i <= LINEAR_TO_SRGB_STEPS; i++) {
+				float c = static_cast<float>(i) / LINEAR_TO_SRGB_STEPS;
+				float encoded = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+				values[i] = static_cast<uint8_t>(std::lround(std::clamp(encoded, 0.0f, 1.0f) * 255.0f));
+			}
+			return values;
+		}();
+		return table;
+	}
+
+	// RGBA8 to linear floats (alpha is always linear)
+	std::vector<float> decodeLevel(const uint8_t* rgba, size_t texelCount, bool srgb) {
+		const auto& toLinear = getSrgbToLinearTable();
+		std::vector<float> level(texelCount * 4);
+		for (size_t i = 0; i < texelCount * 4; i++) {
+			level[i] = srgb && (i % 4) != 3 ? toLinear[rgba[i]] : rgba[i] / 255.0f;
+		}
+		return level;
+	}
+
+	std::vector<uint8_t> encodeLevel(const std::vector<float>& level, bool srgb) {
+		const auto& toSrgb = getLinearToSrgbTable();
+		std::vector<uint8_t> rgba(level.size());
+		for (size_t i = 0; i < level.size(); i++) {
+			float value = std::clamp(level[i], 0.0f, 1.0f);
+			rgba[i] = srgb && (i % 4) != 3 ?
+				toSrgb[static_cast<size_t>(std::lround(value * LINEAR_TO_SRGB_STEPS))] :
+				static_cast<uint8_t>(std::lround(value * 255.0f));
+		}
+		return rgba;
+	}
+
+	//--------------------------------------------------------
+	// DOWNSAMPLING (separable, the 4 channels of a texel at once)
+
+	// Weighted sum of the texels at the offsets (in floats) of the source
+	inline void filterTexel(const float* source, const size_t* texelOffsets, const float* weights, size_t tapCount,
+		float* destination) {
+#ifdef TEXTURE_BAKER_SSE
+		__m128 sum = _mm_setzero_ps();
+		for (size_t i = 0; i < tapCount; i++) {
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source + texelOffsets[i]), _mm_set1_ps(weights[i])));
+		}
+		_mm_storeu_ps(destination, sum);
+#else
+		float sum[4] = {};
+		for (size_t i = 0; i < tapCount; i++) {
+			for (int c = 0; c < 4; c++) sum[c] += source[texelOffsets[i] + c] * weights[i];
+		}
+		memcpy(destination, sum, sizeof(sum));
+#endif
+	}
+
+	// Halve the level along an axis (the source texels out of the level are clamped)
+	void downsampleAxis(const std::vector<float>& source, std::vector<float>& destination, uint32_t width,
+		uint32_t height, bool horizontal, const FilterTaps& taps) {
+
+		uint32_t sourceLength = horizontal ? width : height;
+		uint32_t destinationLength = std::max(sourceLength / 2, 1u);
+		uint32_t lineCount = horizontal ? height : width;
+		uint32_t destinationWidth = horizontal ? destinationLength : width;
+		destination.resize(static_cast<size_t>(destinationWidth) * (horizontal ? height : destinationLength) * 4);
+
+		size_t tapCount = taps.offsets.size();
+		std::vector<size_t> texelOffsets(tapCount);
+		for (uint32_t line = 0; line < lineCount; line++) {
+			for (uint32_t i = 0; i < destinationLength; i++) {
+				for (size_t t = 0; t < tapCount; t++) {
+					int position = std::clamp(static_cast<int>(2 * i) + taps.offsets[t], 0, static_cast<int>(sourceLength) - 1);
+					size_t x = horizontal ? position : line;
+					size_t y = horizontal ? line : position;
+					texelOffsets[t] = (y * width + x) * 4;
+				}
+				size_t x = horizontal ? i : line;
+				size_t y = horizontal ? line : i;
+				filterTexel(source.data(), texelOffsets.data(), taps.weights.data(), tapCount,
+					destination.data() + (y * destinationWidth + x) * 4);
+			}
+		}
+	}
+
+	int64_t sourceTime(const std::string& path) {
+		std::error_code error;
+		auto time = std::filesystem::last_write_time(path, error);
+		return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+	}
+
+	const char* getCompressionName(TextureCompression compression) {
+		switch (compression) {
+		case TEXTURE_COMPRESSION_BC1: return "bc1";
+		case TEXTURE_COMPRESSION_BC3: return "bc3";
+		case TEXTURE_COMPRESSION_BC5: return "bc5";
+		case TEXTURE_COMPRESSION_BC7: return "bc7";
+		default: return "rgba";
+		}
+	}
+}
+
+
+std::vector<std::vector<uint8_t>> generateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height,
+	MipFilter filter, bool srgb) {
+
+	std::vector<std::vector<uint8_t>> levels;
+	levels.emplace_back(rgba, rgba + static_cast<size_t>(width) * height * 4);
+
+	FilterTaps taps = createFilterTaps(filter);
+	std::vector<float> level = decodeLevel(rgba, static_cast<size_t>(width) * height, srgb);
+	std::vector<float> halved;
+	while (width > 1 || height > 1) {
+		// an axis of a single texel is not filtered
+		if (width > 1) {
+			downsampleAxis(level, halved, width, height, true, taps);
+			level.swap(halved);
+			width /= 2;
+		}
+		if (height > 1) {
+			downsampleAxis(level, halved, width, height, false, taps);
+			level.swap(halved);
+			height /= 2;
+		}
+		levels.push_back(encodeLevel(level, srgb));
+	}
+	return levels;
+}
+
+BakedTexture bakeTexture(const uint8_t* rgba, uint32_t width, uint32_t height, const TextureBakeOptions& options) {
+	BakedTexture baked;
+	baked.format = getCompressedFormat(options.compression, options.srgb);
+	baked.width = width;
+	baked.height = height;
+
+	std::vector<std::vector<uint8_t>> mipChain = generateMipChain(rgba, width, height, options.mipFilter, options.srgb);
+	for (size_t i = 0; i < mipChain.size(); i++) {
+		uint32_t levelWidth = std::max(width >> i, 1u);
+		uint32_t levelHeight = std::max(height >> i, 1u);
+		baked.levels.push_back(compressImage(mipChain[i].data(), levelWidth, levelHeight, options.compression));
+	}
+	return baked;
+}
+
+std::string getBakedTexturePath(const std::string& imagePath, const TextureBakeOptions& options) {
+	return imagePath + "." + getCompressionName(options.compression) +
+		(options.mipFilter == MIP_FILTER_KAISER ? ".kaiser" : ".box") + (options.srgb ? "" : ".linear") + ".ktx2";
+}
+
+std::string bakeTextureFile(const std::string& imagePath, const TextureBakeOptions& options) {
+	std::string bakedPath = getBakedTexturePath(imagePath, options);
+	if (std::filesystem::exists(bakedPath) && sourceTime(bakedPath) >= sourceTime(imagePath)) return bakedPath;
+
+	RawImage info = loadImageInfo(imagePath);
+	std::vector<uint8_t> rgba(static_cast<size_t>(info.size));
+	loadImageFromFile(imagePath, rgba.data(), rgba.size());
+
+	BakedTexture baked = bakeTexture(rgba.data(), static_cast<uint32_t>(info.width), static_cast<uint32_t>(info.height),
+		options);
+	writeKtxFile(bakedPath, baked.format, baked.width, baked.height, baked.levels);
+	return bakedPath;
+}
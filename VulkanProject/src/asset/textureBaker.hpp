@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "asset/blockCompression.hpp"
+
+
+// Downsampling filter of the mip levels
+enum MipFilter {
+	MIP_FILTER_BOX,		// 2x2 average
+	MIP_FILTER_KAISER	// Kaiser windowed sinc (sharper, 6 taps per axis)
+};
+
+// How the image file is baked (the baked file of other options is another file)
+struct TextureBakeOptions {
+	TextureCompression compression = TEXTURE_COMPRESSION_BC7;
+	MipFilter mipFilter = MIP_FILTER_KAISER;
+	bool srgb = true;		// color texture (filtered in linear space)
+};
+
+// Mip levels of the texture in its final format (level 0 first)
+struct BakedTexture {
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<std::vector<uint8_t>> levels;
+};
+
+
+// Full mip chain of the RGBA8 image (level 0 is a copy of the image)
+std::vector<std::vector<uint8_t>> generateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height,
+	MipFilter filter, bool srgb);
+
+// Generate the mip chain of the RGBA8 image and compress every level
+BakedTexture bakeTexture(const uint8_t* rgba, uint32_t width, uint32_t height, const TextureBakeOptions& options);
+
+// Path of the KTX2 file baked from the image file with the options (next to the image file)
+std::string getBakedTexturePath(const std::string& imagePath, const TextureBakeOptions& options);
+
+// Bake the image file into its KTX2 file unless it is newer than the image file, and return its path (usable from any
+// thread)
+std::string bakeTextureFile(const std::string& imagePath, const TextureBakeOptions& options = {});
@@ -0,0 +1,120 @@
+#include "asset/vertexEncoder.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+	// Sign that treats 0 as positive (the octahedron folding needs a side for the axes)
+	glm::vec2 signNotZero(glm::vec2 v) {
+		return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	// Project the unit vector on the octahedron and unfold it on the [-1, 1] square
+	glm::vec2 encodeOctahedral(glm::vec3 normal) {
+		float l1Norm = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+		if (l1Norm == 0.0f) return glm::vec2(0.0f);
+
+		glm::vec2 result = glm::vec2(normal.x, normal.y) / l1Norm;
+		if (normal.z < 0.0f) {
+			result = (glm::vec2(1.0f) - glm::abs(glm::vec2(result.y, result.x))) * signNotZero(result);
+		}
+		return result;
+	}
+
+	glm::vec3 decodeOctahedral(glm::vec2 encoded) {
+		glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+		if (normal.z < 0.0f) {
+			glm::vec2 folded = (glm::vec2(1.0f) - glm::abs(glm::vec2(normal.y, normal.x))) * signNotZero(glm::vec2(normal.x, normal.y));
+			normal.x = folded.x;
+			normal.y = folded.y;
+		}
+		return glm::normalize(normal);
+	}
+}
+
+
+VertexQuantization computeVertexQuantization(const std::vector<Vertex>& vertices) {
+	VertexQuantization quantization;
+	if (vertices.empty()) return quantization;
+
+	glm::vec3 minCorner = vertices[0].pos;
+	glm::vec3 maxCorner = vertices[0].pos;
+	for (const Vertex& vertex : vertices) {
+		minCorner = glm::min(minCorner, vertex.pos);
+		maxCorner = glm::max(maxCorner, vertex.pos);
+	}
+
+	quantization.offset = minCorner;
+	quantization.scale = maxCorner - minCorner;
+	// flat meshes: avoid dividing by 0 in the encoding
+	for (int i = 0; i < 3; i++) {
+		if (quantization.scale[i] == 0.0f) quantization.scale[i] = 1.0f;
+	}
+	return quantization;
+}
+
+PackedVertex encodeVertex(const Vertex& vertex, const VertexQuantization& quantization) {
+	PackedVertex packed{};
+
+	glm::vec3 normalizedPosition = (vertex.pos - quantization.offset) / quantization.scale;
+	for (int i = 0; i < 3; i++) {
+		packed.pos[i] = glm::packUnorm1x16(normalizedPosition[i]);
+	}
+	packed.pos[3] = 0;
+
+	glm::vec2 normal = encodeOctahedral(vertex.normal);
+	packed.normal[0] = static_cast<int16_t>(glm::packSnorm1x16(normal.x));
+	packed.normal[1] = static_cast<int16_t>(glm::packSnorm1x16(normal.y));
+
+	packed.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+	packed.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+
+	return packed;
+}
+
+Vertex decodeVertex(const PackedVertex& vertex, const VertexQuantization& quantization) {
+	Vertex decoded{};
+
+	glm::vec3 normalizedPosition(
+		glm::unpackUnorm1x16(vertex.pos[0]),
+		glm::unpackUnorm1x16(vertex.pos[1]),
+		glm::unpackUnorm1x16(vertex.pos[2]));
+	decoded.pos = normalizedPosition * quantization.scale + quantization.offset;
+
+	decoded.normal = decodeOctahedral(glm::vec2(
+		glm::unpackSnorm1x16(static_cast<uint16_t>(vertex.normal[0])),
+		glm::unpackSnorm1x16(static_cast<uint16_t>(vertex.normal[1]))));
+
+	decoded.texCoord = glm::vec2(glm::unpackHalf1x16(vertex.texCoord[0]), glm::unpackHalf1x16(vertex.texCoord[1]));
+
+	return decoded;
+}
+
+std::vector<PackedVertex> packVertices(const std::vector<Vertex>& vertices, const VertexQuantization& quantization,
+	VertexPackingError& error) {
+
+	std::vector<PackedVertex> packed;
+	packed.reserve(vertices.size());
+	error = VertexPackingError{};
+
+	for (const Vertex& vertex : vertices) {
+		packed.push_back(encodeVertex(vertex, quantization));
+
+		// compare the decoded vertex (what the shader will see) with the original one
+		Vertex decoded = decodeVertex(packed.back(), quantization);
+		error.position = std::max(error.position, glm::length(decoded.pos - vertex.pos));
+		error.texCoord = std::max(error.texCoord, glm::length(decoded.texCoord - vertex.texCoord));
+
+		float normalLength = glm::length(vertex.normal);
+		if (normalLength > 0.0f) {
+			float cosine = glm::clamp(glm::dot(decoded.normal, vertex.normal / normalLength), -1.0f, 1.0f);
+			error.normalAngle = std::max(error.normalAngle, glm::degrees(std::acos(cosine)));
+		}
+	}
+
+	return packed;
+}
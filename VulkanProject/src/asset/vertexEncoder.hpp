@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+#include "render/vertex/Vertex.hpp"
+
+
+// Maximum differences between the packed vertices and the original ones
+struct VertexPackingError {
+	float position = 0.0f;		// model units
+	float normalAngle = 0.0f;	// degrees
+	float texCoord = 0.0f;
+};
+
+
+// Quantization range that covers the bounding box of the vertices
+VertexQuantization computeVertexQuantization(const std::vector<Vertex>& vertices);
+
+PackedVertex encodeVertex(const Vertex& vertex, const VertexQuantization& quantization);
+
+Vertex decodeVertex(const PackedVertex& vertex, const VertexQuantization& quantization);
+
+// Encode all the vertices and measure the precision lost
+std::vector<PackedVertex> packVertices(const std::vector<Vertex>& vertices, const VertexQuantization& quantization,
+	VertexPackingError& error);
@@ -0,0 +1,699 @@
+#include "benchmark/benchmarks.hpp"
+
+#include <SDL3/SDL_timer.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset/imageLoader.hpp"
+#include "asset/meshOptimizer.hpp"
+#include "asset/meshSimplifier.hpp"
+#include "asset/meshletBuilder.hpp"
+#include "render/image/TextureManager.hpp"
+#include "render/uniform/CameraUboManager.hpp"
+#include "render/uniform/LightBufferManager.hpp"
+#include "render/uniform/MaterialTable.hpp"
+#include "render/uniform/ModelUboManager.hpp"
+#include "render/uniform/ShadowUboManager.hpp"
+#include "scene/Light.hpp"
+#include "scene/Scene.hpp"
+#include "system/eventManagement.hpp"
+
+
+namespace {
+
+	// Cascades of a sun over the camera for the culling benchmarks, and the sphere the random casters are placed in
+	BoundingSphere updateBenchmarkCascades(ShadowUboManager& cascades, Camera& camera) {
+		Entity sunEntity;
+		Light sun;
+		sun.setOwner(&sunEntity);
+		sun.setColor(glm::vec3(1.0f));
+		sunEntity.transform.changeOrientation(glm::normalize(glm::vec3(0.4f, 0.3f, -1.0f)));
+
+		BoundingSphere sceneBounds{ camera.getTransform()->position, camera.getFarPlane() };
+		cascades.updateBuffer(0, &sun, camera, sceneBounds);
+		return sceneBounds;
+	}
+
+	std::vector<BoundingSphere> createBenchmarkCasters(std::mt19937& random, const BoundingSphere& sceneBounds,
+		uint32_t casterCount) {
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<BoundingSphere> casters(casterCount);
+		for (auto& caster : casters) {
+			caster.center = sceneBounds.center + glm::vec3(unit(random), unit(random), unit(random)) * sceneBounds.radius;
+			caster.radius = 0.5f + glm::abs(unit(random));
+		}
+		return casters;
+	}
+
+	// Wavy grid of quadsPerSide x quadsPerSide quads with its triangles in random order (the order of a scanned or
+	// exported mesh without any optimization)
+	void createBenchmarkGrid(std::mt19937& random, uint32_t quadsPerSide, std::vector<Vertex>& vertices,
+		std::vector<uint32_t>& indices) {
+		uint32_t side = quadsPerSide + 1;
+		vertices.resize(static_cast<size_t>(side) * side);
+		for (uint32_t y = 0; y < side; y++) {
+			for (uint32_t x = 0; x < side; x++) {
+				glm::vec2 texCoord = glm::vec2(x, y) / static_cast<float>(quadsPerSide);
+				Vertex& vertex = vertices[y * side + x];
+				vertex.pos = glm::vec3(texCoord * 100.0f, std::sin(texCoord.x * 40.0f) * std::cos(texCoord.y * 30.0f));
+				vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+				vertex.texCoord = texCoord;
+			}
+		}
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		triangles.reserve(static_cast<size_t>(quadsPerSide) * quadsPerSide * 2);
+		for (uint32_t y = 0; y < quadsPerSide; y++) {
+			for (uint32_t x = 0; x < quadsPerSide; x++) {
+				uint32_t corner = y * side + x;
+				triangles.push_back({ corner, corner + 1, corner + side + 1 });
+				triangles.push_back({ corner, corner + side + 1, corner + side });
+			}
+		}
+		std::shuffle(triangles.begin(), triangles.end(), random);
+
+		indices.clear();
+		indices.reserve(triangles.size() * 3);
+		for (const auto& triangle : triangles) {
+			indices.insert(indices.end(), triangle.begin(), triangle.end());
+		}
+	}
+}
+
+
+void benchmarkLightUpdates(Device device, WorkerPool& workerPool, Camera& camera, VkExtent2D extent) {
+	const uint32_t BENCHMARK_LIGHT_COUNT = 10000;
+	const uint32_t CHANGED_LIGHT_COUNT = 100;
+
+	LightBufferManager benchmarkBuffers;
+	benchmarkBuffers.createBuffers(device, 1);
+	benchmarkBuffers.setWorkerPool(&workerPool);
+
+	Scene benchmarkScene;
+	std::mt19937 random{ 0 };
+	std::vector<Entity*> entities;
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	auto addLights = [&](uint32_t count) {
+		for (uint32_t i = 0; i < count; i++) {
+			Entity* entity = benchmarkScene.addEntity();
+			entity->transform.position = glm::vec3(unit(random), unit(random), unit(random)) * 10.0f;
+			entity->addModule<Light>()->setRadius(1.0f);
+			entities.push_back(entity);
+		}
+	};
+	// the written lights are checked when they are known (the removed lights are replaced by the last ones)
+	auto measure = [&](const char* step, uint32_t minWritten, uint32_t maxWritten) {
+		std::vector<Light*> lights = benchmarkScene.getModulesOfType<Light>();
+		benchmarkBuffers.updateBuffers(0, lights, camera, extent);
+		uint32_t written = benchmarkBuffers.getUploadedLightCount();
+		std::cout << "Light update (" << step << "): " << benchmarkBuffers.getUpdateTime() << " ms, " << written
+			<< " of " << benchmarkBuffers.getLightCount() << " lights written" << std::endl;
+
+		if (benchmarkBuffers.getLightCount() != lights.size()) {
+			throw std::runtime_error("light update benchmark: wrong light count after the " + std::string(step) +
+				" step");
+		}
+		std::vector<bool> usedSlots(lights.size(), false);
+		for (Light* light : lights) {
+			uint32_t slot = benchmarkBuffers.getLightSlot(light);
+			if (slot >= lights.size() || usedSlots[slot]) {
+				throw std::runtime_error("light update benchmark: wrong light slot after the " + std::string(step) +
+					" step");
+			}
+			usedSlots[slot] = true;
+		}
+		if (written < minWritten || written > maxWritten) {
+			throw std::runtime_error("light update benchmark: wrong written light count after the " +
+				std::string(step) + " step");
+		}
+	};
+
+	addLights(BENCHMARK_LIGHT_COUNT);
+	measure("first upload", BENCHMARK_LIGHT_COUNT, BENCHMARK_LIGHT_COUNT);
+	measure("unchanged", 0, 0);
+
+	for (uint32_t i = 0; i < CHANGED_LIGHT_COUNT; i++) {
+		entities[i * (BENCHMARK_LIGHT_COUNT / CHANGED_LIGHT_COUNT)]->transform.position.x += 1.0f;
+	}
+	measure("moved", CHANGED_LIGHT_COUNT, CHANGED_LIGHT_COUNT);
+
+	for (size_t i = 0; i < entities.size(); i += 2) {
+		benchmarkScene.removeEntity(entities[i]);
+	}
+	entities.clear();
+	measure("half removed", 0, BENCHMARK_LIGHT_COUNT / 2);
+
+	addLights(CHANGED_LIGHT_COUNT);
+	measure("added", CHANGED_LIGHT_COUNT, CHANGED_LIGHT_COUNT);
+	measure("unchanged", 0, 0);
+
+	benchmarkBuffers.cleanup();
+}
+
+void benchmarkShadowCulling(Device device, Camera& camera) {
+	ShadowUboManager cascades;
+	cascades.createBuffers(device, 1);
+	BoundingSphere sceneBounds = updateBenchmarkCascades(cascades, camera);
+	std::mt19937 random{ 0 };
+
+	for (uint32_t casterCount = 1000; casterCount <= 100000; casterCount *= 10) {
+		std::vector<BoundingSphere> casters = createBenchmarkCasters(random, sceneBounds, casterCount);
+
+		uint32_t visible[SHADOW_CASCADE_COUNT] = {};
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++) {
+			for (const auto& caster : casters) {
+				visible[cascade] += cascades.isCasterVisible(cascade, caster) ? 1 : 0;
+			}
+		}
+		auto time = std::chrono::high_resolution_clock::now() - start;
+
+		std::cout << "Shadow caster culling (" << casterCount << " casters): "
+			<< std::chrono::duration<float, std::milli>(time).count() << " ms, visible per cascade:";
+		for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++) {
+			std::cout << " " << visible[cascade];
+		}
+		std::cout << std::endl;
+	}
+	cascades.cleanup();
+}
+
+void benchmarkDescriptorBinding(Device device, CommandManager commandManager, LayoutCache& layoutCache,
+	DescriptorAllocator& descriptorAllocator, SamplerCache& samplerCache, const Material& modelMaterial, uint32_t frame) {
+	const uint32_t BENCHMARK_DRAW_COUNT = 1000;
+	if (!modelMaterial.hasAlbedo()) {
+		std::cout << "Descriptor benchmark: the model has no texture" << std::endl;
+		return;
+	}
+	uint32_t textureCount = static_cast<uint32_t>(modelMaterial.textureCount);
+	std::vector<Material> materials(BENCHMARK_DRAW_COUNT, modelMaterial);
+	auto milliseconds = [](auto time) { return std::chrono::duration<float, std::milli>(time).count(); };
+
+	//--------------------------------------------------------
+	// SET PER MATERIAL (sampler and texture array)
+	std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+	bindings[0] = { 0, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr };
+	bindings[1] = { 1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, textureCount, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr };
+	VkDescriptorSetLayout materialSetLayout = layoutCache.getDescriptorSetLayout(bindings);
+	VkPipelineLayout materialPipelineLayout = layoutCache.getPipelineLayout({ materialSetLayout }, {});
+
+	VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
+	auto start = std::chrono::high_resolution_clock::now();
+	uint32_t descriptorWrites = 0;
+	for (const Material& material : materials) {
+		VkDescriptorSet descriptorSet = descriptorAllocator.allocateFrame(frame, materialSetLayout);
+
+		VkDescriptorImageInfo samplerInfo{ material.sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
+		std::vector<VkDescriptorImageInfo> textureInfos(textureCount,
+			{ VK_NULL_HANDLE, material.albedoTexture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+		std::array<VkWriteDescriptorSet, 2> writes{};
+		for (uint32_t i = 0; i < writes.size(); i++) {
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = descriptorSet;
+			writes[i].dstBinding = i;
+			writes[i].descriptorType = bindings[i].descriptorType;
+			writes[i].descriptorCount = bindings[i].descriptorCount;
+			writes[i].pImageInfo = i == 0 ? &samplerInfo : textureInfos.data();
+		}
+		vkUpdateDescriptorSets(device.get(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		descriptorWrites += 1 + textureCount;
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, materialPipelineLayout, 0, 1,
+			&descriptorSet, 0, nullptr);
+	}
+	float perMaterialTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+	commandManager.endSingleTimeCommands(commandBuffer);
+	descriptorAllocator.resetFrame(frame);
+
+	std::cout << "Descriptor benchmark (" << BENCHMARK_DRAW_COUNT << " draws): set per material " << perMaterialTime
+		<< " ms (" << BENCHMARK_DRAW_COUNT << " sets, " << descriptorWrites << " descriptor writes, "
+		<< BENCHMARK_DRAW_COUNT << " binds)";
+
+	//--------------------------------------------------------
+	// BINDLESS TABLE (a table of its own, the materials share the slots of the model textures)
+	if (!device.supportsBindlessTextures()) {
+		std::cout << ", bindless textures not supported" << std::endl;
+		return;
+	}
+	MaterialTable benchmarkTable;
+	benchmarkTable.create(device, layoutCache, descriptorAllocator, samplerCache);
+	uint32_t tableDrawCount = std::min(BENCHMARK_DRAW_COUNT, MAX_MATERIALS);
+	VkPushConstantRange materialRange{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t) };
+	VkPipelineLayout tablePipelineLayout =
+		layoutCache.getPipelineLayout({ materialSetLayout, benchmarkTable.getDescriptorSetLayout() }, { materialRange });
+
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<uint32_t> materialIndices(tableDrawCount);
+	for (uint32_t i = 0; i < tableDrawCount; i++) {
+		materialIndices[i] = benchmarkTable.addMaterial(materials[i]);
+	}
+	float tableTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+
+	commandBuffer = commandManager.beginSingleTimeCommands();
+	start = std::chrono::high_resolution_clock::now();
+	VkDescriptorSet tableSet = benchmarkTable.getDescriptorSet();
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tablePipelineLayout, 1, 1, &tableSet, 0,
+		nullptr);
+	for (uint32_t materialIndex : materialIndices) {
+		vkCmdPushConstants(commandBuffer, tablePipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t),
+			&materialIndex);
+	}
+	float bindlessTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+	commandManager.endSingleTimeCommands(commandBuffer);
+	benchmarkTable.cleanup();
+
+	std::cout << ", bindless " << bindlessTime << " ms (1 bind, " << tableDrawCount << " push constants) after adding "
+		<< tableDrawCount << " materials once in " << tableTime << " ms (" << benchmarkTable.getDescriptorWriteCount()
+		<< " descriptor writes)" << std::endl;
+}
+
+void benchmarkDrawData(Device device, CommandManager commandManager, LayoutCache& layoutCache,
+	DescriptorAllocator& descriptorAllocator, Model& model, Camera& camera, uint32_t frame) {
+	const uint32_t BENCHMARK_DRAW_COUNT = 1000;
+	auto milliseconds = [](auto time) { return std::chrono::duration<float, std::milli>(time).count(); };
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings = {
+		{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr }
+	};
+	VkDescriptorSetLayout setLayout = layoutCache.getDescriptorSetLayout(bindings);
+	auto writeBuffer = [&device](VkDescriptorSet descriptorSet, VkBuffer buffer, VkDeviceSize size) {
+		VkDescriptorBufferInfo bufferInfo{ buffer, 0, size };
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstBinding = 0;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		write.descriptorCount = 1;
+		write.pBufferInfo = &bufferInfo;
+		vkUpdateDescriptorSets(device.get(), 1, &write, 0, nullptr);
+	};
+
+	//--------------------------------------------------------
+	// UNIFORM BUFFER AND SET PER MODEL (written once, the buffers every frame)
+	ModelUboManager benchmarkModelUniforms;
+	benchmarkModelUniforms.createBuffers(device, BENCHMARK_DRAW_COUNT);
+	VkPipelineLayout modelPipelineLayout = layoutCache.getPipelineLayout({ setLayout }, {});
+
+	std::vector<VkDescriptorSet> modelSets(BENCHMARK_DRAW_COUNT);
+	for (uint32_t i = 0; i < BENCHMARK_DRAW_COUNT; i++) {
+		modelSets[i] = descriptorAllocator.allocateFrame(frame, setLayout);
+		writeBuffer(modelSets[i], benchmarkModelUniforms.getBuffer(i), sizeof(ModelUBO));
+	}
+
+	VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < BENCHMARK_DRAW_COUNT; i++) {
+		benchmarkModelUniforms.upateBuffer(i, model, camera);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, modelPipelineLayout, 0, 1,
+			&modelSets[i], 0, nullptr);
+	}
+	float perModelTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+	commandManager.endSingleTimeCommands(commandBuffer);
+	descriptorAllocator.resetFrame(frame);
+	benchmarkModelUniforms.cleanup();
+
+	//--------------------------------------------------------
+	// CAMERA UNIFORM BUFFER AND PUSH CONSTANTS
+	CameraUboManager benchmarkCameraUniforms;
+	benchmarkCameraUniforms.createBuffers(device, 1);
+	VkPushConstantRange drawRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawPushConstants) };
+	VkPipelineLayout drawPipelineLayout = layoutCache.getPipelineLayout({ setLayout }, { drawRange });
+
+	VkDescriptorSet cameraSet = descriptorAllocator.allocateFrame(frame, setLayout);
+	writeBuffer(cameraSet, benchmarkCameraUniforms.getBuffer(0), sizeof(CameraUBO));
+
+	commandBuffer = commandManager.beginSingleTimeCommands();
+	start = std::chrono::high_resolution_clock::now();
+	benchmarkCameraUniforms.updateBuffer(0, camera);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipelineLayout, 0, 1, &cameraSet, 0,
+		nullptr);
+	for (uint32_t i = 0; i < BENCHMARK_DRAW_COUNT; i++) {
+		DrawPushConstants drawConstants = createDrawPushConstants(model);
+		vkCmdPushConstants(commandBuffer, drawPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(drawConstants),
+			&drawConstants);
+	}
+	float pushConstantTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+	commandManager.endSingleTimeCommands(commandBuffer);
+	descriptorAllocator.resetFrame(frame);
+	benchmarkCameraUniforms.cleanup();
+
+	std::cout << "Draw data benchmark (" << BENCHMARK_DRAW_COUNT << " draws): uniform buffer per model "
+		<< perModelTime << " ms (" << BENCHMARK_DRAW_COUNT << " buffer writes of " << sizeof(ModelUBO) << " bytes, "
+		<< BENCHMARK_DRAW_COUNT << " binds), push constants " << pushConstantTime << " ms (1 buffer write, 1 bind, "
+		<< BENCHMARK_DRAW_COUNT << " pushes of " << sizeof(DrawPushConstants) << " bytes)" << std::endl;
+}
+
+void benchmarkTextureLoading(Device device, CommandManager commandManager, const std::string& directory) {
+	std::vector<std::string> paths;
+	for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" ||
+			extension == ".bmp") {
+			paths.push_back(entry.path().string());
+		}
+	}
+	if (paths.empty()) {
+		std::cout << "Texture loading benchmark: no image files in " << directory << std::endl;
+		return;
+	}
+	auto milliseconds = [](auto time) { return std::chrono::duration<float, std::milli>(time).count(); };
+
+	//--------------------------------------------------------
+	// ONE BY ONE (decoded on this thread, a submission each)
+	TextureManager benchmarkManager;
+	benchmarkManager.create(device, commandManager);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const auto& path : paths) {
+		benchmarkManager.acquire(path);
+	}
+	float sequentialTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+	float residentMemory = benchmarkManager.getResidentMemory() / (1024.0f * 1024.0f);
+	benchmarkManager.cleanup();
+
+	std::cout << "Texture loading benchmark (" << paths.size() << " files, " << residentMemory << " MB): one by one "
+		<< sequentialTime << " ms";
+
+	//--------------------------------------------------------
+	// BATCHES WITH 1 TO N DECODING THREADS
+	uint32_t maxThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	for (uint32_t threadCount = 1; ; threadCount = std::min(threadCount * 2, maxThreadCount)) {
+		WorkerPool decodePool;
+		decodePool.create(threadCount);
+		benchmarkManager.create(device, commandManager);
+		benchmarkManager.setWorkerPool(&decodePool);
+
+		start = std::chrono::high_resolution_clock::now();
+		benchmarkManager.acquire(paths);
+		float batchTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+		benchmarkManager.cleanup();
+		decodePool.cleanup();
+
+		std::cout << ", " << threadCount << (threadCount == 1 ? " thread " : " threads ") << batchTime << " ms";
+		if (threadCount == maxThreadCount) break;
+	}
+	std::cout << std::endl;
+}
+
+void benchmarkTextureBaking(Device device, CommandManager commandManager, WorkerPool& workerPool,
+	const std::vector<std::string>& paths, TextureBakeOptions options) {
+	if (paths.empty()) return;
+	auto milliseconds = [](auto time) { return std::chrono::duration<float, std::milli>(time).count(); };
+
+	//--------------------------------------------------------
+	// BAKE IN MEMORY (decoded once, on this thread)
+	float boxTime = 0.0f, kaiserTime = 0.0f;
+	for (const auto& path : paths) {
+		RawImage image = loadImageFromFile(path);
+		uint32_t width = static_cast<uint32_t>(image.width), height = static_cast<uint32_t>(image.height);
+
+		options.mipFilter = MIP_FILTER_BOX;
+		auto start = std::chrono::high_resolution_clock::now();
+		bakeTexture(image.pixels, width, height, options);
+		boxTime += milliseconds(std::chrono::high_resolution_clock::now() - start);
+
+		options.mipFilter = MIP_FILTER_KAISER;
+		start = std::chrono::high_resolution_clock::now();
+		bakeTexture(image.pixels, width, height, options);
+		kaiserTime += milliseconds(std::chrono::high_resolution_clock::now() - start);
+		image.free();
+	}
+
+	//--------------------------------------------------------
+	// LOAD THE IMAGE FILES AND THE BAKED FILES
+	std::vector<std::string> bakedPaths;
+	for (const auto& path : paths) {
+		bakedPaths.push_back(bakeTextureFile(path, options));
+	}
+
+	auto measureLoading = [&](const std::vector<std::string>& files, float& memory) {
+		TextureManager benchmarkManager;
+		benchmarkManager.create(device, commandManager);
+		benchmarkManager.setWorkerPool(&workerPool);
+		auto start = std::chrono::high_resolution_clock::now();
+		benchmarkManager.acquire(files);
+		float time = milliseconds(std::chrono::high_resolution_clock::now() - start);
+		memory = benchmarkManager.getResidentMemory() / (1024.0f * 1024.0f);
+		benchmarkManager.cleanup();
+		return time;
+	};
+	float imageMemory, bakedMemory;
+	float imageTime = measureLoading(paths, imageMemory);
+	float bakedTime = measureLoading(bakedPaths, bakedMemory);
+
+	std::cout << "Texture bake benchmark (" << paths.size() << " files, "
+		<< (options.compression == TEXTURE_COMPRESSION_NONE ? "uncompressed" : "BC7") << "): bake box " << boxTime
+		<< " ms, kaiser " << kaiserTime << " ms, load image files " << imageTime << " ms (" << imageMemory
+		<< " MB), baked files " << bakedTime << " ms (" << bakedMemory << " MB, "
+		<< (imageMemory > 0.0f ? bakedMemory / imageMemory * 100.0f : 0.0f) << "% of the memory)" << std::endl;
+}
+
+void benchmarkJobSystem(Device device, Camera& camera) {
+	const uint32_t CASTER_COUNT = 1000000;
+	const uint32_t CULL_GRAIN_SIZE = 4096;
+	auto milliseconds = [](auto time) { return std::chrono::duration<float, std::milli>(time).count(); };
+
+	//--------------------------------------------------------
+	// SCALING OF THE CULLING (best of 3 runs)
+	ShadowUboManager cascades;
+	cascades.createBuffers(device, 1);
+	BoundingSphere sceneBounds = updateBenchmarkCascades(cascades, camera);
+	std::mt19937 random{ 0 };
+	std::vector<BoundingSphere> casters = createBenchmarkCasters(random, sceneBounds, CASTER_COUNT);
+	auto cullRange = [&](uint32_t first, uint32_t last, uint32_t* visible) {
+		for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++) {
+			for (uint32_t i = first; i < last; i++) {
+				visible[cascade] += cascades.isCasterVisible(cascade, casters[i]) ? 1 : 0;
+			}
+		}
+	};
+
+	uint32_t serialVisible[SHADOW_CASCADE_COUNT] = {};
+	float serialTime = std::numeric_limits<float>::max();
+	for (int run = 0; run < 3; run++) {
+		uint32_t visible[SHADOW_CASCADE_COUNT] = {};
+		auto start = std::chrono::high_resolution_clock::now();
+		cullRange(0, CASTER_COUNT, visible);
+		serialTime = std::min(serialTime, milliseconds(std::chrono::high_resolution_clock::now() - start));
+		std::copy(visible, visible + SHADOW_CASCADE_COUNT, serialVisible);
+	}
+	std::cout << "Job system culling (" << CASTER_COUNT << " casters, " << CULL_GRAIN_SIZE << " per range): one thread "
+		<< serialTime << " ms";
+
+	uint32_t maxThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	for (uint32_t threadCount = 1; ; threadCount = std::min(threadCount * 2, maxThreadCount)) {
+		WorkerPool pool;
+		pool.create(threadCount);
+
+		float parallelTime = std::numeric_limits<float>::max();
+		for (int run = 0; run < 3; run++) {
+			std::atomic<uint32_t> visible[SHADOW_CASCADE_COUNT];
+			for (auto& count : visible) count = 0;
+
+			auto start = std::chrono::high_resolution_clock::now();
+			pool.parallelFor(CASTER_COUNT, CULL_GRAIN_SIZE, [&](uint32_t first, uint32_t last) {
+				uint32_t rangeVisible[SHADOW_CASCADE_COUNT] = {};
+				cullRange(first, last, rangeVisible);
+				for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++) {
+					visible[cascade] += rangeVisible[cascade];
+				}
+			});
+			parallelTime = std::min(parallelTime, milliseconds(std::chrono::high_resolution_clock::now() - start));
+
+			for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++) {
+				if (visible[cascade].load() != serialVisible[cascade]) {
+					throw std::runtime_error("job system benchmark: wrong parallel culling result");
+				}
+			}
+		}
+		pool.cleanup();
+
+		// the calling thread runs ranges too
+		std::cout << ", " << threadCount << " + 1 " << (threadCount == 1 ? "thread " : "threads ") << parallelTime
+			<< " ms (x" << serialTime / parallelTime << ")";
+		if (threadCount == maxThreadCount) break;
+	}
+	std::cout << std::endl;
+	cascades.cleanup();
+}
+
+void benchmarkEventDispatch() {
+	const uint32_t EVENT_COUNT = 1000000;
+	const uint32_t BATCH_SIZE = 256;
+	const uint32_t PRODUCER_COUNT = 4;
+	const EventType EVENT_TYPES[] = { SDL_EVENT_KEY_DOWN, SDL_EVENT_KEY_UP, SDL_EVENT_MOUSE_MOTION };
+	const uint32_t SUBSCRIBERS_PER_TYPE = 2;
+	auto milliseconds = [](auto time) { return std::chrono::duration<float, std::milli>(time).count(); };
+	auto createEvent = [&](uint32_t i) {
+		SDL_Event event{};
+		event.type = EVENT_TYPES[i % 3];
+		return event;
+	};
+
+	uint64_t calls = 0;
+	EventSubscriber subscriber = [&calls](const SDL_Event& event) { calls++; };
+
+	//--------------------------------------------------------
+	// SUBSCRIBER MAP
+	std::map<EventType, std::vector<EventSubscriber>> subscriberMap;
+	for (EventType type : EVENT_TYPES) {
+		subscriberMap[type].assign(SUBSCRIBERS_PER_TYPE, subscriber);
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < EVENT_COUNT; i++) {
+		SDL_Event event = createEvent(i);
+		std::vector<EventSubscriber> callbacks = subscriberMap[event.type];
+		for (auto& callback : callbacks) {
+			callback(event);
+		}
+	}
+	float mapTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+	if (calls != static_cast<uint64_t>(EVENT_COUNT) * SUBSCRIBERS_PER_TYPE) {
+		throw std::runtime_error("event benchmark failed: subscriber map calls");
+	}
+
+	//--------------------------------------------------------
+	// QUEUE AND DISPATCH TABLE
+	EventQueue queue;
+	queue.create();
+	EventDispatcher dispatcher;
+	for (EventType type : EVENT_TYPES) {
+		for (uint32_t i = 0; i < SUBSCRIBERS_PER_TYPE; i++) {
+			dispatcher.addSubscriber(type, subscriber);
+		}
+	}
+
+	calls = 0;
+	QueuedEvent queuedEvent;
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t first = 0; first < EVENT_COUNT; first += BATCH_SIZE) {
+		for (uint32_t i = first; i < std::min(first + BATCH_SIZE, EVENT_COUNT); i++) {
+			queue.push(createEvent(i), 0);
+		}
+		while (queue.pop(queuedEvent)) {
+			dispatcher.dispatch(queuedEvent.event);
+		}
+	}
+	float tableTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+	if (calls != static_cast<uint64_t>(EVENT_COUNT) * SUBSCRIBERS_PER_TYPE) {
+		throw std::runtime_error("event benchmark failed: dispatch table calls");
+	}
+
+	std::cout << "Event dispatch (" << EVENT_COUNT << " events, " << SUBSCRIBERS_PER_TYPE << " subscribers each): map "
+		<< mapTime * 1e6f / EVENT_COUNT << " ns per event, queue and table " << tableTime * 1e6f / EVENT_COUNT
+		<< " ns per event (batches of " << BATCH_SIZE << ")" << std::endl;
+
+	//--------------------------------------------------------
+	// THREADS PUSHING AT ONCE (a full queue is retried)
+	calls = 0;
+	std::atomic<uint32_t> fullCount{ 0 };
+	std::vector<std::thread> producers;
+	for (uint32_t p = 0; p < PRODUCER_COUNT; p++) {
+		producers.emplace_back([&, p]() {
+			for (uint32_t i = p; i < EVENT_COUNT; i += PRODUCER_COUNT) {
+				while (!queue.push(createEvent(i), SDL_GetTicksNS())) {
+					fullCount++;
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	uint32_t received = 0;
+	double delaySum = 0.0;
+	float maxDelay = 0.0f;
+	while (received < EVENT_COUNT) {
+		if (!queue.pop(queuedEvent)) continue;
+		float delay = (SDL_GetTicksNS() - queuedEvent.queuedTime) / 1000.0f;
+		delaySum += delay;
+		maxDelay = std::max(maxDelay, delay);
+		dispatcher.dispatch(queuedEvent.event);
+		received++;
+	}
+	for (auto& producer : producers) {
+		producer.join();
+	}
+	if (calls != static_cast<uint64_t>(EVENT_COUNT) * SUBSCRIBERS_PER_TYPE) {
+		throw std::runtime_error("event benchmark failed: events pushed from several threads");
+	}
+
+	std::cout << "Event queue (" << PRODUCER_COUNT << " threads pushing, " << queue.getCapacity() << " events): delay "
+		<< delaySum / EVENT_COUNT << " us (max " << maxDelay << " us), " << fullCount.load() << " pushes to a full queue"
+		<< std::endl;
+	queue.cleanup();
+}
+
+void benchmarkMeshOptimizer() {
+	const uint32_t QUADS_PER_SIDE = 710;
+	const float OVERDRAW_THRESHOLD = 1.05f;
+	auto milliseconds = [](auto time) { return std::chrono::duration<float, std::milli>(time).count(); };
+
+	std::mt19937 random{ 0 };
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	createBenchmarkGrid(random, QUADS_PER_SIDE, vertices, indices);
+	size_t vertexCount = vertices.size();
+	size_t indexCount = indices.size();
+	float acmrBefore = computeAcmr(indices, vertexCount);
+	float atvrBefore = computeAtvr(indices, vertexCount);
+
+	//--------------------------------------------------------
+	// STAGES OF THE LOADER (in the same order)
+	auto start = std::chrono::high_resolution_clock::now();
+	indices = optimizeVertexCache(indices, vertexCount);
+	float cacheTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+	float acmrCache = computeAcmr(indices, vertexCount);
+
+	start = std::chrono::high_resolution_clock::now();
+	indices = optimizeOverdraw(vertices, indices, OVERDRAW_THRESHOLD);
+	float overdrawTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+	float acmrAfter = computeAcmr(indices, vertexCount);
+	float atvrAfter = computeAtvr(indices, vertexCount);
+
+	start = std::chrono::high_resolution_clock::now();
+	optimizeVertexFetch(vertices, indices);
+	float fetchTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+
+	std::vector<MeshSubset> subsets;
+	start = std::chrono::high_resolution_clock::now();
+	bool shortIndices = splitByVertexWindow(indices, 0, static_cast<uint32_t>(indices.size()), SHORT_INDEX_VERTEX_LIMIT,
+		subsets);
+	float splitTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+
+	std::vector<uint32_t> meshletIndices;
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<Meshlet> meshlets = buildMeshlets(vertices, indices, meshletIndices);
+	float meshletTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+
+	// first level of detail (half the triangles)
+	float lodError = 0.0f;
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<uint32_t> lodIndices = simplifyMesh(vertices, indices, indices.size() / 6 * 3,
+		std::numeric_limits<float>::max(), lodError);
+	float lodTime = milliseconds(std::chrono::high_resolution_clock::now() - start);
+
+	if (indices.size() != indexCount || vertices.size() != vertexCount || meshletIndices.size() != indexCount) {
+		throw std::runtime_error("mesh optimizer benchmark failed: triangles or vertices lost");
+	}
+
+	std::cout << "Mesh optimizer (" << indexCount / 3 << " triangles, " << vertexCount << " vertices): vertex cache "
+		<< cacheTime << " ms, overdraw " << overdrawTime << " ms, vertex fetch " << fetchTime << " ms, 16 bit split "
+		<< splitTime << " ms (" << (shortIndices ? std::to_string(subsets.size()) + " subsets" : "no fit") << "), "
+		<< meshlets.size() << " meshlets " << meshletTime << " ms, LOD of " << lodIndices.size() / 3 << " triangles "
+		<< lodTime << " ms (error " << lodError << ")" << std::endl;
+	std::cout << "Mesh optimizer ACMR " << acmrBefore << " -> " << acmrCache << " (vertex cache) -> " << acmrAfter
+		<< " (overdraw), ATVR " << atvrBefore << " -> " << atvrAfter << std::endl;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+
+#include "asset/textureBaker.hpp"
+#include "context/CommandManager.hpp"
+#include "context/Device.hpp"
+#include "render/image/SamplerCache.hpp"
+#include "render/pipeline/DescriptorAllocator.hpp"
+#include "render/pipeline/LayoutCache.hpp"
+#include "render/uniform/Material.hpp"
+#include "scene/Camera.hpp"
+#include "scene/Model.hpp"
+#include "system/WorkerPool.hpp"
+
+
+// Measurements run before the main loop (each one is enabled by a flag of VulkanAppParams). They create the objects they
+// measure from the subsystems they receive, print their results and throw if a checked result is wrong
+
+
+// Light buffer update cost with 10k lights: first upload, unchanged lights, some moved, half removed and some added.
+// It uses its own buffers, and the slots of the lights and the written lights are checked after each step
+void benchmarkLightUpdates(Device device, WorkerPool& workerPool, Camera& camera, VkExtent2D extent);
+
+// Caster culling cost against every cascade with random casters around the camera (1k, 10k and 100k casters)
+void benchmarkShadowCulling(Device device, Camera& camera);
+
+// CPU cost of giving 1k draws their material: a set per material written and bound before each draw against the
+// materials added once to a bindless table, bound once, and a push constant per draw (the model textures are used
+// by every material)
+void benchmarkDescriptorBinding(Device device, CommandManager commandManager, LayoutCache& layoutCache,
+	DescriptorAllocator& descriptorAllocator, SamplerCache& samplerCache, const Material& modelMaterial, uint32_t frame);
+
+// CPU cost of giving 1k draws their matrices in a frame: a uniform buffer per model written and its set bound before
+// each draw against the camera uniform buffer written and bound once and a push constant per draw (every draw
+// uses the transform of the model)
+void benchmarkDrawData(Device device, CommandManager commandManager, LayoutCache& layoutCache,
+	DescriptorAllocator& descriptorAllocator, Model& model, Camera& camera, uint32_t frame);
+
+// Cost of loading the image files of the directory (uploaded with their mipmaps): one by one on this thread against
+// batches decoded with 1 to N worker threads
+void benchmarkTextureLoading(Device device, CommandManager commandManager, const std::string& directory);
+
+// Bake time of the material image files with each mip filter, and loading of the image files (mip levels generated
+// on the GPU) against their baked files (every level in a copy) with the GPU memory of each
+void benchmarkTextureBaking(Device device, CommandManager commandManager, WorkerPool& workerPool,
+	const std::vector<std::string>& paths, TextureBakeOptions options);
+
+// Caster culling of 1M casters in a parallel loop with pools of 1 to N threads against a single thread (the job system
+// itself is checked by the unit tests)
+void benchmarkJobSystem(Device device, Camera& camera);
+
+// Dispatch cost per event of the subscriber map (the subscribers of the type copied for each event) against the
+// dispatch table fed by the event queue in batches of a frame, and the delay of the queue with 4 threads pushing events
+// at once while this one dispatches them (every event is checked to be dispatched once)
+void benchmarkEventDispatch();
+
+// Time of each stage of the mesh processing of the loader on a generated mesh of 1M triangles in random order (vertex
+// cache, overdraw and vertex fetch order, 16 bit split, meshlets and a level of detail) and its ACMR/ATVR before and
+// after the reordering
+void benchmarkMeshOptimizer();
@@ -2,6 +2,7 @@
 #include <vulkan/vulkan.h>
 #include <stdexcept>
 #include <set>
+#include <algorithm>
 #include "VulkanApplication.hpp"
 
 
@@ -29,6 +30,11 @@ void Device::pickDevice() {
 		if (isDeviceSuitable(device)) {
 			physicalDevice = device;
 			msaaSamples = getMaxUsableSampleCount();
+			queryBindlessSupport();
+
+			VkPhysicalDeviceFeatures supportedFeatures;
+			vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+			textureCompressionBC = supportedFeatures.textureCompressionBC;
 			break;
 		}
 	}
@@ -193,6 +199,39 @@ VkSampleCountFlagBits Device::getMaxUsableSampleCount() {
 	return VK_SAMPLE_COUNT_1_BIT;
 }
 
+void Device::queryBindlessSupport() {
+	bindlessTextures = false;
+	maxBindlessTextures = 0;
+	if (getPhysicalDeviceProperties().apiVersion < VK_API_VERSION_1_2) return;
+
+	//-----------------------------------------
+	// FEATURES
+	VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	VkPhysicalDeviceFeatures2 features{};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &indexingFeatures;
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+	//-----------------------------------------
+	// LIMITS (the array is seen by the fragment stage only)
+	VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+	indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+	VkPhysicalDeviceProperties2 properties{};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &indexingProperties;
+	vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+	bindlessTextures =
+		indexingFeatures.runtimeDescriptorArray &&
+		indexingFeatures.descriptorBindingPartiallyBound &&
+		indexingFeatures.descriptorBindingVariableDescriptorCount &&
+		indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+		indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+	maxBindlessTextures = std::min(indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+		indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+}
+
 VkFormat Device::findSupportedFormat(
 	const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
 
@@ -249,6 +288,16 @@ void Device::createLogicalDevice() {
 	VkPhysicalDeviceFeatures deviceFeatures{};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
 	deviceFeatures.sampleRateShading = VK_TRUE;
+	deviceFeatures.textureCompressionBC = textureCompressionBC;
+
+	// bindless textures (only the features the material table uses)
+	VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+	indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+	indexingFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
+	indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
 
 	//-----------------------------------------
 	// DEVICE CREATE INFO
@@ -259,6 +308,7 @@ void Device::createLogicalDevice() {
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
 	createInfo.pEnabledFeatures = &deviceFeatures;
+	createInfo.pNext = bindlessTextures ? &indexingFeatures : nullptr;
 
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
 	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
@@ -38,6 +38,14 @@ public:
     VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
     VkSampleCountFlagBits getMsaaSamples() { return msaaSamples; }
 
+    // Descriptor indexing (Vulkan 1.2) with update after bind, partially bound and variable count sampled image
+    // arrays, and the most sampled images such an array can have
+    bool supportsBindlessTextures() const { return bindlessTextures; }
+    uint32_t getMaxBindlessTextures() const { return maxBindlessTextures; }
+
+    // Block compressed texture formats (BC1 to BC7)
+    bool supportsTextureCompressionBC() const { return textureCompressionBC; }
+
     VkDevice get() { return logicalDevice; }
     VkQueue getGraphicsQueue() { return graphicsQueue; }
     VkQueue getPresentQueue() { return presentQueue; }
@@ -88,6 +96,9 @@ private:
     // Physical device objects
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;	// destroyed with instance
     VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT; // multisampling
+    bool bindlessTextures = false;
+    uint32_t maxBindlessTextures = 0;
+    bool textureCompressionBC = false;
 
     // Logical device objects
     VkDevice logicalDevice;
@@ -115,6 +126,9 @@ private:
     // Get the maximun sample count supported by the GPU depending on color buffer AND depth buffer
     VkSampleCountFlagBits getMaxUsableSampleCount();
 
+    // Check the descriptor indexing features and limits of the selected device (enabled if it has them)
+    void queryBindlessSupport();
+
 
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // LOGICAL DEVICE METHODS
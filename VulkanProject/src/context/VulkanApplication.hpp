@@ -12,10 +12,17 @@
 #include <unordered_map>
 #include <optional>
 #include <set>
+#include <map>
 //#include <cstdint> // uint32_t
 #include <limits> // std::numeric_limits
 #include <fstream>
 #include <chrono>
+#include <random>
+#include <thread>
+#include <filesystem>
+#include <algorithm>
+#include <exception>
+#include <atomic>
 
 #include "context/Window.hpp"
 #include "context/Device.hpp"
@@ -23,16 +30,35 @@
 #include "render/target/SwapChain.hpp"
 #include "render/target/FramebufferResources.hpp"
 #include "render/image/imageUtils.hpp"
+#include "render/image/SamplerCache.hpp"
+#include "render/image/TextureManager.hpp"
+#include "render/image/TextureStreamer.hpp"
+#include "asset/imageLoader.hpp"
+#include "asset/textureBaker.hpp"
+#include "benchmark/benchmarks.hpp"
 #include "render/pipeline/FirstPassPipeline.hpp"
 #include "render/pipeline/SecondPassPipeline.hpp"
-#include "render/uniform/LightUboManager.hpp"
+#include "render/pipeline/MeshletCullPipeline.hpp"
+#include "render/pipeline/ShadowPassPipeline.hpp"
+#include "render/pipeline/ShaderLibrary.hpp"
+#include "render/pipeline/LayoutCache.hpp"
+#include "render/pipeline/DescriptorAllocator.hpp"
+#include "render/uniform/LightBufferManager.hpp"
 #include "render/uniform/ModelUboManager.hpp"
+#include "render/uniform/CameraUboManager.hpp"
+#include "render/uniform/ShadowUboManager.hpp"
+#include "render/uniform/ShadowAtlasManager.hpp"
 #include "render/uniform/Material.hpp"
+#include "render/uniform/MaterialTable.hpp"
 #include "scene/Model.hpp"
 #include "scene/Camera.hpp"
 #include "scene/Light.hpp"
+#include "scene/AssetLoader.hpp"
 #include "system/eventManagement.hpp"
+#include "system/WorkerPool.hpp"
+#include "system/ShaderWatcher.hpp"
 #include "time/AppTime.hpp"
+#include "time/FrameProfiler.hpp"
 #include "scene/Scene.hpp"
 
 
@@ -44,6 +70,17 @@ const std::string POST_PROCESSING_QUAD_PATH = "C:/development/cpp/VulkanProject/
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
 
+// Point lights added or removed with the +/- keys
+const uint32_t POINT_LIGHT_STEP = 256;
+// One of each this many random point lights casts shadows
+const uint32_t SHADOWED_POINT_LIGHT_INTERVAL = 32;
+
+// Time between the checks of the shader files for hot reload
+const std::chrono::milliseconds SHADER_WATCH_INTERVAL(500);
+
+// Maximum error (in pixels) allowed on the screen when a simplified level of detail is selected
+const float LOD_PIXEL_THRESHOLD = 1.0f;
+
 
 #ifdef NDEBUG
 const bool enableValidationLayers = false;
@@ -61,8 +98,68 @@ struct VulkanAppParams {
 	std::vector<TexturePaths> texturePaths;
 	std::string firstRenderPassVertShaderPath;
 	std::string firstRenderPassFragShaderPath;
+	// First pass fragment shader compiled with BINDLESS (used with bindless textures)
+	std::string firstRenderPassBindlessFragShaderPath;
+	// First pass vertex shader compiled with DRAW_CONSTANTS (used with the draw push constants)
+	std::string firstRenderPassDrawConstantsVertShaderPath;
 	std::string secondRenderPassVertShaderPath;
 	std::string secondRenderPassFragShaderPath;
+	// Compute shader that culls the meshlets of dense models (if empty they are drawn without culling)
+	std::string meshletCullShaderPath;
+	// Depth only vertex shader of the directional light cascades
+	std::string shadowVertShaderPath;
+
+	// Layout of the model vertex buffer (the first pass pipeline variant specializes the vertex shader for it)
+	VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+	// Measure each stage of the mesh processing on a generated mesh of 1M triangles before the main loop
+	bool meshOptimizerBenchmark = false;
+
+	// Random point lights added around the model to test the clustered lighting
+	uint32_t pointLightCount = 0;
+	// Measure the light buffer update adding, changing and removing lights before the main loop
+	bool lightUpdateBenchmark = false;
+	// Measure the caster culling against the cascades with an increasing number of casters before the main loop
+	bool shadowCullBenchmark = false;
+	// Measure the scaling of a parallel culling loop with the worker threads before the main loop
+	bool jobSystemBenchmark = false;
+	// Read the first pass textures from a global descriptor array and the materials from a buffer (if the device
+	// supports descriptor indexing, otherwise each material has its own texture array in the set)
+	bool bindlessTextures = false;
+	// Measure the descriptor updates and binds of a set per material against the bindless table before the main loop
+	bool descriptorBenchmark = false;
+	// Push the model matrices before each first pass draw and read the camera from a uniform buffer written once per
+	// frame (otherwise each model has its uniform buffer in the descriptor set)
+	bool drawPushConstants = false;
+	// Measure the per draw data of a uniform buffer and a set per model against the push constants before the main loop
+	bool drawDataBenchmark = false;
+	// GPU memory kept for the textures without references (evicted in least recently released order when it is
+	// exceeded, 0 frees them with their last reference)
+	VkDeviceSize textureMemoryBudget = 0;
+	// Directory with image files to measure the texture loading with 1 to N decoding threads before the main loop (no
+	// benchmark if empty)
+	std::string textureLoadBenchmarkDirectory;
+	// Bake the image files of the materials into KTX2 files with their mip levels generated on the CPU, block compressed
+	// if the device supports BC formats (baked again when the image file is newer)
+	bool bakeTextures = false;
+	// Measure the bake of the material image files and their loading against the baked files before the main loop
+	bool textureBakeBenchmark = false;
+	// Load only the mip tail of the baked textures and stream their finer levels as the models get closer to the camera
+	// (the levels uploaded per frame are limited by the budget in bytes)
+	bool textureStreaming = false;
+	VkDeviceSize textureUploadBudget = 8 * 1024 * 1024;
+	// Copies of the model loaded in the background after the initialization, in a grid next to it (the main loop keeps
+	// presenting frames meanwhile). They are drawn only with draw push constants and bindless textures
+	uint32_t asyncModelCount = 0;
+	// Bytes of the asynchronous loads uploaded per frame
+	VkDeviceSize assetUploadBudget = 32 * 1024 * 1024;
+	// Measure the event dispatch cost of the subscriber map against the queue and dispatch table, and the delay of the
+	// queue between threads, before the main loop
+	bool eventBenchmark = false;
+	// Compile the missing pipeline variants in worker threads (drawing with a fallback variant meanwhile)
+	bool asyncPipelineCompilation = true;
+	// Rebuild the pipelines when their SPIR-V files change (the sources are compiled again if glslc is found)
+	bool shaderHotReload = false;
+	std::vector<ShaderSource> shaderSources;
 
 	uint32_t fps = 144;
 	uint32_t updateRate = 60;
@@ -143,28 +240,65 @@ private:
 	// Scene
 	Scene scene;
 
-	// Camera and lights
-	size_t lightCount = 2;
-
+	// Camera
 	Camera* camera;
 
+	// Point lights (they can be added and removed at runtime)
+	std::vector<Entity*> pointLights;
+	std::mt19937 lightRandom{ 0 };
+
 	// Geometry
 	Entity postProcessingQuad;
+	TexturePaths modelTexturePaths;
+
+	// Models and materials loaded in the background (frame times measured until all of them are ready)
+	AssetLoader assetLoader;
+	std::vector<ModelHandle> asyncModels;
+	FrameProfiler loadingProfiler;
+	std::chrono::steady_clock::time_point loadingStart;
+	bool asyncLoading = false;
 
-	// Descriptor pool and sets
-	VkDescriptorPool descriptorPool;
+	// Descriptor pools (persistent and per frame in flight)
+	DescriptorAllocator descriptorAllocator;
+
+	// Shader modules and layouts shared by the pipelines
+	ShaderLibrary shaderLibrary;
+	LayoutCache layoutCache;
+
+	// Samplers and textures shared by the materials
+	SamplerCache samplerCache;
+	TextureManager textureManager;
+	// finer mip levels of the baked textures
+	TextureStreamer textureStreamer;
+	bool textureStreaming = false;
 
 	// FIRST PASS OBJECTS
 	FirstPassPipeline firstPassPipeline;
 	FramebufferResources firstPassFramebuffer;
-	VkDescriptorSet firstPassDescriptorSet;
+	// a set per frame in flight, written again when its frame is recorded after the buffers or samplers change
+	std::vector<VkDescriptorSet> firstPassDescriptorSets;
+	std::vector<bool> firstPassDescriptorsChanged;
 	ModelUboManager modelUniforms;
-	LightUboManager lightUniforms;
+	// camera of the frame when the model matrices are pushed
+	CameraUboManager cameraUniforms;
+	bool drawPushConstants = false;
+	LightBufferManager lightBuffers;
+	// bindless textures and materials of the first pass
+	MaterialTable materialTable;
+	bool bindlessTextures = false;
+	MeshletCullPipeline meshletCullPipeline;
+	bool meshletCulling = false;
+	uint32_t visibleMeshletTriangles = 0;
+
+	// SHADOW PASS OBJECTS (cascades of the first directional light)
+	ShadowPassPipeline shadowPassPipeline;
+	ShadowUboManager shadowUniforms;
+	// shadow atlas of the point and spot lights
+	ShadowAtlasManager shadowAtlas;
 
 	// SECOND PASS OBJECTS
 	SecondPassPipeline secondPassPipeline;
 	std::vector<FramebufferResources> secondPassFramebuffers;
-	std::vector<VkDescriptorSet> secondPassDescriptorSets;
 
 	// Sync objects
 	std::vector<VkSemaphore> imageAvailableSemaphores;
@@ -174,6 +308,15 @@ private:
 	// Frame tracking
 	uint32_t currentFrame = 0;
 
+	// Background tasks (pipeline compilation)
+	WorkerPool workerPool;
+
+	// Shader files checked for hot reload
+	ShaderWatcher shaderWatcher;
+
+	// Frame times of the current stats interval
+	FrameProfiler frameProfiler;
+
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -206,9 +349,15 @@ private:
 		addEventSubscriber(SDL_EVENT_WINDOW_MINIMIZED, [this](SDL_Event e) {
 			windowResizedEvent = e.type;
 			});
+		addEventSubscriber(SDL_EVENT_WINDOW_RESTORED, [this](SDL_Event e) {
+			windowResizedEvent = e.type;
+			});
 
 		// Hide the cursor and constrait it to the window (for easier input handling)
 		SDL_SetWindowRelativeMouseMode(window.get(), true);
+
+		// the events are queued as they arrive and dispatched once per frame
+		startEventQueue();
 	}
 
 
@@ -229,32 +378,141 @@ private:
 		commandManager.createPoolAndBuffers(device, MAX_FRAMES_IN_FLIGHT);
 
 		swapChain.create(device, window, surface);
+		shaderLibrary.create(device);
+		layoutCache.create(device);
+		samplerCache.create(device);
+		textureManager.create(device, commandManager, params.textureMemoryBudget);
+		descriptorAllocator.create(device, MAX_FRAMES_IN_FLIGHT);
+
+		// the textures are decoded in the worker threads
+		workerPool.create(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+		textureManager.setWorkerPool(&workerPool);
+		if (!params.textureLoadBenchmarkDirectory.empty()) {
+			benchmarkTextureLoading(device, commandManager, params.textureLoadBenchmarkDirectory);
+		}
+		if (params.meshOptimizerBenchmark) {
+			benchmarkMeshOptimizer();
+		}
+		if (params.textureBakeBenchmark) {
+			std::vector<std::string> bakePaths;
+			for (std::string* path : getTexturePaths(params.texturePaths[0])) {
+				bakePaths.push_back(*path);
+			}
+			benchmarkTextureBaking(device, commandManager, workerPool, bakePaths, getTextureBakeOptions());
+		}
+
+		// only the KTX2 files of the baked textures have their levels streamed
+		textureStreaming = params.textureStreaming && params.bakeTextures;
+		if (params.textureStreaming && !textureStreaming) {
+			std::cout << "Texture streaming needs baked textures, loading every mip level" << std::endl;
+		}
+		if (textureStreaming) {
+			textureStreamer.create(device, MAX_FRAMES_IN_FLIGHT, params.textureUploadBudget);
+			textureStreamer.setWorkerPool(&workerPool);
+			textureManager.setStreamer(&textureStreamer);
+		}
+		assetLoader.create(device, commandManager, samplerCache, textureManager, workerPool, scene, MAX_FRAMES_IN_FLIGHT,
+			params.assetUploadBudget);
 		
 		createWorldObjects(params);
+		printMeshStats();
+		if (textureStreaming) {
+			updateStreamedMaterials();
+		}
 
 		// TODO: use a vector of models and lights
 		modelUniforms.createBuffers(device, 1);
-		lightUniforms.createBuffers(device, 1, lightCount);
+		lightBuffers.createBuffers(device, MAX_FRAMES_IN_FLIGHT);
+		lightBuffers.setWorkerPool(&workerPool);
+		if (params.lightUpdateBenchmark) {
+			benchmarkLightUpdates(device, workerPool, *scene.activeCamera, swapChain.getExtent());
+		}
 
 		// the pipeline needs the texture count (models already loaded)
 		Model* m = scene.getModulesOfType<Model>()[0];
-		firstPassPipeline.create(device, swapChain.getImageFormat(), findDepthFormat(device), m, lightCount,
-			params.firstRenderPassVertShaderPath, params.firstRenderPassFragShaderPath);
+
+		// shadow map sampled by the first pass
+		shadowUniforms.createBuffers(device, MAX_FRAMES_IN_FLIGHT);
+		shadowAtlas.createBuffers(device, MAX_FRAMES_IN_FLIGHT);
+		shadowPassPipeline.create(device, shaderLibrary, layoutCache, findDepthFormat(device), m, MAX_FRAMES_IN_FLIGHT,
+			params.shadowVertShaderPath);
+		if (params.shadowCullBenchmark) {
+			benchmarkShadowCulling(device, *scene.activeCamera);
+		}
+		if (params.jobSystemBenchmark) {
+			benchmarkJobSystem(device, *scene.activeCamera);
+		}
+
+		// bindless textures (the same first pass without them if the device does not support descriptor indexing)
+		bindlessTextures = params.bindlessTextures && device.supportsBindlessTextures();
+		if (params.bindlessTextures && !bindlessTextures) {
+			std::cout << "Bindless textures are not supported by the device, using a descriptor set per material" << std::endl;
+		}
+		std::string firstPassFragShaderPath = params.firstRenderPassFragShaderPath;
+		if (bindlessTextures) {
+			materialTable.create(device, layoutCache, descriptorAllocator, samplerCache);
+			firstPassPipeline.setMaterialTable(&materialTable);
+			firstPassFragShaderPath = params.firstRenderPassBindlessFragShaderPath;
+			addBindlessMaterials();
+		}
+
+		// model matrices as push constants (the camera uniform buffer takes the binding of the model one)
+		drawPushConstants = params.drawPushConstants;
+		std::string firstPassVertShaderPath = params.firstRenderPassVertShaderPath;
+		if (drawPushConstants) {
+			cameraUniforms.createBuffers(device, MAX_FRAMES_IN_FLIGHT);
+			firstPassPipeline.setCameraUniforms(&cameraUniforms);
+			firstPassVertShaderPath = params.firstRenderPassDrawConstantsVertShaderPath;
+		}
+
+		firstPassPipeline.create(device, shaderLibrary, layoutCache, swapChain.getImageFormat(), findDepthFormat(device), m,
+			true, firstPassVertShaderPath, firstPassFragShaderPath);
+		if (params.asyncPipelineCompilation) {
+			firstPassPipeline.setWorkerPool(&workerPool);
+		}
+		warmUpPipelineVariants();
+
+		// cluster culling for the models with meshlets
+		meshletCulling = m->hasMeshlets() && !params.meshletCullShaderPath.empty();
+		if (meshletCulling) {
+			meshletCullPipeline.create(device, shaderLibrary, layoutCache, descriptorAllocator, m, MAX_FRAMES_IN_FLIGHT, params.meshletCullShaderPath);
+		}
 
 		// framebuffer needs post-processing texture image view
 		createFirstPassResources();
 
 		// second pipeline needs post-processing texture count
-		secondPassPipeline.create(device, swapChain.getImageFormat(), findDepthFormat(device), postProcessingQuad.getModulesOfType<Model>()[0], 0,
+		secondPassPipeline.create(device, shaderLibrary, layoutCache, swapChain.getImageFormat(), findDepthFormat(device),
+			postProcessingQuad.getModulesOfType<Model>()[0], false,
 			params.secondRenderPassVertShaderPath, params.secondRenderPassFragShaderPath);
 		
 		createSecondPassFramebuffers();
 
-		createDescriptorPool();
 		createFirstPassDescriptorSets();
-		createSecondPassDescriptorSets();
+		if (params.descriptorBenchmark) {
+			benchmarkDescriptorBinding(device, commandManager, layoutCache, descriptorAllocator, samplerCache,
+				scene.getModulesOfType<Model>()[0]->getMaterial(), currentFrame);
+		}
+		if (params.drawDataBenchmark) {
+			benchmarkDrawData(device, commandManager, layoutCache, descriptorAllocator, *scene.getModulesOfType<Model>()[0],
+				*scene.activeCamera, currentFrame);
+		}
+		if (params.eventBenchmark) {
+			benchmarkEventDispatch();
+		}
 
 		createSyncObjects();
+
+		if (params.shaderHotReload) {
+			shaderWatcher.create(params.shaderSources, { firstPassVertShaderPath,
+				firstPassFragShaderPath, params.secondRenderPassVertShaderPath,
+				params.secondRenderPassFragShaderPath, params.shadowVertShaderPath }, SHADER_WATCH_INTERVAL);
+		}
+
+		// loaded while the main loop runs
+		if (params.asyncModelCount > 0) {
+			requestAsyncModels(params);
+		}
 	}
 
 
@@ -276,7 +534,7 @@ private:
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "Render Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		appInfo.apiVersion = VK_API_VERSION_1_2;	// descriptor indexing of the bindless textures
 
 		// GET EXTENSIONS
 		auto extensions = getRequiredExtensions();
@@ -425,13 +683,10 @@ private:
 	void recreateRenderImages() {
 
 		VkExtent2D extent = { 0,0 };
-		bool minimized = windowResizedEvent == SDL_EVENT_WINDOW_MINIMIZED;
-		SDL_Event sdl_event;
-		while (minimized || extent.width == 0 || extent.height == 0) {
-			SDL_PollEvent(&sdl_event);
+		// a minimized window waits for its restore event
+		while (windowResizedEvent == SDL_EVENT_WINDOW_MINIMIZED || extent.width == 0 || extent.height == 0) {
+			pollEvents();
 			extent = window.getFramebufferSize();
-			// Restore only counts if the window was minimized
-			minimized = minimized && (sdl_event.type != SDL_EVENT_WINDOW_RESTORED);
 		}
 
 		vkDeviceWaitIdle(device.get());
@@ -444,9 +699,6 @@ private:
 		createFirstPassResources();
 		createSecondPassFramebuffers();
 
-		// Reset descriptor in second pass (they use the destroyed texture)
-		configureSecondPassDescriptorSets();
-
 		// Update camera with aspect ratio
 		camera->updateProjection(swapChain.getExtent());
 	}
@@ -462,14 +714,15 @@ private:
 		Entity* modelEntity = scene.addEntity();
 		Model* model = modelEntity->addModule<Model>();
 		Material modelMaterial;
-		modelMaterial.setContext(device, commandManager);
-		modelMaterial.createTextures(params.texturePaths[0]);
-		model->create(device, commandManager, params.modelPath, modelMaterial);
+		modelMaterial.setContext(device, commandManager, samplerCache, textureManager);
+		modelTexturePaths = params.bakeTextures ? bakeTexturePaths(params.texturePaths[0]) : params.texturePaths[0];
+		modelMaterial.createTextures(modelTexturePaths);
+		model->create(device, commandManager, params.modelPath, modelMaterial, false, params.vertexFormat);
 
 		// POST-PROCESSING QUAD (the texture is set later)
 		Model* postProcessingQuadM = postProcessingQuad.addModule<Model>();
 		Material postProcMaterial;
-		postProcMaterial.setContext(device, commandManager);
+		postProcMaterial.setContext(device, commandManager, samplerCache, textureManager);
 		postProcessingQuadM->create(device, commandManager, POST_PROCESSING_QUAD_PATH, postProcMaterial, true);
 
 
@@ -477,7 +730,22 @@ private:
 		Entity* lightTest2 = scene.addEntity();
 		Light* lightM1 = lightTest->addModule<Light>();
 		Light* lightM2 = lightTest2->addModule<Light>();
+		lightM1->setType(LIGHT_TYPE_DIRECTIONAL);
+		lightM1->getTransform()->changeOrientation(glm::normalize(glm::vec3(0.4f, 0.3f, -1.0f)));
+		lightM2->setCastShadows(true);
+
+		// spot light looking down at the model
+		const BoundingSphere& modelBounds = model->getBounds();
+		Entity* spotEntity = scene.addEntity();
+		spotEntity->transform.position = modelBounds.center + glm::vec3(0.0f, 0.0f, modelBounds.radius * 1.5f);
+		spotEntity->transform.changeOrientation(glm::vec3(0.0f, 0.0f, -1.0f));
+		Light* spotLight = spotEntity->addModule<Light>();
+		spotLight->setType(LIGHT_TYPE_SPOT);
+		spotLight->setRadius(modelBounds.radius * 3.0f);
+		spotLight->setSpotAngle(glm::radians(35.0f));
+		spotLight->setCastShadows(true);
 		lightM2->setColor(glm::vec3(1.0f, 0.0f, 0.0f));
+		addPointLights(params.pointLightCount);
 
 		Entity* cameraEntity = scene.addEntity();
 		cameraEntity->transform.lookAt = -Transform::Y;
@@ -493,6 +761,72 @@ private:
 		addEventSubscriber(SDL_EVENT_MOUSE_MOTION, [this](SDL_Event e) {mouseEventCallback(e); });
 	}
 
+	// Options of the baked textures (uncompressed if the device does not support BC formats)
+	TextureBakeOptions getTextureBakeOptions() const {
+		TextureBakeOptions options;
+		options.compression = device.supportsTextureCompressionBC() ? TEXTURE_COMPRESSION_BC7 : TEXTURE_COMPRESSION_NONE;
+		return options;
+	}
+
+	// Image files of the material (every texture type)
+	std::vector<std::string*> getTexturePaths(TexturePaths& texturePaths) {
+		std::vector<std::string*> paths;
+		if (texturePaths.albedoPath) paths.push_back(&*texturePaths.albedoPath);
+		if (texturePaths.specularPath) paths.push_back(&*texturePaths.specularPath);
+		if (texturePaths.normalPath) paths.push_back(&*texturePaths.normalPath);
+		for (auto& path : texturePaths.customPaths) {
+			paths.push_back(&path);
+		}
+		return paths;
+	}
+
+	// Bake the image files of the material in the worker threads and name their KTX2 files instead
+	TexturePaths bakeTexturePaths(TexturePaths texturePaths) {
+		TextureBakeOptions options = getTextureBakeOptions();
+		std::vector<std::string*> paths = getTexturePaths(texturePaths);
+
+		std::vector<std::exception_ptr> errors(paths.size());
+		workerPool.parallelFor(static_cast<uint32_t>(paths.size()), 1, [&](uint32_t first, uint32_t last) {
+			for (uint32_t i = first; i < last; i++) {
+				try {
+					*paths[i] = bakeTextureFile(*paths[i], options);
+				}
+				catch (...) {
+					errors[i] = std::current_exception();
+				}
+			}
+		});
+		for (const auto& error : errors) {
+			if (error) std::rethrow_exception(error);
+		}
+		return texturePaths;
+	}
+
+
+	// Add random point lights inside the bounds of the model
+	void addPointLights(uint32_t count) {
+		const BoundingSphere& bounds = scene.getModulesOfType<Model>()[0]->getBounds();
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		for (uint32_t i = 0; i < count; i++) {
+			Entity* lightEntity = scene.addEntity();
+			Light* pointLight = lightEntity->addModule<Light>();
+			pointLight->getTransform()->position = bounds.center +
+				glm::vec3(unit(lightRandom), unit(lightRandom), unit(lightRandom)) * bounds.radius;
+			pointLight->setColor(glm::abs(glm::vec3(unit(lightRandom), unit(lightRandom), unit(lightRandom))));
+			pointLight->setRadius(bounds.radius * (0.05f + 0.1f * glm::abs(unit(lightRandom))));
+			pointLight->setCastShadows(pointLights.size() % SHADOWED_POINT_LIGHT_INTERVAL == 0);
+			pointLights.push_back(lightEntity);
+		}
+	}
+
+	// Remove the last point lights added
+	void removePointLights(uint32_t count) {
+		for (uint32_t i = 0; i < count && !pointLights.empty(); i++) {
+			scene.removeEntity(pointLights.back());
+			pointLights.pop_back();
+		}
+	}
+
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// FRAMEBUFFERS AND POST-PROCESSING RESOURCES
@@ -534,15 +868,37 @@ private:
 
 		// DRAWING
 
+		//--------------------------------------------------------
+		// ASSETS AND TEXTURE LEVELS (before every pass that uses them)
+		assetLoader.recordUploads(commandBuffer, currentFrame);
+		if (textureStreaming) {
+			textureStreamer.recordUploads(commandBuffer, currentFrame);
+		}
+
+		//--------------------------------------------------------
+		// SHADOW PASS (the shadow map is always sampled by the first pass)
+		shadowPassPipeline.recordShadows(commandBuffer, currentFrame, scene.getModulesOfType<Model>(), shadowUniforms);
+		shadowPassPipeline.recordAtlasTiles(commandBuffer, scene.getModulesOfType<Model>(), shadowAtlas);
+
+		//--------------------------------------------------------
+		// MESHLET CULLING (only the full resolution level of detail has meshlets)
+		Model* model = scene.getModulesOfType<Model>()[0];
+		bool cullMeshlets = meshletCulling && model->getCurrentLod() == 0;
+		IndirectDraw indirectDraw;
+		if (cullMeshlets) {
+			meshletCullPipeline.recordCulling(commandBuffer, currentFrame, *scene.activeCamera);
+			indirectDraw = meshletCullPipeline.getIndirectDraw(currentFrame);
+		}
+
 		//--------------------------------------------------------
 		// FIRST PASS
 		firstPassPipeline.recordDrawing(commandBuffer, firstPassFramebuffer.get(), swapChain.getExtent(),
-			scene.getModulesOfType<Model>()[0], firstPassDescriptorSet);
+			getFirstPassModels(), firstPassDescriptorSets[currentFrame], cullMeshlets ? &indirectDraw : nullptr);
 
 		//--------------------------------------------------------
 		// SECOND PASS
 		secondPassPipeline.recordDrawing(commandBuffer, secondPassFramebuffers[imageIndex].get(), swapChain.getExtent(),
-			postProcessingQuad.getModulesOfType<Model>()[0], secondPassDescriptorSets[imageIndex]);
+			postProcessingQuad.getModulesOfType<Model>()[0], createSecondPassDescriptorSet());
 
 		//--------------------------------------------------------
 		// FINISH COMMAND
@@ -554,51 +910,42 @@ private:
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	// DESCRIPTOR POOL AND DESCRIPTOR SETS CREATION
+	// DESCRIPTOR SETS CREATION
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-	// TODO: parameterize the pool size
-	void createDescriptorPool() {
-		// Sizes
-		std::array<VkDescriptorPoolSize, 3> poolSizes{};
-		// uniform buffer (for first pass)
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = 3;
-		// sampler (for each pass)
-		poolSizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
-		poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) + 1;
-		// sampler (for each pass)
-		poolSizes[2].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		poolSizes[2].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) + 2;
-
-		// Create info
-		VkDescriptorPoolCreateInfo poolInfo{};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) + 1;
-
-		if (vkCreateDescriptorPool(device.get(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create descriptor pool");
+	void createFirstPassDescriptorSets() {
+		firstPassDescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+		firstPassDescriptorsChanged.assign(MAX_FRAMES_IN_FLIGHT, true);
+		for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) {
+			firstPassDescriptorSets[frame] = firstPassPipeline.allocateDescriptorSet(descriptorAllocator);
+			updateFirstPassDescriptorSet(frame);
 		}
 	}
 
-	void createFirstPassDescriptorSets() {
-		firstPassPipeline.allocateDescriptorSets(descriptorPool, 1, &firstPassDescriptorSet);
-		firstPassPipeline.updateDescriptorSet(modelUniforms, scene.getModulesOfType<Model>()[0]->getMaterial(), lightUniforms, firstPassDescriptorSet);
+	// Write the set of the frame again if it changed (its previous commands are completed)
+	void updateFirstPassDescriptorSet(uint32_t frame) {
+		if (!firstPassDescriptorsChanged[frame]) return;
+		firstPassPipeline.updateDescriptorSet(modelUniforms, scene.getModulesOfType<Model>()[0]->getMaterial(), lightBuffers,
+			shadowUniforms, shadowPassPipeline.getShadowMapInfo(), shadowAtlas, shadowPassPipeline.getShadowAtlasInfo(),
+			firstPassDescriptorSets[frame], frame);
+		firstPassDescriptorsChanged[frame] = false;
 	}
 
-	void createSecondPassDescriptorSets() {
-		secondPassDescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
-		secondPassPipeline.allocateDescriptorSets(descriptorPool, MAX_FRAMES_IN_FLIGHT, secondPassDescriptorSets.data());
-		configureSecondPassDescriptorSets();
+	// Models drawn by the first pass (every model has its matrices and material only with push constants and bindless
+	// textures, otherwise the first one is drawn with the material of the set)
+	std::vector<Model*> getFirstPassModels() {
+		if (drawPushConstants && bindlessTextures) {
+			return scene.getModulesOfType<Model>();
+		}
+		return { scene.getModulesOfType<Model>()[0] };
 	}
 
-	void configureSecondPassDescriptorSets(){
-		// DESCRIPTOR SETS CONFIGURATION
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-			secondPassPipeline.updateDescriptorSet(postProcessingQuad.getModulesOfType<Model>()[0]->getMaterial(), secondPassDescriptorSets[i]);
-		}
+	// Transient set of the frame with the current first pass output (it changes when the render images are recreated)
+	VkDescriptorSet createSecondPassDescriptorSet() {
+		VkDescriptorSet descriptorSet =
+			descriptorAllocator.allocateFrame(currentFrame, secondPassPipeline.getDescriptorSetLayout());
+		secondPassPipeline.updateDescriptorSet(postProcessingQuad.getModulesOfType<Model>()[0]->getMaterial(), descriptorSet);
+		return descriptorSet;
 	}
 
 
@@ -645,6 +992,14 @@ private:
 		auto timeSinceLastUpdate = std::chrono::nanoseconds(0);
 		auto lastTime = std::chrono::high_resolution_clock::now();
 
+		// FRAME STATISTICS (a frame that takes the time of two is a hitch)
+		const auto STATS_INTERVAL = std::chrono::seconds(1);
+		auto timeSinceLastStats = std::chrono::nanoseconds(0);
+		frameProfiler.setHitchThreshold(MIN_TIME_BETWEEN_FRAMES * 2);
+		frameProfiler.reset();
+		loadingProfiler.setHitchThreshold(MIN_TIME_BETWEEN_FRAMES * 2);
+		loadingProfiler.reset();
+
 		while (!window.shouldClose()) {
 
 			// UPDATE TIMES
@@ -652,6 +1007,7 @@ private:
 			auto deltaTime = std::chrono::duration_cast<std::chrono::nanoseconds>(currentTime - lastTime);
 			timeSinceLastFrame += deltaTime;
 			timeSinceLastUpdate += deltaTime;
+			timeSinceLastStats += deltaTime;
 			lastTime = currentTime;
 
 			// GAME LOOP
@@ -667,18 +1023,315 @@ private:
 				}
 
 				// DRAW
+				auto frameStart = std::chrono::high_resolution_clock::now();
 				drawFrame();
+				auto frameTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::high_resolution_clock::now() - frameStart);
+				frameProfiler.addFrame(frameTime);
+				if (asyncLoading) {
+					trackAsyncLoading(frameTime);
+				}
 
 				timeSinceLastFrame -= MIN_TIME_BETWEEN_FRAMES;
 			}
 
-			// CPU IDLE TIME
+			// PRINT STATISTICS
+			if (timeSinceLastStats >= STATS_INTERVAL && frameProfiler.getFrameCount() > 0) {
+				printFrameStats();
+				timeSinceLastStats = std::chrono::nanoseconds(0);
+				frameProfiler.reset();
+				descriptorAllocator.resetAllocationCount();
+				resetEventStats();
+			}
 
+			// CPU IDLE TIME (the OS events are queued as they arrive, and dispatched with the next frame)
+			pumpEvents();
 		}
 
 		vkDeviceWaitIdle(device.get());
 	}
 
+	// Processing of the first model when it was loaded (or read from the mesh cache): levels of detail, vertex cache
+	// optimization, index width, meshlets and packed vertices
+	void printMeshStats() {
+		Model* firstModel = scene.getModulesOfType<Model>()[0];
+		const MeshStats& meshStats = firstModel->getStats();
+		std::cout << "First model: " << firstModel->getVertexCount() << " vertices, LOD triangles:";
+		for (uint32_t lod = 0; lod < firstModel->getLodCount(); lod++) {
+			std::cout << " " << firstModel->getLod(lod).indexCount / 3 << " (error " << firstModel->getLod(lod).error << ")";
+		}
+		if (meshStats.cached) {
+			std::cout << " from the mesh cache";
+		}
+		else {
+			std::cout << " generated in " << meshStats.lodTime << " ms, ACMR " << meshStats.acmrBefore << " -> "
+				<< meshStats.acmrAfter << " and ATVR " << meshStats.atvrBefore << " -> " << meshStats.atvrAfter
+				<< " optimized in " << meshStats.optimizeTime << " ms";
+		}
+		std::cout << ", " << (firstModel->getIndexType() == VK_INDEX_TYPE_UINT16 ? "16" : "32") << " bit indices ("
+			<< meshStats.indexBytes / 1024 << " KB instead of " << meshStats.fullIndexBytes / 1024 << " KB, "
+			<< firstModel->getLod(0).subsetCount << " draws at full resolution)";
+		if (firstModel->hasMeshlets()) {
+			std::cout << ", " << firstModel->getMeshletCount() << " meshlets ("
+				<< static_cast<float>(firstModel->getLod(0).indexCount / 3) / firstModel->getMeshletCount()
+				<< " triangles each";
+			if (!meshStats.cached) std::cout << ", built in " << meshStats.meshletTime << " ms";
+			std::cout << ")";
+		}
+		if (firstModel->getVertexFormat() != VERTEX_FORMAT_FLOAT) {
+			std::cout << ", packed vertices: " << meshStats.vertexBytes / 1024 << " KB instead of "
+				<< meshStats.floatVertexBytes / 1024 << " KB (fetch per draw " << meshStats.vertexFetchBytes / 1024
+				<< " KB instead of " << meshStats.floatVertexFetchBytes / 1024 << " KB, max error: position "
+				<< meshStats.positionError << ", normal " << meshStats.normalError << " degrees, texture coordinates "
+				<< meshStats.texCoordError << ")";
+		}
+		std::cout << std::endl;
+	}
+
+	// CPU time of the frames and hitches, geometry drawn with the selected levels of detail and index subsets, light
+	// assignment to the clusters, shadows and pipeline variants
+	void printFrameStats() {
+		uint32_t triangles = 0;
+		uint32_t draws = 0;
+		std::cout << "Frame time: " << std::chrono::duration<float, std::milli>(frameProfiler.getAverageFrameTime()).count()
+			<< " ms (deviation " << std::chrono::duration<float, std::milli>(frameProfiler.getFrameTimeDeviation()).count()
+			<< " ms, max " << std::chrono::duration<float, std::milli>(frameProfiler.getMaxFrameTime()).count() << " ms, "
+			<< frameProfiler.getHitchCount() << " hitches), LODs:";
+		for (auto* model : scene.getModulesOfType<Model>()) {
+			triangles += model->getIndexCount() / 3;
+			draws += model->getSubsetCount();
+			std::cout << " " << model->getCurrentLod();
+		}
+		std::cout << ", " << triangles << " triangles in " << draws << " draws";
+		if (meshletCulling) {
+			std::cout << ", " << visibleMeshletTriangles << " after meshlet culling";
+		}
+		std::cout << ", " << lightBuffers.getLightCount() << " lights (" << lightBuffers.getUploadedLightCount()
+			<< " written) in " << lightBuffers.getAssignedLightIndexCount() << " cluster slots ("
+			<< lightBuffers.getUpdateTime() << " ms)";
+		if (shadowUniforms.hasShadows()) {
+			std::cout << ", cascades:";
+			for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+				std::cout << " " << shadowPassPipeline.getCascadeTime(i) << " ms ("
+					<< shadowPassPipeline.getCascadeCasterCount(i) << " casters)";
+			}
+		}
+		std::cout << ", shadow atlas: " << shadowAtlas.getOccupancy() * 100.0f << "% in " << shadowAtlas.getAllocatedTileCount()
+			<< " tiles (" << shadowAtlas.getRenderedTileCount() << " rendered, " << shadowAtlas.getCachedTileCount()
+			<< " cached, " << shadowAtlas.getUnshadowedLightCount() << " lights without space, "
+			<< shadowAtlas.getUpdateTime() << " ms)";
+		std::cout << ", " << firstPassPipeline.getVariantCount() << " pipeline variants ("
+			<< firstPassPipeline.getVariantCreationTime() << " ms creating, last "
+			<< firstPassPipeline.getLastVariantCreationTime() << " ms, " << firstPassPipeline.getPendingVariantCount()
+			<< " compiling, " << firstPassPipeline.getFallbackDrawCount() << " fallback draws)";
+		if (frameProfiler.getCompileCount() > 0) {
+			std::cout << ", compile queue latency: " << frameProfiler.getAverageCompileLatency() << " ms (max "
+				<< frameProfiler.getMaxCompileLatency() << " ms)";
+		}
+		if (firstPassPipeline.getShaderReloadCount() > 0) {
+			std::cout << ", " << firstPassPipeline.getShaderReloadCount() << " shader reloads (last "
+				<< firstPassPipeline.getLastShaderReloadTime() << " ms)";
+		}
+		std::cout << ", " << shaderLibrary.getModuleCount() << " shader modules (" << shaderLibrary.getFileLoadCount()
+			<< " files read, " << shaderLibrary.getCacheHitCount() << " cache hits), " << layoutCache.getDescriptorSetLayoutCount()
+			<< " set layouts and " << layoutCache.getPipelineLayoutCount() << " pipeline layouts ("
+			<< layoutCache.getCacheHitCount() << " cache hits)";
+		std::cout << ", descriptor pools: " << descriptorAllocator.getPersistentPoolCount() << " persistent and "
+			<< descriptorAllocator.getFramePoolCount() << " per frame ("
+			<< static_cast<float>(descriptorAllocator.getAllocationCount()) / frameProfiler.getFrameCount()
+			<< " sets allocated per frame)";
+		if (bindlessTextures) {
+			std::cout << ", bindless: " << materialTable.getTextureCount() << " of " << materialTable.getTextureCapacity()
+				<< " textures, " << materialTable.getMaterialCount() << " materials (" << materialTable.getDescriptorWriteCount()
+				<< " descriptor writes)";
+		}
+		std::cout << ", " << samplerCache.getSamplerCount() << " samplers of " << samplerCache.getMaxSamplerCount() << " ("
+			<< samplerCache.getReferenceCount() << " references, " << samplerCache.getCacheHitCount() << " cache hits in "
+			<< samplerCache.getAcquireCount() << " requests)";
+		std::cout << ", textures: " << textureManager.getTextureCount() << " resident ("
+			<< textureManager.getResidentMemory() / (1024.0f * 1024.0f) << " MB, " << textureManager.getUnreferencedTextureCount()
+			<< " unreferenced, " << textureManager.getEvictionCount() << " evicted), hit rate "
+			<< textureManager.getHitRate() * 100.0f << "% of " << textureManager.getRequestCount() << " requests";
+		if (textureStreaming) {
+			std::cout << ", streaming: " << textureStreamer.getResidentSize() / (1024.0f * 1024.0f) << " of "
+				<< textureStreamer.getRequestedSize() / (1024.0f * 1024.0f) << " MB requested resident ("
+				<< textureStreamer.getTextureCount() << " textures, " << textureStreamer.getPendingLevelCount()
+				<< " levels pending, " << textureStreamer.getFailedLevelCount() << " failed, "
+				<< textureStreamer.getLastUploadSize() / 1024.0f << " of "
+				<< textureStreamer.getUploadBudget() / 1024.0f << " KB uploaded last frame), latency "
+				<< textureStreamer.getAverageLatency() << " ms (max " << textureStreamer.getMaxLatency() << " ms)";
+		}
+		if (assetLoader.getPendingCount() > 0) {
+			std::cout << ", loading: " << assetLoader.getPendingCount() << " assets pending ("
+				<< assetLoader.getLastUploadSize() / 1024.0f << " of " << assetLoader.getUploadBudget() / 1024.0f
+				<< " KB uploaded last frame)";
+		}
+		EventStats eventStats = getEventStats();
+		std::cout << ", events: " << eventStats.dispatchedCount << " dispatched (" << eventStats.averageDispatchTime
+			<< " ns each, " << eventStats.overflowCount << " overflowed), input latency " << eventStats.averageLatency
+			<< " ms (max " << eventStats.maxLatency << " ms)";
+		std::cout << ", per draw data: " << (drawPushConstants ? "push constants" : "model uniform buffer");
+		std::cout << std::endl;
+	}
+
+	// Load copies of the model in a grid next to it in the background. The copies share the geometry file and the
+	// textures (already in the texture manager), so each one parses and uploads its own geometry
+	void requestAsyncModels(VulkanAppParams params) {
+		if (!drawPushConstants || !bindlessTextures) {
+			std::cout << "Asynchronous models need draw push constants and bindless textures, not loading them" << std::endl;
+			return;
+		}
+
+		Model* model = scene.getModulesOfType<Model>()[0];
+		BoundingSphere bounds = model->getWorldBounds();
+		uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(params.asyncModelCount))));
+		float spacing = 2.5f * bounds.radius;
+
+		loadingStart = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < params.asyncModelCount; i++) {
+			Transform transform = *model->getTransform();
+			transform.position += glm::vec3((i % side + 1) * spacing, (i / side) * spacing, 0.0f);
+			asyncModels.push_back(assetLoader.loadModel(params.modelPath, modelTexturePaths, transform,
+				params.vertexFormat));
+		}
+		asyncLoading = true;
+	}
+
+	// Frame times while the asynchronous models are loaded (printed once every one of them is ready or failed)
+	void trackAsyncLoading(std::chrono::nanoseconds frameTime) {
+		loadingProfiler.addFrame(frameTime);
+		if (assetLoader.getPendingCount() > 0) return;
+		asyncLoading = false;
+
+		uint32_t readyCount = 0;
+		for (const auto& handle : asyncModels) {
+			if (handle.isReady()) readyCount++;
+		}
+		auto milliseconds = [](std::chrono::nanoseconds time) { return std::chrono::duration<float, std::milli>(time).count(); };
+		std::cout << "Asynchronous loading: " << readyCount << " of " << asyncModels.size() << " models ready in "
+			<< milliseconds(std::chrono::steady_clock::now() - loadingStart) << " ms (" << assetLoader.getFailedCount()
+			<< " failed, load time " << assetLoader.getAverageLoadTime() << " ms, max " << assetLoader.getMaxLoadTime()
+			<< " ms), " << loadingProfiler.getFrameCount() << " frames presented meanwhile: "
+			<< milliseconds(loadingProfiler.getAverageFrameTime()) << " ms (deviation "
+			<< milliseconds(loadingProfiler.getFrameTimeDeviation()) << " ms, max "
+			<< milliseconds(loadingProfiler.getMaxFrameTime()) << " ms, " << loadingProfiler.getHitchCount() << " hitches)"
+			<< std::endl;
+	}
+
+	// Add the materials of the models to the bindless table (the ones already added are skipped). The table is only
+	// written here, before the frames that draw the new models are recorded
+	void addBindlessMaterials() {
+		for (auto* model : scene.getModulesOfType<Model>()) {
+			materialTable.addMaterial(model->getMaterial());
+		}
+	}
+
+	// Clamp the sampling of each material to the first level resident in all its textures. The first pass sets are
+	// written again with the new sampler (bindless materials read it from the table instead)
+	void updateStreamedMaterials() {
+		for (auto* model : scene.getModulesOfType<Model>()) {
+			Material& material = model->getMaterial();
+			uint32_t residentLevel = 0;
+			for (VkImage image : material.getTextureImages()) {
+				residentLevel = std::max(residentLevel, textureStreamer.getResidentLevel(image));
+			}
+			float minLod = static_cast<float>(residentLevel);
+			if (minLod == material.minLod) continue;
+
+			if (bindlessTextures) {
+				material.minLod = minLod;
+				materialTable.updateMaterial(material);
+			}
+			else {
+				material.setMinLod(minLod);
+				firstPassDescriptorsChanged.assign(MAX_FRAMES_IN_FLIGHT, true);
+			}
+		}
+	}
+
+	// Compile the variants the scene can use: the one of each model with both light assignments (switched at runtime)
+	// and the fallback of their vertex layouts
+	void warmUpPipelineVariants() {
+		std::vector<PipelineVariantKey> keys;
+		bool bruteForceLights = firstPassPipeline.getBruteForceLights();
+		for (auto* model : scene.getModulesOfType<Model>()) {
+			for (bool bruteForce : { false, true }) {
+				firstPassPipeline.setBruteForceLights(bruteForce);
+				PipelineVariantKey key = firstPassPipeline.getVariantKey(model);
+				keys.push_back(key);
+				keys.push_back(firstPassPipeline.getFallbackKey(key));
+			}
+		}
+		firstPassPipeline.setBruteForceLights(bruteForceLights);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		firstPassPipeline.warmUp(keys);
+		std::cout << "Pipeline warm-up: " << firstPassPipeline.getVariantCount() << " variants in "
+			<< std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count()
+			<< " ms (" << workerPool.getThreadCount() << " worker threads)" << std::endl;
+	}
+
+	// Rebuild the pipelines that use a changed SPIR-V file: the first pass variants in the background (swapped when
+	// they are ready), the other pipelines now. Files saved with the same code are skipped
+	void reloadChangedShaders() {
+		for (const auto& shader : shaderWatcher.takeChangedShaders()) {
+			try {
+				if (!shaderLibrary.reload(shader)) continue;
+			}
+			catch (const std::exception& e) {
+				std::cerr << "Shader reload failed: " << e.what() << std::endl;
+				continue;
+			}
+			std::cout << "Shader changed: " << shader << std::endl;
+			if (firstPassPipeline.usesShader(shader)) {
+				firstPassPipeline.reloadShaders();
+			}
+
+			for (GraphicsPipeline* pipeline : std::initializer_list<GraphicsPipeline*>{ &secondPassPipeline, &shadowPassPipeline }) {
+				if (!pipeline->usesShader(shader)) continue;
+				vkDeviceWaitIdle(device.get());
+				try {
+					pipeline->reloadShaders();
+				}
+				catch (const std::exception& e) {
+					std::cerr << "Shader reload failed: " << e.what() << std::endl;
+				}
+			}
+		}
+	}
+
+	// First directional light of the scene (nullptr if there is none)
+	Light* findDirectionalLight() {
+		for (auto* light : scene.getModulesOfType<Light>()) {
+			if (light->getType() == LIGHT_TYPE_DIRECTIONAL) return light;
+		}
+		return nullptr;
+	}
+
+	// World space bounding sphere enclosing every model (the cascades must include all the casters)
+	BoundingSphere getCasterBounds() {
+		std::vector<Model*> models = scene.getModulesOfType<Model>();
+		BoundingSphere casterBounds{};
+		for (size_t i = 0; i < models.size(); i++) {
+			BoundingSphere bounds = models[i]->getWorldBounds();
+			if (i == 0) {
+				casterBounds = bounds;
+				continue;
+			}
+			// grow the sphere to enclose the new one
+			float distance = glm::length(bounds.center - casterBounds.center);
+			if (distance + bounds.radius <= casterBounds.radius) continue;
+			if (distance + casterBounds.radius <= bounds.radius) {
+				casterBounds = bounds;
+				continue;
+			}
+			float newRadius = (distance + casterBounds.radius + bounds.radius) * 0.5f;
+			casterBounds.center += (bounds.center - casterBounds.center) * ((newRadius - casterBounds.radius) / distance);
+			casterBounds.radius = newRadius;
+		}
+		return casterBounds;
+	}
+
 	void updateWorld() {
 		AppTime::updateDeltaTime();
 
@@ -689,6 +1342,18 @@ private:
 	void keyboardEventCallback(SDL_Event event) {
 		// TODO: create an interface to handle all keyboard event reactions
 		camera->keyboardReaction(event);
+
+		// add and remove point lights (the light buffers grow without rebuilding the pipeline)
+		if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_EQUALS) {
+			addPointLights(POINT_LIGHT_STEP);
+		}
+		else if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_MINUS) {
+			removePointLights(POINT_LIGHT_STEP);
+		}
+		// switch between the clustered and the brute force lighting (another pipeline variant)
+		else if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_B) {
+			firstPassPipeline.setBruteForceLights(!firstPassPipeline.getBruteForceLights());
+		}
 	}
 
 	void mouseEventCallback(SDL_Event event) {
@@ -708,6 +1373,18 @@ private:
 		// WAIT FOR THE PREVIOUS FRAME TO FINISH
 		vkWaitForFences(device.get(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
 
+		// transient descriptor sets of the completed frame
+		descriptorAllocator.resetFrame(currentFrame);
+
+		// results of the previous culling with this frame resources
+		if (meshletCulling) {
+			visibleMeshletTriangles = meshletCullPipeline.getVisibleTriangleCount(currentFrame);
+		}
+		shadowPassPipeline.readCascadeTimes(currentFrame);
+
+		// models and materials uploaded by the completed frame (drawn from this frame)
+		assetLoader.update(currentFrame);
+
 		//---------------------------------------
 		// ACQUIRE AN IMAGE FROM THE SWAP CHAIN
 		uint32_t imageIndex;
@@ -723,10 +1400,49 @@ private:
 			throw std::runtime_error("failed to acquire swap chain image");
 		}
 
+		// SELECT LEVELS OF DETAIL
+		for (auto* model : scene.getModulesOfType<Model>()) {
+			model->selectLod(*scene.activeCamera, swapChain.getExtent(), LOD_PIXEL_THRESHOLD);
+		}
+
+		// MATERIALS OF THE COMPLETED MODELS (drawn from this frame on)
+		if (bindlessTextures && assetLoader.wereAssetsCompleted()) {
+			addBindlessMaterials();
+		}
+
+		// STREAM TEXTURE LEVELS (of the drawn models, the uploads of this frame resources are completed)
+		if (textureStreaming) {
+			for (auto* model : getFirstPassModels()) {
+				float screenSize = model->getScreenSize(*scene.activeCamera, swapChain.getExtent());
+				for (VkImage image : model->getMaterial().getTextureImages()) {
+					textureStreamer.requestScreenSize(image, screenSize);
+				}
+			}
+			textureStreamer.update(currentFrame);
+			if (textureStreamer.wereLevelsChanged() || assetLoader.wereAssetsCompleted()) {
+				updateStreamedMaterials();
+			}
+		}
+
 		// UPDATE UNIFORMS
-		modelUniforms.upateBuffer(0, *scene.getModulesOfType<Model>()[0], *scene.activeCamera);
-		std::vector<Light> lightVec = {*scene.getModulesOfType<Light>()[0], *scene.getModulesOfType<Light>()[1] };
-		lightUniforms.upateBuffer(0, lightVec, *scene.getModulesOfType<Camera>()[0]);
+		if (drawPushConstants) {
+			cameraUniforms.updateBuffer(currentFrame, *scene.activeCamera);
+		}
+		else {
+			modelUniforms.upateBuffer(0, *scene.getModulesOfType<Model>()[0], *scene.activeCamera);
+		}
+		std::vector<Light*> lights = scene.getModulesOfType<Light>();
+		shadowAtlas.updateAtlas(currentFrame, lights, scene.getModulesOfType<Model>(), *scene.activeCamera, swapChain.getExtent());
+		lightBuffers.updateBuffers(currentFrame, lights, *scene.activeCamera, swapChain.getExtent(), &shadowAtlas);
+		if (lightBuffers.wereBuffersRecreated()) {
+			firstPassDescriptorsChanged.assign(MAX_FRAMES_IN_FLIGHT, true);
+		}
+		updateFirstPassDescriptorSet(currentFrame);
+		shadowUniforms.updateBuffer(currentFrame, findDirectionalLight(), *scene.activeCamera, getCasterBounds());
+
+		// pipelines of the changed shaders and variants compiled in the background since the last frame
+		reloadChangedShaders();
+		firstPassPipeline.collectCompiledVariants(frameProfiler);
 
 		vkResetFences(device.get(), 1, &inFlightFences[currentFrame]);
 
@@ -804,12 +1520,27 @@ private:
 			model->cleanup();
 		}
 
+		// Assets still loading and the loaded materials (no worker thread uses them after this)
+		assetLoader.cleanup();
+
+		// Textures (after the materials that release them, no level can be read meanwhile)
+		if (textureStreaming) {
+			textureStreamer.cleanup();
+		}
+		textureManager.cleanup();
+
 		// Uniform
 		modelUniforms.cleanup();
-		lightUniforms.cleanup();
+		cameraUniforms.cleanup();
+		lightBuffers.cleanup();
+		shadowUniforms.cleanup();
+		shadowAtlas.cleanup();
+		if (bindlessTextures) {
+			materialTable.cleanup();
+		}
 
-		// Descriptor pool and set layout
-		vkDestroyDescriptorPool(device.get(), descriptorPool, nullptr);
+		// Descriptor pools
+		descriptorAllocator.cleanup();
 
 		// Sync objects
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
@@ -821,9 +1552,18 @@ private:
 		// Command pool
 		commandManager.cleanup();
 
-		// Pipeline
+		// Pipeline (no variant can be compiling)
+		shaderWatcher.cleanup();
+		workerPool.cleanup();
 		firstPassPipeline.cleanup();
+		shadowPassPipeline.cleanup();
+		if (meshletCulling) {
+			meshletCullPipeline.cleanup();
+		}
 		secondPassPipeline.cleanup();
+		shaderLibrary.cleanup();
+		layoutCache.cleanup();
+		samplerCache.cleanup();
 
 		// Device
 		device.cleanup();
@@ -834,6 +1574,7 @@ private:
 		vkDestroySurfaceKHR(instance, surface, nullptr);
 		vkDestroyInstance(instance, nullptr);
 
+		stopEventQueue();
 		window.cleanup();
 
 		SDL_Quit();
@@ -0,0 +1,83 @@
+#include "render/image/SamplerCache.hpp"
+
+#include <stdexcept>
+
+
+SamplerKey::SamplerKey(const VkSamplerCreateInfo& info) {
+	flags = info.flags;
+	magFilter = info.magFilter;
+	minFilter = info.minFilter;
+	mipmapMode = info.mipmapMode;
+	addressModeU = info.addressModeU;
+	addressModeV = info.addressModeV;
+	addressModeW = info.addressModeW;
+	mipLodBias = info.mipLodBias;
+	anisotropyEnable = info.anisotropyEnable;
+	// the ignored values do not create another sampler
+	maxAnisotropy = info.anisotropyEnable ? info.maxAnisotropy : 1.0f;
+	compareEnable = info.compareEnable;
+	compareOp = info.compareEnable ? info.compareOp : VK_COMPARE_OP_NEVER;
+	minLod = info.minLod;
+	maxLod = info.maxLod;
+	borderColor = info.borderColor;
+	unnormalizedCoordinates = info.unnormalizedCoordinates;
+}
+
+uint32_t SamplerCache::getReferenceCount() const {
+	uint32_t count = 0;
+	for (const auto& cached : samplers) {
+		count += cached.second.referenceCount;
+	}
+	return count;
+}
+
+void SamplerCache::create(Device device) {
+	this->device = device;
+	maxSamplerCount = device.getPhysicalDeviceProperties().limits.maxSamplerAllocationCount;
+}
+
+VkSampler SamplerCache::acquire(const VkSamplerCreateInfo& samplerInfo) {
+	acquireCount++;
+
+	SamplerKey key(samplerInfo);
+	auto found = samplers.find(key);
+	if (found != samplers.end()) {
+		cacheHitCount++;
+		found->second.referenceCount++;
+		return found->second.sampler;
+	}
+
+	if (samplers.size() >= maxSamplerCount) {
+		throw std::runtime_error("sampler allocation limit reached");
+	}
+
+	VkSampler sampler;
+	if (vkCreateSampler(device.get(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create sampler");
+	}
+	samplers.emplace(key, CachedSampler{ sampler, 1 });
+	samplerKeys.emplace(sampler, key);
+	return sampler;
+}
+
+void SamplerCache::release(VkSampler sampler) {
+	auto key = samplerKeys.find(sampler);
+	if (key == samplerKeys.end()) {
+		throw std::runtime_error("released sampler is not in the cache");
+	}
+
+	auto cached = samplers.find(key->second);
+	if (--cached->second.referenceCount > 0) return;
+
+	vkDestroySampler(device.get(), sampler, nullptr);
+	samplers.erase(cached);
+	samplerKeys.erase(key);
+}
+
+void SamplerCache::cleanup() {
+	for (auto& cached : samplers) {
+		vkDestroySampler(device.get(), cached.second.sampler, nullptr);
+	}
+	samplers.clear();
+	samplerKeys.clear();
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include "context/Device.hpp"
+
+
+// State of a sampler create info (the extension chain is not part of the key)
+struct SamplerKey {
+	VkSamplerCreateFlags flags = 0;
+	VkFilter magFilter = VK_FILTER_NEAREST;
+	VkFilter minFilter = VK_FILTER_NEAREST;
+	VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	VkSamplerAddressMode addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	VkSamplerAddressMode addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	VkSamplerAddressMode addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	float mipLodBias = 0.0f;
+	VkBool32 anisotropyEnable = VK_FALSE;
+	float maxAnisotropy = 1.0f;
+	VkBool32 compareEnable = VK_FALSE;
+	VkCompareOp compareOp = VK_COMPARE_OP_NEVER;
+	float minLod = 0.0f;
+	float maxLod = 0.0f;
+	VkBorderColor borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+	VkBool32 unnormalizedCoordinates = VK_FALSE;
+
+	SamplerKey() = default;
+	explicit SamplerKey(const VkSamplerCreateInfo& info);
+
+	bool operator==(const SamplerKey& other) const {
+		return flags == other.flags && magFilter == other.magFilter && minFilter == other.minFilter &&
+			mipmapMode == other.mipmapMode && addressModeU == other.addressModeU &&
+			addressModeV == other.addressModeV && addressModeW == other.addressModeW &&
+			mipLodBias == other.mipLodBias && anisotropyEnable == other.anisotropyEnable &&
+			maxAnisotropy == other.maxAnisotropy && compareEnable == other.compareEnable &&
+			compareOp == other.compareOp && minLod == other.minLod && maxLod == other.maxLod &&
+			borderColor == other.borderColor && unnormalizedCoordinates == other.unnormalizedCoordinates;
+	}
+};
+
+
+namespace std {
+	template<> struct hash<SamplerKey> {
+		size_t operator()(SamplerKey const& key) const {
+			size_t seed = hash<uint32_t>()(key.flags);
+			auto combine = [&seed](size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+			combine(hash<uint32_t>()(key.magFilter));
+			combine(hash<uint32_t>()(key.minFilter));
+			combine(hash<uint32_t>()(key.mipmapMode));
+			combine(hash<uint32_t>()(key.addressModeU));
+			combine(hash<uint32_t>()(key.addressModeV));
+			combine(hash<uint32_t>()(key.addressModeW));
+			combine(hash<float>()(key.mipLodBias));
+			combine(hash<uint32_t>()(key.anisotropyEnable));
+			combine(hash<float>()(key.maxAnisotropy));
+			combine(hash<uint32_t>()(key.compareEnable));
+			combine(hash<uint32_t>()(key.compareOp));
+			combine(hash<float>()(key.minLod));
+			combine(hash<float>()(key.maxLod));
+			combine(hash<uint32_t>()(key.borderColor));
+			combine(hash<uint32_t>()(key.unnormalizedCoordinates));
+			return seed;
+		}
+	};
+}
+
+
+// Samplers shared by every owner with the same create info. Each acquire adds a reference to the sampler and it is
+// destroyed when the last one is released, so the materials use a few samplers instead of one each (used from the main
+// thread)
+class SamplerCache {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	// Statistics (the acquires are counted since creation)
+	uint32_t getSamplerCount() const { return static_cast<uint32_t>(samplers.size()); }
+	uint32_t getReferenceCount() const;
+	uint32_t getAcquireCount() const { return acquireCount; }
+	uint32_t getCacheHitCount() const { return cacheHitCount; }
+	uint32_t getMaxSamplerCount() const { return maxSamplerCount; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	void create(Device device);
+
+	// Sampler with the create info (created the first time it is requested, throw if the device limit is reached)
+	VkSampler acquire(const VkSamplerCreateInfo& samplerInfo);
+
+	// Release a reference of the sampler (destroyed with the last one)
+	void release(VkSampler sampler);
+
+	// Destroy the samplers that are still referenced
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	Device device;
+
+	struct CachedSampler {
+		VkSampler sampler;
+		uint32_t referenceCount;
+	};
+	std::unordered_map<SamplerKey, CachedSampler> samplers;
+	std::unordered_map<VkSampler, SamplerKey> samplerKeys;
+
+	uint32_t maxSamplerCount = 0;
+	uint32_t acquireCount = 0;
+	uint32_t cacheHitCount = 0;
+};
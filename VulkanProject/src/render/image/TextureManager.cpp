@@ -0,0 +1,454 @@
+#include "render/image/TextureManager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+
+#include "asset/blockCompression.hpp"
+#include "asset/imageLoader.hpp"
+
+
+namespace {
+
+	// Offset alignment of the images in the staging buffer (multiple of the texel and compressed block sizes)
+	const VkDeviceSize STAGING_ALIGNMENT = 16;
+	// Staging memory of a batch (a bigger image is uploaded alone)
+	const VkDeviceSize MAX_STAGING_SIZE = 256 * 1024 * 1024;
+
+	// Size of the aligned region of a texture in the staging buffer
+	VkDeviceSize alignStagingSize(VkDeviceSize size) {
+		return (size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+	}
+
+	// The same file named with other relative paths is the same texture
+	std::string canonicalPath(const std::string& path) {
+		std::error_code error;
+		std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+		return error ? path : canonical.string();
+	}
+}
+
+
+void TextureManager::create(Device device, CommandManager commandManager, VkDeviceSize memoryBudget) {
+	this->device = device;
+	this->commandManager = commandManager;
+	this->memoryBudget = memoryBudget;
+}
+
+Texture TextureManager::acquire(const std::string& path, const TextureOptions& options) {
+	return acquire(std::vector<std::string>{ path }, options)[0];
+}
+
+std::vector<Texture> TextureManager::acquire(const std::vector<std::string>& paths, const TextureOptions& options) {
+	std::vector<TextureKey> keys;
+	std::vector<TextureKey> missingKeys;
+	for (const auto& path : paths) {
+		TextureKey key{ canonicalPath(path), options.format, options.generateMipmaps };
+		keys.push_back(key);
+		if (textures.find(key) == textures.end() &&
+			std::find(missingKeys.begin(), missingKeys.end(), key) == missingKeys.end()) {
+			missingKeys.push_back(key);
+		}
+	}
+
+	return acquireKeys(keys, missingKeys, loadTextures(missingKeys));
+}
+
+std::vector<Texture> TextureManager::acquireKeys(const std::vector<TextureKey>& keys,
+	const std::vector<TextureKey>& loadedKeys, const std::vector<Texture>& loadedTextures) {
+
+	// the new textures start without references (they are counted with the others)
+	for (size_t i = 0; i < loadedKeys.size(); i++) {
+		CachedTexture cached;
+		cached.texture = loadedTextures[i];
+		residentMemory += cached.texture.memorySize;
+		textureKeys.emplace(cached.texture.image.image, loadedKeys[i]);
+		textures.emplace(loadedKeys[i], cached);
+	}
+
+	std::vector<Texture> acquired;
+	for (const auto& key : keys) {
+		requestCount++;
+		CachedTexture& cached = textures.at(key);
+		bool loaded = std::find(loadedKeys.begin(), loadedKeys.end(), key) != loadedKeys.end();
+
+		// the repeated requests of a texture loaded now are hits
+		if (!loaded || cached.referenceCount > 0) cacheHitCount++;
+		if (!loaded && cached.referenceCount == 0) unreferencedTextures.erase(cached.unreferencedPosition);
+		cached.referenceCount++;
+		acquired.push_back(cached.texture);
+	}
+
+	// the new textures may need the space of the unreferenced ones
+	evict();
+	return acquired;
+}
+
+std::shared_ptr<TextureManager::TextureUpload> TextureManager::createUpload(const std::vector<std::string>& paths,
+	const TextureOptions& options) {
+
+	auto upload = std::make_shared<TextureUpload>();
+	for (const auto& path : paths) {
+		TextureKey key{ canonicalPath(path), options.format, options.generateMipmaps };
+		upload->keys.push_back(key);
+		if (std::find(upload->cachedKeys.begin(), upload->cachedKeys.end(), key) != upload->cachedKeys.end() ||
+			std::find(upload->loadedKeys.begin(), upload->loadedKeys.end(), key) != upload->loadedKeys.end()) {
+			continue;
+		}
+
+		// a cached texture cannot be evicted while the upload is in progress
+		auto cached = textures.find(key);
+		if (cached == textures.end()) {
+			upload->loadedKeys.push_back(key);
+			continue;
+		}
+		if (cached->second.referenceCount == 0) unreferencedTextures.erase(cached->second.unreferencedPosition);
+		cached->second.referenceCount++;
+		upload->cachedKeys.push_back(key);
+	}
+	return upload;
+}
+
+void TextureManager::decodeUpload(TextureUpload& upload) {
+	//-----------------------------------------
+	// STAGING BUFFER (a region per image)
+	for (const auto& key : upload.loadedKeys) {
+		upload.pendingTextures.push_back(readTextureInfo(key));
+		upload.offsets.push_back(upload.stagingSize);
+		upload.stagingSize += upload.pendingTextures.back().stagingSize;
+	}
+	if (upload.stagingSize == 0) return;
+
+	device.createBuffer(upload.stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		upload.stagingBuffer, upload.stagingBufferMemory);
+
+	void* data;
+	vkMapMemory(device.get(), upload.stagingBufferMemory, 0, upload.stagingSize, 0, &data);
+
+	//-----------------------------------------
+	// DECODE (in the calling thread, the uploads are decoded in parallel)
+	try {
+		for (size_t i = 0; i < upload.loadedKeys.size(); i++) {
+			decodeTexture(upload.loadedKeys[i], upload.pendingTextures[i], static_cast<uint8_t*>(data) + upload.offsets[i]);
+		}
+	}
+	catch (...) {
+		vkUnmapMemory(device.get(), upload.stagingBufferMemory);
+		throw;
+	}
+	vkUnmapMemory(device.get(), upload.stagingBufferMemory);
+}
+
+VkDeviceSize TextureManager::getUploadSize(const TextureUpload& upload) const {
+	return upload.stagingSize;
+}
+
+void TextureManager::recordUpload(VkCommandBuffer commandBuffer, TextureUpload& upload) {
+	recordTextureUploads(commandBuffer, upload.loadedKeys, upload.pendingTextures, upload.stagingBuffer, upload.offsets,
+		0, upload.loadedKeys.size());
+	upload.recorded = true;
+}
+
+std::vector<Texture> TextureManager::acquire(TextureUpload& upload) {
+	if (!upload.recorded) {
+		throw std::runtime_error("texture upload acquired before it was recorded");
+	}
+	finishTextures(upload.loadedKeys, upload.pendingTextures, 0, upload.loadedKeys.size());
+
+	// the textures loaded by other requests while this one was decoded are kept
+	std::vector<TextureKey> loadedKeys;
+	std::vector<Texture> loadedTextures;
+	for (size_t i = 0; i < upload.loadedKeys.size(); i++) {
+		Texture& texture = upload.pendingTextures[i].texture;
+		if (textures.find(upload.loadedKeys[i]) != textures.end()) {
+			if (streamer != nullptr) streamer->removeTexture(texture.image.image);
+			texture.image.ownedImage = true;
+			destroyImageObjects(device, texture.image);
+			continue;
+		}
+		loadedKeys.push_back(upload.loadedKeys[i]);
+		loadedTextures.push_back(texture);
+	}
+	upload.pendingTextures.clear();
+
+	// the references of each path are taken before the ones of the upload are dropped
+	std::vector<Texture> acquired = acquireKeys(upload.keys, loadedKeys, loadedTextures);
+	cancelUpload(upload);
+	return acquired;
+}
+
+void TextureManager::cancelUpload(TextureUpload& upload) {
+	for (auto& pending : upload.pendingTextures) {
+		destroyImageObjects(device, pending.texture.image);
+	}
+	upload.pendingTextures.clear();
+
+	if (upload.stagingBuffer != VK_NULL_HANDLE) {
+		vkDestroyBuffer(device.get(), upload.stagingBuffer, nullptr);
+		vkFreeMemory(device.get(), upload.stagingBufferMemory, nullptr);
+		upload.stagingBuffer = VK_NULL_HANDLE;
+		upload.stagingBufferMemory = VK_NULL_HANDLE;
+	}
+
+	for (const auto& key : upload.cachedKeys) {
+		release(textures.at(key).texture.image.image);
+	}
+	upload.cachedKeys.clear();
+}
+
+void TextureManager::release(VkImage image) {
+	auto found = textureKeys.find(image);
+	if (found == textureKeys.end()) {
+		throw std::runtime_error("released texture is not in the texture manager");
+	}
+	TextureKey key = found->second;
+
+	CachedTexture& cached = textures.at(key);
+	if (--cached.referenceCount > 0) return;
+
+	if (memoryBudget == 0) {
+		destroyTexture(key);
+		return;
+	}
+	cached.unreferencedPosition = unreferencedTextures.insert(unreferencedTextures.end(), key);
+	evict();
+}
+
+void TextureManager::evict() {
+	while (residentMemory > memoryBudget && !unreferencedTextures.empty()) {
+		TextureKey key = unreferencedTextures.front();
+		unreferencedTextures.pop_front();
+		destroyTexture(key);
+		evictionCount++;
+	}
+}
+
+void TextureManager::destroyTexture(const TextureKey& key) {
+	auto cached = textures.find(key);
+	Texture& texture = cached->second.texture;
+	residentMemory -= texture.memorySize;
+	textureKeys.erase(texture.image.image);
+	if (streamer != nullptr) streamer->removeTexture(texture.image.image);
+
+	texture.image.ownedImage = true;
+	destroyImageObjects(device, texture.image);
+	textures.erase(cached);
+}
+
+std::vector<Texture> TextureManager::loadTextures(const std::vector<TextureKey>& keys) {
+	//-----------------------------------------
+	// READ THE IMAGE SIZES (and the levels of the KTX2 files)
+	std::vector<PendingTexture> pendingTextures;
+	for (const auto& key : keys) {
+		pendingTextures.push_back(readTextureInfo(key));
+	}
+
+	//-----------------------------------------
+	// LOAD THEM IN BATCHES THAT FIT IN THE STAGING BUFFER (at least one image each)
+	size_t first = 0;
+	while (first < keys.size()) {
+		size_t last = first + 1;
+		VkDeviceSize stagingSize = pendingTextures[first].stagingSize;
+		while (last < keys.size() && stagingSize + pendingTextures[last].stagingSize <= MAX_STAGING_SIZE) {
+			stagingSize += pendingTextures[last].stagingSize;
+			last++;
+		}
+		loadBatch(keys, pendingTextures, first, last);
+		first = last;
+	}
+
+	std::vector<Texture> loadedTextures;
+	for (const auto& pending : pendingTextures) {
+		loadedTextures.push_back(pending.texture);
+	}
+	return loadedTextures;
+}
+
+TextureManager::PendingTexture TextureManager::readTextureInfo(const TextureKey& key) const {
+	PendingTexture pending;
+	Texture& texture = pending.texture;
+	pending.ktx = std::filesystem::path(key.path).extension() == ".ktx2";
+
+	if (pending.ktx) {
+		pending.ktxInfo = readKtxInfo(key.path);
+		if (isBlockCompressedFormat(pending.ktxInfo.format) && !device.supportsTextureCompressionBC()) {
+			throw std::runtime_error("compressed texture format is not supported by the device");
+		}
+		texture.format = pending.ktxInfo.format;
+		texture.width = pending.ktxInfo.width;
+		texture.height = pending.ktxInfo.height;
+		texture.mipLevels = pending.ktxInfo.levelCount;
+		pending.firstLevel = streamer != nullptr ? streamer->getTailLevel(pending.ktxInfo) : 0;
+		pending.stagingSize = alignStagingSize(pending.ktxInfo.dataSize - pending.ktxInfo.dataOffsets[pending.firstLevel]);
+		return pending;
+	}
+
+	RawImage info = loadImageInfo(key.path);
+	texture.format = key.format;
+	texture.width = static_cast<uint32_t>(info.width);
+	texture.height = static_cast<uint32_t>(info.height);
+	texture.mipLevels = key.generateMipmaps ?
+		static_cast<uint32_t>(std::floor(std::log2(std::max(info.width, info.height)))) + 1 : 1;
+	pending.stagingSize = alignStagingSize(static_cast<VkDeviceSize>(texture.width) * texture.height * 4);
+	return pending;
+}
+
+void TextureManager::decodeTexture(const TextureKey& key, const PendingTexture& pending, uint8_t* destination) const {
+	if (pending.ktx) {
+		readKtxLevels(key.path, pending.ktxInfo, destination, pending.firstLevel);
+	}
+	else {
+		loadImageFromFile(key.path, destination, static_cast<size_t>(pending.texture.width) * pending.texture.height * 4);
+	}
+}
+
+void TextureManager::loadBatch(const std::vector<TextureKey>& keys, std::vector<PendingTexture>& pendingTextures,
+	size_t first, size_t last) {
+
+	//-----------------------------------------
+	// STAGING BUFFER (a region per image)
+	std::vector<VkDeviceSize> offsets(keys.size());
+	VkDeviceSize stagingSize = 0;
+	for (size_t i = first; i < last; i++) {
+		offsets[i] = stagingSize;
+		stagingSize += pendingTextures[i].stagingSize;
+	}
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	device.createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer, stagingBufferMemory);
+
+	void* data;
+	vkMapMemory(device.get(), stagingBufferMemory, 0, stagingSize, 0, &data);
+	uint8_t* stagingData = static_cast<uint8_t*>(data);
+
+	//-----------------------------------------
+	// DECODE IN PARALLEL (each task writes its own region and error, and only these tasks are waited for)
+	std::vector<std::exception_ptr> errors(keys.size());
+	JobCounter decoded;
+	for (size_t i = first; i < last; i++) {
+		WorkerTask decode = [&, i]() {
+			try {
+				decodeTexture(keys[i], pendingTextures[i], stagingData + offsets[i]);
+			}
+			catch (...) {
+				errors[i] = std::current_exception();
+			}
+		};
+		if (workerPool != nullptr) workerPool->submit(decode, &decoded);
+		else decode();
+	}
+	if (workerPool != nullptr) workerPool->wait(decoded);
+	vkUnmapMemory(device.get(), stagingBufferMemory);
+
+	for (const auto& error : errors) {
+		if (!error) continue;
+		vkDestroyBuffer(device.get(), stagingBuffer, nullptr);
+		vkFreeMemory(device.get(), stagingBufferMemory, nullptr);
+		std::rethrow_exception(error);
+	}
+
+	//-----------------------------------------
+	// UPLOAD ALL OF THEM AND GENERATE THEIR MIPMAPS (a single submission)
+	VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
+	recordTextureUploads(commandBuffer, keys, pendingTextures, stagingBuffer, offsets, first, last);
+	commandManager.endSingleTimeCommands(commandBuffer);
+
+	//-----------------------------------------
+	// CLEAN UP STAGING STUFF
+	vkDestroyBuffer(device.get(), stagingBuffer, nullptr);
+	vkFreeMemory(device.get(), stagingBufferMemory, nullptr);
+
+	finishTextures(keys, pendingTextures, first, last);
+}
+
+void TextureManager::recordTextureUploads(VkCommandBuffer commandBuffer, const std::vector<TextureKey>& keys,
+	std::vector<PendingTexture>& pendingTextures, VkBuffer stagingBuffer, const std::vector<VkDeviceSize>& offsets,
+	size_t first, size_t last) {
+
+	//-----------------------------------------
+	// CREATE THE IMAGES
+	for (size_t i = first; i < last; i++) {
+		Texture& texture = pendingTextures[i].texture;
+		createImage(device, texture.width, texture.height, texture.mipLevels, VK_SAMPLE_COUNT_1_BIT,
+			texture.format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			texture.image.image, texture.image.memory);
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(device.get(), texture.image.image, &memoryRequirements);
+		texture.memorySize = memoryRequirements.size;
+	}
+
+	//-----------------------------------------
+	// UPLOAD THEM AND GENERATE THEIR MIPMAPS
+	for (size_t i = first; i < last; i++) {
+		const PendingTexture& pending = pendingTextures[i];
+		const Texture& texture = pending.texture;
+		recordTransitionImageLayout(commandBuffer, texture.image.image, texture.format, VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, texture.mipLevels);
+
+		// every baked level in a copy (the finer levels than the tail of a streamed texture are not sampled yet)
+		if (pending.ktx) {
+			std::vector<VkDeviceSize> levelOffsets;
+			for (uint32_t level = pending.firstLevel; level < texture.mipLevels; level++) {
+				levelOffsets.push_back(offsets[i] + pending.ktxInfo.dataOffsets[level] -
+					pending.ktxInfo.dataOffsets[pending.firstLevel]);
+			}
+			recordCopyBufferToMipLevels(commandBuffer, stagingBuffer, texture.image.image, texture.width,
+				texture.height, levelOffsets, pending.firstLevel);
+			recordTransitionImageLayout(commandBuffer, texture.image.image, texture.format,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texture.mipLevels);
+			continue;
+		}
+
+		recordCopyBufferToImage(commandBuffer, stagingBuffer, texture.image.image, texture.width, texture.height,
+			offsets[i]);
+
+		// transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		if (keys[i].generateMipmaps) {
+			recordMipmapGeneration(device, commandBuffer, texture.image.image, texture.format, texture.width,
+				texture.height, texture.mipLevels);
+		}
+		else {
+			recordTransitionImageLayout(commandBuffer, texture.image.image, texture.format,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+		}
+	}
+}
+
+void TextureManager::finishTextures(const std::vector<TextureKey>& keys, std::vector<PendingTexture>& pendingTextures,
+	size_t first, size_t last) {
+
+	for (size_t i = first; i < last; i++) {
+		Texture& texture = pendingTextures[i].texture;
+		texture.image.view = createImageView(device, texture.image.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT,
+			texture.mipLevels);
+
+		// released through the manager
+		texture.image.ownedImage = false;
+
+		if (streamer != nullptr && pendingTextures[i].ktx) {
+			streamer->addTexture(texture.image.image, keys[i].path, pendingTextures[i].ktxInfo,
+				pendingTextures[i].firstLevel);
+		}
+	}
+}
+
+void TextureManager::cleanup() {
+	for (auto& cached : textures) {
+		if (streamer != nullptr) streamer->removeTexture(cached.second.texture.image.image);
+		cached.second.texture.image.ownedImage = true;
+		destroyImageObjects(device, cached.second.texture.image);
+	}
+	textures.clear();
+	textureKeys.clear();
+	unreferencedTextures.clear();
+	residentMemory = 0;
+}
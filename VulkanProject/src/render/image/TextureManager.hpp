@@ -0,0 +1,220 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "context/Device.hpp"
+#include "context/CommandManager.hpp"
+#include "asset/ktxFile.hpp"
+#include "render/image/imageUtils.hpp"
+#include "render/image/TextureStreamer.hpp"
+#include "system/WorkerPool.hpp"
+
+
+// How the image file is uploaded (the same file with other options is another texture). KTX2 files keep the format and
+// mip levels that they were baked with
+struct TextureOptions {
+	VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+	bool generateMipmaps = true;
+};
+
+// Canonical path of the file and its upload options
+struct TextureKey {
+	std::string path;
+	VkFormat format;
+	bool generateMipmaps;
+
+	bool operator==(const TextureKey& other) const {
+		return path == other.path && format == other.format && generateMipmaps == other.generateMipmaps;
+	}
+};
+
+namespace std {
+	template<> struct hash<TextureKey> {
+		size_t operator()(TextureKey const& key) const {
+			size_t seed = hash<string>()(key.path);
+			auto combine = [&seed](size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+			combine(hash<uint32_t>()(key.format));
+			combine(hash<bool>()(key.generateMipmaps));
+			return seed;
+		}
+	};
+}
+
+// Shared texture (the image objects are not owned: they are released through the manager)
+struct Texture {
+	ImageObjects image;
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipLevels = 1;
+	VkDeviceSize memorySize = 0;
+};
+
+
+// Textures loaded once per file and options and shared by every material that names them. Each acquire adds a
+// reference and the texture is freed with the last release, or kept while it fits in the memory budget (if there is
+// one) and evicted in least recently released order. The new textures of a request are decoded in parallel by the
+// worker pool into a shared staging buffer and uploaded with a single submission. Baked KTX2 files are read as they
+// are, with every mip level in a single copy, or only their mip tail if there is a streamer for the finer levels (used
+// from the main thread, except decodeUpload)
+class TextureManager {
+public:
+
+	// Textures decoded by prepareUpload and uploaded by the commands of a frame
+	struct TextureUpload;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	// Statistics (the requests are counted since creation)
+	uint32_t getTextureCount() const { return static_cast<uint32_t>(textures.size()); }
+	uint32_t getUnreferencedTextureCount() const { return static_cast<uint32_t>(unreferencedTextures.size()); }
+	VkDeviceSize getResidentMemory() const { return residentMemory; }
+	VkDeviceSize getMemoryBudget() const { return memoryBudget; }
+	uint32_t getRequestCount() const { return requestCount; }
+	uint32_t getCacheHitCount() const { return cacheHitCount; }
+	float getHitRate() const { return requestCount > 0 ? static_cast<float>(cacheHitCount) / requestCount : 0.0f; }
+	uint32_t getEvictionCount() const { return evictionCount; }
+
+	// The image is a texture of the manager
+	bool owns(VkImage image) const { return textureKeys.find(image) != textureKeys.end(); }
+
+	// Decode the images in the worker threads (on the calling thread if there is no pool)
+	void setWorkerPool(WorkerPool* workerPool) { this->workerPool = workerPool; }
+
+	// Stream the levels of the KTX2 files finer than their mip tail (set before the textures are loaded)
+	void setStreamer(TextureStreamer* streamer) { this->streamer = streamer; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// The textures without references are kept until the resident memory exceeds the budget (0 frees them with their
+	// last reference)
+	void create(Device device, CommandManager commandManager, VkDeviceSize memoryBudget = 0);
+
+	// Texture of the file with the options (loaded and uploaded the first time it is requested)
+	Texture acquire(const std::string& path, const TextureOptions& options = {});
+
+	// Textures of the files with the options, in the same order (the missing ones are loaded together)
+	std::vector<Texture> acquire(const std::vector<std::string>& paths, const TextureOptions& options = {});
+
+	// Start an upload of the textures of the files. The textures already in the cache keep a reference until the upload
+	// is acquired or cancelled, the others are decoded by decodeUpload, their images are created and copied by
+	// recordUpload, and they are added to the cache by acquire once those commands are completed
+	std::shared_ptr<TextureUpload> createUpload(const std::vector<std::string>& paths, const TextureOptions& options = {});
+
+	// Read and decode the missing files of the upload into a staging buffer of its own (usable from any thread, it does
+	// not touch the cache)
+	void decodeUpload(TextureUpload& upload);
+
+	// Bytes of the staging buffer of the upload
+	VkDeviceSize getUploadSize(const TextureUpload& upload) const;
+
+	// Create the images of the upload and record their copies and mipmap generation
+	void recordUpload(VkCommandBuffer commandBuffer, TextureUpload& upload);
+
+	// Textures of a recorded upload whose commands are completed, in the order of its paths (a texture loaded meanwhile
+	// by another request is used instead of its uploaded copy)
+	std::vector<Texture> acquire(TextureUpload& upload);
+
+	// Destroy the staging buffer and images of an upload that will not be acquired and release its cached textures (its
+	// commands are completed)
+	void cancelUpload(TextureUpload& upload);
+
+	// Release a reference of the texture
+	void release(VkImage image);
+
+	// Destroy every texture (referenced or not)
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	Device device;
+	CommandManager commandManager;
+	WorkerPool* workerPool = nullptr;
+	TextureStreamer* streamer = nullptr;
+	VkDeviceSize memoryBudget = 0;
+
+	struct CachedTexture {
+		Texture texture;
+		uint32_t referenceCount = 0;
+		std::list<TextureKey>::iterator unreferencedPosition;	// valid without references
+	};
+	std::unordered_map<TextureKey, CachedTexture> textures;
+	std::unordered_map<VkImage, TextureKey> textureKeys;
+	std::list<TextureKey> unreferencedTextures;		// least recently released first
+
+	VkDeviceSize residentMemory = 0;
+	uint32_t requestCount = 0;
+	uint32_t cacheHitCount = 0;
+	uint32_t evictionCount = 0;
+
+	// Texture being loaded and the data of its staging region
+	struct PendingTexture {
+		Texture texture;
+		bool ktx = false;
+		KtxInfo ktxInfo;		// levels of a KTX2 file
+		uint32_t firstLevel = 0;	// first level read (the mip tail of a streamed texture)
+		VkDeviceSize stagingSize = 0;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Add the loaded textures to the cache and take a reference of the texture of each key, in the same order
+	std::vector<Texture> acquireKeys(const std::vector<TextureKey>& keys, const std::vector<TextureKey>& loadedKeys,
+		const std::vector<Texture>& loadedTextures);
+
+	// Decode the image files (or read the KTX2 files) into staging buffers, upload them to device local images and
+	// generate the mipmaps of the image files
+	std::vector<Texture> loadTextures(const std::vector<TextureKey>& keys);
+
+	// Load the textures in [first, last) with a staging buffer and a submission (their sizes are already read)
+	void loadBatch(const std::vector<TextureKey>& keys, std::vector<PendingTexture>& pendingTextures, size_t first,
+		size_t last);
+
+	// Size, format and levels of the texture of the file
+	PendingTexture readTextureInfo(const TextureKey& key) const;
+
+	// Decode the image file (or read the KTX2 levels) into the staging region of the texture
+	void decodeTexture(const TextureKey& key, const PendingTexture& pending, uint8_t* destination) const;
+
+	// Create the images of the textures in [first, last) and record their upload from the staging regions
+	void recordTextureUploads(VkCommandBuffer commandBuffer, const std::vector<TextureKey>& keys,
+		std::vector<PendingTexture>& pendingTextures, VkBuffer stagingBuffer, const std::vector<VkDeviceSize>& offsets,
+		size_t first, size_t last);
+
+	// Create the views of the uploaded textures in [first, last) and stream their finer levels
+	void finishTextures(const std::vector<TextureKey>& keys, std::vector<PendingTexture>& pendingTextures, size_t first,
+		size_t last);
+
+	// Destroy unreferenced textures until the resident memory fits in the budget
+	void evict();
+
+	void destroyTexture(const TextureKey& key);
+};
+
+
+// Staging data of the textures of an asynchronous request (one texture per different key not in the cache)
+struct TextureManager::TextureUpload {
+	std::vector<TextureKey> keys;			// of each path
+	std::vector<TextureKey> cachedKeys;		// referenced until the upload is acquired
+	std::vector<TextureKey> loadedKeys;
+	std::vector<PendingTexture> pendingTextures;
+	std::vector<VkDeviceSize> offsets;
+	VkBuffer stagingBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+	VkDeviceSize stagingSize = 0;
+	bool recorded = false;
+};
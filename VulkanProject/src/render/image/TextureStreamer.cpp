@@ -0,0 +1,263 @@
+#include "render/image/TextureStreamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "render/image/imageUtils.hpp"
+
+
+namespace {
+
+	// Offset alignment of the levels in the staging buffer (multiple of the texel and compressed block sizes)
+	const VkDeviceSize STAGING_ALIGNMENT = 16;
+
+	VkDeviceSize alignStagingSize(VkDeviceSize size) {
+		return (size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+	}
+}
+
+
+uint32_t TextureStreamer::getResidentLevel(VkImage image) const {
+	auto found = textures.find(image);
+	return found != textures.end() ? found->second.residentLevel : 0;
+}
+
+uint32_t TextureStreamer::getTailLevel(const KtxInfo& info) const {
+	uint32_t level = 0;
+	while (level + 1 < info.levelCount && std::max(info.width >> level, info.height >> level) > tailSize) {
+		level++;
+	}
+	return level;
+}
+
+VkDeviceSize TextureStreamer::getLevelsSize(const StreamedTexture& texture, uint32_t firstLevel) const {
+	VkDeviceSize size = 0;
+	for (uint32_t level = firstLevel; level < texture.info.levelCount; level++) {
+		size += texture.info.levelSizes[level];
+	}
+	return size;
+}
+
+VkDeviceSize TextureStreamer::getResidentSize() const {
+	VkDeviceSize size = 0;
+	for (const auto& entry : textures) {
+		size += getLevelsSize(entry.second, entry.second.residentLevel);
+	}
+	return size;
+}
+
+VkDeviceSize TextureStreamer::getRequestedSize() const {
+	VkDeviceSize size = 0;
+	for (const auto& entry : textures) {
+		size += getLevelsSize(entry.second, std::min(entry.second.requestedLevel, entry.second.residentLevel));
+	}
+	return size;
+}
+
+void TextureStreamer::create(Device device, uint32_t frameCount, VkDeviceSize uploadBudget, uint32_t tailSize) {
+	this->device = device;
+	this->uploadBudget = uploadBudget;
+	this->tailSize = tailSize;
+
+	stagingBuffers.resize(frameCount);
+	for (auto& stagingBuffer : stagingBuffers) {
+		resizeStagingBuffer(stagingBuffer, uploadBudget);
+	}
+	frameUploads.resize(frameCount);
+}
+
+void TextureStreamer::resizeStagingBuffer(StagingBuffer& stagingBuffer, VkDeviceSize size) {
+	if (stagingBuffer.buffer != VK_NULL_HANDLE) {
+		vkDestroyBuffer(device.get(), stagingBuffer.buffer, nullptr);
+		vkFreeMemory(device.get(), stagingBuffer.memory, nullptr);
+	}
+
+	stagingBuffer.size = alignStagingSize(size);
+	device.createBuffer(stagingBuffer.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer.buffer, stagingBuffer.memory);
+
+	void* mapped;
+	vkMapMemory(device.get(), stagingBuffer.memory, 0, stagingBuffer.size, 0, &mapped);
+	stagingBuffer.mapped = static_cast<uint8_t*>(mapped);
+}
+
+void TextureStreamer::addTexture(VkImage image, const std::string& path, const KtxInfo& info, uint32_t residentLevel) {
+	StreamedTexture texture;
+	texture.id = nextId++;
+	texture.path = path;
+	texture.info = info;
+	texture.residentLevel = residentLevel;
+	texture.requestedLevel = residentLevel;
+	textures[image] = texture;
+}
+
+void TextureStreamer::removeTexture(VkImage image) {
+	auto found = textures.find(image);
+	if (found == textures.end()) return;
+
+	// its reads and uploads in progress are ignored when they finish (the id does not match)
+	if (found->second.streaming) pendingLevelCount--;
+	textures.erase(found);
+}
+
+void TextureStreamer::requestScreenSize(VkImage image, float screenSize) {
+	auto found = textures.find(image);
+	if (found == textures.end()) return;
+
+	// a texel per pixel
+	const KtxInfo& info = found->second.info;
+	float texelsPerPixel = std::max(info.width, info.height) / std::max(screenSize, 1.0f);
+	float level = std::floor(std::log2(std::max(texelsPerPixel, 1.0f)));
+	requestLevel(image, std::min(static_cast<uint32_t>(level), info.levelCount - 1));
+}
+
+void TextureStreamer::requestLevel(VkImage image, uint32_t level) {
+	auto found = textures.find(image);
+	if (found == textures.end()) return;
+
+	StreamedTexture& texture = found->second;
+	level = std::max(level, texture.finestLevel);
+	if (level >= texture.requestedLevel) return;
+
+	// the latency is measured from the first request that needs a finer level than the resident ones
+	if (texture.requestedLevel >= texture.residentLevel) {
+		texture.requestTime = std::chrono::steady_clock::now();
+	}
+	texture.requestedLevel = level;
+}
+
+void TextureStreamer::update(uint32_t frame) {
+	levelsChanged = false;
+
+	//-----------------------------------------
+	// LEVELS UPLOADED BY THE COMPLETED FRAME
+	for (const auto& uploaded : frameUploads[frame]) {
+		auto found = textures.find(uploaded.image);
+		if (found == textures.end() || found->second.id != uploaded.id) continue;
+
+		StreamedTexture& texture = found->second;
+		texture.residentLevel = uploaded.level;
+		texture.streaming = false;
+		pendingLevelCount--;
+		levelsChanged = true;
+
+		if (texture.residentLevel <= texture.requestedLevel) {
+			float latency = std::chrono::duration<float, std::milli>(
+				std::chrono::steady_clock::now() - texture.requestTime).count();
+			latencySum += latency;
+			latencyCount++;
+			maxLatency = std::max(maxLatency, latency);
+		}
+	}
+	frameUploads[frame].clear();
+
+	//-----------------------------------------
+	// READ THE NEXT LEVEL OF THE TEXTURES THAT NEED FINER ONES
+	for (auto& entry : textures) {
+		StreamedTexture& texture = entry.second;
+		if (!texture.streaming && texture.requestedLevel < texture.residentLevel) {
+			startRead(entry.first, texture);
+		}
+	}
+}
+
+void TextureStreamer::startRead(VkImage image, StreamedTexture& texture) {
+	texture.streaming = true;
+	pendingLevelCount++;
+
+	// the task has its own copy of the file data (the texture can be removed meanwhile)
+	uint32_t level = texture.residentLevel - 1;
+	WorkerTask read = [this, image, id = texture.id, path = texture.path, info = texture.info, level]() {
+		LevelData levelData{ image, id, level };
+		try {
+			levelData.data.resize(static_cast<size_t>(info.levelSizes[level]));
+			readKtxLevel(path, info, level, levelData.data.data());
+		}
+		catch (...) {
+			levelData.error = std::current_exception();
+		}
+		std::lock_guard<std::mutex> lock(readMutex);
+		readLevels.push_back(std::move(levelData));
+	};
+	if (workerPool != nullptr) workerPool->submit(read);
+	else read();
+}
+
+void TextureStreamer::recordUploads(VkCommandBuffer commandBuffer, uint32_t frame) {
+	{
+		std::lock_guard<std::mutex> lock(readMutex);
+		for (auto& levelData : readLevels) {
+			uploadQueue.push_back(std::move(levelData));
+		}
+		readLevels.clear();
+	}
+
+	//-----------------------------------------
+	// COPY THE LEVELS THAT FIT IN THE BUDGET (a bigger level is uploaded alone)
+	StagingBuffer& stagingBuffer = stagingBuffers[frame];
+	VkDeviceSize offset = 0;
+	while (!uploadQueue.empty()) {
+		LevelData& levelData = uploadQueue.front();
+		auto found = textures.find(levelData.image);
+		if (found == textures.end() || found->second.id != levelData.id) {
+			uploadQueue.pop_front();
+			continue;
+		}
+
+		// the texture keeps its resident levels and the level is not asked for again
+		if (levelData.error) {
+			StreamedTexture& texture = found->second;
+			try {
+				std::rethrow_exception(levelData.error);
+			}
+			catch (const std::exception& e) {
+				std::cout << "Texture streaming: cannot read level " << levelData.level << " of " << texture.path << ": "
+					<< e.what() << std::endl;
+			}
+			texture.streaming = false;
+			texture.finestLevel = texture.residentLevel;
+			texture.requestedLevel = texture.residentLevel;
+			pendingLevelCount--;
+			failedLevelCount++;
+			uploadQueue.pop_front();
+			continue;
+		}
+
+		VkDeviceSize size = alignStagingSize(levelData.data.size());
+		if (offset > 0 && offset + size > uploadBudget) break;
+		if (size > stagingBuffer.size) resizeStagingBuffer(stagingBuffer, size);
+		memcpy(stagingBuffer.mapped + offset, levelData.data.data(), levelData.data.size());
+
+		// the level is not sampled until it is resident (its previous content is discarded)
+		const StreamedTexture& texture = found->second;
+		recordTransitionImageLayout(commandBuffer, levelData.image, texture.info.format, VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, levelData.level);
+		recordCopyBufferToMipLevels(commandBuffer, stagingBuffer.buffer, levelData.image, texture.info.width,
+			texture.info.height, { offset }, levelData.level);
+		recordTransitionImageLayout(commandBuffer, levelData.image, texture.info.format,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, levelData.level);
+
+		frameUploads[frame].push_back({ levelData.image, levelData.id, levelData.level });
+		offset += size;
+		uploadQueue.pop_front();
+	}
+	lastUploadSize = offset;
+}
+
+void TextureStreamer::cleanup() {
+	if (workerPool != nullptr) workerPool->wait();
+
+	for (auto& stagingBuffer : stagingBuffers) {
+		vkDestroyBuffer(device.get(), stagingBuffer.buffer, nullptr);
+		vkFreeMemory(device.get(), stagingBuffer.memory, nullptr);
+	}
+	stagingBuffers.clear();
+	frameUploads.clear();
+	textures.clear();
+	readLevels.clear();
+	uploadQueue.clear();
+	pendingLevelCount = 0;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "context/Device.hpp"
+#include "asset/ktxFile.hpp"
+#include "system/WorkerPool.hpp"
+
+
+// Texels of the biggest level of the mip tail (uploaded with the texture)
+const uint32_t DEFAULT_STREAMING_TAIL_SIZE = 64;
+
+
+// Mip levels of the streamed KTX2 textures. Only the mip tail is uploaded when a texture is loaded; the finer levels
+// are requested each frame from the size of the texture on the screen, read from the file by the worker pool and
+// uploaded by the frame command buffer under a byte budget (a level per texture at a time, from the coarsest one). A
+// level becomes resident when the frame that uploaded it is completed, so the frames in flight never sample a level
+// that is being written. The image memory of every level is allocated with the texture (used from the main thread)
+class TextureStreamer {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	bool isStreamed(VkImage image) const { return textures.find(image) != textures.end(); }
+
+	// First resident level of the texture (0 if it is not streamed)
+	uint32_t getResidentLevel(VkImage image) const;
+
+	// First level of the mip tail of the texture
+	uint32_t getTailLevel(const KtxInfo& info) const;
+
+	// The resident levels of some texture changed in the last update (the sampling of their materials is clamped again)
+	bool wereLevelsChanged() const { return levelsChanged; }
+
+	// Read the levels in the worker threads (on the calling thread if there is no pool)
+	void setWorkerPool(WorkerPool* workerPool) { this->workerPool = workerPool; }
+
+	// Statistics (the latency goes from the request of a finer level than the resident ones until it is resident)
+	uint32_t getTextureCount() const { return static_cast<uint32_t>(textures.size()); }
+	VkDeviceSize getResidentSize() const;
+	VkDeviceSize getRequestedSize() const;
+	VkDeviceSize getUploadBudget() const { return uploadBudget; }
+	VkDeviceSize getLastUploadSize() const { return lastUploadSize; }
+	uint32_t getPendingLevelCount() const { return pendingLevelCount; }
+	uint32_t getFailedLevelCount() const { return failedLevelCount; }
+	float getAverageLatency() const { return latencyCount > 0 ? latencySum / latencyCount : 0.0f; }
+	float getMaxLatency() const { return maxLatency; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Create a staging buffer of the upload budget per frame in flight (the tail size is the size in texels of the
+	// biggest level uploaded with the texture)
+	void create(Device device, uint32_t frameCount, VkDeviceSize uploadBudget,
+		uint32_t tailSize = DEFAULT_STREAMING_TAIL_SIZE);
+
+	// Stream the levels of the KTX2 file finer than the resident level
+	void addTexture(VkImage image, const std::string& path, const KtxInfo& info, uint32_t residentLevel);
+
+	// Stop streaming the texture (its pending levels are dropped)
+	void removeTexture(VkImage image);
+
+	// Ask for the level of the texture that covers the screen size in pixels (the texture is assumed to be mapped once
+	// along that size)
+	void requestScreenSize(VkImage image, float screenSize);
+
+	// Ask for a level of the texture (finer levels are not evicted once resident, and a level that could not be read is
+	// not asked for again)
+	void requestLevel(VkImage image, uint32_t level);
+
+	// Make resident the levels uploaded by the frame (its commands are completed) and start reading the next finer
+	// level of the textures that need it
+	void update(uint32_t frame);
+
+	// Record the upload of the read levels that fit in the budget (before the passes that sample the textures)
+	void recordUploads(VkCommandBuffer commandBuffer, uint32_t frame);
+
+	// Wait for the reads in progress and destroy the staging buffers
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	Device device;
+	WorkerPool* workerPool = nullptr;
+	VkDeviceSize uploadBudget = 0;
+	uint32_t tailSize = DEFAULT_STREAMING_TAIL_SIZE;
+
+	struct StreamedTexture {
+		uint64_t id;			// the image handle can be reused by a later texture
+		std::string path;
+		KtxInfo info;
+		uint32_t residentLevel;
+		uint32_t requestedLevel;
+		uint32_t finestLevel = 0;	// the finer levels could not be read
+		bool streaming = false;		// a level is being read or uploaded
+		std::chrono::steady_clock::time_point requestTime;
+	};
+	std::unordered_map<VkImage, StreamedTexture> textures;
+	uint64_t nextId = 0;
+
+	// Level read from the file (written by the worker threads)
+	struct LevelData {
+		VkImage image;
+		uint64_t id;
+		uint32_t level;
+		std::vector<uint8_t> data;
+		std::exception_ptr error;
+	};
+	std::mutex readMutex;
+	std::vector<LevelData> readLevels;
+	std::deque<LevelData> uploadQueue;
+
+	// Host visible staging buffer of each frame in flight (persistently mapped)
+	struct StagingBuffer {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		uint8_t* mapped = nullptr;
+		VkDeviceSize size = 0;
+	};
+	std::vector<StagingBuffer> stagingBuffers;
+
+	// Levels uploaded by the commands of each frame in flight
+	struct UploadedLevel {
+		VkImage image;
+		uint64_t id;
+		uint32_t level;
+	};
+	std::vector<std::vector<UploadedLevel>> frameUploads;
+
+	bool levelsChanged = false;
+	VkDeviceSize lastUploadSize = 0;
+	uint32_t pendingLevelCount = 0;
+	uint32_t failedLevelCount = 0;
+	float latencySum = 0.0f;
+	uint32_t latencyCount = 0;
+	float maxLatency = 0.0f;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Read the next finer level of the texture
+	void startRead(VkImage image, StreamedTexture& texture);
+
+	// Recreate the staging buffer of the frame with at least the size (its previous commands are completed)
+	void resizeStagingBuffer(StagingBuffer& stagingBuffer, VkDeviceSize size);
+
+	// Bytes of the levels of the texture from the first one
+	VkDeviceSize getLevelsSize(const StreamedTexture& texture, uint32_t firstLevel) const;
+};
@@ -1,9 +1,11 @@
 #include "render/image/imageUtils.hpp"
 
+#include <algorithm>
+
 
 void createImage(Device device, uint32_t width, uint32_t height, uint32_t mipLevels,
 	VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-	VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory) {
+	VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t arrayLayers) {
 
 	//-----------------------------------------
 	// CREATE IMAGE
@@ -14,7 +16,7 @@ void createImage(Device device, uint32_t width, uint32_t height, uint32_t mipLev
 	imageInfo.extent.height = height;
 	imageInfo.extent.depth = 1;
 	imageInfo.mipLevels = mipLevels;
-	imageInfo.arrayLayers = 1;
+	imageInfo.arrayLayers = arrayLayers;
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
 	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -47,7 +49,7 @@ void createImage(Device device, uint32_t width, uint32_t height, uint32_t mipLev
 }
 
 VkImageView createImageView(Device device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
-	uint32_t mipLevels) {
+	uint32_t mipLevels, VkImageViewType viewType, uint32_t baseArrayLayer, uint32_t layerCount) {
 
 	//-----------------------------------------
 	// IMAGE AND FORMAT
@@ -55,7 +57,7 @@ VkImageView createImageView(Device device, VkImage image, VkFormat format, VkIma
 	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	viewInfo.image = image;
 
-	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.viewType = viewType;
 	viewInfo.format = format;
 
 	//-----------------------------------------
@@ -70,8 +72,8 @@ VkImageView createImageView(Device device, VkImage image, VkFormat format, VkIma
 	viewInfo.subresourceRange.aspectMask = aspectFlags;
 	viewInfo.subresourceRange.baseMipLevel = 0;
 	viewInfo.subresourceRange.levelCount = mipLevels;
-	viewInfo.subresourceRange.baseArrayLayer = 0;
-	viewInfo.subresourceRange.layerCount = 1;
+	viewInfo.subresourceRange.baseArrayLayer = baseArrayLayer;
+	viewInfo.subresourceRange.layerCount = layerCount;
 
 	//-----------------------------------------
 	// CREATE
@@ -86,15 +88,18 @@ VkImageView createImageView(Device device, VkImage image, VkFormat format, VkIma
 // TODO: record all copy operations in the same command buffer to allow
 // asynchronously execution (layout transitions too)
 void copyBufferToImage(CommandManager commandManager, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-
-	//-----------------------------------------
-	// BEGIN
 	VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
+	recordCopyBufferToImage(commandBuffer, buffer, image, width, height);
+	commandManager.endSingleTimeCommands(commandBuffer);
+}
+
+void recordCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width,
+	uint32_t height, VkDeviceSize bufferOffset) {
 
 	//-----------------------------------------
 	// DEFINE REGION
 	VkBufferImageCopy region{};
-	region.bufferOffset = 0;
+	region.bufferOffset = bufferOffset;
 	region.bufferRowLength = 0;
 	region.bufferImageHeight = 0;
 
@@ -117,18 +122,52 @@ void copyBufferToImage(CommandManager commandManager, VkBuffer buffer, VkImage i
 		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		1, &region
 	);
+}
+
+void recordCopyBufferToMipLevels(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width,
+	uint32_t height, const std::vector<VkDeviceSize>& levelOffsets, uint32_t baseMipLevel) {
 
 	//-----------------------------------------
-	// SUBMIT
-	commandManager.endSingleTimeCommands(commandBuffer);
+	// DEFINE A REGION PER LEVEL
+	std::vector<VkBufferImageCopy> regions(levelOffsets.size());
+	for (uint32_t i = 0; i < regions.size(); i++) {
+		uint32_t level = baseMipLevel + i;
+		VkBufferImageCopy& region = regions[i];
+		region.bufferOffset = levelOffsets[i];
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = {
+			std::max(width >> level, 1u),
+			std::max(height >> level, 1u),
+			1
+		};
+	}
+
+	//-----------------------------------------
+	// COPY THE LEVELS
+	vkCmdCopyBufferToImage(commandBuffer,
+		buffer, image,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(regions.size()), regions.data()
+	);
 }
 
 void transitionImageLayout(CommandManager commandManager, VkImage image, VkFormat format,
 	VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels) {
-
-	//-----------------------------------------
-	// BEGIN
 	VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
+	recordTransitionImageLayout(commandBuffer, image, format, oldLayout, newLayout, mipLevels);
+	commandManager.endSingleTimeCommands(commandBuffer);
+}
+
+void recordTransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format,
+	VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, uint32_t baseMipLevel) {
 
 	//-----------------------------------------
 	// BARRIER
@@ -141,7 +180,7 @@ void transitionImageLayout(CommandManager commandManager, VkImage image, VkForma
 
 	barrier.image = image;
 	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.baseMipLevel = baseMipLevel;
 	barrier.subresourceRange.levelCount = mipLevels;
 	barrier.subresourceRange.baseArrayLayer = 0;
 	barrier.subresourceRange.layerCount = 1;
@@ -172,7 +211,7 @@ void transitionImageLayout(CommandManager commandManager, VkImage image, VkForma
 	}
 
 	//-----------------------------------------
-	// RECORD COMMAND AND SUBMIT
+	// RECORD COMMAND
 
 	vkCmdPipelineBarrier(
 		commandBuffer,
@@ -182,11 +221,16 @@ void transitionImageLayout(CommandManager commandManager, VkImage image, VkForma
 		0, nullptr,
 		1, &barrier
 	);
+}
 
+void generateMipmaps(Device device, CommandManager commandManager,
+	VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
+	VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
+	recordMipmapGeneration(device, commandBuffer, image, imageFormat, texWidth, texHeight, mipLevels);
 	commandManager.endSingleTimeCommands(commandBuffer);
 }
 
-void generateMipmaps(Device device, CommandManager commandManager,
+void recordMipmapGeneration(Device device, VkCommandBuffer commandBuffer,
 	VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
 
 	//-----------------------------------------
@@ -197,10 +241,6 @@ void generateMipmaps(Device device, CommandManager commandManager,
 		throw std::runtime_error("texture image format does not support linear blitting");
 	}
 
-	//-----------------------------------------
-	// BEGIN RECORDING
-	VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
-
 	//-----------------------------------------
 	// REUSABLE IMAGE MEMORY BARRIER
 	VkImageMemoryBarrier barrier{};
@@ -286,14 +326,12 @@ void generateMipmaps(Device device, CommandManager commandManager,
 	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
 	//-----------------------------------------
-	// RECORD LAS BARRIER AND SUBMIT
+	// RECORD LAS BARRIER
 	vkCmdPipelineBarrier(commandBuffer,
 		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
 		0, nullptr,
 		0, nullptr,
 		1, &barrier);
-
-	commandManager.endSingleTimeCommands(commandBuffer);
 }
 
 VkFormat findDepthFormat(Device device) {
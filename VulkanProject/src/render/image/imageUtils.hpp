@@ -2,6 +2,8 @@
 
 #include <vulkan/vulkan.h>
 
+#include <vector>
+
 #include "context/Device.hpp"
 #include "context/CommandManager.hpp"
 
@@ -17,23 +19,41 @@ struct ImageObjects {
 // Create an image with the specified properties and bind it with the memory
 void createImage(Device device, uint32_t width, uint32_t height, uint32_t mipLevels,
 	VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-	VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+	VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t arrayLayers = 1);
 
-// Create the image view of the image with the specified info
+// Create the image view of the image with the specified info (a single layer by default)
 VkImageView createImageView(Device device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
-	uint32_t mipLevels);
+	uint32_t mipLevels, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D, uint32_t baseArrayLayer = 0,
+	uint32_t layerCount = 1);
 
 // Copy the content of a buffer to an image
 void copyBufferToImage(CommandManager commandManager, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 
+// Record the copy of the buffer content from the offset to the first mip level of the image
+void recordCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width,
+	uint32_t height, VkDeviceSize bufferOffset = 0);
+
+// Record the copy of consecutive mip levels of the image in a single command (the level offsets are in the buffer, the
+// base level first)
+void recordCopyBufferToMipLevels(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width,
+	uint32_t height, const std::vector<VkDeviceSize>& levelOffsets, uint32_t baseMipLevel = 0);
+
 // Make transition of image layout to another specified
 void transitionImageLayout(CommandManager commandManager, VkImage image, VkFormat format,
 	VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
 
+// Record the transition of image layout to another specified (of 'mipLevels' levels from the base one)
+void recordTransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format,
+	VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, uint32_t baseMipLevel = 0);
+
 // Generate 'mipLevels' mipmaps of the image
 void generateMipmaps(Device device, CommandManager commandManager,
 	VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
 
+// Record the generation of 'mipLevels' mipmaps of the image (it ends in shader read only layout)
+void recordMipmapGeneration(Device device, VkCommandBuffer commandBuffer,
+	VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+
 // Find a suitable depth format given a device
 VkFormat findDepthFormat(Device device);
 
@@ -0,0 +1,162 @@
+#include "render/pipeline/DescriptorAllocator.hpp"
+
+#include <array>
+#include <stdexcept>
+
+
+namespace {
+
+	// Sets of each pool
+	const uint32_t SETS_PER_POOL = 64;
+
+	// Descriptors of each type per set in a pool (the first pass set uses most of them)
+	const std::array<VkDescriptorPoolSize, 5> DESCRIPTORS_PER_SET = { {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 },
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 1 },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 }
+	} };
+}
+
+
+uint32_t DescriptorAllocator::getFramePoolCount() const {
+	size_t count = 0;
+	for (const auto& poolList : framePools) {
+		count += poolList.pools.size();
+	}
+	return static_cast<uint32_t>(count);
+}
+
+void DescriptorAllocator::create(Device device, uint32_t frameCount) {
+	this->device = device;
+
+	persistentPools.pools.push_back(createPool());
+	framePools.resize(frameCount);
+	for (auto& poolList : framePools) {
+		poolList.pools.push_back(createPool());
+	}
+}
+
+VkDescriptorPool DescriptorAllocator::createPool() {
+	std::array<VkDescriptorPoolSize, DESCRIPTORS_PER_SET.size()> poolSizes = DESCRIPTORS_PER_SET;
+	for (auto& poolSize : poolSizes) {
+		poolSize.descriptorCount *= SETS_PER_POOL;
+	}
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = SETS_PER_POOL;
+
+	VkDescriptorPool pool;
+	if (vkCreateDescriptorPool(device.get(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor pool");
+	}
+	return pool;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+	return allocate(persistentPools, layout);
+}
+
+VkDescriptorSet DescriptorAllocator::allocateUpdateAfterBind(VkDescriptorSetLayout layout,
+	const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t variableDescriptorCount) {
+
+	//--------------------------------------------------------
+	// POOL (sized for the set)
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = 1;
+
+	VkDescriptorPool pool;
+	if (vkCreateDescriptorPool(device.get(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create update after bind descriptor pool");
+	}
+	updateAfterBindPools.push_back(pool);
+
+	//--------------------------------------------------------
+	// SET
+	VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+	variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+	variableCountInfo.descriptorSetCount = 1;
+	variableCountInfo.pDescriptorCounts = &variableDescriptorCount;
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.pNext = variableDescriptorCount > 0 ? &variableCountInfo : nullptr;
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	VkDescriptorSet descriptorSet;
+	if (vkAllocateDescriptorSets(device.get(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate update after bind descriptor set");
+	}
+	allocationCount++;
+	return descriptorSet;
+}
+
+VkDescriptorSet DescriptorAllocator::allocateFrame(uint32_t frame, VkDescriptorSetLayout layout) {
+	return allocate(framePools[frame], layout);
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(PoolList& poolList, VkDescriptorSetLayout layout) {
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	VkDescriptorSet descriptorSet;
+	bool emptyPool = false;
+	while (true) {
+		allocInfo.descriptorPool = poolList.pools[poolList.current];
+		VkResult result = vkAllocateDescriptorSets(device.get(), &allocInfo, &descriptorSet);
+		if (result == VK_SUCCESS) {
+			allocationCount++;
+			return descriptorSet;
+		}
+		if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+			throw std::runtime_error("failed to allocate descriptor set");
+		}
+		if (emptyPool) {
+			throw std::runtime_error("descriptor set does not fit in an empty descriptor pool");
+		}
+
+		// the pools after the current one are empty (a new one is created when all are full)
+		poolList.current++;
+		if (poolList.current == poolList.pools.size()) {
+			poolList.pools.push_back(createPool());
+		}
+		emptyPool = true;
+	}
+}
+
+void DescriptorAllocator::resetFrame(uint32_t frame) {
+	PoolList& poolList = framePools[frame];
+	for (size_t i = 0; i <= poolList.current; i++) {
+		vkResetDescriptorPool(device.get(), poolList.pools[i], 0);
+	}
+	poolList.current = 0;
+}
+
+void DescriptorAllocator::cleanup() {
+	for (VkDescriptorPool pool : persistentPools.pools) {
+		vkDestroyDescriptorPool(device.get(), pool, nullptr);
+	}
+	persistentPools = {};
+	for (auto& poolList : framePools) {
+		for (VkDescriptorPool pool : poolList.pools) {
+			vkDestroyDescriptorPool(device.get(), pool, nullptr);
+		}
+	}
+	framePools.clear();
+	for (VkDescriptorPool pool : updateAfterBindPools) {
+		vkDestroyDescriptorPool(device.get(), pool, nullptr);
+	}
+	updateAfterBindPools.clear();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "context/Device.hpp"
+
+
+// Descriptor sets from lists of pools that grow when a pool runs out of memory. Long lived sets (passes and materials)
+// come from the persistent pools and transient sets from the pools of a frame in flight, which are reset in bulk when
+// the frame is recorded again (used from the main thread)
+class DescriptorAllocator {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	// Statistics (the allocations are counted since the last reset)
+	uint32_t getPersistentPoolCount() const { return static_cast<uint32_t>(persistentPools.pools.size()); }
+	uint32_t getFramePoolCount() const;
+	uint32_t getUpdateAfterBindPoolCount() const { return static_cast<uint32_t>(updateAfterBindPools.size()); }
+	uint32_t getAllocationCount() const { return allocationCount; }
+	void resetAllocationCount() { allocationCount = 0; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Create the first persistent pool and a pool per frame in flight
+	void create(Device device, uint32_t frameCount);
+
+	// Set that lives until cleanup
+	VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+	// Set of an update after bind layout that lives until cleanup, in a pool with the descriptors of the set (the
+	// variable count is the size of the last binding if it has a variable descriptor count, 0 otherwise)
+	VkDescriptorSet allocateUpdateAfterBind(VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& poolSizes,
+		uint32_t variableDescriptorCount = 0);
+
+	// Set that lives until the frame is reset
+	VkDescriptorSet allocateFrame(uint32_t frame, VkDescriptorSetLayout layout);
+
+	// Free the transient sets of the frame (its previous commands must be completed)
+	void resetFrame(uint32_t frame);
+
+	// Destroy the pools and their sets
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	Device device;
+
+	// pools before the current one are full
+	struct PoolList {
+		std::vector<VkDescriptorPool> pools;
+		size_t current = 0;
+	};
+	PoolList persistentPools;
+	std::vector<PoolList> framePools;
+	std::vector<VkDescriptorPool> updateAfterBindPools;		// a set each
+
+	uint32_t allocationCount = 0;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	VkDescriptorPool createPool();
+
+	// Allocate from the current pool of the list, moving to the next one (or a new one) when it is full
+	VkDescriptorSet allocate(PoolList& poolList, VkDescriptorSetLayout layout);
+};
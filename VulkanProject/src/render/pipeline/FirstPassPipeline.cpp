@@ -6,8 +6,9 @@
 #include <array>
 #include <stdexcept>
 #include <string>
+#include <chrono>
+#include <iostream>
 
-#include "asset/bytecodeFileReader.hpp"
 
 
 void FirstPassPipeline::createRenderPass(VkFormat imageFormat, VkFormat depthFormat)  {
@@ -112,14 +113,41 @@ void FirstPassPipeline::createRenderPass(VkFormat imageFormat, VkFormat depthFor
 
 void FirstPassPipeline::createGraphicsPipeline(std::string vertShaderLocation, std::string fragShaderLocation) {
 
+	//--------------------------------------------------------
+	// SHADERS (the variants specialize the same modules)
+
+	vertShaderModule = shaderLibrary->load(vertShaderLocation).module;
+	fragShaderModule = shaderLibrary->load(fragShaderLocation).module;
+
+
+	//--------------------------------------------------------
+	// PIPELINE LAYOUT
+
+	std::vector<VkDescriptorSetLayout> setLayouts = { descriptorSetLayout };
+	std::vector<VkPushConstantRange> pushConstantRanges;
+	if (cameraUniforms != nullptr) {
+		// model matrices of the draw
+		pushConstantRanges.push_back({ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawPushConstants) });
+	}
+	if (materialTable != nullptr) {
+		// bindless textures in set 1 and the material index of the draw
+		setLayouts.push_back(materialTable->getDescriptorSetLayout());
+		pushConstantRanges.push_back({ VK_SHADER_STAGE_FRAGMENT_BIT, MATERIAL_PUSH_CONSTANT_OFFSET, sizeof(uint32_t) });
+	}
+	pipelineLayout = layoutCache->getPipelineLayout(setLayouts, pushConstantRanges);
+
+
+	// the variants are created when they are drawn
+	pipeline = VK_NULL_HANDLE;
+}
+
+VkPipeline FirstPassPipeline::createVariant(const PipelineVariantKey& key, VkShaderModule vertShaderModule,
+	VkShaderModule fragShaderModule) {
+
 	//--------------------------------------------------------
 	// SHADERS
 
-	// create shader modules
-	auto vertShaderCode = readFile(vertShaderLocation);
-	auto fragShaderCode = readFile(fragShaderLocation);
-	VkShaderModule vertShaderModule = createShaderModule(device, vertShaderCode);
-	VkShaderModule fragShaderModule = createShaderModule(device, fragShaderCode);
+	SpecializationData specialization(key);
 
 	// VERTEX SHADER
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
@@ -127,7 +155,7 @@ void FirstPassPipeline::createGraphicsPipeline(std::string vertShaderLocation, s
 	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
 	vertShaderStageInfo.module = vertShaderModule;
 	vertShaderStageInfo.pName = "main";
-	vertShaderStageInfo.pSpecializationInfo = nullptr; // For constants
+	vertShaderStageInfo.pSpecializationInfo = &specialization.info;
 
 	// FRAGMENT SHADER
 	VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
@@ -135,7 +163,7 @@ void FirstPassPipeline::createGraphicsPipeline(std::string vertShaderLocation, s
 	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	fragShaderStageInfo.module = fragShaderModule;
 	fragShaderStageInfo.pName = "main";
-	fragShaderStageInfo.pSpecializationInfo = nullptr; // For constants
+	fragShaderStageInfo.pSpecializationInfo = &specialization.info;
 
 	// SHADER STAGES
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
@@ -144,8 +172,8 @@ void FirstPassPipeline::createGraphicsPipeline(std::string vertShaderLocation, s
 	//--------------------------------------------------------
 	// VERTEX INPUT
 
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	auto bindingDescription = getVertexBindingDescription(key.vertexFormat);
+	auto attributeDescriptions = getVertexAttributeDescriptions(key.vertexFormat);
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -197,7 +225,7 @@ void FirstPassPipeline::createGraphicsPipeline(std::string vertShaderLocation, s
 	VkPipelineMultisampleStateCreateInfo multisampling{};
 	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	multisampling.sampleShadingEnable = VK_TRUE;
-	multisampling.rasterizationSamples = device.getMsaaSamples();
+	multisampling.rasterizationSamples = key.msaaSamples;
 	multisampling.minSampleShading = 1.0f; // Optional
 	multisampling.pSampleMask = nullptr; // Optional
 	multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
@@ -237,21 +265,6 @@ void FirstPassPipeline::createGraphicsPipeline(std::string vertShaderLocation, s
 	colorBlending.pAttachments = &colorBlendAttachment;
 
 
-	//--------------------------------------------------------
-	// PIPELINE LAYOUT
-
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-	pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-	pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-
-	if (vkCreatePipelineLayout(device.get(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create pipeline layout");
-	}
-
-
 	//--------------------------------------------------------
 	// DYNAMIC STATES
 
@@ -292,16 +305,240 @@ void FirstPassPipeline::createGraphicsPipeline(std::string vertShaderLocation, s
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 	pipelineInfo.basePipelineIndex = -1; // Optional
 
-	if (vkCreateGraphicsPipelines(device.get(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline)
+	VkPipeline variant;
+	if (vkCreateGraphicsPipelines(device.get(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &variant)
 		!= VK_SUCCESS) {
-		throw std::runtime_error("failed to create graphics pipeline");
+		throw std::runtime_error("failed to create graphics pipeline variant");
 	}
 
+	return variant;
+}
 
-	//--------------------------------------------------------
-	// DESTROY SHADER MODULES
-	// They are not necessary, compilation to machine code already happens
-	// in pipeline creation
-	vkDestroyShaderModule(device.get(), fragShaderModule, nullptr);
-	vkDestroyShaderModule(device.get(), vertShaderModule, nullptr);
+PipelineVariantKey FirstPassPipeline::getVariantKey(Model* model) {
+	const Material& material = model->getMaterial();
+
+	PipelineVariantKey key;
+	key.vertexFormat = model->getVertexFormat();
+	// the bindless materials are read from the table (every material uses the same variant)
+	if (materialTable == nullptr) {
+		key.textureTypes = material.usedTypes;
+		key.textureCount = static_cast<uint32_t>(material.textureCount);
+		key.shininess = material.shininess;
+	}
+	key.bruteForceLights = bruteForceLights;
+	// the render pass attachments use the device sample count
+	key.msaaSamples = device.getMsaaSamples();
+	return key;
+}
+
+VkPipeline FirstPassPipeline::getVariant(const PipelineVariantKey& key) {
+	auto found = variants.find(key);
+	if (found != variants.end()) return found->second;
+
+	PipelineVariantKey fallbackKey = getFallbackKey(key);
+	if (workerPool == nullptr || key == fallbackKey) {
+		return createVariantNow(key);
+	}
+
+	// draw with the fallback until the variant is compiled
+	requestVariant(key);
+	fallbackDrawCount++;
+	found = variants.find(fallbackKey);
+	return found != variants.end() ? found->second : createVariantNow(fallbackKey);
+}
+
+PipelineVariantKey FirstPassPipeline::getFallbackKey(const PipelineVariantKey& key) const {
+	PipelineVariantKey fallbackKey;
+	fallbackKey.vertexFormat = key.vertexFormat;
+	fallbackKey.bruteForceLights = key.bruteForceLights;
+	fallbackKey.msaaSamples = key.msaaSamples;
+	return fallbackKey;
+}
+
+void FirstPassPipeline::warmUp(const std::vector<PipelineVariantKey>& keys) {
+	if (workerPool == nullptr) {
+		for (const auto& key : keys) {
+			if (variants.find(key) == variants.end()) createVariantNow(key);
+		}
+		return;
+	}
+
+	for (const auto& key : keys) {
+		if (variants.find(key) == variants.end()) requestVariant(key);
+	}
+	workerPool->wait();
+
+	FrameProfiler loadProfiler;
+	collectCompiledVariants(loadProfiler);
+}
+
+void FirstPassPipeline::collectCompiledVariants(FrameProfiler& profiler) {
+	std::vector<ReloadedShaders> reloaded;
+	{
+		std::lock_guard<std::mutex> lock(compiledMutex);
+		reloaded.swap(reloadedShaders);
+	}
+	for (auto& shaders : reloaded) {
+		swapShaders(shaders);
+	}
+
+	std::vector<CompiledVariant> compiled;
+	{
+		std::lock_guard<std::mutex> lock(compiledMutex);
+		compiled.swap(compiledVariants);
+	}
+
+	for (auto& variant : compiled) {
+		pendingVariants.erase(variant.key);
+
+		// compiled with the shaders before a reload (requested again when it is drawn)
+		if (variant.generation != shaderGeneration) {
+			vkDestroyPipeline(device.get(), variant.pipeline, nullptr);
+			continue;
+		}
+		if (variant.error) std::rethrow_exception(variant.error);
+
+		variants.emplace(variant.key, variant.pipeline);
+		lastVariantCreationTime = variant.creationTime;
+		variantCreationTime += variant.creationTime;
+		profiler.addCompileLatency(
+			std::chrono::duration<float, std::milli>(variant.readyTime - variant.requestTime).count());
+	}
+}
+
+VkPipeline FirstPassPipeline::createVariantNow(const PipelineVariantKey& key) {
+	auto start = std::chrono::high_resolution_clock::now();
+	VkPipeline variant = createVariant(key, vertShaderModule, fragShaderModule);
+	lastVariantCreationTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	variantCreationTime += lastVariantCreationTime;
+
+	variants.emplace(key, variant);
+	return variant;
+}
+
+void FirstPassPipeline::requestVariant(const PipelineVariantKey& key) {
+	if (!pendingVariants.insert(key).second) return;
+
+	auto requestTime = std::chrono::high_resolution_clock::now();
+	VkShaderModule vertModule = vertShaderModule;
+	VkShaderModule fragModule = fragShaderModule;
+	uint32_t generation = shaderGeneration;
+	workerPool->submit([this, key, requestTime, vertModule, fragModule, generation]() {
+		CompiledVariant compiled;
+		compiled.key = key;
+		compiled.requestTime = requestTime;
+		compiled.generation = generation;
+
+		// the shader modules, layout and render pass are only read while the pipeline is created
+		auto start = std::chrono::high_resolution_clock::now();
+		try {
+			compiled.pipeline = createVariant(key, vertModule, fragModule);
+		}
+		catch (...) {
+			compiled.error = std::current_exception();
+		}
+		compiled.readyTime = std::chrono::high_resolution_clock::now();
+		compiled.creationTime = std::chrono::duration<float, std::milli>(compiled.readyTime - start).count();
+
+		std::lock_guard<std::mutex> lock(compiledMutex);
+		compiledVariants.push_back(compiled);
+	});
+}
+
+VkPipeline FirstPassPipeline::getPipeline(Model* model) {
+	return getVariant(getVariantKey(model));
+}
+
+void FirstPassPipeline::reloadShaders() {
+	std::vector<PipelineVariantKey> keys;
+	for (const auto& variant : variants) {
+		keys.push_back(variant.first);
+	}
+
+	if (workerPool == nullptr) {
+		ReloadedShaders shaders = compileShaders(keys);
+		swapShaders(shaders);
+		return;
+	}
+
+	workerPool->submit([this, keys]() {
+		ReloadedShaders shaders = compileShaders(keys);
+		std::lock_guard<std::mutex> lock(compiledMutex);
+		reloadedShaders.push_back(shaders);
+	});
+}
+
+FirstPassPipeline::ReloadedShaders FirstPassPipeline::compileShaders(const std::vector<PipelineVariantKey>& keys) {
+	ReloadedShaders shaders;
+	auto start = std::chrono::high_resolution_clock::now();
+	try {
+		std::vector<const ShaderModule*> modules = loadShaders();
+		validateShaders(modules);
+		shaders.vertShaderModule = modules[0]->module;
+		shaders.fragShaderModule = modules[1]->module;
+		for (const auto& key : keys) {
+			shaders.variants.emplace_back(key, createVariant(key, shaders.vertShaderModule, shaders.fragShaderModule));
+		}
+	}
+	catch (...) {
+		shaders.error = std::current_exception();
+	}
+	shaders.creationTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return shaders;
+}
+
+void FirstPassPipeline::swapShaders(ReloadedShaders& shaders) {
+
+	// invalid shaders: the current variants are kept
+	if (shaders.error) {
+		for (auto& variant : shaders.variants) {
+			vkDestroyPipeline(device.get(), variant.second, nullptr);
+		}
+		try {
+			std::rethrow_exception(shaders.error);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Shader reload failed: " << e.what() << std::endl;
+		}
+		return;
+	}
+
+	// no command can be drawing with the old pipelines (the variants still compiling with the old modules are
+	// discarded when they are collected, the library keeps the modules)
+	vkDeviceWaitIdle(device.get());
+
+	for (auto& variant : variants) {
+		vkDestroyPipeline(device.get(), variant.second, nullptr);
+	}
+	variants.clear();
+
+	vertShaderModule = shaders.vertShaderModule;
+	fragShaderModule = shaders.fragShaderModule;
+	for (auto& variant : shaders.variants) {
+		variants.emplace(variant.first, variant.second);
+	}
+	shaderGeneration++;
+	shaderReloadCount++;
+	lastShaderReloadTime = shaders.creationTime;
+}
+
+void FirstPassPipeline::cleanup() {
+	// the worker pool must be stopped before (no compilation can be running)
+	for (auto& variant : compiledVariants) {
+		vkDestroyPipeline(device.get(), variant.pipeline, nullptr);
+	}
+	compiledVariants.clear();
+	for (auto& shaders : reloadedShaders) {
+		for (auto& variant : shaders.variants) {
+			vkDestroyPipeline(device.get(), variant.second, nullptr);
+		}
+	}
+	reloadedShaders.clear();
+	pendingVariants.clear();
+	for (auto& variant : variants) {
+		vkDestroyPipeline(device.get(), variant.second, nullptr);
+	}
+	variants.clear();
+
+	GraphicsPipeline::cleanup();
 }
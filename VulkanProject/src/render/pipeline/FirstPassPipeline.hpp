@@ -2,15 +2,141 @@
 
 #include <vulkan/vulkan.h>
 
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "render/pipeline/GraphicsPIpeline.hpp"
+#include "render/pipeline/PipelineVariant.hpp"
+#include "system/WorkerPool.hpp"
+#include "time/FrameProfiler.hpp"
 
 
+// Forward pass of the models. A pipeline variant is created the first time a combination of features (material
+// textures, vertex layout, light assignment and sample count) is drawn and then it is reused from the variant table.
+// With a worker pool the variants are compiled in the background and the models are drawn with the fallback variant
+// of their vertex layout (untextured, created at load) until theirs is ready
 class  FirstPassPipeline : public GraphicsPipeline {
 
 public:
 
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	// Shade every light for every fragment instead of the lights of the fragment cluster (reference path)
+	void setBruteForceLights(bool bruteForceLights) { this->bruteForceLights = bruteForceLights; }
+	bool getBruteForceLights() const { return bruteForceLights; }
+
+	// Compile the missing variants in the background (nullptr to create them when they are drawn)
+	void setWorkerPool(WorkerPool* workerPool) { this->workerPool = workerPool; }
+
+	// Statistics of the variant table
+	uint32_t getVariantCount() const { return static_cast<uint32_t>(variants.size()); }
+	uint32_t getPendingVariantCount() const { return static_cast<uint32_t>(pendingVariants.size()); }
+	uint32_t getFallbackDrawCount() const { return fallbackDrawCount; }
+	float getVariantCreationTime() const { return variantCreationTime; }
+	float getLastVariantCreationTime() const { return lastVariantCreationTime; }
+	uint32_t getShaderReloadCount() const { return shaderReloadCount; }
+	float getLastShaderReloadTime() const { return lastShaderReloadTime; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Features of the variant that draws the model
+	PipelineVariantKey getVariantKey(Model* model);
+
+	// Pipeline of the variant. If it is not in the table it is created, or requested to the worker pool and the
+	// fallback variant is returned
+	VkPipeline getVariant(const PipelineVariantKey& key);
+
+	// Untextured variant with the vertex layout, light assignment and sample count of the key
+	PipelineVariantKey getFallbackKey(const PipelineVariantKey& key) const;
+
+	// Compile a known list of variants at load (in parallel with a worker pool) and wait for them
+	void warmUp(const std::vector<PipelineVariantKey>& keys);
+
+	// Move the variants compiled in the background to the table and swap the reloaded shaders (called once per frame
+	// before the drawing)
+	void collectCompiledVariants(FrameProfiler& profiler);
+
+	// Compile the variants in the table with the current modules of the shader files in the library. With a worker
+	// pool they are swapped at the next collection (the device does not need to be idle). Invalid shaders keep the
+	// current variants
+	void reloadShaders() override;
+
+	// Destroy Vulkan and other objects
+	void cleanup();
+
+protected:
+
+	VkPipeline getPipeline(Model* model) override;
+
 private:
-	
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	// kept to create the variants (owned by the shader library)
+	VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+	VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+
+	std::unordered_map<PipelineVariantKey, VkPipeline> variants;
+	bool bruteForceLights = false;
+
+	// variants requested to the worker pool and the ones it finished (shared with the workers)
+	struct CompiledVariant {
+		PipelineVariantKey key;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		std::chrono::high_resolution_clock::time_point requestTime;
+		std::chrono::high_resolution_clock::time_point readyTime;
+		float creationTime = 0.0f;
+		uint32_t generation = 0;
+		std::exception_ptr error;
+	};
+	WorkerPool* workerPool = nullptr;
+	std::unordered_set<PipelineVariantKey> pendingVariants;
+	std::mutex compiledMutex;
+	std::vector<CompiledVariant> compiledVariants;
+
+	// shader modules and variants compiled from the reloaded shader files
+	struct ReloadedShaders {
+		VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+		VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+		std::vector<std::pair<PipelineVariantKey, VkPipeline>> variants;
+		float creationTime = 0.0f;
+		std::exception_ptr error;
+	};
+	std::vector<ReloadedShaders> reloadedShaders;
+	uint32_t shaderGeneration = 0;		// variants compiled with older modules are discarded
+	uint32_t shaderReloadCount = 0;
+	float lastShaderReloadTime = 0.0f;
+
+	uint32_t fallbackDrawCount = 0;
+	float variantCreationTime = 0.0f;
+	float lastVariantCreationTime = 0.0f;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
 	void createRenderPass(VkFormat imageFormat, VkFormat depthFormat) override;
 	void createGraphicsPipeline(std::string vertexShaderLocation, std::string fragmentShaderLocation) override;
+
+	// Create the pipeline of a variant with its specialization constants
+	VkPipeline createVariant(const PipelineVariantKey& key, VkShaderModule vertShaderModule,
+		VkShaderModule fragShaderModule);
+
+	// Create the variant in the calling thread and add it to the table
+	VkPipeline createVariantNow(const PipelineVariantKey& key);
+
+	// Queue the creation of the variant in the worker pool (if it was not queued yet)
+	void requestVariant(const PipelineVariantKey& key);
+
+	// Validate the shader modules of the files and create the variants with them (in any thread)
+	ReloadedShaders compileShaders(const std::vector<PipelineVariantKey>& keys);
+
+	// Replace the shader modules and the variants by the reloaded ones
+	void swapShaders(ReloadedShaders& shaders);
 };
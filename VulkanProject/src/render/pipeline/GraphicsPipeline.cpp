@@ -1,6 +1,10 @@
 #include "render/pipeline/GraphicsPIpeline.hpp"
 
 
+// the material index follows the matrices of the draw
+static_assert(sizeof(DrawPushConstants) == MATERIAL_PUSH_CONSTANT_OFFSET, "push constant offsets must match the shaders");
+
+
 namespace Bindings {
 	void addBufferBinding(std::vector<VkDescriptorSetLayoutBinding>& bindings, size_t count, VkShaderStageFlagBits stage) {
 		VkDescriptorSetLayoutBinding modelUboLayoutBinding{};
@@ -12,6 +16,27 @@ namespace Bindings {
 		bindings.push_back(modelUboLayoutBinding);
 	}
 
+	void addStorageBufferBinding(std::vector<VkDescriptorSetLayoutBinding>& bindings, VkShaderStageFlagBits stage) {
+		VkDescriptorSetLayoutBinding storageLayoutBinding{};
+		storageLayoutBinding.binding = static_cast<uint32_t>(bindings.size());
+		storageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		storageLayoutBinding.descriptorCount = 1;
+		storageLayoutBinding.stageFlags = stage;
+
+		bindings.push_back(storageLayoutBinding);
+	}
+
+	void addCombinedImageSamplerBinding(std::vector<VkDescriptorSetLayoutBinding>& bindings, VkShaderStageFlagBits stage) {
+		VkDescriptorSetLayoutBinding imageSamplerLayoutBinding{};
+		imageSamplerLayoutBinding.binding = static_cast<uint32_t>(bindings.size());
+		imageSamplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		imageSamplerLayoutBinding.descriptorCount = 1;
+		imageSamplerLayoutBinding.stageFlags = stage;
+		imageSamplerLayoutBinding.pImmutableSamplers = nullptr;
+
+		bindings.push_back(imageSamplerLayoutBinding);
+	}
+
 	void addTextureBindings(std::vector<VkDescriptorSetLayoutBinding>& bindings, int textureCount) {
 		VkDescriptorSetLayoutBinding samplerLayoutBinding{};
 		samplerLayoutBinding.binding = static_cast<uint32_t>(bindings.size());
@@ -30,11 +55,25 @@ namespace Bindings {
 
 		bindings.push_back(texturesLayoutBinding);
 	}
+
+	void addMaterialTableBindings(std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+		VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+		samplerLayoutBinding.binding = static_cast<uint32_t>(bindings.size());
+		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+		samplerLayoutBinding.descriptorCount = 1;
+		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		bindings.push_back(samplerLayoutBinding);
+
+		// the textures are in the set of the table
+		addStorageBufferBinding(bindings, VK_SHADER_STAGE_FRAGMENT_BIT);
+	}
 }
 
 namespace DescriptorSets {
 	void addBufferDescriptorWrite(VkBuffer buffer, VkDeviceSize size, VkDescriptorSet descriptorSetDst,
-		VkDescriptorBufferInfo& bufferInfo, std::vector<VkWriteDescriptorSet>& descriptorWrites) {
+		VkDescriptorBufferInfo& bufferInfo, std::vector<VkWriteDescriptorSet>& descriptorWrites,
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
 
 		// INFO
 		bufferInfo.buffer = buffer;
@@ -47,13 +86,28 @@ namespace DescriptorSets {
 		lightsBufferWrite.dstSet = descriptorSetDst;
 		lightsBufferWrite.dstBinding = static_cast<uint32_t>(descriptorWrites.size());
 		lightsBufferWrite.dstArrayElement = 0;
-		lightsBufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		lightsBufferWrite.descriptorType = type;
 		lightsBufferWrite.descriptorCount = 1;
 		lightsBufferWrite.pBufferInfo = &bufferInfo;
 
 		descriptorWrites.push_back(lightsBufferWrite);
 	}
 
+	void addCombinedImageSamplerDescriptorWrite(const VkDescriptorImageInfo& imageInfo, VkDescriptorSet descriptorSetDst,
+		std::vector<VkWriteDescriptorSet>& descriptorWrites) {
+
+		VkWriteDescriptorSet imageSamplerWrite{};
+		imageSamplerWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		imageSamplerWrite.dstSet = descriptorSetDst;
+		imageSamplerWrite.dstBinding = static_cast<uint32_t>(descriptorWrites.size());
+		imageSamplerWrite.dstArrayElement = 0;
+		imageSamplerWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		imageSamplerWrite.descriptorCount = 1;
+		imageSamplerWrite.pImageInfo = &imageInfo;
+
+		descriptorWrites.push_back(imageSamplerWrite);
+	}
+
 	void addTextureDescriptorWrites(const Material& material, VkDescriptorSet descriptorSetDst,
 		VkDescriptorImageInfo& samplerInfo, std::vector<VkDescriptorImageInfo>& textureInfos,
 		std::vector<VkWriteDescriptorSet>& descriptorWrites) {
@@ -119,56 +173,118 @@ namespace DescriptorSets {
 
 		descriptorWrites.push_back(texturesWrite);
 	}
+
+	void addMaterialTableDescriptorWrites(const MaterialTable& materialTable, VkDescriptorSet descriptorSetDst,
+		VkDescriptorImageInfo& samplerInfo, VkDescriptorBufferInfo& bufferInfo,
+		std::vector<VkWriteDescriptorSet>& descriptorWrites) {
+
+		// shared sampler
+		samplerInfo.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		samplerInfo.sampler = materialTable.getSampler();
+
+		VkWriteDescriptorSet samplerWrite{};
+		samplerWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		samplerWrite.dstSet = descriptorSetDst;
+		samplerWrite.dstBinding = static_cast<uint32_t>(descriptorWrites.size());
+		samplerWrite.dstArrayElement = 0;
+		samplerWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+		samplerWrite.descriptorCount = 1;
+		samplerWrite.pImageInfo = &samplerInfo;
+
+		descriptorWrites.push_back(samplerWrite);
+
+		// materials
+		addBufferDescriptorWrite(materialTable.getBuffer(), materialTable.getBufferSize(), descriptorSetDst, bufferInfo,
+			descriptorWrites, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+	}
 }
 
-void GraphicsPipeline::create(Device device, VkFormat imageFormat, VkFormat depthFormat, Model* model, uint32_t lightCount,
-	std::string vertShaderLocation, std::string fragShaderLocation) {
+void GraphicsPipeline::create(Device device, ShaderLibrary& shaderLibrary, LayoutCache& layoutCache, VkFormat imageFormat,
+	VkFormat depthFormat, Model* model, bool useLights, std::string vertShaderLocation, std::string fragShaderLocation) {
 
 	this->device = device;
+	this->shaderLibrary = &shaderLibrary;
+	this->layoutCache = &layoutCache;
+	this->vertexFormat = model->getVertexFormat();
+	this->vertShaderLocation = vertShaderLocation;
+	this->fragShaderLocation = fragShaderLocation;
 
 	createRenderPass(imageFormat, depthFormat);
-	createDescriptorSetLayout(model, lightCount);
+	createDescriptorSetLayout(model, useLights);
+	validateShaders(loadShaders());
 	createGraphicsPipeline(vertShaderLocation, fragShaderLocation);
 }
 
 
-void GraphicsPipeline::createDescriptorSetLayout(Model* model, uint32_t lightCount) {
+void GraphicsPipeline::createDescriptorSetLayout(Model* model, bool useLights) {
 
 	//----------------------------------------------------
 	// BINDINGS
 	std::vector<VkDescriptorSetLayoutBinding> bindings;
 
-	// MODEL UBO
+	// MODEL UBO (or the camera UBO)
 	if (!model->useRawVertexData())
 		Bindings::addBufferBinding(bindings, 1, VK_SHADER_STAGE_VERTEX_BIT);
 
-	// SAMPLER AND TEXTURE
+	// SAMPLER AND TEXTURE (or the material buffer of the bindless table)
 	size_t textureCount = model->getMaterial().textureCount;
-	if (textureCount > 0) {
+	if (materialTable != nullptr) {
+		Bindings::addMaterialTableBindings(bindings);
+	}
+	else if (textureCount > 0) {
 		Bindings::addTextureBindings(bindings, textureCount);
 	}
 
-	// LIGHT UBOS
-	if (lightCount > 0) {
-		Bindings::addBufferBinding(bindings, lightCount, VK_SHADER_STAGE_FRAGMENT_BIT);
+	// LIGHTS, CLUSTER GRID AND LIGHT INDEX LIST
+	if (useLights) {
+		Bindings::addStorageBufferBinding(bindings, VK_SHADER_STAGE_FRAGMENT_BIT);
+		Bindings::addStorageBufferBinding(bindings, VK_SHADER_STAGE_FRAGMENT_BIT);
+		Bindings::addStorageBufferBinding(bindings, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+		// DIRECTIONAL LIGHT CASCADES AND SHADOW MAP
+		Bindings::addBufferBinding(bindings, 1, VK_SHADER_STAGE_FRAGMENT_BIT);
+		Bindings::addCombinedImageSamplerBinding(bindings, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+		// POINT AND SPOT LIGHTS SHADOW TILES AND ATLAS
+		Bindings::addStorageBufferBinding(bindings, VK_SHADER_STAGE_FRAGMENT_BIT);
+		Bindings::addCombinedImageSamplerBinding(bindings, VK_SHADER_STAGE_FRAGMENT_BIT);
 	}
 
 	//----------------------------------------------------
-	// CREATE DESCRIPTOR SET LAYOUT
-	VkDescriptorSetLayoutCreateInfo layoutInfo{};
-	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-	layoutInfo.pBindings = bindings.data();
-
-	// CREATION
-	if (vkCreateDescriptorSetLayout(device.get(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create descriptor set layout");
+	// DESCRIPTOR SET LAYOUT (shared with the pipelines with the same bindings)
+	descriptorSetLayout = layoutCache->getDescriptorSetLayout(bindings);
+	layoutBindings = bindings;
+}
+
+std::vector<const ShaderModule*> GraphicsPipeline::loadShaders() {
+	std::vector<const ShaderModule*> shaders;
+	shaders.push_back(&shaderLibrary->load(vertShaderLocation));
+	if (!fragShaderLocation.empty()) {
+		shaders.push_back(&shaderLibrary->load(fragShaderLocation));
 	}
+	return shaders;
 }
 
+void GraphicsPipeline::validateShaders(const std::vector<const ShaderModule*>& shaders) const {
+	std::vector<const ShaderReflection*> reflections;
+	for (const ShaderModule* shader : shaders) {
+		reflections.push_back(&shader->reflection);
+	}
+	std::vector<std::vector<VkDescriptorSetLayoutBinding>> setLayoutBindings = { layoutBindings };
+	if (materialTable != nullptr) {
+		setLayoutBindings.push_back(materialTable->getLayoutBindings());
+	}
+	validateDescriptorSetLayout(setLayoutBindings, reflections, vertShaderLocation);
+}
+
+
+void GraphicsPipeline::recordDrawing(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkExtent2D extent,
+	Model* model, VkDescriptorSet descriptorSet, const IndirectDraw* indirectDraw) {
+	recordDrawing(commandBuffer, framebuffer, extent, std::vector<Model*>{ model }, descriptorSet, indirectDraw);
+}
 
 void GraphicsPipeline::recordDrawing(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkExtent2D extent,
-	Model* model, VkDescriptorSet descriptorSet) {
+	const std::vector<Model*>& models, VkDescriptorSet descriptorSet, const IndirectDraw* indirectDraw) {
 
 	//---------------------
 	// RENDER PASS
@@ -189,18 +305,9 @@ void GraphicsPipeline::recordDrawing(VkCommandBuffer commandBuffer, VkFramebuffe
 
 	// drawing commands
 	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
 	//---------------------
-	// PIPELINE DATA
-
-	// vertex buffers
-	VkBuffer vertexBuffers[] = { model->getVertexBuffer() };
-	VkDeviceSize offsets[] = { 0 };
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-
-	// index buffer
-	vkCmdBindIndexBuffer(commandBuffer, model->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	// PIPELINE DATA (shared by the models)
 
 	// viewport and scissor stage
 	VkViewport viewport{};
@@ -217,61 +324,142 @@ void GraphicsPipeline::recordDrawing(VkCommandBuffer commandBuffer, VkFramebuffe
 	scissor.extent = extent;
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-		pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	for (size_t m = 0; m < models.size(); m++) {
+		Model* model = models[m];
+		const IndirectDraw* modelIndirectDraw = m == 0 ? indirectDraw : nullptr;
+
+		// the models are drawn once their material is in the bindless table
+		int32_t materialIndex = materialTable != nullptr ? materialTable->getMaterialIndex(model->getMaterial()) : -1;
+		if (materialTable != nullptr && materialIndex < 0) continue;
+
+		// the sets stay bound while the pipelines of the models have the same layout
+		VkPipeline modelPipeline = getPipeline(model);
+		if (modelPipeline != boundPipeline) {
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, modelPipeline);
+			if (boundPipeline == VK_NULL_HANDLE) {
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+					pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+				if (materialTable != nullptr) {
+					VkDescriptorSet tableSet = materialTable->getDescriptorSet();
+					vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+						pipelineLayout, 1, 1, &tableSet, 0, nullptr);
+				}
+			}
+			boundPipeline = modelPipeline;
+		}
+
+		//---------------------
+		// MODEL DATA
 
-	//---------------------
-	// DRAW GEOMETRY AND END
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(model->getIndices().size()), 1, 0, 0, 0);
-	vkCmdEndRenderPass(commandBuffer);
-}
+		// vertex buffers
+		VkBuffer vertexBuffers[] = { model->getVertexBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
 
-// TODO: store inside a 'DescriptorPool' class all allocation requests and do all of them with one call to Vulkan
-void GraphicsPipeline::allocateDescriptorSets(VkDescriptorPool pool, uint32_t count, VkDescriptorSet* descriptorSets) {
-	std::vector<VkDescriptorSetLayout> layouts(count, descriptorSetLayout);
+		// index buffer
+		if (modelIndirectDraw != nullptr) {
+			vkCmdBindIndexBuffer(commandBuffer, modelIndirectDraw->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		}
+		else {
+			vkCmdBindIndexBuffer(commandBuffer, model->getIndexBuffer(), 0, model->getIndexType());
+		}
 
-	VkDescriptorSetAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocInfo.descriptorPool = pool;
-	allocInfo.descriptorSetCount = count;
-	allocInfo.pSetLayouts = layouts.data();
+		// model matrices of the draw (the sets are not changed between draws)
+		if (cameraUniforms != nullptr) {
+			DrawPushConstants drawConstants = createDrawPushConstants(*model);
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(drawConstants), &drawConstants);
+		}
+
+		// material of the model in the bindless table
+		if (materialTable != nullptr) {
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, MATERIAL_PUSH_CONSTANT_OFFSET,
+				sizeof(uint32_t), &materialIndex);
+		}
 
-	if (vkAllocateDescriptorSets(device.get(), &allocInfo, descriptorSets) != VK_SUCCESS) {
-		throw std::runtime_error("failed to allocate first pass descriptor set");
+		//---------------------
+		// DRAW GEOMETRY
+		if (modelIndirectDraw != nullptr) {
+			vkCmdDrawIndexedIndirect(commandBuffer, modelIndirectDraw->drawBuffer, 0, 1,
+				sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else {
+			for (uint32_t i = 0; i < model->getSubsetCount(); i++) {
+				const MeshSubset& subset = model->getSubset(i);
+				vkCmdDrawIndexed(commandBuffer, subset.indexCount, 1, subset.firstIndex, subset.vertexOffset, 0);
+			}
+		}
 	}
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+VkDescriptorSet GraphicsPipeline::allocateDescriptorSet(DescriptorAllocator& descriptorAllocator) {
+	return descriptorAllocator.allocate(descriptorSetLayout);
 }
 
 // TODO: move this to a Renderer class
 void GraphicsPipeline::updateDescriptorSet(Material material, VkDescriptorSet descriptorSet) {
-	updateDescriptorSet({}, material, {}, descriptorSet);
+	updateDescriptorSet({}, material, {}, {}, {}, {}, {}, descriptorSet);
 }
 
 // TODO: move this to a Renderer class
-void GraphicsPipeline::updateDescriptorSet(ModelUboManager modelUniforms, Material material, LightUboManager lightsUniforms,
-	VkDescriptorSet descriptorSet) {
+void GraphicsPipeline::updateDescriptorSet(ModelUboManager modelUniforms, Material material, const LightBufferManager& lightBuffers,
+	const ShadowUboManager& shadowUniforms, VkDescriptorImageInfo shadowMapInfo, const ShadowAtlasManager& shadowAtlas,
+	VkDescriptorImageInfo shadowAtlasInfo, VkDescriptorSet descriptorSet, uint32_t frame) {
 
 	// DESCRIPTOR WRITES
 	std::vector<VkWriteDescriptorSet> descriptorWrites{};
 
-	// Model UBO
+	// Model UBO (or the camera UBO if the model matrices are pushed)
 	VkDescriptorBufferInfo modelBufferInfo;
-	if (modelUniforms.hasModel()) {
+	if (cameraUniforms != nullptr && cameraUniforms->hasBuffers()) {
+		DescriptorSets::addBufferDescriptorWrite(cameraUniforms->getBuffer(frame), sizeof(CameraUBO),
+			descriptorSet, modelBufferInfo, descriptorWrites);
+	}
+	else if (modelUniforms.hasModel()) {
 		DescriptorSets::addBufferDescriptorWrite(modelUniforms.getBuffer(0), sizeof(ModelUBO),
 			descriptorSet, modelBufferInfo, descriptorWrites);
 	}
 
-	// Sample and textures
+	// Sample and textures (or the material buffer of the bindless table)
 	VkDescriptorImageInfo samplerInfo{};
 	std::vector<VkDescriptorImageInfo> textureInfos;
-	if (material.textureCount > 0) {
+	VkDescriptorBufferInfo materialsBufferInfo{};
+	if (materialTable != nullptr) {
+		DescriptorSets::addMaterialTableDescriptorWrites(*materialTable, descriptorSet, samplerInfo, materialsBufferInfo,
+			descriptorWrites);
+	}
+	else if (material.textureCount > 0) {
 		DescriptorSets::addTextureDescriptorWrites(material, descriptorSet, samplerInfo, textureInfos, descriptorWrites);
 	}
 
-	// Lights UBO
+	// Lights, cluster grid and light indices
 	VkDescriptorBufferInfo lightsBufferInfo{};
-	if (lightsUniforms.getLightCount() > 0) {
-		DescriptorSets::addBufferDescriptorWrite(lightsUniforms.getBuffer(0), sizeof(LightUBO) * lightsUniforms.getLightCount(),
-			descriptorSet, lightsBufferInfo, descriptorWrites);
+	VkDescriptorBufferInfo clustersBufferInfo{};
+	VkDescriptorBufferInfo lightIndicesBufferInfo{};
+	if (lightBuffers.getLightCapacity() > 0) {
+		DescriptorSets::addBufferDescriptorWrite(lightBuffers.getLightBuffer(frame), lightBuffers.getLightBufferSize(),
+			descriptorSet, lightsBufferInfo, descriptorWrites, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		DescriptorSets::addBufferDescriptorWrite(lightBuffers.getClusterBuffer(frame), lightBuffers.getClusterBufferSize(),
+			descriptorSet, clustersBufferInfo, descriptorWrites, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		DescriptorSets::addBufferDescriptorWrite(lightBuffers.getLightIndexBuffer(frame), lightBuffers.getLightIndexBufferSize(),
+			descriptorSet, lightIndicesBufferInfo, descriptorWrites, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+	}
+
+	// Directional light cascades and shadow map
+	VkDescriptorBufferInfo shadowBufferInfo{};
+	if (shadowUniforms.hasBuffers()) {
+		DescriptorSets::addBufferDescriptorWrite(shadowUniforms.getBuffer(frame), sizeof(ShadowUBO),
+			descriptorSet, shadowBufferInfo, descriptorWrites);
+		DescriptorSets::addCombinedImageSamplerDescriptorWrite(shadowMapInfo, descriptorSet, descriptorWrites);
+	}
+
+	// Shadow tiles and atlas
+	VkDescriptorBufferInfo shadowTilesBufferInfo{};
+	if (shadowAtlas.hasBuffers()) {
+		DescriptorSets::addBufferDescriptorWrite(shadowAtlas.getBuffer(frame), shadowAtlas.getBufferSize(),
+			descriptorSet, shadowTilesBufferInfo, descriptorWrites, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+		DescriptorSets::addCombinedImageSamplerDescriptorWrite(shadowAtlasInfo, descriptorSet, descriptorWrites);
 	}
 	
 	// UPDATE
@@ -279,26 +467,24 @@ void GraphicsPipeline::updateDescriptorSet(ModelUboManager modelUniforms, Materi
 		descriptorWrites.data(), 0, nullptr);
 }
 
-VkShaderModule GraphicsPipeline::createShaderModule(Device device, const std::vector<char>& code) {
-	// CREATE INFO
-	VkShaderModuleCreateInfo createInfo{};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size(); // Size in bytes (char)
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data()); // Vulkan uses uint32 pointer (not char)
-	// It is not necessary to check alignment, std::vector already does
-
-	// CREATE SHADER MODULE
-	VkShaderModule shaderModule;
-	if (vkCreateShaderModule(device.get(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create shader module");
+void GraphicsPipeline::reloadShaders() {
+	VkPipeline oldPipeline = pipeline;
+
+	// the old pipeline is kept if the new shaders are not valid (the layout comes from the cache)
+	try {
+		validateShaders(loadShaders());
+		createGraphicsPipeline(vertShaderLocation, fragShaderLocation);
+	}
+	catch (...) {
+		pipeline = oldPipeline;
+		throw;
 	}
 
-	return shaderModule;
+	vkDestroyPipeline(device.get(), oldPipeline, nullptr);
 }
 
 void GraphicsPipeline::cleanup() {
-	vkDestroyDescriptorSetLayout(device.get(), descriptorSetLayout, nullptr);
+	// the layouts are destroyed by the cache
 	vkDestroyPipeline(device.get(), pipeline, nullptr);
-	vkDestroyPipelineLayout(device.get(), pipelineLayout, nullptr);
 	vkDestroyRenderPass(device.get(), renderPass, nullptr);
 }
@@ -5,7 +5,15 @@
 #include "scene/Model.hpp"
 #include "render/uniform/Material.hpp"
 #include "render/uniform/ModelUboManager.hpp"
-#include "render/uniform/LightUboManager.hpp"
+#include "render/uniform/CameraUboManager.hpp"
+#include "render/uniform/LightBufferManager.hpp"
+#include "render/uniform/ShadowUboManager.hpp"
+#include "render/uniform/ShadowAtlasManager.hpp"
+#include "render/uniform/MaterialTable.hpp"
+#include "render/pipeline/MeshletCullPipeline.hpp"
+#include "render/pipeline/ShaderLibrary.hpp"
+#include "render/pipeline/LayoutCache.hpp"
+#include "render/pipeline/DescriptorAllocator.hpp"
 
 
 class GraphicsPipeline {
@@ -17,26 +25,52 @@ public:
 	VkRenderPass getRenderPass() { return renderPass; }
 	VkDescriptorSetLayout getDescriptorSetLayout() { return descriptorSetLayout; }
 
+	// Read the textures and the material of the draws from the bindless table instead of a texture array in the set of
+	// the pipeline (set before the creation)
+	void setMaterialTable(MaterialTable* materialTable) { this->materialTable = materialTable; }
+
+	// Read the view and projection from the camera uniforms and push the model matrices before each draw instead of a
+	// model UBO in the set (set before the creation)
+	void setCameraUniforms(CameraUboManager* cameraUniforms) { this->cameraUniforms = cameraUniforms; }
+
+	// The pipeline was created with the SPIR-V file
+	bool usesShader(const std::string& location) const {
+		return !location.empty() && (location == vertShaderLocation || location == fragShaderLocation);
+	}
+
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// METHODS
 	
-	// Create the graphics pipeline with the specified formats
-	void create(Device device, VkFormat imageFormat, VkFormat depthFormat, Model* model, uint32_t lightCount,
-		std::string vertShaderLocation, std::string fragShaderLocation);
+	// Create the graphics pipeline with the specified formats. The shader modules and layouts come from the caches
+	// (throw if the shaders declare bindings that the descriptor set layout does not have)
+	void create(Device device, ShaderLibrary& shaderLibrary, LayoutCache& layoutCache, VkFormat imageFormat,
+		VkFormat depthFormat, Model* model, bool useLights, std::string vertShaderLocation, std::string fragShaderLocation);
 
-	// Allocate descriptor sets with the layout of the pipeline
-	void allocateDescriptorSets(VkDescriptorPool pool, uint32_t count, VkDescriptorSet* descriptorSets);
+	// Allocate a long lived descriptor set with the layout of the pipeline (transient sets are allocated for a frame
+	// with the layout)
+	VkDescriptorSet allocateDescriptorSet(DescriptorAllocator& descriptorAllocator);
 
-	// Write a descriptor set with the corresponding data
-	void updateDescriptorSet(ModelUboManager modelUniforms, Material material, LightUboManager lightsUniforms,
-		VkDescriptorSet descriptorSet);
+	// Write a descriptor set with the corresponding data (the per frame buffers of the frame in flight)
+	void updateDescriptorSet(ModelUboManager modelUniforms, Material material, const LightBufferManager& lightBuffers,
+		const ShadowUboManager& shadowUniforms, VkDescriptorImageInfo shadowMapInfo, const ShadowAtlasManager& shadowAtlas,
+		VkDescriptorImageInfo shadowAtlasInfo, VkDescriptorSet descriptorSet, uint32_t frame = 0);
 
 	// Write a descriptor set with the corresponding data
 	void updateDescriptorSet(Material material, VkDescriptorSet descriptorSet);
 
-	// Record a command buffer with the necessary operations to use the pipeline
+	// Record a command buffer with the necessary operations to use the pipeline. If an indirect draw is received its
+	// indices are drawn instead of the model ones
 	void recordDrawing(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkExtent2D extent,
-		Model* model, VkDescriptorSet descriptorSet);
+		Model* model, VkDescriptorSet descriptorSet, const IndirectDraw* indirectDraw = nullptr);
+
+	// Record the drawing of the models in a single render pass, each with its pipeline variant, matrices and material
+	// (with push constants and the bindless table, otherwise they share the data of the set). The indirect draw
+	// replaces the indices of the first model
+	void recordDrawing(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkExtent2D extent,
+		const std::vector<Model*>& models, VkDescriptorSet descriptorSet, const IndirectDraw* indirectDraw = nullptr);
+
+	// Create the pipeline again with the current modules of its shader files in the library (the device must be idle)
+	virtual void reloadShaders();
 
 	// Destroy Vulkan and other objects
 	void cleanup();
@@ -47,12 +81,30 @@ protected:
 	// CLASS MEMBERS
 
 	Device device;
+	ShaderLibrary* shaderLibrary = nullptr;
+	LayoutCache* layoutCache = nullptr;
 
 	VkPipeline pipeline;
 	VkRenderPass renderPass;
-	VkDescriptorSetLayout descriptorSetLayout;
+	VkDescriptorSetLayout descriptorSetLayout;		// owned by the layout cache
 	VkPipelineLayout pipelineLayout;
 
+	// Bindings of the descriptor set layout (checked against the shaders)
+	std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+
+	// Bindless textures and materials (set 1 and the material index as push constant)
+	MaterialTable* materialTable = nullptr;
+
+	// Camera UBO in the binding of the model UBO and the model matrices as push constants
+	CameraUboManager* cameraUniforms = nullptr;
+
+	// Vertex layout of the model the pipeline was created for
+	VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+
+	// SPIR-V files of the pipeline (to reload them)
+	std::string vertShaderLocation;
+	std::string fragShaderLocation;
+
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// METHODS
 
@@ -60,11 +112,18 @@ protected:
 	virtual void createRenderPass(VkFormat imageFormat, VkFormat depthFormat) = 0;
 
 	// Defines the Descriptor Set Layout of the pipeline
-	void createDescriptorSetLayout(Model* model, uint32_t lightCount);
+	void createDescriptorSetLayout(Model* model, bool useLights);
+
+	// Modules of the shader files of the pipeline (vertex first)
+	std::vector<const ShaderModule*> loadShaders();
+
+	// Check the descriptor set layout against the bindings declared by the shaders
+	void validateShaders(const std::vector<const ShaderModule*>& shaders) const;
 
 	// Create a GraphicsPipeline with all the stages and a PipelineLayout
 	virtual void createGraphicsPipeline(std::string vertexShaderLocation, std::string fragmentShaderLocation) = 0;
 
-	static VkShaderModule createShaderModule(Device device, const std::vector<char>& code);
+	// Pipeline bound to draw the model
+	virtual VkPipeline getPipeline(Model* model) { return pipeline; }
 
 };
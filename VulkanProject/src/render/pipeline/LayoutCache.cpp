@@ -0,0 +1,93 @@
+#include "render/pipeline/LayoutCache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+void LayoutCache::create(Device device) {
+	this->device = device;
+}
+
+VkDescriptorSetLayout LayoutCache::getDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings,
+	std::vector<VkDescriptorBindingFlags> bindingFlags) {
+
+	if (!bindingFlags.empty() && bindingFlags.size() != bindings.size()) {
+		throw std::runtime_error("descriptor binding flags do not match the bindings");
+	}
+
+	// the same bindings added in another order are the same layout (the flags follow their bindings)
+	std::vector<size_t> order(bindings.size());
+	for (size_t i = 0; i < order.size(); i++) order[i] = i;
+	std::sort(order.begin(), order.end(), [&bindings](size_t a, size_t b) { return bindings[a].binding < bindings[b].binding; });
+
+	DescriptorSetLayoutKey key;
+	bool updateAfterBind = false;
+	for (size_t i : order) {
+		key.bindings.push_back(bindings[i]);
+		if (bindingFlags.empty()) continue;
+		key.bindingFlags.push_back(bindingFlags[i]);
+		updateAfterBind = updateAfterBind || (bindingFlags[i] & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT);
+	}
+	auto found = descriptorSetLayouts.find(key);
+	if (found != descriptorSetLayouts.end()) {
+		cacheHitCount++;
+		return found->second;
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+	flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	flagsInfo.bindingCount = static_cast<uint32_t>(key.bindingFlags.size());
+	flagsInfo.pBindingFlags = key.bindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = key.bindingFlags.empty() ? nullptr : &flagsInfo;
+	layoutInfo.flags = updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0;
+	layoutInfo.bindingCount = static_cast<uint32_t>(key.bindings.size());
+	layoutInfo.pBindings = key.bindings.data();
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	if (vkCreateDescriptorSetLayout(device.get(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout");
+	}
+
+	descriptorSetLayouts.emplace(key, descriptorSetLayout);
+	return descriptorSetLayout;
+}
+
+VkPipelineLayout LayoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts,
+	const std::vector<VkPushConstantRange>& pushConstantRanges) {
+
+	PipelineLayoutKey key{ setLayouts, pushConstantRanges };
+	auto found = pipelineLayouts.find(key);
+	if (found != pipelineLayouts.end()) {
+		cacheHitCount++;
+		return found->second;
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+	pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+	VkPipelineLayout pipelineLayout;
+	if (vkCreatePipelineLayout(device.get(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout");
+	}
+
+	pipelineLayouts.emplace(key, pipelineLayout);
+	return pipelineLayout;
+}
+
+void LayoutCache::cleanup() {
+	for (auto& pipelineLayout : pipelineLayouts) {
+		vkDestroyPipelineLayout(device.get(), pipelineLayout.second, nullptr);
+	}
+	pipelineLayouts.clear();
+	for (auto& descriptorSetLayout : descriptorSetLayouts) {
+		vkDestroyDescriptorSetLayout(device.get(), descriptorSetLayout.second, nullptr);
+	}
+	descriptorSetLayouts.clear();
+}
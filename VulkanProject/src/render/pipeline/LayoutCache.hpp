@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "context/Device.hpp"
+
+
+// Bindings of a descriptor set layout (sorted by binding number) and their flags (empty if none has flags)
+struct DescriptorSetLayoutKey {
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	std::vector<VkDescriptorBindingFlags> bindingFlags;
+
+	bool operator==(const DescriptorSetLayoutKey& other) const {
+		if (bindings.size() != other.bindings.size() || bindingFlags != other.bindingFlags) return false;
+		for (size_t i = 0; i < bindings.size(); i++) {
+			const auto& a = bindings[i];
+			const auto& b = other.bindings[i];
+			if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+				a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags ||
+				a.pImmutableSamplers != b.pImmutableSamplers) return false;
+		}
+		return true;
+	}
+};
+
+// Set layouts and push constant ranges of a pipeline layout
+struct PipelineLayoutKey {
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	std::vector<VkPushConstantRange> pushConstantRanges;
+
+	bool operator==(const PipelineLayoutKey& other) const {
+		if (setLayouts != other.setLayouts || pushConstantRanges.size() != other.pushConstantRanges.size()) return false;
+		for (size_t i = 0; i < pushConstantRanges.size(); i++) {
+			const auto& a = pushConstantRanges[i];
+			const auto& b = other.pushConstantRanges[i];
+			if (a.stageFlags != b.stageFlags || a.offset != b.offset || a.size != b.size) return false;
+		}
+		return true;
+	}
+};
+
+
+namespace std {
+	template<> struct hash<DescriptorSetLayoutKey> {
+		size_t operator()(DescriptorSetLayoutKey const& key) const {
+			size_t seed = hash<size_t>()(key.bindings.size());
+			auto combine = [&seed](size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+			for (const auto& binding : key.bindings) {
+				combine(hash<uint32_t>()(binding.binding));
+				combine(hash<uint32_t>()(binding.descriptorType));
+				combine(hash<uint32_t>()(binding.descriptorCount));
+				combine(hash<uint32_t>()(binding.stageFlags));
+				combine(hash<const void*>()(binding.pImmutableSamplers));
+			}
+			for (VkDescriptorBindingFlags flags : key.bindingFlags) {
+				combine(hash<uint32_t>()(flags));
+			}
+			return seed;
+		}
+	};
+
+	template<> struct hash<PipelineLayoutKey> {
+		size_t operator()(PipelineLayoutKey const& key) const {
+			size_t seed = hash<size_t>()(key.setLayouts.size());
+			auto combine = [&seed](size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+			for (VkDescriptorSetLayout setLayout : key.setLayouts) {
+				combine(hash<VkDescriptorSetLayout>()(setLayout));
+			}
+			for (const auto& range : key.pushConstantRanges) {
+				combine(hash<uint32_t>()(range.stageFlags));
+				combine(hash<uint32_t>()(range.offset));
+				combine(hash<uint32_t>()(range.size));
+			}
+			return seed;
+		}
+	};
+}
+
+
+// Descriptor set layouts and pipeline layouts shared by the pipelines. Identical bindings are created once, so the
+// descriptor sets of pipelines with the same layout are compatible (used from the main thread)
+class LayoutCache {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	// Statistics of the cache
+	uint32_t getDescriptorSetLayoutCount() const { return static_cast<uint32_t>(descriptorSetLayouts.size()); }
+	uint32_t getPipelineLayoutCount() const { return static_cast<uint32_t>(pipelineLayouts.size()); }
+	uint32_t getCacheHitCount() const { return cacheHitCount; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	void create(Device device);
+
+	// Layout with the bindings (created the first time they are requested). The flags are given per binding, in the same
+	// order, and a layout with update after bind bindings is allocated from update after bind pools
+	VkDescriptorSetLayout getDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings,
+		std::vector<VkDescriptorBindingFlags> bindingFlags = {});
+
+	// Layout with the set layouts and push constant ranges (created the first time they are requested)
+	VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts,
+		const std::vector<VkPushConstantRange>& pushConstantRanges);
+
+	// Destroy the layouts (after the pipelines that use them)
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	Device device;
+
+	std::unordered_map<DescriptorSetLayoutKey, VkDescriptorSetLayout> descriptorSetLayouts;
+	std::unordered_map<PipelineLayoutKey, VkPipelineLayout> pipelineLayouts;
+	uint32_t cacheHitCount = 0;
+};
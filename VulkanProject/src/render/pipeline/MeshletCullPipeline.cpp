@@ -0,0 +1,233 @@
+#include "render/pipeline/MeshletCullPipeline.hpp"
+
+#include <array>
+#include <stdexcept>
+
+#include "asset/spirvReflection.hpp"
+
+
+namespace {
+
+	// Storage buffers: meshlets, meshlet indices, output indices and draw command
+	const uint32_t CULL_BINDING_COUNT = 4;
+
+	// Threads per meshlet (one per triangle)
+	const uint32_t CULL_WORKGROUP_SIZE = 128;
+	static_assert(CULL_WORKGROUP_SIZE >= MESHLET_MAX_TRIANGLES, "a culling thread must exist for each triangle");
+
+	// Must match the push constant block of meshletCull.comp
+	struct CullParams {
+		glm::vec4 frustumPlanes[6];
+		glm::vec4 cameraPosition;
+		uint32_t meshletCount;
+	};
+
+	// Planes of the clip volume (Vulkan depth range) in the space transformed by the matrix, normalized so the
+	// distances are in that space units
+	void extractFrustumPlanes(const glm::mat4& matrix, glm::vec4 planes[6]) {
+		glm::vec4 row[4];
+		for (int i = 0; i < 4; i++) {
+			row[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+		}
+
+		planes[0] = row[3] + row[0];	// left
+		planes[1] = row[3] - row[0];	// right
+		planes[2] = row[3] + row[1];	// bottom
+		planes[3] = row[3] - row[1];	// top
+		planes[4] = row[2];				// near
+		planes[5] = row[3] - row[2];	// far
+
+		for (int i = 0; i < 6; i++) {
+			float length = glm::length(glm::vec3(planes[i]));
+			if (length > 0.0f) planes[i] /= length;
+		}
+	}
+}
+
+
+void MeshletCullPipeline::create(Device device, ShaderLibrary& shaderLibrary, LayoutCache& layoutCache,
+	DescriptorAllocator& descriptorAllocator, Model* model, uint32_t frameCount, std::string compShaderLocation) {
+	if (!model->hasMeshlets()) throw std::runtime_error("the model has no meshlets to cull");
+
+	this->device = device;
+	this->model = model;
+
+	createDescriptorSetLayout(layoutCache);
+	createComputePipeline(layoutCache, shaderLibrary.load(compShaderLocation), compShaderLocation);
+	createBuffers(frameCount);
+	createDescriptorSets(descriptorAllocator, frameCount);
+}
+
+void MeshletCullPipeline::createDescriptorSetLayout(LayoutCache& layoutCache) {
+	std::array<VkDescriptorSetLayoutBinding, CULL_BINDING_COUNT> bindings{};
+	for (uint32_t i = 0; i < CULL_BINDING_COUNT; i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	layoutBindings.assign(bindings.begin(), bindings.end());
+	descriptorSetLayout = layoutCache.getDescriptorSetLayout(layoutBindings);
+}
+
+void MeshletCullPipeline::createComputePipeline(LayoutCache& layoutCache, const ShaderModule& compShader,
+	const std::string& compShaderLocation) {
+	validateDescriptorSetLayout({ layoutBindings }, { &compShader.reflection }, compShaderLocation);
+
+	VkPipelineShaderStageCreateInfo compShaderStageInfo{};
+	compShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	compShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	compShaderStageInfo.module = compShader.module;
+	compShaderStageInfo.pName = "main";
+
+	// PIPELINE LAYOUT
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(CullParams);
+
+	pipelineLayout = layoutCache.getPipelineLayout({ descriptorSetLayout }, { pushConstantRange });
+
+	// PIPELINE
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = compShaderStageInfo;
+	pipelineInfo.layout = pipelineLayout;
+
+	if (vkCreateComputePipelines(device.get(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create meshlet culling pipeline");
+	}
+}
+
+void MeshletCullPipeline::createBuffers(uint32_t frameCount) {
+	outputIndexBuffers.resize(frameCount);
+	outputIndexBuffersMemory.resize(frameCount);
+	drawBuffers.resize(frameCount);
+	drawBuffersMemory.resize(frameCount);
+	drawBuffersMapped.resize(frameCount);
+
+	// enough space for all the meshlets visible
+	VkDeviceSize indexBufferSize = sizeof(uint32_t) * model->getMeshletIndexCount();
+	VkDeviceSize drawBufferSize = sizeof(VkDrawIndexedIndirectCommand);
+
+	for (uint32_t i = 0; i < frameCount; i++) {
+		device.createBuffer(indexBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, outputIndexBuffers[i], outputIndexBuffersMemory[i]);
+
+		// host visible to read the visible triangle count back
+		device.createBuffer(drawBufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			drawBuffers[i], drawBuffersMemory[i]);
+		vkMapMemory(device.get(), drawBuffersMemory[i], 0, drawBufferSize, 0, &drawBuffersMapped[i]);
+		memset(drawBuffersMapped[i], 0, drawBufferSize);
+	}
+}
+
+void MeshletCullPipeline::createDescriptorSets(DescriptorAllocator& descriptorAllocator, uint32_t frameCount) {
+	//--------------------------------------------------------
+	// SETS (persistent, a set per frame in flight)
+	descriptorSets.resize(frameCount);
+	for (uint32_t i = 0; i < frameCount; i++) {
+		descriptorSets[i] = descriptorAllocator.allocate(descriptorSetLayout);
+	}
+
+	//--------------------------------------------------------
+	// WRITES
+	for (uint32_t i = 0; i < frameCount; i++) {
+		std::array<VkDescriptorBufferInfo, CULL_BINDING_COUNT> bufferInfos{};
+		bufferInfos[0] = { model->getMeshletBuffer(), 0, VK_WHOLE_SIZE };
+		bufferInfos[1] = { model->getMeshletIndexBuffer(), 0, VK_WHOLE_SIZE };
+		bufferInfos[2] = { outputIndexBuffers[i], 0, VK_WHOLE_SIZE };
+		bufferInfos[3] = { drawBuffers[i], 0, VK_WHOLE_SIZE };
+
+		std::array<VkWriteDescriptorSet, CULL_BINDING_COUNT> writes{};
+		for (uint32_t b = 0; b < CULL_BINDING_COUNT; b++) {
+			writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[b].dstSet = descriptorSets[i];
+			writes[b].dstBinding = b;
+			writes[b].dstArrayElement = 0;
+			writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[b].descriptorCount = 1;
+			writes[b].pBufferInfo = &bufferInfos[b];
+		}
+
+		vkUpdateDescriptorSets(device.get(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+}
+
+void MeshletCullPipeline::recordCulling(VkCommandBuffer commandBuffer, uint32_t frame, Camera& camera) {
+
+	//--------------------------------------------------------
+	// RESET THE DRAW COMMAND (no indices, a single instance)
+	VkDrawIndexedIndirectCommand emptyDraw{};
+	emptyDraw.instanceCount = 1;
+	vkCmdUpdateBuffer(commandBuffer, drawBuffers[frame], 0, sizeof(emptyDraw), &emptyDraw);
+
+	VkBufferMemoryBarrier resetBarrier{};
+	resetBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	resetBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	resetBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	resetBarrier.buffer = drawBuffers[frame];
+	resetBarrier.offset = 0;
+	resetBarrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+		0, nullptr, 1, &resetBarrier, 0, nullptr);
+
+	//--------------------------------------------------------
+	// CULLING PARAMETERS IN MODEL SPACE
+	// (the meshlet bounds are computed from the float vertices: no dequantization)
+	glm::mat4 modelMatrix = createModelMatrix(model->getTransform());
+	glm::mat4 invModelMatrix = glm::inverse(modelMatrix);
+
+	CullParams params{};
+	extractFrustumPlanes(camera.getProjection() * camera.getView() * modelMatrix, params.frustumPlanes);
+	params.cameraPosition = invModelMatrix * glm::vec4(camera.getTransform()->position, 1.0f);
+	params.meshletCount = model->getMeshletCount();
+
+	//--------------------------------------------------------
+	// DISPATCH (a workgroup per meshlet)
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1,
+		&descriptorSets[frame], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+	vkCmdDispatch(commandBuffer, model->getMeshletCount(), 1, 1);
+
+	//--------------------------------------------------------
+	// MAKE THE RESULTS VISIBLE TO THE DRAW
+	std::array<VkBufferMemoryBarrier, 2> barriers{};
+	for (auto& barrier : barriers) {
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+	}
+	barriers[0].dstAccessMask = VK_ACCESS_INDEX_READ_BIT;
+	barriers[0].buffer = outputIndexBuffers[frame];
+	barriers[1].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	barriers[1].buffer = drawBuffers[frame];
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0,
+		0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+}
+
+uint32_t MeshletCullPipeline::getVisibleTriangleCount(uint32_t frame) {
+	return static_cast<VkDrawIndexedIndirectCommand*>(drawBuffersMapped[frame])->indexCount / 3;
+}
+
+void MeshletCullPipeline::cleanup() {
+	for (size_t i = 0; i < drawBuffers.size(); i++) {
+		vkDestroyBuffer(device.get(), outputIndexBuffers[i], nullptr);
+		vkFreeMemory(device.get(), outputIndexBuffersMemory[i], nullptr);
+		vkDestroyBuffer(device.get(), drawBuffers[i], nullptr);
+		vkFreeMemory(device.get(), drawBuffersMemory[i], nullptr);
+	}
+
+	vkDestroyPipeline(device.get(), pipeline, nullptr);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "context/Device.hpp"
+#include "scene/Model.hpp"
+#include "scene/Camera.hpp"
+#include "render/pipeline/ShaderLibrary.hpp"
+#include "render/pipeline/LayoutCache.hpp"
+#include "render/pipeline/DescriptorAllocator.hpp"
+
+
+// Buffers of a draw whose indices were written on the GPU
+struct IndirectDraw {
+	VkBuffer indexBuffer = VK_NULL_HANDLE;	// 32 bit indices
+	VkBuffer drawBuffer = VK_NULL_HANDLE;	// VkDrawIndexedIndirectCommand
+};
+
+
+// Compute pass that culls the meshlets of a model (frustum and normal cone) and writes the triangles of the visible
+// ones in an index buffer drawn with an indirect call
+class MeshletCullPipeline {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	IndirectDraw getIndirectDraw(uint32_t frame) { return { outputIndexBuffers[frame], drawBuffers[frame] }; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Create the compute pipeline and the output buffers of each frame in flight for the meshlets of the model
+	void create(Device device, ShaderLibrary& shaderLibrary, LayoutCache& layoutCache,
+		DescriptorAllocator& descriptorAllocator, Model* model, uint32_t frameCount, std::string compShaderLocation);
+
+	// Record the culling of the meshlets seen by the camera. The results are ready for the vertex input and the
+	// indirect draw stages of the following commands
+	void recordCulling(VkCommandBuffer commandBuffer, uint32_t frame, Camera& camera);
+
+	// Visible triangles written in the last completed culling of the frame (read from host visible memory)
+	uint32_t getVisibleTriangleCount(uint32_t frame);
+
+	// Destroy Vulkan and other objects
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	Device device;
+	Model* model;
+
+	VkDescriptorSetLayout descriptorSetLayout;		// owned by the layout cache
+	std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+	std::vector<VkDescriptorSet> descriptorSets;		// from the persistent pools of the allocator
+
+	// per frame in flight
+	std::vector<VkBuffer> outputIndexBuffers;
+	std::vector<VkDeviceMemory> outputIndexBuffersMemory;
+	std::vector<VkBuffer> drawBuffers;
+	std::vector<VkDeviceMemory> drawBuffersMemory;
+	std::vector<void*> drawBuffersMapped;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	void createDescriptorSetLayout(LayoutCache& layoutCache);
+	void createComputePipeline(LayoutCache& layoutCache, const ShaderModule& compShader,
+		const std::string& compShaderLocation);
+	void createBuffers(uint32_t frameCount);
+	void createDescriptorSets(DescriptorAllocator& descriptorAllocator, uint32_t frameCount);
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "render/uniform/Material.hpp"
+#include "render/vertex/Vertex.hpp"
+
+
+// Specialization constants of the first pass shaders (must match the constant_id of shader.vert and shader.frag)
+enum SpecializationConstant {
+	SPEC_CONSTANT_PACKED_VERTEX = 0,
+	SPEC_CONSTANT_TEXTURE_TYPES = 1,
+	SPEC_CONSTANT_TEXTURE_COUNT = 2,
+	SPEC_CONSTANT_SHININESS = 3,
+	SPEC_CONSTANT_BRUTE_FORCE_LIGHTS = 4,
+	SPEC_CONSTANT_COUNT
+};
+
+
+// Features of a pipeline variant. The shader features are specialization constants and the sample count changes the
+// multisample state
+struct PipelineVariantKey {
+	VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+	Material::TextureTypes textureTypes = TEXTURE_TYPE_NONE_BIT;
+	uint32_t textureCount = 0;
+	float shininess = 20.0f;
+	bool bruteForceLights = false;
+	VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	bool operator==(const PipelineVariantKey& other) const {
+		return vertexFormat == other.vertexFormat && textureTypes == other.textureTypes &&
+			textureCount == other.textureCount && shininess == other.shininess &&
+			bruteForceLights == other.bruteForceLights && msaaSamples == other.msaaSamples;
+	}
+};
+
+
+// Values of the specialization constants of a variant (the same data is given to every stage, the constants that a
+// stage does not declare are ignored)
+struct SpecializationData {
+	VkBool32 packedVertex;
+	uint32_t textureTypes;
+	uint32_t textureCount;
+	float shininess;
+	VkBool32 bruteForceLights;
+
+	std::array<VkSpecializationMapEntry, SPEC_CONSTANT_COUNT> mapEntries;
+	VkSpecializationInfo info;
+
+	SpecializationData(const PipelineVariantKey& key) {
+		packedVertex = key.vertexFormat == VERTEX_FORMAT_PACKED;
+		textureTypes = key.textureTypes;
+		// the texture array can not be empty
+		textureCount = key.textureCount > 0 ? key.textureCount : 1;
+		shininess = key.shininess;
+		bruteForceLights = key.bruteForceLights;
+
+		mapEntries[SPEC_CONSTANT_PACKED_VERTEX] =
+			{ SPEC_CONSTANT_PACKED_VERTEX, offsetof(SpecializationData, packedVertex), sizeof(VkBool32) };
+		mapEntries[SPEC_CONSTANT_TEXTURE_TYPES] =
+			{ SPEC_CONSTANT_TEXTURE_TYPES, offsetof(SpecializationData, textureTypes), sizeof(uint32_t) };
+		mapEntries[SPEC_CONSTANT_TEXTURE_COUNT] =
+			{ SPEC_CONSTANT_TEXTURE_COUNT, offsetof(SpecializationData, textureCount), sizeof(uint32_t) };
+		mapEntries[SPEC_CONSTANT_SHININESS] =
+			{ SPEC_CONSTANT_SHININESS, offsetof(SpecializationData, shininess), sizeof(float) };
+		mapEntries[SPEC_CONSTANT_BRUTE_FORCE_LIGHTS] =
+			{ SPEC_CONSTANT_BRUTE_FORCE_LIGHTS, offsetof(SpecializationData, bruteForceLights), sizeof(VkBool32) };
+
+		info.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+		info.pMapEntries = mapEntries.data();
+		info.dataSize = offsetof(SpecializationData, bruteForceLights) + sizeof(VkBool32);
+		info.pData = this;
+	}
+
+	// the info points to this object
+	SpecializationData(const SpecializationData&) = delete;
+	SpecializationData& operator=(const SpecializationData&) = delete;
+};
+
+
+namespace std {
+	template<> struct hash<PipelineVariantKey> {
+		size_t operator()(PipelineVariantKey const& key) const {
+			size_t seed = hash<uint32_t>()(key.textureTypes);
+			auto combine = [&seed](size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+			combine(hash<uint32_t>()(key.vertexFormat));
+			combine(hash<uint32_t>()(key.textureCount));
+			combine(hash<float>()(key.shininess));
+			combine(hash<bool>()(key.bruteForceLights));
+			combine(hash<uint32_t>()(key.msaaSamples));
+			return seed;
+		}
+	};
+}
@@ -7,8 +7,6 @@
 #include <stdexcept>
 #include <string>
 
-#include "asset/bytecodeFileReader.hpp"
-
 
 void SecondPassPipeline::createRenderPass(VkFormat imageFormat, VkFormat depthFormat) {
 
@@ -115,11 +113,9 @@ void SecondPassPipeline::createGraphicsPipeline(std::string vertShaderLocation,
 	//--------------------------------------------------------
 	// SHADERS
 
-	// create shader modules
-	auto vertShaderCode = readFile(vertShaderLocation);
-	auto fragShaderCode = readFile(fragShaderLocation);
-	VkShaderModule vertShaderModule = createShaderModule(device, vertShaderCode);
-	VkShaderModule fragShaderModule = createShaderModule(device, fragShaderCode);
+	// shader modules (owned by the library)
+	VkShaderModule vertShaderModule = shaderLibrary->load(vertShaderLocation).module;
+	VkShaderModule fragShaderModule = shaderLibrary->load(fragShaderLocation).module;
 
 	// VERTEX SHADER
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
@@ -144,8 +140,8 @@ void SecondPassPipeline::createGraphicsPipeline(std::string vertShaderLocation,
 	//--------------------------------------------------------
 	// VERTEX INPUT
 
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	auto bindingDescription = getVertexBindingDescription(vertexFormat);
+	auto attributeDescriptions = getVertexAttributeDescriptions(vertexFormat);
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -232,16 +228,7 @@ void SecondPassPipeline::createGraphicsPipeline(std::string vertShaderLocation,
 	//--------------------------------------------------------
 	// PIPELINE LAYOUT
 
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-	pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-	pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-
-	if (vkCreatePipelineLayout(device.get(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create pipeline layout");
-	}
+	pipelineLayout = layoutCache->getPipelineLayout({ descriptorSetLayout }, {});
 
 
 	//--------------------------------------------------------
@@ -288,12 +275,4 @@ void SecondPassPipeline::createGraphicsPipeline(std::string vertShaderLocation,
 		!= VK_SUCCESS) {
 		throw std::runtime_error("failed to create graphics pipeline");
 	}
-
-
-	//--------------------------------------------------------
-	// DESTROY SHADER MODULES
-	// They are not necessary, compilation to machine code already happens
-	// in pipeline creation
-	vkDestroyShaderModule(device.get(), fragShaderModule, nullptr);
-	vkDestroyShaderModule(device.get(), vertShaderModule, nullptr);
 }
@@ -0,0 +1,108 @@
+#include "render/pipeline/ShaderLibrary.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "asset/bytecodeFileReader.hpp"
+
+
+namespace {
+
+	// FNV-1a (64 bits)
+	uint64_t hashCode(const char* data, size_t size) {
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++) {
+			hash ^= static_cast<unsigned char>(data[i]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
+
+
+void ShaderLibrary::create(Device device) {
+	this->device = device;
+}
+
+const ShaderModule& ShaderLibrary::load(const std::string& location) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto found = files.find(location);
+	if (found != files.end()) {
+		cacheHitCount++;
+		return *found->second;
+	}
+
+	const ShaderModule& shaderModule = loadFile(location);
+	files[location] = &shaderModule;
+	return shaderModule;
+}
+
+bool ShaderLibrary::reload(const std::string& location) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto found = files.find(location);
+	const ShaderModule* oldModule = found != files.end() ? found->second : nullptr;
+
+	const ShaderModule& shaderModule = loadFile(location);
+	files[location] = &shaderModule;
+	return &shaderModule != oldModule;
+}
+
+const ShaderModule& ShaderLibrary::loadFile(const std::string& location) {
+	MappedFile file = mapFile(location);
+	fileLoadCount++;
+
+	try {
+		// Vulkan reads the code as 32 bit words
+		if (file.size % sizeof(uint32_t) != 0) {
+			throw std::runtime_error("invalid spir-v file size");
+		}
+		uint64_t hash = hashCode(file.data, file.size);
+
+		// same code in another file or in a previous version of this one (the code is compared, the hash may collide)
+		auto range = modules.equal_range(hash);
+		for (auto found = range.first; found != range.second; ++found) {
+			const std::vector<uint32_t>& moduleCode = found->second.code;
+			if (moduleCode.size() * sizeof(uint32_t) == file.size &&
+				memcmp(moduleCode.data(), file.data, file.size) == 0) {
+				cacheHitCount++;
+				unmapFile(file);
+				return found->second;
+			}
+		}
+
+		// the mapping is page aligned
+		const uint32_t* code = reinterpret_cast<const uint32_t*>(file.data);
+		ShaderModule shaderModule;
+		shaderModule.hash = hash;
+		shaderModule.code.assign(code, code + file.size / sizeof(uint32_t));
+		shaderModule.reflection = reflectSpirv(code, file.size / sizeof(uint32_t));
+
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = file.size;
+		createInfo.pCode = code;
+		if (vkCreateShaderModule(device.get(), &createInfo, nullptr, &shaderModule.module) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shader module");
+		}
+		std::cout << "Shader " << location << " with size: " << file.size << std::endl;
+
+		unmapFile(file);
+		return modules.emplace(hash, std::move(shaderModule))->second;
+	}
+	catch (...) {
+		unmapFile(file);
+		throw;
+	}
+}
+
+void ShaderLibrary::cleanup() {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& shaderModule : modules) {
+		vkDestroyShaderModule(device.get(), shaderModule.second.module, nullptr);
+	}
+	modules.clear();
+	files.clear();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "context/Device.hpp"
+#include "asset/spirvReflection.hpp"
+
+
+// Shader module created from a SPIR-V file
+struct ShaderModule {
+	VkShaderModule module = VK_NULL_HANDLE;
+	uint64_t hash = 0;				// of the SPIR-V code
+	std::vector<uint32_t> code;		// compared on a hash match (a collision gets its own module)
+	ShaderReflection reflection;
+};
+
+
+// Cache of the shader modules used by the pipelines. A SPIR-V file is mapped and hashed once, and its module is
+// reflected and shared by every pipeline (and every file with the same code). The modules are kept until cleanup so
+// the pipelines compiled in the background can still use them after a reload. Thread safe
+class ShaderLibrary {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	// Statistics of the cache
+	uint32_t getModuleCount() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return static_cast<uint32_t>(modules.size());
+	}
+	uint32_t getFileLoadCount() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return fileLoadCount;
+	}
+	uint32_t getCacheHitCount() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return cacheHitCount;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	void create(Device device);
+
+	// Module of the SPIR-V file (read the first time it is requested, then from the cache)
+	const ShaderModule& load(const std::string& location);
+
+	// Read the file again. The following loads return the module of the new content (false if the code did not change)
+	bool reload(const std::string& location);
+
+	// Destroy the modules (no pipeline can be created with them after this)
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	Device device;
+
+	mutable std::mutex mutex;
+	std::unordered_multimap<uint64_t, ShaderModule> modules;		// by code hash (node addresses are stable)
+	std::unordered_map<std::string, const ShaderModule*> files;		// current module of each file
+
+	uint32_t fileLoadCount = 0;
+	uint32_t cacheHitCount = 0;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Map the file and find or create the module of its code (the mutex must be locked)
+	const ShaderModule& loadFile(const std::string& location);
+};
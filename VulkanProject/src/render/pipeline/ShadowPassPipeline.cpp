@@ -0,0 +1,545 @@
+#include "render/pipeline/ShadowPassPipeline.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+
+namespace {
+
+	// Must match the push constant block of shadow.vert
+	struct ShadowPushConstants {
+		glm::mat4 lightModelViewProjection;
+	};
+
+	// Depth bias to avoid shadow acne (in depth units and scaled by the slope of the triangle)
+	const float SHADOW_DEPTH_BIAS_CONSTANT = 1.25f;
+	const float SHADOW_DEPTH_BIAS_SLOPE = 1.75f;
+}
+
+
+void ShadowPassPipeline::create(Device device, ShaderLibrary& shaderLibrary, LayoutCache& layoutCache,
+	VkFormat depthFormat, Model* model, uint32_t frameCount, std::string vertShaderLocation) {
+
+	this->device = device;
+	this->shaderLibrary = &shaderLibrary;
+	this->layoutCache = &layoutCache;
+	this->depthFormat = depthFormat;
+	this->vertexFormat = model->getVertexFormat();
+	this->vertShaderLocation = vertShaderLocation;
+
+	// the matrices are push constants: no descriptors
+	descriptorSetLayout = VK_NULL_HANDLE;
+
+	createRenderPass(VK_FORMAT_UNDEFINED, depthFormat);
+	validateShaders(loadShaders());
+	createGraphicsPipeline(vertShaderLocation, "");
+	createShadowMap();
+	createShadowAtlas();
+	createQueryPool(frameCount);
+}
+
+void ShadowPassPipeline::createRenderPass(VkFormat imageFormat, VkFormat depthFormat) {
+	// Clear the image, undefined initial layout
+	createDepthRenderPass(depthFormat, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_IMAGE_LAYOUT_UNDEFINED, renderPass);
+}
+
+void ShadowPassPipeline::createDepthRenderPass(VkFormat depthFormat, VkAttachmentLoadOp loadOp,
+	VkImageLayout initialLayout, VkRenderPass& depthRenderPass) {
+
+	//----------------------------------------------------
+	// DEPTH ATTACHMENT
+
+	// Store the image, depth read only as final layout (sampled by the first pass)
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = loadOp;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = initialLayout;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentRef{};
+	depthAttachmentRef.attachment = 0;
+	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	//----------------------------------------------------
+	// RENDER SUBPASS
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 0;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+	//----------------------------------------------------
+	// DEPENDENCIES
+
+	// the previous frame sampling must finish before the depth is written again
+	std::array<VkSubpassDependency, 2> dependencies{};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	// the depth must be written before the first pass samples it
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	//----------------------------------------------------
+	// CREATE RENDER PASS
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &depthAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
+
+	if (vkCreateRenderPass(device.get(), &renderPassInfo, nullptr, &depthRenderPass) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shadow render pass");
+	}
+}
+
+void ShadowPassPipeline::createGraphicsPipeline(std::string vertShaderLocation, std::string fragShaderLocation) {
+
+	//--------------------------------------------------------
+	// SHADERS (vertex only: the depth is written without fragment shader)
+
+	VkShaderModule vertShaderModule = shaderLibrary->load(vertShaderLocation).module;
+
+	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertShaderStageInfo.module = vertShaderModule;
+	vertShaderStageInfo.pName = "main";
+	vertShaderStageInfo.pSpecializationInfo = nullptr;
+
+
+	//--------------------------------------------------------
+	// VERTEX INPUT (only the position)
+
+	auto bindingDescription = getVertexBindingDescription(vertexFormat);
+	auto attributeDescriptions = getVertexAttributeDescriptions(vertexFormat);
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.vertexAttributeDescriptionCount = 1;
+	vertexInputInfo.pVertexAttributeDescriptions = &attributeDescriptions[0];
+
+
+	//--------------------------------------------------------
+	// INPUT ASSEMBLY
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+
+	//--------------------------------------------------------
+	// VIEWPORT AND SCISSORS (configured at drawing time)
+
+	VkPipelineViewportStateCreateInfo viewportState{};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+
+
+	//--------------------------------------------------------
+	// RASTERIZER
+
+	VkPipelineRasterizationStateCreateInfo rasterizer{};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE;
+	rasterizer.rasterizerDiscardEnable = VK_FALSE;
+
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+
+	// both faces cast shadows (open meshes and thin geometry)
+	rasterizer.cullMode = VK_CULL_MODE_NONE;
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	// depth value changes
+	rasterizer.depthBiasEnable = VK_TRUE;
+	rasterizer.depthBiasConstantFactor = SHADOW_DEPTH_BIAS_CONSTANT;
+	rasterizer.depthBiasSlopeFactor = SHADOW_DEPTH_BIAS_SLOPE;
+	rasterizer.depthBiasClamp = 0.0f;
+
+
+	//--------------------------------------------------------
+	// MULTISAMPLING (disabled)
+
+	VkPipelineMultisampleStateCreateInfo multisampling{};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.sampleShadingEnable = VK_FALSE;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+
+	//--------------------------------------------------------
+	// DEPTH AND STENCIL
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = VK_FALSE;
+
+
+	//--------------------------------------------------------
+	// COLOR BLENDING (no color attachments)
+
+	VkPipelineColorBlendStateCreateInfo colorBlending{};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.logicOpEnable = VK_FALSE;
+	colorBlending.attachmentCount = 0;
+
+
+	//--------------------------------------------------------
+	// PIPELINE LAYOUT (the matrix of each cascade and model is a push constant)
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(ShadowPushConstants);
+
+	pipelineLayout = layoutCache->getPipelineLayout({}, { pushConstantRange });
+
+
+	//--------------------------------------------------------
+	// DYNAMIC STATES
+
+	std::vector<VkDynamicState> dynamicStates = {
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+
+	VkPipelineDynamicStateCreateInfo dynamicState{};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicState.pDynamicStates = dynamicStates.data();
+
+
+	//--------------------------------------------------------
+	//--------------------------------------------------------
+	// CREATE GRAPHICS PIPELINE
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 1;
+	pipelineInfo.pStages = &vertShaderStageInfo;
+
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.pDynamicState = &dynamicState;
+
+	pipelineInfo.layout = pipelineLayout;
+
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+
+	if (vkCreateGraphicsPipelines(device.get(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline)
+		!= VK_SUCCESS) {
+		throw std::runtime_error("failed to create shadow pipeline");
+	}
+}
+
+void ShadowPassPipeline::createShadowMap() {
+
+	//--------------------------------------------------------
+	// DEPTH IMAGE ARRAY
+	createImage(device, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 1, VK_SAMPLE_COUNT_1_BIT,
+		depthFormat, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		shadowMap.image, shadowMap.memory, SHADOW_CASCADE_COUNT);
+	shadowMap.view = createImageView(device, shadowMap.image, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1,
+		VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, SHADOW_CASCADE_COUNT);
+
+	//--------------------------------------------------------
+	// A FRAMEBUFFER PER CASCADE
+	layerViews.resize(SHADOW_CASCADE_COUNT);
+	framebuffers.resize(SHADOW_CASCADE_COUNT);
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+		layerViews[i] = createImageView(device, shadowMap.image, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1,
+			VK_IMAGE_VIEW_TYPE_2D, i, 1);
+
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = 1;
+		framebufferInfo.pAttachments = &layerViews[i];
+		framebufferInfo.width = SHADOW_MAP_SIZE;
+		framebufferInfo.height = SHADOW_MAP_SIZE;
+		framebufferInfo.layers = 1;
+
+		if (vkCreateFramebuffer(device.get(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shadow framebuffer");
+		}
+	}
+
+	//--------------------------------------------------------
+	// COMPARISON SAMPLER (hardware filtered depth test, lit outside the map)
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1.0f;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = 0.0f;
+
+	if (vkCreateSampler(device.get(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shadow sampler");
+	}
+}
+
+void ShadowPassPipeline::createShadowAtlas() {
+
+	//--------------------------------------------------------
+	// DEPTH IMAGE
+	createImage(device, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE, 1, VK_SAMPLE_COUNT_1_BIT,
+		depthFormat, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		shadowAtlas.image, shadowAtlas.memory);
+	shadowAtlas.view = createImageView(device, shadowAtlas.image, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+
+	//--------------------------------------------------------
+	// RENDER PASS THAT KEEPS THE CACHED TILES (compatible with the pipeline)
+	createDepthRenderPass(depthFormat, VK_ATTACHMENT_LOAD_OP_LOAD, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+		atlasRenderPass);
+
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = atlasRenderPass;
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.pAttachments = &shadowAtlas.view;
+	framebufferInfo.width = SHADOW_ATLAS_SIZE;
+	framebufferInfo.height = SHADOW_ATLAS_SIZE;
+	framebufferInfo.layers = 1;
+
+	if (vkCreateFramebuffer(device.get(), &framebufferInfo, nullptr, &atlasFramebuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shadow atlas framebuffer");
+	}
+}
+
+void ShadowPassPipeline::createQueryPool(uint32_t frameCount) {
+	timestampPeriod = device.getPhysicalDeviceProperties().limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo queryPoolInfo{};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = frameCount * SHADOW_CASCADE_COUNT * 2;
+
+	if (vkCreateQueryPool(device.get(), &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shadow query pool");
+	}
+}
+
+void ShadowPassPipeline::recordShadows(VkCommandBuffer commandBuffer, uint32_t frame,
+	const std::vector<Model*>& casters, const ShadowUboManager& shadowUniforms) {
+
+	uint32_t firstQuery = frame * SHADOW_CASCADE_COUNT * 2;
+	vkCmdResetQueryPool(commandBuffer, queryPool, firstQuery, SHADOW_CASCADE_COUNT * 2);
+
+	// casters in world space
+	std::vector<BoundingSphere> casterBounds(casters.size());
+	for (size_t i = 0; i < casters.size(); i++) {
+		casterBounds[i] = casters[i]->getWorldBounds();
+	}
+
+	//---------------------
+	// VIEWPORT AND SCISSOR (the whole layer)
+	VkExtent2D extent = { SHADOW_MAP_SIZE, SHADOW_MAP_SIZE };
+
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(extent.width);
+	viewport.height = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.offset = { 0, 0 };
+	scissor.extent = extent;
+
+	VkClearValue clearValue{};
+	clearValue.depthStencil = { 1.0f, 0 };
+
+	for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++) {
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, firstQuery + cascade * 2);
+
+		//---------------------
+		// RENDER PASS
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = framebuffers[cascade];
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = extent;
+		renderPassInfo.clearValueCount = 1;
+		renderPassInfo.pClearValues = &clearValue;
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		//---------------------
+		// CASTERS OF THE CASCADE
+		cascadeCasterCounts[cascade] = 0;
+		for (size_t i = 0; i < casters.size() && shadowUniforms.hasShadows(); i++) {
+			if (!shadowUniforms.isCasterVisible(cascade, casterBounds[i])) continue;
+			cascadeCasterCounts[cascade]++;
+			recordCaster(commandBuffer, casters[i], shadowUniforms.getCascade(cascade).viewProjection);
+		}
+
+		vkCmdEndRenderPass(commandBuffer);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, firstQuery + cascade * 2 + 1);
+	}
+}
+
+void ShadowPassPipeline::recordAtlasTiles(VkCommandBuffer commandBuffer, const std::vector<Model*>& casters,
+	const ShadowAtlasManager& shadowAtlasManager) {
+
+	// the cached tiles are kept (the first time the whole atlas is cleared to leave it in the sampled layout)
+	const std::vector<ShadowTileRender>& tiles = shadowAtlasManager.getTilesToRender();
+	if (tiles.empty() && atlasInitialized) return;
+
+	// casters in world space
+	std::vector<BoundingSphere> casterBounds(casters.size());
+	for (size_t i = 0; i < casters.size(); i++) {
+		casterBounds[i] = casters[i]->getWorldBounds();
+	}
+
+	//---------------------
+	// RENDER PASS
+	VkClearValue clearValue{};
+	clearValue.depthStencil = { 1.0f, 0 };
+
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = atlasInitialized ? atlasRenderPass : renderPass;
+	renderPassInfo.framebuffer = atlasFramebuffer;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = { SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE };
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearValue;
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+	for (const ShadowTileRender& tile : tiles) {
+
+		//---------------------
+		// VIEWPORT AND SCISSOR (the tile)
+		VkViewport viewport{};
+		viewport.x = static_cast<float>(tile.rect.offset.x);
+		viewport.y = static_cast<float>(tile.rect.offset.y);
+		viewport.width = static_cast<float>(tile.rect.extent.width);
+		viewport.height = static_cast<float>(tile.rect.extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &tile.rect);
+
+		// only the tile is cleared
+		VkClearAttachment clearAttachment{};
+		clearAttachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		clearAttachment.clearValue = clearValue;
+		VkClearRect clearRect{};
+		clearRect.rect = tile.rect;
+		clearRect.baseArrayLayer = 0;
+		clearRect.layerCount = 1;
+		vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect);
+
+		//---------------------
+		// CASTERS INSIDE THE LIGHT RANGE
+		for (size_t i = 0; i < casters.size(); i++) {
+			float distance = glm::length(casterBounds[i].center - tile.lightBounds.center);
+			if (distance >= casterBounds[i].radius + tile.lightBounds.radius) continue;
+
+			recordCaster(commandBuffer, casters[i], tile.viewProjection);
+		}
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+	atlasInitialized = true;
+}
+
+void ShadowPassPipeline::recordCaster(VkCommandBuffer commandBuffer, Model* model, const glm::mat4& viewProjection) {
+	ShadowPushConstants pushConstants{};
+	pushConstants.lightModelViewProjection = viewProjection * createModelMatrix(model->getTransform()) *
+		model->getDequantizationMatrix();
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants),
+		&pushConstants);
+
+	VkBuffer vertexBuffers[] = { model->getVertexBuffer() };
+	VkDeviceSize offsets[] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, model->getIndexBuffer(), 0, model->getIndexType());
+
+	for (uint32_t s = 0; s < model->getSubsetCount(); s++) {
+		const MeshSubset& subset = model->getSubset(s);
+		vkCmdDrawIndexed(commandBuffer, subset.indexCount, 1, subset.firstIndex, subset.vertexOffset, 0);
+	}
+}
+
+void ShadowPassPipeline::readCascadeTimes(uint32_t frame) {
+	uint64_t timestamps[SHADOW_CASCADE_COUNT * 2];
+	VkResult result = vkGetQueryPoolResults(device.get(), queryPool, frame * SHADOW_CASCADE_COUNT * 2,
+		SHADOW_CASCADE_COUNT * 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	// not ready before the first recording of the frame
+	if (result != VK_SUCCESS) return;
+
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+		cascadeTimes[i] = (timestamps[i * 2 + 1] - timestamps[i * 2]) * timestampPeriod * 1e-6f;
+	}
+}
+
+void ShadowPassPipeline::cleanup() {
+	vkDestroyQueryPool(device.get(), queryPool, nullptr);
+	vkDestroySampler(device.get(), sampler, nullptr);
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+		vkDestroyFramebuffer(device.get(), framebuffers[i], nullptr);
+		vkDestroyImageView(device.get(), layerViews[i], nullptr);
+	}
+	destroyImageObjects(device, shadowMap);
+	vkDestroyFramebuffer(device.get(), atlasFramebuffer, nullptr);
+	vkDestroyRenderPass(device.get(), atlasRenderPass, nullptr);
+	destroyImageObjects(device, shadowAtlas);
+
+	GraphicsPipeline::cleanup();
+}
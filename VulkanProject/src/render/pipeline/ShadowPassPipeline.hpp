@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "render/pipeline/GraphicsPipeline.hpp"
+#include "render/image/imageUtils.hpp"
+#include "render/uniform/ShadowUboManager.hpp"
+#include "render/uniform/ShadowAtlasManager.hpp"
+
+
+// Depth only pass that renders the shadow casters of each cascade of the directional light into a layer of the shadow
+// map array. The casters are culled against each cascade and the GPU time of every cascade is measured. The same
+// pipeline renders the invalidated tiles of the shadow atlas of point and spot lights
+class ShadowPassPipeline : public GraphicsPipeline {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	// Shadow map array with a comparison sampler (for the descriptor sets of the passes that receive shadows)
+	VkDescriptorImageInfo getShadowMapInfo() const {
+		return { sampler, shadowMap.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+	}
+	VkDescriptorImageInfo getShadowAtlasInfo() const {
+		return { sampler, shadowAtlas.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+	}
+
+	// Statistics of the last completed frame
+	float getCascadeTime(uint32_t cascade) const { return cascadeTimes[cascade]; }
+	uint32_t getCascadeCasterCount(uint32_t cascade) const { return cascadeCasterCounts[cascade]; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Create the depth pipeline for the vertex layout of the model, the shadow map array (a layer per cascade) and
+	// the timestamp queries of each frame in flight
+	void create(Device device, ShaderLibrary& shaderLibrary, LayoutCache& layoutCache, VkFormat depthFormat, Model* model,
+		uint32_t frameCount, std::string vertShaderLocation);
+
+	// Record the rendering of the casters visible in each cascade. The shadow map is cleared even if there are no
+	// shadows (it is always sampled by the first pass)
+	void recordShadows(VkCommandBuffer commandBuffer, uint32_t frame, const std::vector<Model*>& casters,
+		const ShadowUboManager& shadowUniforms);
+
+	// Record the rendering of the tiles invalidated by the last atlas update (the other tiles keep their content)
+	void recordAtlasTiles(VkCommandBuffer commandBuffer, const std::vector<Model*>& casters,
+		const ShadowAtlasManager& shadowAtlasManager);
+
+	// Read the GPU time of each cascade of the last completed recording of the frame
+	void readCascadeTimes(uint32_t frame);
+
+	// Destroy Vulkan and other objects
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	VkFormat depthFormat;
+
+	// a layer per cascade (the array view is sampled, the layer views are the framebuffer attachments)
+	ImageObjects shadowMap;
+	std::vector<VkImageView> layerViews;
+	std::vector<VkFramebuffer> framebuffers;
+	VkSampler sampler;
+
+	// single layer atlas of the point and spot lights tiles (loaded to keep the cached tiles)
+	ImageObjects shadowAtlas;
+	VkRenderPass atlasRenderPass;
+	VkFramebuffer atlasFramebuffer;
+	bool atlasInitialized = false;
+
+	// begin and end timestamps of each cascade for each frame in flight
+	VkQueryPool queryPool;
+	float timestampPeriod = 1.0f;
+	float cascadeTimes[SHADOW_CASCADE_COUNT] = {};
+	uint32_t cascadeCasterCounts[SHADOW_CASCADE_COUNT] = {};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	void createRenderPass(VkFormat imageFormat, VkFormat depthFormat) override;
+	void createGraphicsPipeline(std::string vertexShaderLocation, std::string fragmentShaderLocation) override;
+
+	// Depth only render pass whose result is sampled by the first pass
+	void createDepthRenderPass(VkFormat depthFormat, VkAttachmentLoadOp loadOp, VkImageLayout initialLayout,
+		VkRenderPass& depthRenderPass);
+
+	void createShadowMap();
+	void createShadowAtlas();
+
+	// Draw a caster with the light view projection
+	void recordCaster(VkCommandBuffer commandBuffer, Model* model, const glm::mat4& viewProjection);
+	void createQueryPool(uint32_t frameCount);
+};
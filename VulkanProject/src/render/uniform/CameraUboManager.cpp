@@ -0,0 +1,46 @@
+#include "render/uniform/CameraUboManager.hpp"
+
+#include <cstring>
+
+
+void CameraUboManager::createBuffers(Device device, size_t count) {
+
+	//--------------------------------------------------------
+	// SET CLASS MEMBERS
+
+	this->device = device;
+
+	buffers.resize(count);
+	buffersMemory.resize(count);
+	buffersMapped.resize(count);
+
+	//--------------------------------------------------------
+	// CREATE BUFFERS
+
+	VkDeviceSize bufferSize = sizeof(CameraUBO);
+	for (size_t i = 0; i < count; i++) {
+		device.createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			buffers[i], buffersMemory[i]);
+
+		vkMapMemory(device.get(), buffersMemory[i], 0, bufferSize, 0, &buffersMapped[i]);
+	}
+}
+
+void CameraUboManager::updateBuffer(uint32_t index, Camera& camera) {
+	CameraUBO ubo{};
+	ubo.view = camera.getView();
+	ubo.proj = camera.getProjection();
+
+	memcpy(buffersMapped[index], &ubo, sizeof(ubo));
+}
+
+void CameraUboManager::cleanup() {
+	for (size_t i = 0; i < buffers.size(); i++) {
+		vkDestroyBuffer(device.get(), buffers[i], nullptr);
+		vkFreeMemory(device.get(), buffersMemory[i], nullptr);
+	}
+	buffers.clear();
+	buffersMemory.clear();
+	buffersMapped.clear();
+}
@@ -5,36 +5,36 @@
 
 #include "context/Device.hpp"
 #include "scene/Camera.hpp"
-#include "scene/Light.hpp"
 
 
-struct LightUBO {
-    alignas(16) glm::vec3 pos;
-    alignas(16) glm::vec3 color;
-    alignas(16) glm::vec3 direction;
+// See alignment requirements in specification
+// (https://docs.vulkan.org/spec/latest/chapters/interfaces.html#interfaces-resources-layout)
+// Matrices shared by every draw of a frame (the draws push their model matrices)
+struct CameraUBO {
+    alignas(16) glm::mat4 view;
+    alignas(16) glm::mat4 proj;
 };
 
 
-// Manage a buffer with all lights for each FRAME_IN_FLIGHT
-class LightUboManager {
+// Manage the uniform buffers with the camera of the frame. They are written once per frame instead of a buffer per
+// model
+class CameraUboManager {
 public:
 
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // GETTERS AND SETTERS
 
-    size_t getLightCount() const { return lightCount; }
-
-    // Return a buffer that references the memory with all the lights
+    bool hasBuffers() const { return !buffers.empty(); }
     VkBuffer getBuffer(size_t index) const { return buffers[index]; }
 
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // METHODS
 
     // Create as many uniform buffers as count
-    void createBuffers(Device device, size_t count, size_t lightCount);
+    void createBuffers(Device device, size_t count);
 
     // Update uniform values
-    void upateBuffer(uint32_t index, std::vector<Light> lights, Camera camera);
+    void updateBuffer(uint32_t index, Camera& camera);
 
     // Destroy Vulkan an other objects
     void cleanup();
@@ -46,9 +46,6 @@ private:
 
     Device device;
 
-    size_t lightCount = 0;
-
-    // a vector per frame
     std::vector<VkBuffer> buffers;
     std::vector<VkDeviceMemory> buffersMemory;
     std::vector<void*> buffersMapped;
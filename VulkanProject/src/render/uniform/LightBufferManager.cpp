@@ -0,0 +1,328 @@
+#include "render/uniform/LightBufferManager.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+
+namespace {
+
+	// Logarithmic depth slice of a view space depth (the same distribution as the fragment shader)
+	uint32_t depthSlice(float depth, float nearPlane, float farPlane) {
+		float slice = std::log(depth / nearPlane) / std::log(farPlane / nearPlane) * CLUSTER_GRID_Z;
+		return static_cast<uint32_t>(glm::clamp(slice, 0.0f, static_cast<float>(CLUSTER_GRID_Z - 1)));
+	}
+
+	// Screen tile of a normalized device coordinate
+	uint32_t tile(float ndc, uint32_t gridSize) {
+		float position = (ndc * 0.5f + 0.5f) * gridSize;
+		return static_cast<uint32_t>(glm::clamp(position, 0.0f, static_cast<float>(gridSize - 1)));
+	}
+}
+
+
+uint32_t LightBufferManager::getLightSlot(const Light* light) const {
+	auto found = lightSlots.find(light);
+	return found != lightSlots.end() ? found->second : UINT32_MAX;
+}
+
+void LightBufferManager::createBuffers(Device device, size_t count) {
+
+	//--------------------------------------------------------
+	// SET CLASS MEMBERS
+
+	this->device = device;
+	lightCapacity = INITIAL_LIGHT_CAPACITY;
+	lightIndexCapacity = static_cast<size_t>(CLUSTER_COUNT) * AVERAGE_LIGHTS_PER_CLUSTER;
+
+	lightBuffers.resize(count);
+	lightBuffersMemory.resize(count);
+	lightBuffersMapped.resize(count);
+	clusterBuffers.resize(count);
+	clusterBuffersMemory.resize(count);
+	clusterBuffersMapped.resize(count);
+	lightIndexBuffers.resize(count);
+	lightIndexBuffersMemory.resize(count);
+	lightIndexBuffersMapped.resize(count);
+	uploadedLights.resize(count);
+
+	clusterCounts.resize(CLUSTER_COUNT);
+	clusterCells.resize(CLUSTER_COUNT);
+
+	//--------------------------------------------------------
+	// CREATE BUFFERS
+
+	for (size_t i = 0; i < count; i++) {
+		createMappedBuffer(getLightBufferSize(), lightBuffers[i], lightBuffersMemory[i], lightBuffersMapped[i]);
+		createMappedBuffer(getClusterBufferSize(), clusterBuffers[i], clusterBuffersMemory[i], clusterBuffersMapped[i]);
+		createMappedBuffer(getLightIndexBufferSize(), lightIndexBuffers[i], lightIndexBuffersMemory[i],
+			lightIndexBuffersMapped[i]);
+	}
+}
+
+void LightBufferManager::growLightBuffers(size_t lightCount) {
+	lightCapacity = std::max(lightCapacity * 2, lightCount);
+
+	// the old buffers may be in use by the frames in flight
+	vkDeviceWaitIdle(device.get());
+
+	for (size_t i = 0; i < lightBuffers.size(); i++) {
+		vkDestroyBuffer(device.get(), lightBuffers[i], nullptr);
+		vkFreeMemory(device.get(), lightBuffersMemory[i], nullptr);
+		createMappedBuffer(getLightBufferSize(), lightBuffers[i], lightBuffersMemory[i], lightBuffersMapped[i]);
+
+		// the new buffers are empty: every light has to be written
+		uploadedLights[i].clear();
+	}
+	buffersRecreated = true;
+}
+
+void LightBufferManager::updateSlots(const std::vector<Light*>& lights) {
+	currentStamp++;
+
+	// new lights at the end
+	for (Light* light : lights) {
+		if (light->getType() == LIGHT_TYPE_DIRECTIONAL) continue;
+
+		auto [slot, inserted] = lightSlots.emplace(light, static_cast<uint32_t>(slotLights.size()));
+		if (inserted) {
+			slotLights.push_back(light);
+			lightStamps.push_back(currentStamp);
+		}
+		else {
+			lightStamps[slot->second] = currentStamp;
+		}
+	}
+
+	// removed lights (not received this time)
+	for (size_t s = 0; s < slotLights.size();) {
+		if (lightStamps[s] == currentStamp) {
+			s++;
+			continue;
+		}
+
+		lightSlots.erase(slotLights[s]);
+		size_t last = slotLights.size() - 1;
+		if (s != last) {
+			slotLights[s] = slotLights[last];
+			lightStamps[s] = lightStamps[last];
+			lightSlots[slotLights[s]] = static_cast<uint32_t>(s);
+		}
+		slotLights.pop_back();
+		lightStamps.pop_back();
+	}
+}
+
+void LightBufferManager::createMappedBuffer(VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& memory, void*& mapped) {
+	device.createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		buffer, memory);
+
+	vkMapMemory(device.get(), memory, 0, size, 0, &mapped);
+	memset(mapped, 0, size);
+}
+
+void LightBufferManager::runRanges(uint32_t count, uint32_t grainSize, const WorkerRange& body) {
+	if (workerPool != nullptr) workerPool->parallelFor(count, grainSize, body);
+	else body(0, count);
+}
+
+bool LightBufferManager::computeClusterRange(glm::vec3 viewPosition, float radius, const glm::mat4& projection,
+	float nearPlane, float farPlane, ClusterRange& range) const {
+
+	//--------------------------------------------
+	// DEPTH SLICES (the camera looks to -Z)
+	float depth = -viewPosition.z;
+	float minDepth = depth - radius;
+	float maxDepth = depth + radius;
+	if (maxDepth < nearPlane || minDepth > farPlane) return false;
+
+	range.minZ = depthSlice(std::max(minDepth, nearPlane), nearPlane, farPlane);
+	range.maxZ = depthSlice(std::min(maxDepth, farPlane), nearPlane, farPlane);
+
+	//--------------------------------------------
+	// SCREEN TILES (projected bounding box of the sphere)
+	if (minDepth <= nearPlane) {
+		// the sphere crosses the near plane: its projection is unbounded
+		range.minX = 0;
+		range.maxX = CLUSTER_GRID_X - 1;
+		range.minY = 0;
+		range.maxY = CLUSTER_GRID_Y - 1;
+		return true;
+	}
+
+	glm::vec2 minNdc(1.0f);
+	glm::vec2 maxNdc(-1.0f);
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 offset(
+			(corner & 1) ? radius : -radius,
+			(corner & 2) ? radius : -radius,
+			(corner & 4) ? radius : -radius);
+		glm::vec4 clip = projection * glm::vec4(viewPosition + offset, 1.0f);
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		minNdc = glm::min(minNdc, ndc);
+		maxNdc = glm::max(maxNdc, ndc);
+	}
+	if (maxNdc.x < -1.0f || maxNdc.y < -1.0f || minNdc.x > 1.0f || minNdc.y > 1.0f) return false;
+
+	range.minX = tile(minNdc.x, CLUSTER_GRID_X);
+	range.maxX = tile(maxNdc.x, CLUSTER_GRID_X);
+	range.minY = tile(minNdc.y, CLUSTER_GRID_Y);
+	range.maxY = tile(maxNdc.y, CLUSTER_GRID_Y);
+	return true;
+}
+
+void LightBufferManager::updateBuffers(uint32_t index, const std::vector<Light*>& lights, Camera& camera,
+	VkExtent2D extent, const ShadowAtlasManager* shadowAtlas) {
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	glm::mat4 view = camera.getView();
+	glm::mat4 projection = camera.getProjection();
+	float nearPlane = camera.getNearPlane();
+	float farPlane = camera.getFarPlane();
+
+	//--------------------------------------------------------
+	// LIGHT SLOTS
+
+	buffersRecreated = false;
+	updateSlots(lights);
+	uint32_t lightCount = static_cast<uint32_t>(slotLights.size());
+	if (lightCount > lightCapacity) {
+		growLightBuffers(lightCount);
+	}
+
+	//--------------------------------------------------------
+	// CHANGED LIGHTS (world space)
+
+	auto* lightHeader = static_cast<LightBufferHeader*>(lightBuffersMapped[index]);
+	auto* gpuLights = reinterpret_cast<GPULight*>(lightHeader + 1);
+	lightHeader->lightCount = lightCount;
+
+	std::vector<GPULight>& uploaded = uploadedLights[index];
+	uploadedLightCount = 0;
+	for (uint32_t s = 0; s < lightCount; s++) {
+		Light* light = slotLights[s];
+
+		GPULight gpuLight;
+		gpuLight.positionRadius = glm::vec4(light->getTransform()->position, light->getRadius());
+		float firstShadowTile = shadowAtlas ? static_cast<float>(shadowAtlas->getFirstTile(light)) : -1.0f;
+		gpuLight.color = glm::vec4(light->getColor(), firstShadowTile);
+		float spotCosine = light->getType() == LIGHT_TYPE_SPOT ? std::cos(light->getSpotAngle()) : -1.0f;
+		gpuLight.direction = glm::vec4(light->getDirection(), spotCosine);
+
+		if (s < uploaded.size()) {
+			if (memcmp(&uploaded[s], &gpuLight, sizeof(GPULight)) == 0) continue;
+			uploaded[s] = gpuLight;
+		}
+		else {
+			uploaded.push_back(gpuLight);
+		}
+		gpuLights[s] = gpuLight;
+		uploadedLightCount++;
+	}
+
+	//--------------------------------------------------------
+	// CLUSTERS OF EACH LIGHT (view space)
+
+	lightRanges.resize(lightCount);
+	std::fill(clusterCounts.begin(), clusterCounts.end(), 0);
+	const uint32_t OUTSIDE = UINT32_MAX;
+
+	runRanges(lightCount, LIGHT_ASSIGNMENT_GRAIN_SIZE, [&](uint32_t first, uint32_t last) {
+		for (uint32_t i = first; i < last; i++) {
+			glm::vec3 lightPos = glm::vec3(view * glm::vec4(glm::vec3(uploaded[i].positionRadius), 1.0f));
+			float radius = uploaded[i].positionRadius.w;
+
+			ClusterRange& range = lightRanges[i];
+			if (!computeClusterRange(lightPos, radius, projection, nearPlane, farPlane, range)) {
+				range.minX = OUTSIDE;
+			}
+		}
+	});
+
+	// count the lights of each cluster (a depth slice per job, so each cluster is written by a single thread)
+	runRanges(CLUSTER_GRID_Z, 1, [&](uint32_t first, uint32_t last) {
+		for (uint32_t z = first; z < last; z++) {
+			for (uint32_t i = 0; i < lightCount; i++) {
+				const ClusterRange& range = lightRanges[i];
+				if (range.minX == OUTSIDE || z < range.minZ || z > range.maxZ) continue;
+
+				for (uint32_t y = range.minY; y <= range.maxY; y++) {
+					for (uint32_t x = range.minX; x <= range.maxX; x++) {
+						clusterCounts[(z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x]++;
+					}
+				}
+			}
+		}
+	});
+
+	//--------------------------------------------------------
+	// CLUSTER RANGES IN THE LIGHT INDEX LIST
+
+	auto* clusterHeader = static_cast<ClusterGridHeader*>(clusterBuffersMapped[index]);
+	auto* cells = reinterpret_cast<ClusterCell*>(clusterHeader + 1);
+	clusterHeader->gridSize = glm::uvec4(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, 0);
+	clusterHeader->viewport = glm::vec4(extent.width, extent.height, nearPlane, farPlane);
+	clusterHeader->inverseView = glm::inverse(view);
+
+	// the ranges are kept on the CPU while they are filled (the mapped memory is only written)
+	uint32_t offset = 0;
+	bool overflow = false;
+	for (uint32_t c = 0; c < CLUSTER_COUNT; c++) {
+		uint32_t count = clusterCounts[c];
+		if (offset + count > lightIndexCapacity) {
+			count = static_cast<uint32_t>(lightIndexCapacity) - offset;
+			overflow = true;
+		}
+		clusterCells[c] = { offset, 0 };
+		clusterCounts[c] = count; // space left for the cluster
+		offset += count;
+	}
+	assignedLightIndexCount = offset;
+
+	if (overflow && !overflowReported) {
+		std::cout << "Clustered lighting: light index list full, some lights are ignored" << std::endl;
+		overflowReported = true;
+	}
+
+	//--------------------------------------------------------
+	// FILL THE LIGHT INDEX LIST (a depth slice per job, the lights of each cluster in slot order)
+
+	auto* lightIndices = static_cast<uint32_t*>(lightIndexBuffersMapped[index]);
+	runRanges(CLUSTER_GRID_Z, 1, [&](uint32_t first, uint32_t last) {
+		for (uint32_t z = first; z < last; z++) {
+			for (uint32_t i = 0; i < lightCount; i++) {
+				const ClusterRange& range = lightRanges[i];
+				if (range.minX == OUTSIDE || z < range.minZ || z > range.maxZ) continue;
+
+				for (uint32_t y = range.minY; y <= range.maxY; y++) {
+					for (uint32_t x = range.minX; x <= range.maxX; x++) {
+						uint32_t c = (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+						ClusterCell& cell = clusterCells[c];
+						if (cell.count < clusterCounts[c]) {
+							lightIndices[cell.offset + cell.count++] = i;
+						}
+					}
+				}
+			}
+		}
+	});
+	memcpy(cells, clusterCells.data(), sizeof(ClusterCell) * CLUSTER_COUNT);
+
+	auto end = std::chrono::high_resolution_clock::now();
+	updateTime = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void LightBufferManager::cleanup() {
+	for (size_t i = 0; i < lightBuffers.size(); i++) {
+		vkDestroyBuffer(device.get(), lightBuffers[i], nullptr);
+		vkFreeMemory(device.get(), lightBuffersMemory[i], nullptr);
+		vkDestroyBuffer(device.get(), clusterBuffers[i], nullptr);
+		vkFreeMemory(device.get(), clusterBuffersMemory[i], nullptr);
+		vkDestroyBuffer(device.get(), lightIndexBuffers[i], nullptr);
+		vkFreeMemory(device.get(), lightIndexBuffersMemory[i], nullptr);
+	}
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+
+#include "context/Device.hpp"
+#include "scene/Camera.hpp"
+#include "scene/Light.hpp"
+#include "render/uniform/ShadowAtlasManager.hpp"
+#include "system/WorkerPool.hpp"
+
+
+//--------------------------------------------------------
+// CLUSTER GRID (view space froxels: screen tiles and logarithmic depth slices)
+const uint32_t CLUSTER_GRID_X = 16;
+const uint32_t CLUSTER_GRID_Y = 9;
+const uint32_t CLUSTER_GRID_Z = 24;
+const uint32_t CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+// Average lights per cluster the light index list has space for
+const uint32_t AVERAGE_LIGHTS_PER_CLUSTER = 64;
+
+// Lights the light buffers have space for before they grow
+const size_t INITIAL_LIGHT_CAPACITY = 64;
+
+// Lights whose clusters are computed by each job of the assignment
+const uint32_t LIGHT_ASSIGNMENT_GRAIN_SIZE = 64;
+
+
+// See alignment requirements in specification
+// (https://docs.vulkan.org/spec/latest/chapters/interfaces.html#interfaces-resources-layout)
+// Light in world space (std430)
+struct GPULight {
+    alignas(16) glm::vec4 positionRadius;
+    alignas(16) glm::vec4 color;        // w = first shadow atlas tile (-1 without shadows)
+    alignas(16) glm::vec4 direction;    // w = cosine of the spot cone half angle (-1 for point lights)
+};
+
+struct LightBufferHeader {
+    uint32_t lightCount;
+    uint32_t padding[3];
+};
+
+// Information the fragment shader needs to find its cluster and to shade in world space
+struct ClusterGridHeader {
+    alignas(16) glm::uvec4 gridSize;
+    alignas(16) glm::vec4 viewport;     // width, height, near plane, far plane
+    alignas(16) glm::mat4 inverseView;
+};
+
+// Range of the light index list with the lights of a cluster
+struct ClusterCell {
+    uint32_t offset;
+    uint32_t count;
+};
+
+
+// Manage the storage buffers with all the lights and their assignment to the clusters of the view frustum, a set of
+// buffers per frame in flight (updated when the previous commands of its frame are completed). Each light keeps its slot
+// of the light buffers while it exists, so only new lights and lights whose transform or color changed since the last
+// update of the set are written. The light buffers grow when the lights do not fit
+
+class LightBufferManager {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // GETTERS AND SETTERS
+
+    size_t getLightCapacity() const { return lightCapacity; }
+    uint32_t getLightCount() const { return static_cast<uint32_t>(slotLights.size()); }
+
+    // Slot of the light in the light buffers (UINT32_MAX if it is not in them)
+    uint32_t getLightSlot(const Light* light) const;
+
+    // Assign the lights to the clusters in the worker threads (on the calling thread if there is no pool)
+    void setWorkerPool(WorkerPool* workerPool) { this->workerPool = workerPool; }
+
+    // True if the last update recreated the buffers (the descriptor sets that use them must be written again)
+    bool wereBuffersRecreated() const { return buffersRecreated; }
+
+    // Buffers with the lights, the cluster grid and the light indices of the clusters
+    VkBuffer getLightBuffer(size_t index) const { return lightBuffers[index]; }
+    VkBuffer getClusterBuffer(size_t index) const { return clusterBuffers[index]; }
+    VkBuffer getLightIndexBuffer(size_t index) const { return lightIndexBuffers[index]; }
+
+    VkDeviceSize getLightBufferSize() const { return sizeof(LightBufferHeader) + sizeof(GPULight) * lightCapacity; }
+    VkDeviceSize getClusterBufferSize() const { return sizeof(ClusterGridHeader) + sizeof(ClusterCell) * CLUSTER_COUNT; }
+    VkDeviceSize getLightIndexBufferSize() const { return sizeof(uint32_t) * lightIndexCapacity; }
+
+    // Statistics of the last update
+    uint32_t getUploadedLightCount() const { return uploadedLightCount; }
+    uint32_t getAssignedLightIndexCount() const { return assignedLightIndexCount; }
+    float getUpdateTime() const { return updateTime; }
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // METHODS
+
+    // Create as many sets of light buffers as count (one per frame in flight)
+    void createBuffers(Device device, size_t count);
+
+    // Update the point and spot lights (the buffers grow if necessary) and assign them to the clusters of the camera
+    // frustum. Directional lights are ignored (they are shaded with the shadow cascades). The shadow tiles of the
+    // lights are taken from shadowAtlas (if any)
+    void updateBuffers(uint32_t index, const std::vector<Light*>& lights, Camera& camera, VkExtent2D extent,
+        const ShadowAtlasManager* shadowAtlas = nullptr);
+
+    // Destroy Vulkan an other objects
+    void cleanup();
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // CLASS MEMBERS
+
+    Device device;
+    WorkerPool* workerPool = nullptr;
+
+    size_t lightCapacity = 0;
+    size_t lightIndexCapacity = 0;
+    bool buffersRecreated = false;
+
+    // a buffer per frame in flight
+    std::vector<VkBuffer> lightBuffers;
+    std::vector<VkDeviceMemory> lightBuffersMemory;
+    std::vector<void*> lightBuffersMapped;
+    std::vector<VkBuffer> clusterBuffers;
+    std::vector<VkDeviceMemory> clusterBuffersMemory;
+    std::vector<void*> clusterBuffersMapped;
+    std::vector<VkBuffer> lightIndexBuffers;
+    std::vector<VkDeviceMemory> lightIndexBuffersMemory;
+    std::vector<void*> lightIndexBuffersMapped;
+
+    // light of each slot of the light buffers and slot of each light
+    std::vector<Light*> slotLights;
+    std::unordered_map<const Light*, uint32_t> lightSlots;
+    // copy of the lights written in each light buffer (to skip the unchanged ones)
+    std::vector<std::vector<GPULight>> uploadedLights;
+
+    // assignment scratch data (kept to avoid allocations every frame)
+    struct ClusterRange {
+        uint32_t minX, maxX, minY, maxY, minZ, maxZ;
+    };
+    std::vector<ClusterRange> lightRanges;
+    std::vector<uint32_t> clusterCounts;
+    // ranges of the clusters filled on the CPU and copied once to the mapped buffer
+    std::vector<ClusterCell> clusterCells;
+    std::vector<uint32_t> lightStamps;
+    uint32_t currentStamp = 0;
+
+    uint32_t uploadedLightCount = 0;
+    uint32_t assignedLightIndexCount = 0;
+    float updateTime = 0.0f;
+    bool overflowReported = false;
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // METHODS
+
+    // Create a host visible buffer and keep it mapped
+    void createMappedBuffer(VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& memory, void*& mapped);
+
+    // Give a slot to the new lights and free the slots of the removed ones (the last slot fills the hole)
+    void updateSlots(const std::vector<Light*>& lights);
+
+    // Recreate the light buffers with space for at least lightCount lights
+    void growLightBuffers(size_t lightCount);
+
+    // Clusters touched by the bounding box of a light sphere (false if the light is outside the frustum)
+    bool computeClusterRange(glm::vec3 viewPosition, float radius, const glm::mat4& projection, float nearPlane,
+        float farPlane, ClusterRange& range) const;
+
+    // Call the body with ranges of [0, count) in the worker pool, or with the whole range without it
+    void runRanges(uint32_t count, uint32_t grainSize, const WorkerRange& body);
+};
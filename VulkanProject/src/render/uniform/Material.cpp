@@ -2,37 +2,74 @@
 
 #include <iostream>
 #include <stdexcept>
-#include <stb_image.h>
 
-#include "asset/imageLoader.hpp"
 #include "render/image/imageUtils.hpp"
+#include "render/uniform/MaterialTable.hpp"
 
 
-void Material::setContext(Device device, CommandManager commandManager) {
+void Material::setContext(Device device, CommandManager commandManager, SamplerCache& samplerCache,
+	TextureManager& textureManager) {
+
 	this->device = device;
 	this->commandManager = commandManager;
+	this->samplerCache = &samplerCache;
+	this->textureManager = &textureManager;
+}
+
+std::vector<VkImage> Material::getTextureImages() const {
+	std::vector<VkImage> images;
+	if (hasAlbedo()) images.push_back(albedoTexture.image);
+	if (hasSpecular()) images.push_back(specularTexture.image);
+	if (hasNormal()) images.push_back(normalTexture.image);
+	for (const auto& texture : customTextures) {
+		images.push_back(texture.image);
+	}
+	return images;
+}
+
+void Material::listTextures(const TexturePaths& texturePaths, std::vector<TextureType>& types,
+	std::vector<std::string>& paths) {
+
+	if (texturePaths.albedoPath.has_value()) {
+		types.push_back(TEXTURE_TYPE_ALBEDO_BIT);
+		paths.push_back(texturePaths.albedoPath.value());
+	}
+	if (texturePaths.specularPath.has_value()) {
+		types.push_back(TEXTURE_TYPE_SPECULAR_BIT);
+		paths.push_back(texturePaths.specularPath.value());
+	}
+	if (texturePaths.normalPath.has_value()) {
+		types.push_back(TEXTURE_TYPE_NORMAL_BIT);
+		paths.push_back(texturePaths.normalPath.value());
+	}
+	for (auto& texturePath : texturePaths.customPaths) {
+		types.push_back(TEXTURE_TYPE_CUSTOM_BIT);
+		paths.push_back(texturePath);
+	}
 }
 
 void Material::createTextures(TexturePaths texturePaths) {
+	std::vector<TextureType> types;
+	std::vector<std::string> paths;
+	listTextures(texturePaths, types, paths);
 
-	if (texturePaths.albedoPath.has_value())
-		createTexture(TEXTURE_TYPE_ALBEDO_BIT, texturePaths.albedoPath.value());
-	if (texturePaths.specularPath.has_value())
-		createTexture(TEXTURE_TYPE_SPECULAR_BIT, texturePaths.specularPath.value());
-	if (texturePaths.normalPath.has_value())
-		createTexture(TEXTURE_TYPE_NORMAL_BIT, texturePaths.normalPath.value());
-	for (auto& texturePath : texturePaths.customPaths)
-		createTexture(TEXTURE_TYPE_CUSTOM_BIT, texturePath);
+	// the textures are decoded together and uploaded with a single submission
+	storeTextures(types, textureManager->acquire(paths));
+}
+
+void Material::storeTextures(const std::vector<TextureType>& types, const std::vector<Texture>& textures) {
+	for (size_t i = 0; i < textures.size(); i++) {
+		mipLevels = textures[i].mipLevels;
+		storeTexture(types[i], textures[i].image);
+	}
 }
 
 void Material::createTexture(TextureType type, std::string texturePath) {
-	// CREATE THE TEXTURE
-	ImageObjects newTexture{};
-	createTextureImage(texturePath, newTexture);
-	newTexture.view = createImageView(
-		device, newTexture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+	// GET THE TEXTURE (shared with the materials that name the same file)
+	Texture texture = textureManager->acquire(texturePath);
+	mipLevels = texture.mipLevels;
 
-	storeTexture(type, newTexture);
+	storeTexture(type, texture.image);
 }
 
 void Material::addTexture(TextureType type, ImageObjects texture) {
@@ -40,6 +77,16 @@ void Material::addTexture(TextureType type, ImageObjects texture) {
 	storeTexture(type, texture);
 }
 
+void Material::setMinLod(float minLod) {
+	if (minLod == this->minLod) return;
+	this->minLod = minLod;
+
+	// the current sampler is kept until cleanup (frames in flight can use it)
+	if (sampler == VK_NULL_HANDLE) return;
+	previousSamplers.push_back(sampler);
+	createSampler(mipLevels);
+}
+
 void Material::storeTexture(TextureType type, ImageObjects texture) {
 	// CREATE THE SAMPLER (if not created yet)
 	if (sampler == VK_NULL_HANDLE) createSampler(mipLevels);
@@ -94,73 +141,27 @@ void Material::createSampler(uint32_t mipLevels) {
 	// MIPMAPS
 	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	samplerInfo.mipLodBias = 0.0f; // optional
-	samplerInfo.minLod = 0.0f; // optional
+	samplerInfo.minLod = minLod;
 	samplerInfo.maxLod = static_cast<float>(mipLevels);
 
-	// CREATE SAMPLER
-	if (vkCreateSampler(device.get(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create texture sampler");
-	}
-}
-
-// TODO: review if this method or part of it could be in imageUtils or similar
-void Material::createTextureImage(std::string texturePath, ImageObjects& texture) {
-	//-----------------------------------------
-	// LOAD IMAGE
-	RawImage image = loadImageFromFile(texturePath);
-	VkDeviceSize imageSize = static_cast<VkDeviceSize>(image.size);
-	uint32_t texWidth = static_cast<uint32_t>(image.width);
-	uint32_t texHeight = static_cast<uint32_t>(image.height);
-	// Compute mip levels
-	mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(image.width, image.height)))) + 1;
-
-	//-----------------------------------------
-	// COPY IMAGE TO STAGING BUFFER
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	device.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer, stagingBufferMemory);
-
-	void* data;
-	vkMapMemory(device.get(), stagingBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, image.pixels, static_cast<size_t>(imageSize));
-	vkUnmapMemory(device.get(), stagingBufferMemory);
-
-	// cleanup old pixel array
-	image.free();
-
-	//-----------------------------------------
-	// CREATE IMAGE
-	createImage(device, texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT,
-		VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		texture.image, texture.memory);
-
-	//-----------------------------------------
-	// COPY THE IMAGE FROM STAGING BUFFER
-	transitionImageLayout(commandManager, texture.image,
-		VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		mipLevels);
-	copyBufferToImage(commandManager, stagingBuffer, texture.image,
-		static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-	// transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
-
-	//-----------------------------------------
-	// CLEAN UP STAGING STUFF
-	vkDestroyBuffer(device.get(), stagingBuffer, nullptr);
-	vkFreeMemory(device.get(), stagingBufferMemory, nullptr);
-
-	//-----------------------------------------
-	// GENERATE MIPMAPS
-	generateMipmaps(device, commandManager, texture.image, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mipLevels);
+	// GET SAMPLER (shared with the materials with the same mip levels)
+	sampler = samplerCache->acquire(samplerInfo);
 }
 
 
 void Material::cleanup() {
-	vkDestroySampler(device.get(), sampler, nullptr);
+	if (materialTable != nullptr) {
+		materialTable->removeMaterial(*this);
+		materialTable = nullptr;
+	}
+	if (sampler != VK_NULL_HANDLE) {
+		samplerCache->release(sampler);
+		sampler = VK_NULL_HANDLE;
+	}
+	for (VkSampler previousSampler : previousSamplers) {
+		samplerCache->release(previousSampler);
+	}
+	previousSamplers.clear();
 
 	destroyTextures();
 }
@@ -168,17 +169,27 @@ void Material::cleanup() {
 void Material::destroyTextures() {
 
 	if (TEXTURE_TYPE_ALBEDO_BIT & usedTypes)
-		destroyImageObjects(device, albedoTexture);
+		destroyTexture(albedoTexture);
 	if (TEXTURE_TYPE_SPECULAR_BIT & usedTypes)
-		destroyImageObjects(device, specularTexture);
+		destroyTexture(specularTexture);
 	if (TEXTURE_TYPE_NORMAL_BIT & usedTypes)
-		destroyImageObjects(device, normalTexture);
+		destroyTexture(normalTexture);
 
 	for (auto& texture : customTextures) {
-		destroyImageObjects(device, texture);
+		destroyTexture(texture);
 	}
 	customTextures.clear();
 
 	textureCount = 0;
 	usedTypes = TEXTURE_TYPE_NONE_BIT;
 }
+
+void Material::destroyTexture(ImageObjects& texture) {
+	// the shared textures are released (the added ones are not owned)
+	if (textureManager != nullptr && textureManager->owns(texture.image)) {
+		textureManager->release(texture.image);
+		texture = {};
+		return;
+	}
+	destroyImageObjects(device, texture);
+}
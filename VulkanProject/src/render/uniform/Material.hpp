@@ -7,8 +7,12 @@
 #include "context/Device.hpp"
 #include "context/CommandManager.hpp"
 #include "render/image/imageUtils.hpp"
+#include "render/image/SamplerCache.hpp"
+#include "render/image/TextureManager.hpp"
 
 
+class MaterialTable;
+
 struct TexturePaths {
 	std::optional<std::string> albedoPath;
 	std::optional<std::string> specularPath;
@@ -25,46 +29,71 @@ enum TextureType {
 };
 
 
-// TODO: add other material info (shininess, etc)
+// TODO: add other material info
 struct Material {
 
 	using TextureTypes = uint32_t;
 
 	Device device;
 	CommandManager commandManager;
+	SamplerCache* samplerCache = nullptr;
+	TextureManager* textureManager = nullptr;
 
 	size_t textureCount = 0;
 	TextureTypes usedTypes = TEXTURE_TYPE_NONE_BIT;
 
+	// Blinn-Phong exponent (specialization constant of the first pass)
+	float shininess = 20.0f;
+
 	ImageObjects albedoTexture;
 	ImageObjects specularTexture;
 	ImageObjects normalTexture;
 	std::vector<ImageObjects> customTextures;
 
-	uint32_t mipLevels = 1; // computed in createTexture() since them depend on the texture size
-	// TODO: review other owner for the sampler
+	uint32_t mipLevels = 1; // of the last created texture (they depend on the texture size)
+	// first level that the textures can be sampled from (the finer levels of streamed textures are not resident yet)
+	float minLod = 0.0f;
+	// shared with the materials with the same sampler state (owned by the sampler cache)
 	VkSampler sampler = VK_NULL_HANDLE;
+	// samplers of the previous min LODs (frames in flight can use them, there is one per mip level at most)
+	std::vector<VkSampler> previousSamplers;
+	// bindless table the material was added to (it is removed from the table on cleanup)
+	MaterialTable* materialTable = nullptr;
 
 	bool hasAlbedo() const { return usedTypes & TEXTURE_TYPE_ALBEDO_BIT; }
 	bool hasSpecular() const { return usedTypes & TEXTURE_TYPE_SPECULAR_BIT; }
 	bool hasNormal() const { return usedTypes & TEXTURE_TYPE_NORMAL_BIT; }
 	bool hasCustom() const { return usedTypes & TEXTURE_TYPE_CUSTOM_BIT; }
+
+	// Images of every texture of the material
+	std::vector<VkImage> getTextureImages() const;
 	
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// METHODS
 	
-	// Store the device and command manager for future operations
-	void setContext(Device device, CommandManager commandManager);
+	// Store the device, command manager, sampler cache and texture manager for future operations
+	void setContext(Device device, CommandManager commandManager, SamplerCache& samplerCache,
+		TextureManager& textureManager);
 
-	// Create all textures with a defined path in the struct texturePaths
+	// Get all textures with a defined path in the struct texturePaths from the texture manager
 	void createTextures(TexturePaths texturePaths);
 
-	// Create all the resources involved in texture usage and add it to the texture list
+	// Store the textures already acquired from the texture manager (one per type, see listTextures)
+	void storeTextures(const std::vector<TextureType>& types, const std::vector<Texture>& textures);
+
+	// Type and file of each defined path, in the order the textures are stored
+	static void listTextures(const TexturePaths& texturePaths, std::vector<TextureType>& types,
+		std::vector<std::string>& paths);
+
+	// Get the texture of the file from the texture manager and add it to the texture list
 	void createTexture(TextureType type, std::string texturePath);
 
 	// Add a texture of the specified type
 	void addTexture(TextureType type, ImageObjects texture);
 
+	// Clamp the sampling of the textures to the level (the sampler is replaced, its descriptors have to be written again)
+	void setMinLod(float minLod);
+
 	// Destroy Vulkan and other objects
 	void cleanup();
 
@@ -76,11 +105,11 @@ private:
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// METHODS
 
-	// Create an image and its memory for the texture and generate its mipmaps
-	void createTextureImage(std::string texturePath, ImageObjects& texture);
-	
-	// Create sampler for the textures
+	// Get the sampler for the textures from the cache
 	void createSampler(uint32_t mipLevels);
 
 	void storeTexture(TextureType type, ImageObjects texture);
+
+	// Release a shared texture or destroy an owned one
+	void destroyTexture(ImageObjects& texture);
 };
@@ -0,0 +1,208 @@
+#include "render/uniform/MaterialTable.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+
+int32_t MaterialTable::getMaterialIndex(const Material& material) const {
+	auto found = materials.find(&material);
+	return found != materials.end() ? static_cast<int32_t>(found->second.index) : -1;
+}
+
+void MaterialTable::create(Device device, LayoutCache& layoutCache, DescriptorAllocator& descriptorAllocator,
+	SamplerCache& samplerCache) {
+
+	this->device = device;
+	this->samplerCache = &samplerCache;
+
+	if (!device.supportsBindlessTextures()) {
+		throw std::runtime_error("bindless textures are not supported by the device");
+	}
+	textureCapacity = std::min(MAX_BINDLESS_TEXTURES, device.getMaxBindlessTextures());
+
+	// slot 0 is taken first
+	for (uint32_t i = 0; i < textureCapacity; i++) {
+		freeSlots.push_back(textureCapacity - 1 - i);
+	}
+
+	//--------------------------------------------------------
+	// DESCRIPTOR SET (the array is written while it is bound and only the written slots are valid)
+
+	VkDescriptorSetLayoutBinding texturesBinding{};
+	texturesBinding.binding = 0;
+	texturesBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	texturesBinding.descriptorCount = textureCapacity;
+	texturesBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	layoutBindings = { texturesBinding };
+
+	VkDescriptorBindingFlags texturesFlags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+		VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+		VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+
+	descriptorSetLayout = layoutCache.getDescriptorSetLayout(layoutBindings, { texturesFlags });
+	descriptorSet = descriptorAllocator.allocateUpdateAfterBind(descriptorSetLayout,
+		{ { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, textureCapacity } }, textureCapacity);
+
+	//--------------------------------------------------------
+	// MATERIAL BUFFER
+
+	device.createBuffer(getBufferSize(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		buffer, bufferMemory);
+
+	void* mapped;
+	vkMapMemory(device.get(), bufferMemory, 0, getBufferSize(), 0, &mapped);
+	bufferMapped = static_cast<MaterialData*>(mapped);
+	memset(bufferMapped, 0, getBufferSize());
+
+	createSampler();
+}
+
+void MaterialTable::createSampler() {
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+	// ANISOTROPIC FILTERING
+	VkPhysicalDeviceProperties properties = device.getPhysicalDeviceProperties();
+	samplerInfo.anisotropyEnable = VK_TRUE;
+	samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+
+	// MIPMAPS (textures with any mip count)
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	sampler = samplerCache->acquire(samplerInfo);
+}
+
+uint32_t MaterialTable::acquireTexture(VkImageView view) {
+	auto found = textureSlots.find(view);
+	if (found != textureSlots.end()) {
+		found->second.references++;
+		return found->second.index;
+	}
+
+	if (freeSlots.empty()) {
+		throw std::runtime_error("bindless texture array is full");
+	}
+	uint32_t index = freeSlots.back();
+	freeSlots.pop_back();
+	textureSlots.emplace(view, TextureSlot{ index, 1 });
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = view;
+
+	VkWriteDescriptorSet textureWrite{};
+	textureWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	textureWrite.dstSet = descriptorSet;
+	textureWrite.dstBinding = 0;
+	textureWrite.dstArrayElement = index;
+	textureWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	textureWrite.descriptorCount = 1;
+	textureWrite.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(device.get(), 1, &textureWrite, 0, nullptr);
+	descriptorWriteCount++;
+	return index;
+}
+
+void MaterialTable::releaseTexture(VkImageView view) {
+	auto found = textureSlots.find(view);
+	if (found == textureSlots.end()) return;
+	if (--found->second.references > 0) return;
+
+	// partially bound: the old descriptor is not read
+	freeSlots.push_back(found->second.index);
+	textureSlots.erase(found);
+}
+
+uint32_t MaterialTable::addMaterial(Material& material) {
+	auto found = materials.find(&material);
+	if (found != materials.end()) return found->second.index;
+
+	if (freeMaterialIndices.empty() && usedMaterialIndices >= MAX_MATERIALS) {
+		throw std::runtime_error("bindless material table is full");
+	}
+
+	// the new textures are counted first (nothing is taken if they do not fit)
+	std::vector<VkImageView> views;
+	if (material.hasAlbedo()) views.push_back(material.albedoTexture.view);
+	if (material.hasSpecular()) views.push_back(material.specularTexture.view);
+	if (material.hasNormal()) views.push_back(material.normalTexture.view);
+	std::vector<VkImageView> newViews;
+	for (VkImageView view : views) {
+		if (textureSlots.count(view) > 0 || std::find(newViews.begin(), newViews.end(), view) != newViews.end()) continue;
+		newViews.push_back(view);
+	}
+	if (newViews.size() > freeSlots.size()) {
+		throw std::runtime_error("bindless texture array is full");
+	}
+
+	MaterialEntry entry;
+	entry.textures = views;
+	auto getSlot = [&](bool used, VkImageView view) { return used ? static_cast<int32_t>(acquireTexture(view)) : -1; };
+	MaterialData data;
+	data.albedoTexture = getSlot(material.hasAlbedo(), material.albedoTexture.view);
+	data.specularTexture = getSlot(material.hasSpecular(), material.specularTexture.view);
+	data.normalTexture = getSlot(material.hasNormal(), material.normalTexture.view);
+	data.shininess = material.shininess;
+	data.minLod = material.minLod;
+
+	if (!freeMaterialIndices.empty()) {
+		entry.index = freeMaterialIndices.back();
+		freeMaterialIndices.pop_back();
+	}
+	else {
+		entry.index = usedMaterialIndices++;
+	}
+
+	// a new entry is not read by the frames in flight
+	bufferMapped[entry.index] = data;
+	uint32_t index = entry.index;
+	materials.emplace(&material, std::move(entry));
+	material.materialTable = this;
+	return index;
+}
+
+void MaterialTable::removeMaterial(const Material& material) {
+	auto found = materials.find(&material);
+	if (found == materials.end()) return;
+
+	for (VkImageView view : found->second.textures) {
+		releaseTexture(view);
+	}
+	freeMaterialIndices.push_back(found->second.index);
+	materials.erase(found);
+}
+
+void MaterialTable::updateMaterial(const Material& material) {
+	auto found = materials.find(&material);
+	if (found == materials.end()) return;
+	bufferMapped[found->second.index].minLod = material.minLod;
+}
+
+void MaterialTable::cleanup() {
+	samplerCache->release(sampler);
+	vkDestroyBuffer(device.get(), buffer, nullptr);
+	vkFreeMemory(device.get(), bufferMemory, nullptr);
+	materials.clear();
+	freeMaterialIndices.clear();
+	usedMaterialIndices = 0;
+	textureSlots.clear();
+	freeSlots.clear();
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "context/Device.hpp"
+#include "render/image/SamplerCache.hpp"
+#include "render/uniform/Material.hpp"
+#include "render/pipeline/LayoutCache.hpp"
+#include "render/pipeline/DescriptorAllocator.hpp"
+
+
+//--------------------------------------------------------
+// BINDLESS TEXTURES (must match shader.frag)
+
+// Textures of the global array (less if the device does not support as many)
+const uint32_t MAX_BINDLESS_TEXTURES = 4096;
+const uint32_t MAX_MATERIALS = 1024;
+
+// Offset of the material index in the push constants of the draw (after the matrices of the vertex shader)
+const uint32_t MATERIAL_PUSH_CONSTANT_OFFSET = 112;
+
+
+// See alignment requirements in specification
+// (https://docs.vulkan.org/spec/latest/chapters/interfaces.html#interfaces-resources-layout)
+// Material of the table (std430). The textures are indices in the global array (-1 if the material has not that texture)
+struct MaterialData {
+    int32_t albedoTexture;
+    int32_t specularTexture;
+    int32_t normalTexture;
+    float shininess;
+    float minLod;           // first resident level of the streamed textures
+};
+
+
+// Textures of every material in a single update after bind descriptor array and the materials in a storage buffer with
+// their texture indices. The array is in its own descriptor set, bound once for the whole frame, and the draws select
+// their material with a push constant. Materials are added when their model is created or completed (never while a
+// frame is recorded) and a texture shared by several materials takes a single slot. Textures and materials are written
+// when they are added (the slots that a frame in flight can read are never rewritten)
+class MaterialTable {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // GETTERS AND SETTERS
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+    VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+    const std::vector<VkDescriptorSetLayoutBinding>& getLayoutBindings() const { return layoutBindings; }
+
+    // Material buffer and sampler of every texture (written in the descriptor set of the pipelines)
+    VkBuffer getBuffer() const { return buffer; }
+    VkDeviceSize getBufferSize() const { return sizeof(MaterialData) * MAX_MATERIALS; }
+    VkSampler getSampler() const { return sampler; }
+
+    // Index of the material in the table (-1 if it was not added)
+    int32_t getMaterialIndex(const Material& material) const;
+
+    // Statistics (the descriptor writes are counted since creation)
+    uint32_t getTextureCapacity() const { return textureCapacity; }
+    uint32_t getTextureCount() const { return static_cast<uint32_t>(textureSlots.size()); }
+    uint32_t getMaterialCount() const { return static_cast<uint32_t>(materials.size()); }
+    uint32_t getDescriptorWriteCount() const { return descriptorWriteCount; }
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // METHODS
+
+    // Create the descriptor set with the texture array and the material buffer, and get the sampler from the cache
+    void create(Device device, LayoutCache& layoutCache, DescriptorAllocator& descriptorAllocator,
+        SamplerCache& samplerCache);
+
+    // Add the textures of the material and its entry in the buffer (the same material is added once). The material is
+    // removed from the table by its cleanup
+    uint32_t addMaterial(Material& material);
+
+    // Free the entry of the material and the slots of the textures no other material uses (no frame in flight can
+    // read them)
+    void removeMaterial(const Material& material);
+
+    // Write the min LOD of an added material again (both values are valid for the frames in flight, the levels finer
+    // than the old one are resident before it is lowered)
+    void updateMaterial(const Material& material);
+
+    // Destroy Vulkan and other objects (the descriptor set is destroyed with its pool)
+    void cleanup();
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // CLASS MEMBERS
+
+    Device device;
+
+    VkDescriptorSetLayout descriptorSetLayout;      // owned by the layout cache
+    VkDescriptorSet descriptorSet;
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+
+    // slot of each texture in the array and the materials that use it
+    struct TextureSlot {
+        uint32_t index;
+        uint32_t references;
+    };
+    uint32_t textureCapacity = 0;
+    std::unordered_map<VkImageView, TextureSlot> textureSlots;
+    std::vector<uint32_t> freeSlots;
+
+    // entry of each material in the buffer and the textures it references
+    struct MaterialEntry {
+        uint32_t index;
+        std::vector<VkImageView> textures;
+    };
+    VkBuffer buffer;
+    VkDeviceMemory bufferMemory;
+    MaterialData* bufferMapped = nullptr;
+    std::unordered_map<const Material*, MaterialEntry> materials;
+    std::vector<uint32_t> freeMaterialIndices;
+    uint32_t usedMaterialIndices = 0;
+
+    SamplerCache* samplerCache = nullptr;
+    VkSampler sampler;              // owned by the sampler cache
+
+    uint32_t descriptorWriteCount = 0;
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // METHODS
+
+    // Linear sampler with every mip level of the textures
+    void createSampler();
+
+    // Slot of the texture, written in a free slot of the array the first time
+    uint32_t acquireTexture(VkImageView view);
+
+    // Free the slot of the texture when its last material is removed (the descriptor is left as it is)
+    void releaseTexture(VkImageView view);
+};
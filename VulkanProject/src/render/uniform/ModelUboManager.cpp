@@ -1,6 +1,18 @@
 #include "render/uniform/ModelUboManager.hpp"
 
 
+DrawPushConstants createDrawPushConstants(Model& model) {
+	DrawPushConstants constants{};
+	glm::mat4 world = createModelMatrix(model.getTransform());
+	constants.model = world * model.getDequantizationMatrix();
+
+	glm::mat3 normalMatrix = glm::inverse(glm::transpose(glm::mat3(world)));
+	for (int i = 0; i < 3; i++) {
+		constants.normalMatrix[i] = glm::vec4(normalMatrix[i], 0.0f);
+	}
+	return constants;
+}
+
 void ModelUboManager::createBuffers(Device device, int count) {
 
 	//--------------------------------------------------------
@@ -30,9 +42,10 @@ void ModelUboManager::upateBuffer(uint32_t index, Model model, Camera camera) {
 	ModelUBO ubo{};
 	glm::mat4 view = camera.getView();
 
-	// Compute matrices
-	ubo.modelView = view * createModelMatrix(model.getTransform());
-	ubo.invTrans_modelView = glm::inverse(glm::transpose(ubo.modelView));
+	// Compute matrices (the normals are not quantized: the dequantization only affects the positions)
+	glm::mat4 modelView = view * createModelMatrix(model.getTransform());
+	ubo.modelView = modelView * model.getDequantizationMatrix();
+	ubo.invTrans_modelView = glm::inverse(glm::transpose(modelView));
 	ubo.proj = camera.getProjection();
 
 	memcpy(buffersMapped[index], &ubo, sizeof(ubo));
@@ -16,6 +16,16 @@ struct ModelUBO {
     alignas(16) glm::mat4 proj;
 };
 
+// Per draw data pushed before each draw when the camera is in its own uniform buffer (must match shader.vert compiled
+// with DRAW_CONSTANTS). The columns of the normal matrix are padded to vec4 as in the push constant block
+struct DrawPushConstants {
+    alignas(16) glm::mat4 model;            // includes the dequantization of the positions
+    alignas(16) glm::mat3x4 normalMatrix;   // inverse transpose of the world matrix
+};
+
+// Model matrices of the draw (world space, the camera UBO has the view and projection)
+DrawPushConstants createDrawPushConstants(Model& model);
+
 
 class ModelUboManager {
 public:
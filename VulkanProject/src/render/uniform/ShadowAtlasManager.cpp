@@ -0,0 +1,378 @@
+#include "render/uniform/ShadowAtlasManager.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+
+namespace {
+
+	// Near plane of the light projections relative to the light radius
+	const float SHADOW_NEAR_PLANE_RATIO = 0.01f;
+
+	// Widest spot light cone a tile can cover (half angle)
+	const float MAX_SHADOW_SPOT_ANGLE = glm::radians(85.0f);
+
+	// Cube faces of point lights: +X, -X, +Y, -Y, +Z, -Z (must match shader.frag)
+	const glm::vec3 CUBE_FACE_DIRECTIONS[SHADOW_TILES_PER_LIGHT] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+
+	bool spheresIntersect(const BoundingSphere& a, glm::vec3 center, float radius) {
+		return glm::length(a.center - center) < a.radius + radius;
+	}
+}
+
+
+void ShadowAtlasManager::createBuffers(Device device, size_t count) {
+
+	//--------------------------------------------------------
+	// SET CLASS MEMBERS
+
+	this->device = device;
+
+	buffers.resize(count);
+	buffersMemory.resize(count);
+	buffersMapped.resize(count);
+
+	tileData.resize(MAX_SHADOWED_LIGHTS * SHADOW_TILES_PER_LIGHT);
+
+	// slot 0 is taken first
+	for (uint32_t i = 0; i < MAX_SHADOWED_LIGHTS; i++) {
+		freeSlots.push_back(MAX_SHADOWED_LIGHTS - 1 - i);
+	}
+
+	// the atlas starts split in tiles of the biggest size
+	freeNodes.resize(getLevel(SHADOW_TILE_MIN_SIZE) + 1);
+	for (uint32_t y = 0; y < SHADOW_ATLAS_SIZE; y += SHADOW_TILE_MAX_SIZE) {
+		for (uint32_t x = 0; x < SHADOW_ATLAS_SIZE; x += SHADOW_TILE_MAX_SIZE) {
+			freeNodes[0].push_back(glm::uvec2(x, y));
+		}
+	}
+
+	//--------------------------------------------------------
+	// CREATE BUFFERS
+
+	VkDeviceSize bufferSize = getBufferSize();
+	for (size_t i = 0; i < count; i++) {
+		device.createBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			buffers[i], buffersMemory[i]);
+
+		vkMapMemory(device.get(), buffersMemory[i], 0, bufferSize, 0, &buffersMapped[i]);
+		memset(buffersMapped[i], 0, bufferSize);
+	}
+}
+
+int32_t ShadowAtlasManager::getFirstTile(const Light* light) const {
+	auto it = shadowedLights.find(light);
+	if (it == shadowedLights.end()) return -1;
+	return static_cast<int32_t>(it->second.slot * SHADOW_TILES_PER_LIGHT);
+}
+
+void ShadowAtlasManager::updateAtlas(uint32_t index, const std::vector<Light*>& lights,
+	const std::vector<Model*>& casters, Camera& camera, VkExtent2D extent) {
+
+	auto start = std::chrono::high_resolution_clock::now();
+	currentStamp++;
+	tilesToRender.clear();
+
+	//--------------------------------------------------------
+	// CASTERS THAT MOVED, APPEARED OR DISAPPEARED (their old and new bounds)
+
+	std::vector<BoundingSphere> changedBounds;
+	for (Model* caster : casters) {
+		if (caster->getTransform() == nullptr) continue;
+
+		glm::mat4 modelMatrix = createModelMatrix(caster->getTransform());
+		BoundingSphere bounds = caster->getWorldBounds();
+
+		auto [snapshot, inserted] = casterSnapshots.emplace(caster, CasterSnapshot{ modelMatrix, bounds, currentStamp });
+		if (inserted) {
+			changedBounds.push_back(bounds);
+			continue;
+		}
+		if (snapshot->second.modelMatrix != modelMatrix) {
+			changedBounds.push_back(snapshot->second.bounds);
+			changedBounds.push_back(bounds);
+			snapshot->second.modelMatrix = modelMatrix;
+			snapshot->second.bounds = bounds;
+		}
+		snapshot->second.stamp = currentStamp;
+	}
+	for (auto it = casterSnapshots.begin(); it != casterSnapshots.end();) {
+		if (it->second.stamp == currentStamp) {
+			++it;
+			continue;
+		}
+		changedBounds.push_back(it->second.bounds);
+		it = casterSnapshots.erase(it);
+	}
+
+	//--------------------------------------------------------
+	// VISIBLE LIGHTS WITH SHADOWS (biggest on the screen first)
+
+	struct TileRequest {
+		Light* light;
+		uint32_t tileSize;
+	};
+	std::vector<TileRequest> requests;
+	for (Light* light : lights) {
+		if (!light->getCastShadows() || light->getType() == LIGHT_TYPE_DIRECTIONAL) continue;
+
+		uint32_t tileSize = computeTileSize(light, camera, extent);
+		if (tileSize == 0) continue;
+
+		requests.push_back({ light, tileSize });
+		auto shadowedLight = shadowedLights.find(light);
+		if (shadowedLight != shadowedLights.end()) {
+			shadowedLight->second.stamp = currentStamp;
+		}
+	}
+	std::stable_sort(requests.begin(), requests.end(),
+		[](const TileRequest& a, const TileRequest& b) { return a.tileSize > b.tileSize; });
+
+	// lights removed, hidden or without shadows give their tiles back
+	for (auto it = shadowedLights.begin(); it != shadowedLights.end();) {
+		if (it->second.stamp == currentStamp) {
+			++it;
+			continue;
+		}
+		releaseLight(it->second);
+		it = shadowedLights.erase(it);
+	}
+
+	//--------------------------------------------------------
+	// TILES OF EACH LIGHT
+
+	unshadowedLightCount = 0;
+	for (const TileRequest& request : requests) {
+		Light* light = request.light;
+		uint32_t tileCount = light->getType() == LIGHT_TYPE_POINT ? SHADOW_TILES_PER_LIGHT : 1;
+
+		auto shadowedLight = shadowedLights.find(light);
+		if (shadowedLight == shadowedLights.end()) {
+			if (freeSlots.empty()) {
+				unshadowedLightCount++;
+				continue;
+			}
+			ShadowedLight newLight{};
+			newLight.slot = freeSlots.back();
+			freeSlots.pop_back();
+			shadowedLight = shadowedLights.emplace(light, newLight).first;
+		}
+		ShadowedLight& entry = shadowedLight->second;
+		bool dirty = false;
+
+		// keep the tiles while the size is the same or one level smaller (to avoid rendering them again when the
+		// light size on the screen is close to a power of two) or while the request that did not fit does not change
+		bool keepTiles = entry.tileCount == tileCount && (request.tileSize == entry.requestedTileSize ||
+			(request.tileSize <= entry.tileSize && request.tileSize * 4 > entry.tileSize));
+		if (!keepTiles) {
+			for (uint32_t t = 0; t < entry.tileCount; t++) {
+				freeNode(entry.tileSize, entry.tiles[t]);
+			}
+			entry.tileCount = 0;
+
+			// smaller tiles if the atlas is full
+			for (uint32_t tileSize = request.tileSize; tileSize >= SHADOW_TILE_MIN_SIZE && entry.tileCount == 0; tileSize /= 2) {
+				uint32_t allocated = 0;
+				while (allocated < tileCount && allocateNode(tileSize, entry.tiles[allocated])) {
+					allocated++;
+				}
+				if (allocated == tileCount) {
+					entry.tileSize = tileSize;
+					entry.tileCount = tileCount;
+				}
+				else {
+					for (uint32_t t = 0; t < allocated; t++) {
+						freeNode(tileSize, entry.tiles[t]);
+					}
+				}
+			}
+			entry.requestedTileSize = request.tileSize;
+			if (entry.tileCount == 0) {
+				releaseLight(entry);
+				shadowedLights.erase(shadowedLight);
+				unshadowedLightCount++;
+				continue;
+			}
+			dirty = true;
+		}
+
+		// light changes
+		glm::vec3 position = light->getTransform()->position;
+		glm::vec3 direction = light->getDirection();
+		dirty |= entry.position != position || entry.direction != direction || entry.radius != light->getRadius() ||
+			entry.spotAngle != light->getSpotAngle() || entry.type != light->getType();
+		entry.position = position;
+		entry.direction = direction;
+		entry.radius = light->getRadius();
+		entry.spotAngle = light->getSpotAngle();
+		entry.type = light->getType();
+
+		// caster changes inside the light range
+		for (size_t i = 0; i < changedBounds.size() && !dirty; i++) {
+			dirty = spheresIntersect(changedBounds[i], position, entry.radius);
+		}
+
+		float tanHalfFov = entry.type == LIGHT_TYPE_SPOT ? std::tan(std::min(entry.spotAngle, MAX_SHADOW_SPOT_ANGLE)) : 1.0f;
+		for (uint32_t t = 0; t < entry.tileCount; t++) {
+			ShadowTileData& tile = tileData[entry.slot * SHADOW_TILES_PER_LIGHT + t];
+			tile.viewProjection = computeTileViewProjection(entry, t);
+			tile.atlasRect = glm::vec4(glm::vec2(entry.tiles[t]), static_cast<float>(entry.tileSize), 0.0f) /
+				static_cast<float>(SHADOW_ATLAS_SIZE);
+			tile.atlasRect.w = tanHalfFov;
+
+			if (dirty) {
+				ShadowTileRender render{};
+				render.rect.offset = { static_cast<int32_t>(entry.tiles[t].x), static_cast<int32_t>(entry.tiles[t].y) };
+				render.rect.extent = { entry.tileSize, entry.tileSize };
+				render.viewProjection = tile.viewProjection;
+				render.lightBounds.center = position;
+				render.lightBounds.radius = entry.radius;
+				tilesToRender.push_back(render);
+			}
+		}
+	}
+
+	// all the tiles are written (each buffer may have a different old state)
+	memcpy(buffersMapped[index], tileData.data(), getBufferSize());
+
+	//--------------------------------------------------------
+	// STATISTICS
+
+	allocatedTileCount = 0;
+	uint64_t allocatedTexels = 0;
+	for (const auto& [light, entry] : shadowedLights) {
+		allocatedTileCount += entry.tileCount;
+		allocatedTexels += static_cast<uint64_t>(entry.tileCount) * entry.tileSize * entry.tileSize;
+	}
+	occupancy = static_cast<float>(allocatedTexels) / (static_cast<float>(SHADOW_ATLAS_SIZE) * SHADOW_ATLAS_SIZE);
+
+	updateTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+uint32_t ShadowAtlasManager::getLevel(uint32_t tileSize) const {
+	uint32_t level = 0;
+	for (uint32_t size = SHADOW_TILE_MAX_SIZE; size > tileSize; size /= 2) {
+		level++;
+	}
+	return level;
+}
+
+bool ShadowAtlasManager::allocateNode(uint32_t tileSize, glm::uvec2& node) {
+	uint32_t level = getLevel(tileSize);
+	if (freeNodes[level].empty()) {
+		// split a bigger node in four
+		glm::uvec2 parent;
+		if (tileSize >= SHADOW_TILE_MAX_SIZE || !allocateNode(tileSize * 2, parent)) return false;
+
+		freeNodes[level].push_back(parent + glm::uvec2(tileSize, tileSize));
+		freeNodes[level].push_back(parent + glm::uvec2(0, tileSize));
+		freeNodes[level].push_back(parent + glm::uvec2(tileSize, 0));
+		freeNodes[level].push_back(parent);
+	}
+
+	node = freeNodes[level].back();
+	freeNodes[level].pop_back();
+	return true;
+}
+
+void ShadowAtlasManager::freeNode(uint32_t tileSize, glm::uvec2 node) {
+	uint32_t level = getLevel(tileSize);
+	std::vector<glm::uvec2>& nodes = freeNodes[level];
+
+	if (tileSize < SHADOW_TILE_MAX_SIZE) {
+		// merge with the siblings if all of them are free
+		glm::uvec2 parent = (node / (tileSize * 2)) * (tileSize * 2);
+		uint32_t freeSiblings = 0;
+		for (const glm::uvec2& other : nodes) {
+			if ((other / (tileSize * 2)) * (tileSize * 2) == parent) freeSiblings++;
+		}
+		if (freeSiblings == 3) {
+			nodes.erase(std::remove_if(nodes.begin(), nodes.end(), [&](const glm::uvec2& other) {
+				return (other / (tileSize * 2)) * (tileSize * 2) == parent;
+				}), nodes.end());
+			freeNode(tileSize * 2, parent);
+			return;
+		}
+	}
+
+	nodes.push_back(node);
+}
+
+void ShadowAtlasManager::releaseLight(ShadowedLight& shadowedLight) {
+	for (uint32_t t = 0; t < shadowedLight.tileCount; t++) {
+		freeNode(shadowedLight.tileSize, shadowedLight.tiles[t]);
+	}
+	shadowedLight.tileCount = 0;
+	freeSlots.push_back(shadowedLight.slot);
+}
+
+uint32_t ShadowAtlasManager::computeTileSize(Light* light, Camera& camera, VkExtent2D extent) const {
+	glm::mat4 projection = camera.getProjection();
+	glm::vec3 viewPosition = glm::vec3(camera.getView() * glm::vec4(light->getTransform()->position, 1.0f));
+	float radius = light->getRadius();
+	float depth = -viewPosition.z;
+
+	//--------------------------------------------
+	// LIGHT SPHERE OUTSIDE THE FRUSTUM
+	float tanX = 1.0f / projection[0][0];
+	float tanY = 1.0f / std::fabs(projection[1][1]);
+	if (depth + radius < camera.getNearPlane() || depth - radius > camera.getFarPlane() ||
+		std::fabs(viewPosition.x) - tanX * depth > radius * std::sqrt(1.0f + tanX * tanX) ||
+		std::fabs(viewPosition.y) - tanY * depth > radius * std::sqrt(1.0f + tanY * tanY)) {
+		return 0;
+	}
+
+	//--------------------------------------------
+	// DIAMETER ON THE SCREEN (pixels)
+	float distance = glm::length(viewPosition);
+	if (distance <= radius) return SHADOW_TILE_MAX_SIZE;
+	float pixels = radius / distance * std::fabs(projection[1][1]) * extent.height;
+
+	uint32_t tileSize = SHADOW_TILE_MIN_SIZE;
+	while (tileSize < pixels && tileSize < SHADOW_TILE_MAX_SIZE) {
+		tileSize *= 2;
+	}
+	return tileSize;
+}
+
+glm::mat4 ShadowAtlasManager::computeTileViewProjection(const ShadowedLight& shadowedLight, uint32_t face) const {
+	glm::vec3 direction;
+	float fov;
+	if (shadowedLight.type == LIGHT_TYPE_SPOT) {
+		direction = glm::normalize(shadowedLight.direction);
+		fov = 2.0f * std::min(shadowedLight.spotAngle, MAX_SHADOW_SPOT_ANGLE);
+	}
+	else {
+		direction = CUBE_FACE_DIRECTIONS[face];
+		fov = glm::radians(90.0f);
+	}
+
+	// the world up is Z
+	glm::vec3 up = std::fabs(direction.z) > 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+	glm::mat4 view = glm::lookAt(shadowedLight.position, shadowedLight.position + direction, up);
+
+	glm::mat4 projection = glm::perspective(fov, 1.0f, shadowedLight.radius * SHADOW_NEAR_PLANE_RATIO,
+		shadowedLight.radius);
+	projection[1][1] *= -1; // same convention as the camera
+
+	return projection * view;
+}
+
+void ShadowAtlasManager::cleanup() {
+	for (size_t i = 0; i < buffers.size(); i++) {
+		vkDestroyBuffer(device.get(), buffers[i], nullptr);
+		vkFreeMemory(device.get(), buffersMemory[i], nullptr);
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+
+#include "context/Device.hpp"
+#include "render/vertex/Mesh.hpp"
+#include "scene/Camera.hpp"
+#include "scene/Light.hpp"
+#include "scene/Model.hpp"
+
+
+//--------------------------------------------------------
+// SHADOW ATLAS (must match shader.frag)
+const uint32_t SHADOW_ATLAS_SIZE = 4096;
+
+// Tiles are square with power of two sizes (the atlas is split as a quadtree)
+const uint32_t SHADOW_TILE_MAX_SIZE = 1024;
+const uint32_t SHADOW_TILE_MIN_SIZE = 128;
+
+// Lights with shadows at the same time (a point light uses a tile per cube face)
+const uint32_t MAX_SHADOWED_LIGHTS = 64;
+const uint32_t SHADOW_TILES_PER_LIGHT = 6;
+
+
+// See alignment requirements in specification
+// (https://docs.vulkan.org/spec/latest/chapters/interfaces.html#interfaces-resources-layout)
+// Tile of the atlas (std430). The tiles of a light start at SHADOW_TILES_PER_LIGHT * its shadow slot
+struct ShadowTileData {
+    alignas(16) glm::mat4 viewProjection;   // world to tile
+    alignas(16) glm::vec4 atlasRect;        // xy offset and z size in atlas coordinates, w tangent of the half fov
+};
+
+// Tile that has to be rendered this frame
+struct ShadowTileRender {
+    VkRect2D rect;
+    glm::mat4 viewProjection;
+    BoundingSphere lightBounds;     // only the casters inside are drawn
+};
+
+
+// Manage the shadow atlas of the point and spot lights that cast shadows and the storage buffers with the tiles for
+// each FRAME_IN_FLIGHT. The tile size of each light depends on its size on the screen. The tiles are cached: they are
+// only rendered again if the light or a caster inside its range moved (the transforms are compared with the ones of
+// the last rendering) or if the light got a new tile
+class ShadowAtlasManager {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // GETTERS AND SETTERS
+
+    VkBuffer getBuffer(size_t index) const { return buffers[index]; }
+    VkDeviceSize getBufferSize() const { return sizeof(ShadowTileData) * MAX_SHADOWED_LIGHTS * SHADOW_TILES_PER_LIGHT; }
+    bool hasBuffers() const { return !buffers.empty(); }
+
+    // First tile of the light in the tile buffer (-1 if it has no shadows)
+    int32_t getFirstTile(const Light* light) const;
+
+    // Tiles invalidated by the last update
+    const std::vector<ShadowTileRender>& getTilesToRender() const { return tilesToRender; }
+
+    // Statistics of the last update
+    uint32_t getAllocatedTileCount() const { return allocatedTileCount; }
+    float getOccupancy() const { return occupancy; }
+    uint32_t getRenderedTileCount() const { return static_cast<uint32_t>(tilesToRender.size()); }
+    uint32_t getCachedTileCount() const { return allocatedTileCount - getRenderedTileCount(); }
+    uint32_t getUnshadowedLightCount() const { return unshadowedLightCount; }
+    float getUpdateTime() const { return updateTime; }
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // METHODS
+
+    // Create as many tile buffers as count
+    void createBuffers(Device device, size_t count);
+
+    // Give tiles to the visible lights that cast shadows (the most important ones first) and find the tiles whose
+    // light or casters changed since they were rendered
+    void updateAtlas(uint32_t index, const std::vector<Light*>& lights, const std::vector<Model*>& casters,
+        Camera& camera, VkExtent2D extent);
+
+    // Destroy Vulkan an other objects
+    void cleanup();
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // CLASS MEMBERS
+
+    Device device;
+
+    std::vector<VkBuffer> buffers;
+    std::vector<VkDeviceMemory> buffersMemory;
+    std::vector<void*> buffersMapped;
+
+    // Light with tiles and the light state they were rendered with
+    struct ShadowedLight {
+        uint32_t slot;
+        uint32_t tileSize = 0;
+        uint32_t requestedTileSize = 0;     // bigger than tileSize if the atlas was full
+        uint32_t tileCount = 0;
+        glm::uvec2 tiles[SHADOW_TILES_PER_LIGHT];
+        glm::vec3 position;
+        glm::vec3 direction;
+        float radius;
+        float spotAngle;
+        LightType type;
+        uint32_t stamp;
+    };
+    std::unordered_map<const Light*, ShadowedLight> shadowedLights;
+    std::vector<uint32_t> freeSlots;
+
+    // free quadtree nodes of each tile size (from SHADOW_TILE_MAX_SIZE to SHADOW_TILE_MIN_SIZE)
+    std::vector<std::vector<glm::uvec2>> freeNodes;
+
+    // casters transforms of the last update
+    struct CasterSnapshot {
+        glm::mat4 modelMatrix;
+        BoundingSphere bounds;
+        uint32_t stamp;
+    };
+    std::unordered_map<const Model*, CasterSnapshot> casterSnapshots;
+    uint32_t currentStamp = 0;
+
+    std::vector<ShadowTileData> tileData;
+    std::vector<ShadowTileRender> tilesToRender;
+
+    uint32_t allocatedTileCount = 0;
+    float occupancy = 0.0f;
+    uint32_t unshadowedLightCount = 0;
+    float updateTime = 0.0f;
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // METHODS
+
+    // Quadtree level of a tile size
+    uint32_t getLevel(uint32_t tileSize) const;
+
+    // Take a free node of the size (splitting a bigger one if necessary)
+    bool allocateNode(uint32_t tileSize, glm::uvec2& node);
+
+    // Return a node (merged with its siblings if all of them are free)
+    void freeNode(uint32_t tileSize, glm::uvec2 node);
+
+    // Free the tiles and the slot of a light
+    void releaseLight(ShadowedLight& shadowedLight);
+
+    // Tile size for the size of the light sphere on the screen (0 if it is not visible)
+    uint32_t computeTileSize(Light* light, Camera& camera, VkExtent2D extent) const;
+
+    // Light view projection of a tile (a cube face of point lights)
+    glm::mat4 computeTileViewProjection(const ShadowedLight& shadowedLight, uint32_t face) const;
+};
@@ -0,0 +1,147 @@
+#include "render/uniform/ShadowUboManager.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+void ShadowUboManager::createBuffers(Device device, size_t count) {
+
+	//--------------------------------------------------------
+	// SET CLASS MEMBERS
+
+	this->device = device;
+
+	buffers.resize(count);
+	buffersMemory.resize(count);
+	buffersMapped.resize(count);
+
+	//--------------------------------------------------------
+	// CREATE BUFFERS
+
+	VkDeviceSize bufferSize = sizeof(ShadowUBO);
+	for (size_t i = 0; i < count; i++) {
+		device.createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			buffers[i], buffersMemory[i]);
+
+		vkMapMemory(device.get(), buffersMemory[i], 0, bufferSize, 0, &buffersMapped[i]);
+		memset(buffersMapped[i], 0, bufferSize);
+	}
+}
+
+void ShadowUboManager::updateBuffer(uint32_t index, Light* light, Camera& camera, const BoundingSphere& casterBounds) {
+
+	ShadowUBO ubo{};
+	shadows = light != nullptr;
+
+	if (shadows) {
+		glm::vec3 lightDirection = glm::normalize(light->getDirection());
+		fitCascades(lightDirection, camera, casterBounds);
+
+		for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+			ubo.cascadeViewProjections[i] = cascades[i].viewProjection;
+			ubo.cascadeSplits[i] = cascades[i].splitDepth;
+		}
+		ubo.lightDirection = glm::vec4(lightDirection, 1.0f);
+		ubo.lightColor = glm::vec4(light->getColor(), 1.0f);
+	}
+
+	memcpy(buffersMapped[index], &ubo, sizeof(ubo));
+}
+
+void ShadowUboManager::fitCascades(glm::vec3 lightDirection, Camera& camera, const BoundingSphere& casterBounds) {
+
+	float nearPlane = camera.getNearPlane();
+	float farPlane = camera.getFarPlane();
+	glm::mat4 projection = camera.getProjection();
+	glm::mat4 inverseView = glm::inverse(camera.getView());
+
+	// half extents of the frustum at distance 1 (the projection Y is flipped for Vulkan)
+	float tanX = 1.0f / projection[0][0];
+	float tanY = 1.0f / std::abs(projection[1][1]);
+
+	// light space up vector (the world up is Z)
+	glm::vec3 up = std::abs(lightDirection.z) > 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+
+	float sliceNear = nearPlane;
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+
+		//--------------------------------------------
+		// SPLIT (practical split scheme)
+		float p = static_cast<float>(i + 1) / SHADOW_CASCADE_COUNT;
+		float logSplit = nearPlane * std::pow(farPlane / nearPlane, p);
+		float uniformSplit = nearPlane + (farPlane - nearPlane) * p;
+		float sliceFar = SHADOW_SPLIT_LAMBDA * logSplit + (1.0f - SHADOW_SPLIT_LAMBDA) * uniformSplit;
+
+		//--------------------------------------------
+		// BOUNDING SPHERE OF THE SLICE (world space)
+		glm::vec3 corners[8];
+		glm::vec3 center(0.0f);
+		for (int c = 0; c < 8; c++) {
+			float depth = (c & 4) ? sliceFar : sliceNear;
+			glm::vec3 viewCorner(
+				((c & 1) ? 1.0f : -1.0f) * tanX * depth,
+				((c & 2) ? 1.0f : -1.0f) * tanY * depth,
+				-depth);
+			corners[c] = glm::vec3(inverseView * glm::vec4(viewCorner, 1.0f));
+			center += corners[c] / 8.0f;
+		}
+		float radius = 0.0f;
+		for (int c = 0; c < 8; c++) {
+			radius = std::max(radius, glm::length(corners[c] - center));
+		}
+		// quantized so rounding errors do not change the texel size between frames
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		//--------------------------------------------
+		// LIGHT VIEW (pulled back to the farthest caster towards the light)
+		float casterDistance = glm::dot(casterBounds.center - center, -lightDirection) + casterBounds.radius;
+		float pullBack = std::max(radius, casterDistance);
+		glm::vec3 eye = center - lightDirection * pullBack;
+
+		ShadowCascade& cascade = cascades[i];
+		cascade.view = glm::lookAt(eye, center, up);
+		cascade.radius = radius;
+		cascade.depth = pullBack + radius;
+		cascade.splitDepth = sliceFar;
+
+		glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, cascade.depth);
+		lightProjection[1][1] *= -1; // same convention as the camera
+
+		//--------------------------------------------
+		// TEXEL SNAPPING (move the projection so the world origin falls on a texel corner)
+		glm::vec4 origin = lightProjection * cascade.view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		glm::vec2 texel = glm::vec2(origin) * (SHADOW_MAP_SIZE * 0.5f);
+		glm::vec2 offset = (glm::round(texel) - texel) / (SHADOW_MAP_SIZE * 0.5f);
+		lightProjection[3][0] += offset.x;
+		lightProjection[3][1] += offset.y;
+
+		cascade.viewProjection = lightProjection * cascade.view;
+		sliceNear = sliceFar;
+	}
+}
+
+bool ShadowUboManager::isCasterVisible(uint32_t cascade, const BoundingSphere& bounds) const {
+	const ShadowCascade& volume = cascades[cascade];
+	glm::vec3 lightPosition = glm::vec3(volume.view * glm::vec4(bounds.center, 1.0f));
+
+	// inside the orthographic box (the light looks to -Z)
+	float extent = volume.radius + bounds.radius;
+	return std::abs(lightPosition.x) <= extent &&
+		std::abs(lightPosition.y) <= extent &&
+		-lightPosition.z - bounds.radius <= volume.depth &&
+		-lightPosition.z + bounds.radius >= 0.0f;
+}
+
+void ShadowUboManager::cleanup() {
+	for (size_t i = 0; i < buffers.size(); i++) {
+		vkDestroyBuffer(device.get(), buffers[i], nullptr);
+		vkFreeMemory(device.get(), buffersMemory[i], nullptr);
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "context/Device.hpp"
+#include "render/vertex/Mesh.hpp"
+#include "scene/Camera.hpp"
+#include "scene/Light.hpp"
+
+
+//--------------------------------------------------------
+// CASCADED SHADOW MAPS (must match shader.frag)
+const uint32_t SHADOW_CASCADE_COUNT = 4;
+const uint32_t SHADOW_MAP_SIZE = 2048;
+
+// Blend between logarithmic (1) and uniform (0) cascade splits
+const float SHADOW_SPLIT_LAMBDA = 0.75f;
+
+
+// See alignment requirements in specification
+// (https://docs.vulkan.org/spec/latest/chapters/interfaces.html#interfaces-resources-layout)
+struct ShadowUBO {
+    alignas(16) glm::mat4 cascadeViewProjections[SHADOW_CASCADE_COUNT];   // world to shadow map
+    alignas(16) glm::vec4 cascadeSplits;                                  // far view depth of each cascade
+    alignas(16) glm::vec4 lightDirection;                                 // w = 0 if there is no directional light
+    alignas(16) glm::vec4 lightColor;
+};
+
+// Light space volume covered by a cascade
+struct ShadowCascade {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    float radius = 0.0f;        // half size of the orthographic projection
+    float depth = 0.0f;         // distance from the near to the far plane
+    float splitDepth = 0.0f;    // far view depth of the camera slice
+};
+
+
+// Manage the uniform buffers with the cascades of the directional light shadows for each FRAME_IN_FLIGHT. The cascades
+// split the camera frustum and enclose each slice in a sphere (so their size does not change when the camera rotates)
+// whose shadow map texels are snapped to the world (so the shadows do not shimmer when the camera moves)
+class ShadowUboManager {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // GETTERS AND SETTERS
+
+    VkBuffer getBuffer(size_t index) const { return buffers[index]; }
+    bool hasBuffers() const { return !buffers.empty(); }
+
+    // True if the last update had a directional light
+    bool hasShadows() const { return shadows; }
+    const ShadowCascade& getCascade(uint32_t cascade) const { return cascades[cascade]; }
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // METHODS
+
+    // Create as many uniform buffers as count
+    void createBuffers(Device device, size_t count);
+
+    // Fit the cascades to the camera frustum for the light (nullptr if there is no directional light). The light
+    // space near planes are moved back to include every caster inside casterBounds (world space)
+    void updateBuffer(uint32_t index, Light* light, Camera& camera, const BoundingSphere& casterBounds);
+
+    // True if a caster (world space bounding sphere) can cast shadows inside the cascade
+    bool isCasterVisible(uint32_t cascade, const BoundingSphere& bounds) const;
+
+    // Destroy Vulkan an other objects
+    void cleanup();
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // CLASS MEMBERS
+
+    Device device;
+
+    std::vector<VkBuffer> buffers;
+    std::vector<VkDeviceMemory> buffersMemory;
+    std::vector<void*> buffersMapped;
+
+    ShadowCascade cascades[SHADOW_CASCADE_COUNT];
+    bool shadows = false;
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // METHODS
+
+    // Compute the light space volume of each slice of the camera frustum
+    void fitCascades(glm::vec3 lightDirection, Camera& camera, const BoundingSphere& casterBounds);
+};
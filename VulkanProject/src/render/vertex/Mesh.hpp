@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Maximum number of levels of detail generated for a mesh (including the full resolution one)
+const uint32_t MAX_LOD_COUNT = 5;
+
+// Limits of a meshlet (the culling shader uses a thread per triangle)
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// Vertices addressable by a 16 bit index from the vertex offset of a subset
+const uint32_t SHORT_INDEX_VERTEX_LIMIT = 65536;
+
+
+// Part of the index buffer drawn with a single call. The indices are relative to vertexOffset so meshes with more
+// vertices than the 16 bit limit can still use short indices
+struct MeshSubset {
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	int32_t vertexOffset = 0;
+};
+
+
+// Range of the index buffer used by a level of detail
+struct MeshLod {
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	// Geometric deviation from the full resolution mesh (in model units)
+	float error = 0.0f;
+	// Subsets that cover the range
+	uint32_t firstSubset = 0;
+	uint32_t subsetCount = 0;
+};
+
+// Processing of a mesh when it is loaded (the loading steps are not measured when it is read from the cache)
+struct MeshStats {
+	bool cached = false;
+	// milliseconds of each loading step
+	float lodTime = 0.0f;
+	float optimizeTime = 0.0f;
+	float meshletTime = 0.0f;
+	// vertex cache and vertex fetch efficiency of the full resolution level of detail before and after the optimization
+	float acmrBefore = 0.0f;
+	float acmrAfter = 0.0f;
+	float atvrBefore = 0.0f;
+	float atvrAfter = 0.0f;
+	// bytes of the index buffer and of the 32 bit indices it replaces
+	size_t indexBytes = 0;
+	size_t fullIndexBytes = 0;
+	// bytes of the vertex buffer and of the float vertices it replaces, in memory and fetched by a full resolution draw
+	size_t vertexBytes = 0;
+	size_t floatVertexBytes = 0;
+	size_t vertexFetchBytes = 0;
+	size_t floatVertexFetchBytes = 0;
+	// maximum error of the packed vertices (model units, degrees and texture coordinates)
+	float positionError = 0.0f;
+	float normalError = 0.0f;
+	float texCoordError = 0.0f;
+};
+
+struct BoundingSphere {
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+};
+
+// Cluster of nearby triangles culled as a unit by the meshlet culling pass (std430 layout)
+struct Meshlet {
+	// Bounding sphere
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+	// Normal cone: sine of the cone half angle (1 if the cone is too wide to cull)
+	glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+	float coneCutoff = 1.0f;
+	// Range of the meshlet index list
+	uint32_t firstIndex = 0;
+	uint32_t triangleCount = 0;
+	uint32_t padding[2] = { 0, 0 };
+};
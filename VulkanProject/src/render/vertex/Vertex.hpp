@@ -6,6 +6,14 @@
 #include <glm/gtx/hash.hpp>
 
 #include <array>
+#include <cstdint>
+
+
+// Layout of the vertex buffer of a mesh
+enum VertexFormat {
+	VERTEX_FORMAT_FLOAT,	// Vertex (32 bytes)
+	VERTEX_FORMAT_PACKED	// PackedVertex (16 bytes)
+};
 
 
 struct Vertex {
@@ -51,6 +59,76 @@ struct Vertex {
 	}
 };
 
+// Compressed vertex: positions as 16 bit normalized values inside the mesh bounds (the dequantization is applied with
+// the model matrix), octahedral encoded normals and half float texture coordinates
+struct PackedVertex {
+	uint16_t pos[4];		// unorm (w is padding)
+	int16_t normal[2];		// snorm octahedral
+	uint16_t texCoord[2];	// half float
+
+	static VkVertexInputBindingDescription getBindingDescription() {
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = sizeof(PackedVertex);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
+		std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+
+		// Position attribute
+		attributeDescriptions[0].binding = 0;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+		attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+
+		// Normal attribute
+		attributeDescriptions[1].binding = 0;
+		attributeDescriptions[1].location = 1;
+		attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+		attributeDescriptions[1].offset = offsetof(PackedVertex, normal);
+
+		// Texture coordinates attribute
+		attributeDescriptions[2].binding = 0;
+		attributeDescriptions[2].location = 2;
+		attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+		attributeDescriptions[2].offset = offsetof(PackedVertex, texCoord);
+
+		return attributeDescriptions;
+	}
+};
+
+// Transformation from the quantized positions (0 to 1) to model space
+struct VertexQuantization {
+	glm::vec3 offset = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+
+	glm::mat4 getDequantizationMatrix() const {
+		glm::mat4 matrix(1.0f);
+		matrix[0][0] = scale.x;
+		matrix[1][1] = scale.y;
+		matrix[2][2] = scale.z;
+		matrix[3] = glm::vec4(offset, 1.0f);
+		return matrix;
+	}
+};
+
+
+inline uint32_t getVertexSize(VertexFormat format) {
+	return format == VERTEX_FORMAT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+inline VkVertexInputBindingDescription getVertexBindingDescription(VertexFormat format) {
+	return format == VERTEX_FORMAT_PACKED ? PackedVertex::getBindingDescription() : Vertex::getBindingDescription();
+}
+
+inline std::array<VkVertexInputAttributeDescription, 3> getVertexAttributeDescriptions(VertexFormat format) {
+	return format == VERTEX_FORMAT_PACKED ? PackedVertex::getAttributeDescriptions() : Vertex::getAttributeDescriptions();
+}
+
+
 namespace std {
 	template<> struct hash<Vertex> {
 		size_t operator()(Vertex const& vertex) const {
@@ -0,0 +1,213 @@
+#include "scene/AssetLoader.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "scene/Camera.hpp"
+#include "scene/Light.hpp"
+
+
+void AssetLoader::create(Device device, CommandManager commandManager, SamplerCache& samplerCache,
+	TextureManager& textureManager, WorkerPool& workerPool, Scene& scene, uint32_t frameCount,
+	VkDeviceSize uploadBudget) {
+
+	this->device = device;
+	this->commandManager = commandManager;
+	this->samplerCache = &samplerCache;
+	this->textureManager = &textureManager;
+	this->workerPool = &workerPool;
+	this->scene = &scene;
+	this->uploadBudget = uploadBudget;
+	frameUploads.resize(frameCount);
+}
+
+ModelHandle AssetLoader::loadModel(const std::string& modelPath, const TexturePaths& texturePaths,
+	const Transform& transform, VertexFormat vertexFormat) {
+
+	PendingAsset& asset = addAsset(texturePaths);
+	asset.entity = std::make_unique<Entity>();
+	asset.entity->transform = transform;
+	asset.model = asset.entity->addModule<Model>();
+	asset.modelPath = modelPath;
+	asset.vertexFormat = vertexFormat;
+	asset.modelState = std::make_shared<ModelHandle::State>();
+	startLoad(asset);
+
+	ModelHandle handle;
+	handle.state = asset.modelState;
+	return handle;
+}
+
+MaterialHandle AssetLoader::loadMaterial(const TexturePaths& texturePaths) {
+	PendingAsset& asset = addAsset(texturePaths);
+	asset.materialState = std::make_shared<MaterialHandle::State>();
+	startLoad(asset);
+
+	MaterialHandle handle;
+	handle.state = asset.materialState;
+	return handle;
+}
+
+AssetLoader::PendingAsset& AssetLoader::addAsset(const TexturePaths& texturePaths) {
+	auto asset = std::make_unique<PendingAsset>();
+	asset->material = std::make_unique<Material>();
+	asset->material->setContext(device, commandManager, *samplerCache, *textureManager);
+	std::vector<std::string> paths;
+	Material::listTextures(texturePaths, asset->textureTypes, paths);
+
+	// only the textures that are not in the manager yet are decoded
+	asset->textureUpload = textureManager->createUpload(paths);
+	asset->requestTime = std::chrono::steady_clock::now();
+
+	pendingAssets.push_back(std::move(asset));
+	return *pendingAssets.back();
+}
+
+void AssetLoader::startLoad(PendingAsset& asset) {
+	// the task only writes its own asset until it is pushed to the loaded ones
+	PendingAsset* loading = &asset;
+	workerPool->submit([this, loading]() {
+		try {
+			if (loading->model != nullptr) {
+				loading->model->load(device, loading->modelPath, false, loading->vertexFormat);
+			}
+			textureManager->decodeUpload(*loading->textureUpload);
+		}
+		catch (...) {
+			loading->error = std::current_exception();
+		}
+		std::lock_guard<std::mutex> lock(loadMutex);
+		loadedAssets.push_back(loading);
+	});
+}
+
+void AssetLoader::update(uint32_t frame) {
+	assetsCompleted = false;
+
+	for (PendingAsset* asset : frameUploads[frame]) {
+		completeAsset(*asset);
+		removeAsset(*asset);
+	}
+	frameUploads[frame].clear();
+}
+
+void AssetLoader::recordUploads(VkCommandBuffer commandBuffer, uint32_t frame) {
+	{
+		std::lock_guard<std::mutex> lock(loadMutex);
+		uploadQueue.insert(uploadQueue.end(), loadedAssets.begin(), loadedAssets.end());
+		loadedAssets.clear();
+	}
+
+	//-----------------------------------------
+	// COPY THE ASSETS THAT FIT IN THE BUDGET (a bigger asset is uploaded alone)
+	VkDeviceSize uploadSize = 0;
+	while (!uploadQueue.empty()) {
+		PendingAsset& asset = *uploadQueue.front();
+		if (asset.error) {
+			uploadQueue.pop_front();
+			failAsset(asset);
+			continue;
+		}
+
+		VkDeviceSize size = textureManager->getUploadSize(*asset.textureUpload);
+		if (asset.model != nullptr) size += asset.model->getUploadSize();
+		if (uploadSize > 0 && uploadSize + size > uploadBudget) break;
+
+		if (asset.model != nullptr) asset.model->recordUpload(commandBuffer);
+		textureManager->recordUpload(commandBuffer, *asset.textureUpload);
+
+		frameUploads[frame].push_back(&asset);
+		uploadSize += size;
+		uploadQueue.pop_front();
+	}
+	lastUploadSize = uploadSize;
+}
+
+void AssetLoader::completeAsset(PendingAsset& asset) {
+	asset.material->storeTextures(asset.textureTypes, textureManager->acquire(*asset.textureUpload));
+
+	// the model is drawn from the next frame with its material
+	if (asset.model != nullptr) {
+		asset.model->finishUpload();
+		asset.model->setMaterial(*asset.material);
+		scene->addEntity(std::move(asset.entity));
+		asset.modelState->asset = asset.model;
+		asset.modelState->state = ASSET_STATE_READY;
+	}
+	else {
+		materials.push_back(std::move(asset.material));
+		asset.materialState->asset = materials.back().get();
+		asset.materialState->state = ASSET_STATE_READY;
+	}
+
+	float loadTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - asset.requestTime).count();
+	loadTimeSum += loadTime;
+	maxLoadTime = std::max(maxLoadTime, loadTime);
+	loadedCount++;
+	assetsCompleted = true;
+}
+
+void AssetLoader::failAsset(PendingAsset& asset) {
+	std::string message;
+	try {
+		std::rethrow_exception(asset.error);
+	}
+	catch (const std::exception& e) {
+		message = e.what();
+	}
+	catch (...) {
+		message = "unknown error";
+	}
+	std::cout << "Failed to load " << (asset.model != nullptr ? "model " + asset.modelPath : "material") << ": "
+		<< message << std::endl;
+
+	if (asset.modelState != nullptr) {
+		asset.modelState->state = ASSET_STATE_FAILED;
+		asset.modelState->error = message;
+	}
+	if (asset.materialState != nullptr) {
+		asset.materialState->state = ASSET_STATE_FAILED;
+		asset.materialState->error = message;
+	}
+	failedCount++;
+
+	destroyAsset(asset);
+	removeAsset(asset);
+}
+
+void AssetLoader::destroyAsset(PendingAsset& asset) {
+	textureManager->cancelUpload(*asset.textureUpload);
+	if (asset.model != nullptr && asset.entity != nullptr) {
+		asset.model->finishUpload();
+		asset.model->cleanup();
+	}
+}
+
+void AssetLoader::removeAsset(PendingAsset& asset) {
+	auto found = std::find_if(pendingAssets.begin(), pendingAssets.end(),
+		[&asset](const std::unique_ptr<PendingAsset>& pending) { return pending.get() == &asset; });
+	if (found != pendingAssets.end()) {
+		pendingAssets.erase(found);
+	}
+}
+
+void AssetLoader::cleanup() {
+	// no worker thread writes the pending assets after this
+	if (workerPool != nullptr) workerPool->wait();
+
+	for (auto& asset : pendingAssets) {
+		if (asset->modelState != nullptr) asset->modelState->state = ASSET_STATE_FAILED;
+		if (asset->materialState != nullptr) asset->materialState->state = ASSET_STATE_FAILED;
+		destroyAsset(*asset);
+	}
+	pendingAssets.clear();
+	loadedAssets.clear();
+	uploadQueue.clear();
+	frameUploads.clear();
+
+	for (auto& material : materials) {
+		material->cleanup();
+	}
+	materials.clear();
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "context/Device.hpp"
+#include "context/CommandManager.hpp"
+#include "render/image/SamplerCache.hpp"
+#include "render/image/TextureManager.hpp"
+#include "render/uniform/Material.hpp"
+#include "scene/Model.hpp"
+#include "scene/Scene.hpp"
+#include "system/WorkerPool.hpp"
+
+
+enum AssetState {
+	ASSET_STATE_LOADING,
+	ASSET_STATE_READY,
+	ASSET_STATE_FAILED
+};
+
+// Asset requested to the asset loader. Its state only changes in the loader update, so the main thread never sees an
+// asset partially uploaded
+template<typename T>
+class AssetHandle {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	AssetState getState() const { return state != nullptr ? state->state : ASSET_STATE_FAILED; }
+	bool isReady() const { return getState() == ASSET_STATE_READY; }
+	bool isFailed() const { return getState() == ASSET_STATE_FAILED; }
+
+	// Asset once it is ready (nullptr before)
+	T* get() const { return isReady() ? state->asset : nullptr; }
+
+	// Reason of the failure
+	std::string getError() const { return state != nullptr ? state->error : "asset was not requested"; }
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	friend class AssetLoader;
+
+	struct State {
+		AssetState state = ASSET_STATE_LOADING;
+		T* asset = nullptr;
+		std::string error;
+	};
+	std::shared_ptr<State> state;
+};
+
+using ModelHandle = AssetHandle<Model>;
+using MaterialHandle = AssetHandle<Material>;
+
+
+// Models and materials loaded in the background while the frames are presented. The worker threads load the geometry
+// and decode the textures into staging buffers, the frame command buffers copy them under a byte budget, and an asset
+// becomes ready in the update after the frame that uploaded it is completed: a model is added to the scene at once
+// with its entity and material. The loaded materials are owned by the loader (used from the main thread)
+class AssetLoader {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	// Some asset became ready in the last update (the materials of the new models may need their min LOD)
+	bool wereAssetsCompleted() const { return assetsCompleted; }
+
+	// Statistics (the load time goes from the request until the asset is ready)
+	uint32_t getPendingCount() const { return static_cast<uint32_t>(pendingAssets.size()); }
+	uint32_t getLoadedCount() const { return loadedCount; }
+	uint32_t getFailedCount() const { return failedCount; }
+	VkDeviceSize getUploadBudget() const { return uploadBudget; }
+	VkDeviceSize getLastUploadSize() const { return lastUploadSize; }
+	float getAverageLoadTime() const { return loadedCount > 0 ? loadTimeSum / loadedCount : 0.0f; }
+	float getMaxLoadTime() const { return maxLoadTime; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// The assets uploaded per frame are limited by the budget in bytes (a bigger asset is uploaded alone)
+	void create(Device device, CommandManager commandManager, SamplerCache& samplerCache, TextureManager& textureManager,
+		WorkerPool& workerPool, Scene& scene, uint32_t frameCount, VkDeviceSize uploadBudget);
+
+	// Load the model and the textures of its material. Once ready it is added to the scene with an entity of its own
+	// placed at the transform
+	ModelHandle loadModel(const std::string& modelPath, const TexturePaths& texturePaths, const Transform& transform,
+		VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT);
+
+	// Load the textures of a material (owned by the loader)
+	MaterialHandle loadMaterial(const TexturePaths& texturePaths);
+
+	// Make ready the assets uploaded by the frame (its commands are completed)
+	void update(uint32_t frame);
+
+	// Record the uploads of the assets loaded by the worker threads that fit in the budget (before the passes that use
+	// them)
+	void recordUploads(VkCommandBuffer commandBuffer, uint32_t frame);
+
+	// Wait for the loads in progress and destroy the pending assets and the loaded materials (the device is idle)
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	Device device;
+	CommandManager commandManager;
+	SamplerCache* samplerCache = nullptr;
+	TextureManager* textureManager = nullptr;
+	WorkerPool* workerPool = nullptr;
+	Scene* scene = nullptr;
+	VkDeviceSize uploadBudget = 0;
+
+	// Asset being loaded (the worker thread only writes it until it is in the loaded assets)
+	struct PendingAsset {
+		std::shared_ptr<ModelHandle::State> modelState;
+		std::shared_ptr<MaterialHandle::State> materialState;
+		std::unique_ptr<Entity> entity;			// of the model, out of the scene until it is ready
+		Model* model = nullptr;
+		std::string modelPath;
+		VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+		std::unique_ptr<Material> material;
+		std::vector<TextureType> textureTypes;
+		std::shared_ptr<TextureManager::TextureUpload> textureUpload;
+		std::exception_ptr error;
+		std::chrono::steady_clock::time_point requestTime;
+	};
+	std::list<std::unique_ptr<PendingAsset>> pendingAssets;
+
+	std::mutex loadMutex;
+	std::vector<PendingAsset*> loadedAssets;		// written by the worker threads
+	std::deque<PendingAsset*> uploadQueue;
+	std::vector<std::vector<PendingAsset*>> frameUploads;	// uploaded by the commands of each frame in flight
+
+	std::vector<std::unique_ptr<Material>> materials;
+
+	bool assetsCompleted = false;
+	VkDeviceSize lastUploadSize = 0;
+	uint32_t loadedCount = 0;
+	uint32_t failedCount = 0;
+	float loadTimeSum = 0.0f;
+	float maxLoadTime = 0.0f;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Track a new asset with a material of the texture files
+	PendingAsset& addAsset(const TexturePaths& texturePaths);
+
+	// Load the geometry and decode the textures of the asset in a worker thread
+	void startLoad(PendingAsset& asset);
+
+	// Publish the uploaded asset through its handle
+	void completeAsset(PendingAsset& asset);
+
+	// Report the error of the asset through its handle and destroy what it loaded (nothing of it was recorded)
+	void failAsset(PendingAsset& asset);
+
+	// Destroy the staging buffers and the objects of an asset that is not ready (its commands are completed)
+	void destroyAsset(PendingAsset& asset);
+
+	void removeAsset(PendingAsset& asset);
+};
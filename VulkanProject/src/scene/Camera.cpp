@@ -102,6 +102,6 @@ void Camera::computeProjection() {
 
 	float aspectRatio = extent.width / (float)extent.height;
 	projection = glm::perspective(
-		glm::radians(45.0f), aspectRatio, 0.1f, 10.0f);
+		glm::radians(45.0f), aspectRatio, nearPlane, farPlane);
 	projection[1][1] *= -1; // non-OpenGL GLM usage adjustment
 }
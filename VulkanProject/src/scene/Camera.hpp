@@ -20,6 +20,8 @@ class Camera : public Module {
 public:
 	glm::mat4 getView() { return view; }
 	glm::mat4 getProjection() { return projection; }
+	float getNearPlane() { return nearPlane; }
+	float getFarPlane() { return farPlane; }
 
 	void updateProjection(VkExtent2D extent) { this->extent = extent; computeProjection(); }
 
@@ -36,6 +38,8 @@ private:
 
 	glm::mat4 view;
 	glm::mat4 projection;
+	float nearPlane = 0.1f;
+	float farPlane = 10.0f;
 
 	void computeView();
 	void computeProjection();
@@ -7,16 +7,34 @@
 #include "scene/Transform.hpp"
 
 
+// Point lights are limited by their radius, spot lights also by a cone around their direction, directional lights
+// (e.g. the sun) light the whole scene from a direction and cast cascaded shadows
+enum LightType {
+	LIGHT_TYPE_POINT,
+	LIGHT_TYPE_SPOT,
+	LIGHT_TYPE_DIRECTIONAL
+};
+
+
 class Light : public Module {
 public:
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// GETTERS AND SETTERS
 
+	LightType getType() const { return type; }
 	glm::vec3 getDirection() const { return transform->lookAt; }
 	glm::vec3 getColor() const { return color; }
+	float getRadius() const { return radius; }
+	float getSpotAngle() const { return spotAngle; }
+	bool getCastShadows() const { return castShadows; }
 
+	void setType(LightType type) { this->type = type; }
 	void setColor(glm::vec3 color) { this->color = color; }
+	void setRadius(float radius) { this->radius = radius; }
+	void setSpotAngle(float spotAngle) { this->spotAngle = spotAngle; }
+	// Point and spot lights with shadows get tiles of the shadow atlas (directional lights always cast shadows)
+	void setCastShadows(bool castShadows) { this->castShadows = castShadows; }
 
 	Light();
 
@@ -31,7 +49,13 @@ private:
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// CLASS MEMBERS
 
-	// TODO: add intensity and radius variables
+	// TODO: add intensity variable
+	LightType type = LIGHT_TYPE_POINT;
 	glm::vec3 color;
+	// Distance where the light contribution reaches zero
+	float radius = 10.0f;
+	// Half angle of the spot light cone (radians)
+	float spotAngle = glm::radians(45.0f);
+	bool castShadows = false;
 
 };
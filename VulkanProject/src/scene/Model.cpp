@@ -1,25 +1,44 @@
 #include "Model.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <stdexcept>
 #include "asset/modelLoader.hpp"
+#include "asset/meshOptimizer.hpp"
+#include "asset/vertexEncoder.hpp"
+#include "scene/Camera.hpp"
 
 
 void Model::create(Device device, CommandManager commandManager, std::string modelPath, Material material,
-	bool useRawVertexData) {
+	bool useRawVertexData, VertexFormat vertexFormat) {
 
-	this->device = device;
 	this->material = material;
+	load(device, modelPath, useRawVertexData, vertexFormat);
+
+	// every buffer in a single submission
+	VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
+	recordUpload(commandBuffer);
+	commandManager.endSingleTimeCommands(commandBuffer);
+	finishUpload();
+}
+
+void Model::load(Device device, std::string modelPath, bool useRawVertexData, VertexFormat vertexFormat) {
+	this->device = device;
+	this->vertexFormat = vertexFormat;
 
 	//--------------------------------------------------------
 	// LOAD THE GEOMETRY
 	loadModel(modelPath);
 
 	//--------------------------------------------------------
-	// CREATE VERTEX AND INDEX BUFFERS
-	createBuffer(commandManager, sizeof(vertices[0]) * vertices.size(), vertices.data(),
-		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexBufferMemory);
-	createBuffer(commandManager, sizeof(indices[0]) * indices.size(), indices.data(),
-		VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory);
+	// CREATE VERTEX AND INDEX BUFFERS (filled by the upload)
+	createVertexBuffer();
+	createIndexBuffer();
+	if (hasMeshlets()) {
+		createBuffer(sizeof(meshlets[0]) * meshlets.size(), meshlets.data(),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshletBuffer, meshletBufferMemory);
+		createBuffer(sizeof(meshletIndices[0]) * meshletIndices.size(), meshletIndices.data(),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshletIndexBuffer, meshletIndexBufferMemory);
+	}
 
 	//--------------------------------------------------------
 	// TRANSFORM (if the vertex data will be used with transformations)
@@ -28,42 +47,203 @@ void Model::create(Device device, CommandManager commandManager, std::string mod
 	}
 }
 
+VkDeviceSize Model::getUploadSize() {
+	VkDeviceSize size = 0;
+	for (const auto& copy : stagedCopies) {
+		size += copy.size;
+	}
+	return size;
+}
+
+void Model::recordUpload(VkCommandBuffer commandBuffer) {
+	for (const auto& copy : stagedCopies) {
+		VkBufferCopy copyRegion{};
+		copyRegion.size = copy.size;
+		vkCmdCopyBuffer(commandBuffer, copy.stagingBuffer, copy.buffer, 1, &copyRegion);
+	}
+
+	// the next commands of the queue can read the geometry (draws and meshlet culling)
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void Model::finishUpload() {
+	for (const auto& copy : stagedCopies) {
+		vkDestroyBuffer(device.get(), copy.stagingBuffer, nullptr);
+		vkFreeMemory(device.get(), copy.stagingBufferMemory, nullptr);
+	}
+	stagedCopies.clear();
+}
+
 void Model::loadModel(std::string modelPath) {
 	ModelData data = loadModelFromFile(modelPath);
 	vertices = std::move(data.vertices);
 	indices = std::move(data.indices);
+	lods = std::move(data.lods);
+	subsets = std::move(data.subsets);
+	indexType = data.indexType;
+	meshlets = std::move(data.meshlets);
+	meshletIndices = std::move(data.meshletIndices);
+	bounds = data.bounds;
+	stats = data.stats;
+	currentLod = 0;
+
+	if (lods.empty()) {
+		lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+	}
+	if (subsets.empty()) {
+		for (MeshLod& lod : lods) {
+			lod.firstSubset = static_cast<uint32_t>(subsets.size());
+			lod.subsetCount = 1;
+			subsets.push_back({ lod.firstIndex, lod.indexCount, 0 });
+		}
+	}
+}
+
+std::vector<uint32_t> Model::getLodIndices(uint32_t lod) {
+	std::vector<uint32_t> lodIndices;
+	lodIndices.reserve(lods[lod].indexCount);
+	for (uint32_t s = lods[lod].firstSubset; s < lods[lod].firstSubset + lods[lod].subsetCount; s++) {
+		for (uint32_t i = subsets[s].firstIndex; i < subsets[s].firstIndex + subsets[s].indexCount; i++) {
+			lodIndices.push_back(indices[i] + subsets[s].vertexOffset);
+		}
+	}
+	return lodIndices;
+}
+
+void Model::createIndexBuffer() {
+	stats.fullIndexBytes = sizeof(uint32_t) * indices.size();
+	if (indexType == VK_INDEX_TYPE_UINT32) {
+		stats.indexBytes = stats.fullIndexBytes;
+		createBuffer(sizeof(indices[0]) * indices.size(), indices.data(),
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory);
+		return;
+	}
+
+	// the indices are relative to the vertex offset of their subset, so they fit unless the subsets are wrong
+	std::vector<uint16_t> shortIndices;
+	shortIndices.reserve(indices.size());
+	for (uint32_t index : indices) {
+		if (index >= SHORT_INDEX_VERTEX_LIMIT) {
+			throw std::runtime_error("index out of the 16 bit range of its subset");
+		}
+		shortIndices.push_back(static_cast<uint16_t>(index));
+	}
+	stats.indexBytes = sizeof(shortIndices[0]) * shortIndices.size();
+	createBuffer(sizeof(shortIndices[0]) * shortIndices.size(), shortIndices.data(),
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory);
+}
+
+void Model::createVertexBuffer() {
+	stats.floatVertexBytes = sizeof(Vertex) * vertices.size();
+	if (vertexFormat == VERTEX_FORMAT_FLOAT) {
+		quantization = VertexQuantization{};
+		stats.vertexBytes = stats.floatVertexBytes;
+		createBuffer(sizeof(vertices[0]) * vertices.size(), vertices.data(),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexBufferMemory);
+		return;
+	}
+
+	//--------------------------------------------
+	// ENCODE THE VERTICES
+	VertexPackingError error;
+	quantization = computeVertexQuantization(vertices);
+	std::vector<PackedVertex> packedVertices = packVertices(vertices, quantization, error);
+
+	createBuffer(sizeof(packedVertices[0]) * packedVertices.size(), packedVertices.data(),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexBufferMemory);
+
+	//--------------------------------------------
+	// MEMORY AND BANDWIDTH COMPARED WITH THE FLOAT LAYOUT
+	std::vector<uint32_t> fullResolution = getLodIndices(0);
+	float transformedVertices = computeAcmr(fullResolution, vertices.size()) * fullResolution.size() / 3;
+	stats.vertexBytes = sizeof(PackedVertex) * packedVertices.size();
+	stats.vertexFetchBytes = static_cast<size_t>(transformedVertices * sizeof(PackedVertex));
+	stats.floatVertexFetchBytes = static_cast<size_t>(transformedVertices * sizeof(Vertex));
+	stats.positionError = error.position;
+	stats.normalError = error.normalAngle;
+	stats.texCoordError = error.texCoord;
+}
+
+BoundingSphere Model::getWorldBounds() {
+	if (transform == nullptr) return bounds;
+
+	BoundingSphere worldBounds;
+	worldBounds.center = glm::vec3(createModelMatrix(transform) * glm::vec4(bounds.center, 1.0f));
+	worldBounds.radius = bounds.radius * getMaxScale();
+	return worldBounds;
+}
+
+float Model::getMaxScale() {
+	return std::max(std::fabs(transform->scale.x), std::max(std::fabs(transform->scale.y), std::fabs(transform->scale.z)));
+}
+
+float Model::getPixelsPerUnit(Camera& camera, VkExtent2D extent) {
+	//--------------------------------------------
+	// DISTANCE FROM THE CAMERA TO THE MODEL SURFACE
+	glm::mat4 modelMatrix = createModelMatrix(transform);
+	glm::vec3 worldCenter = glm::vec3(modelMatrix * glm::vec4(bounds.center, 1.0f));
+	float distance = glm::length(worldCenter - camera.getTransform()->position) - bounds.radius * getMaxScale();
+	distance = std::max(distance, camera.getNearPlane());
+
+	//--------------------------------------------
+	// PIXELS PER MODEL UNIT AT THAT DISTANCE
+	return std::fabs(camera.getProjection()[1][1]) * 0.5f * extent.height / distance;
+}
+
+void Model::selectLod(Camera& camera, VkExtent2D extent, float pixelThreshold) {
+	currentLod = 0;
+	if (transform == nullptr || camera.getTransform() == nullptr || lods.size() == 1) return;
+
+	float scale = getMaxScale();
+	float pixelsPerUnit = getPixelsPerUnit(camera, extent);
+
+	// the errors grow with the level: keep the last one that is still under the threshold
+	for (uint32_t lod = 1; lod < lods.size(); lod++) {
+		if (lods[lod].error * scale * pixelsPerUnit > pixelThreshold) break;
+		currentLod = lod;
+	}
+}
+
+float Model::getScreenSize(Camera& camera, VkExtent2D extent) {
+	if (transform == nullptr || camera.getTransform() == nullptr) {
+		return static_cast<float>(std::max(extent.width, extent.height));
+	}
+
+	return 2.0f * bounds.radius * getMaxScale() * getPixelsPerUnit(camera, extent);
 }
 
 // TODO: allocate more than one resource from a single call
 // TODO: store all the data in a single buffer and use offsets in calls with them
-void Model::createBuffer(CommandManager commandManager, VkDeviceSize bufferSize, void* bufferData,
-	VkBufferUsageFlagBits usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+void Model::createBuffer(VkDeviceSize bufferSize, void* bufferData, VkBufferUsageFlagBits usage, VkBuffer& buffer,
+	VkDeviceMemory& bufferMemory) {
 
 	//--------------------------------------------
-	// STAGING BUFFER
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
+	// STAGING BUFFER (destroyed when the upload is finished)
+	StagedCopy copy;
+	copy.size = bufferSize;
 	device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer, stagingBufferMemory);
+		copy.stagingBuffer, copy.stagingBufferMemory);
 
 	// copy data to the buffer
 	void* data;
-	vkMapMemory(device.get(), stagingBufferMemory, 0, bufferSize, 0, &data);
+	vkMapMemory(device.get(), copy.stagingBufferMemory, 0, bufferSize, 0, &data);
 	memcpy(data, bufferData, (size_t)bufferSize);
-	vkUnmapMemory(device.get(), stagingBufferMemory);
+	vkUnmapMemory(device.get(), copy.stagingBufferMemory);
 
 	//--------------------------------------------
-	// CREATE BUFFER AND FILL IT WITH DATA
+	// CREATE BUFFER (filled by the recorded copy)
 	device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
 
-	commandManager.copyBuffer(stagingBuffer, buffer, bufferSize);
-
-	//--------------------------------------------
-	// Clean up
-	vkDestroyBuffer(device.get(), stagingBuffer, nullptr);
-	vkFreeMemory(device.get(), stagingBufferMemory, nullptr);
+	copy.buffer = buffer;
+	stagedCopies.push_back(copy);
 }
 
 void Model::cleanup() {
@@ -71,5 +251,11 @@ void Model::cleanup() {
 	vkFreeMemory(device.get(), vertexBufferMemory, nullptr);
 	vkDestroyBuffer(device.get(), indexBuffer, nullptr);
 	vkFreeMemory(device.get(), indexBufferMemory, nullptr);
+	if (meshletBuffer != VK_NULL_HANDLE) {
+		vkDestroyBuffer(device.get(), meshletBuffer, nullptr);
+		vkFreeMemory(device.get(), meshletBufferMemory, nullptr);
+		vkDestroyBuffer(device.get(), meshletIndexBuffer, nullptr);
+		vkFreeMemory(device.get(), meshletIndexBufferMemory, nullptr);
+	}
 	material.cleanup();
 }
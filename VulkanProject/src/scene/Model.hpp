@@ -2,10 +2,13 @@
 
 #include "scene/Module.hpp"
 #include "render/vertex/Vertex.hpp"
+#include "render/vertex/Mesh.hpp"
 #include "Transform.hpp"
 #include "render/uniform/Material.hpp"
 
 
+class Camera;
+
 class Model : public Module {
 public:
 
@@ -15,9 +18,35 @@ public:
 	bool useRawVertexData() { return transform == nullptr; }
 
 	std::vector<uint32_t> getIndices() { return indices; }
+	// Index range of the selected level of detail
+	uint32_t getFirstIndex() { return lods[currentLod].firstIndex; }
+	uint32_t getIndexCount() { return lods[currentLod].indexCount; }
+	uint32_t getCurrentLod() { return currentLod; }
+	VkIndexType getIndexType() { return indexType; }
+	// Subsets (one draw each) of the selected level of detail
+	uint32_t getSubsetCount() { return lods[currentLod].subsetCount; }
+	const MeshSubset& getSubset(uint32_t index) { return subsets[lods[currentLod].firstSubset + index]; }
+	uint32_t getLodCount() { return static_cast<uint32_t>(lods.size()); }
+	const MeshLod& getLod(uint32_t lod) { return lods[lod]; }
+	uint32_t getVertexCount() { return static_cast<uint32_t>(vertices.size()); }
+	// Statistics of the loading and buffer creation
+	const MeshStats& getStats() { return stats; }
+	const BoundingSphere& getBounds() { return bounds; }
+	// Bounding sphere with the model transform applied
+	BoundingSphere getWorldBounds();
 	VkBuffer getVertexBuffer() { return vertexBuffer; }
+	VertexFormat getVertexFormat() { return vertexFormat; }
+	// Transformation from the vertex buffer positions to model space (identity for float vertices)
+	glm::mat4 getDequantizationMatrix() { return quantization.getDequantizationMatrix(); }
 	
 	VkBuffer getIndexBuffer() { return indexBuffer; }
+
+	// Meshlets of the full resolution level of detail (storage buffers for the culling pass)
+	bool hasMeshlets() { return !meshlets.empty(); }
+	uint32_t getMeshletCount() { return static_cast<uint32_t>(meshlets.size()); }
+	uint32_t getMeshletIndexCount() { return static_cast<uint32_t>(meshletIndices.size()); }
+	VkBuffer getMeshletBuffer() { return meshletBuffer; }
+	VkBuffer getMeshletIndexBuffer() { return meshletIndexBuffer; }
 	Material& getMaterial() { return material; }
 
 	void setMaterial(Material& material) { this->material = std::move(material); }
@@ -26,9 +55,31 @@ public:
 	// METHODS
 
 	// Load a model, create its vertex and index buffer and its textures. If useRawVertexData is true then the transform
-	// is not initialized (the shader will use the raw vertex data without transformations)
+	// is not initialized (the shader will use the raw vertex data without transformations). The vertex buffer is
+	// stored with vertexFormat layout
 	void create(Device device, CommandManager commandManager, std::string modelPath, Material material,
-		bool useRawVertexData = false);
+		bool useRawVertexData = false, VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT);
+
+	// Load a model and create its buffers with the data in staging buffers, without commands (usable from a worker
+	// thread while the model is not in the scene). The buffers are filled by the copies of recordUpload
+	void load(Device device, std::string modelPath, bool useRawVertexData = false,
+		VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT);
+
+	// Bytes of the staging buffers
+	VkDeviceSize getUploadSize();
+
+	// Record the copies of the staging buffers (the next commands of the queue can read the buffers)
+	void recordUpload(VkCommandBuffer commandBuffer);
+
+	// Destroy the staging buffers (their copies are completed)
+	void finishUpload();
+
+	// Select the coarsest level of detail whose error projected on the screen is below pixelThreshold pixels
+	void selectLod(Camera& camera, VkExtent2D extent, float pixelThreshold);
+
+	// Pixels covered on the screen by the diameter of the bounds at their closest distance to the camera (the whole
+	// screen if the model has no transform)
+	float getScreenSize(Camera& camera, VkExtent2D extent);
 
 	void setOwner(Entity* owner) override {
 		Module::setOwner(owner);
@@ -47,10 +98,33 @@ private:
 	Device device;
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
-	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
-	VkBuffer indexBuffer;
-	VkDeviceMemory indexBufferMemory;
+	std::vector<MeshLod> lods;
+	std::vector<MeshSubset> subsets;
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> meshletIndices;
+	BoundingSphere bounds;
+	MeshStats stats;
+	uint32_t currentLod = 0;
+	VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+	VertexQuantization quantization;
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
+	VkBuffer meshletBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory meshletBufferMemory = VK_NULL_HANDLE;
+	VkBuffer meshletIndexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory meshletIndexBufferMemory = VK_NULL_HANDLE;
+
+	// Staging buffer of each device local buffer until the upload is finished
+	struct StagedCopy {
+		VkBuffer stagingBuffer;
+		VkDeviceMemory stagingBufferMemory;
+		VkBuffer buffer;
+		VkDeviceSize size;
+	};
+	std::vector<StagedCopy> stagedCopies;
 
 	Material material;
 
@@ -60,7 +134,22 @@ private:
 	// Load a model from file
 	void loadModel(std::string modelPath);
 
-	// Create a buffer in GPU memory and fill it with the received data
-	void createBuffer(CommandManager commandManager, VkDeviceSize bufferSize, void* bufferData,
-		VkBufferUsageFlagBits bufferUsage, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	// Create the vertex buffer with the layout of the vertex format
+	void createVertexBuffer();
+
+	// Create the index buffer with the index type of the mesh
+	void createIndexBuffer();
+
+	// Indices of a level of detail relative to the start of the vertex buffer
+	std::vector<uint32_t> getLodIndices(uint32_t lod);
+
+	// Largest absolute scale of the transform (mirrored axes scale as much as the others)
+	float getMaxScale();
+
+	// Pixels per model unit at the closest distance of the bounds to the camera (the model and camera have a transform)
+	float getPixelsPerUnit(Camera& camera, VkExtent2D extent);
+
+	// Create a buffer in GPU memory and a staging buffer with the received data (copied by the upload)
+	void createBuffer(VkDeviceSize bufferSize, void* bufferData, VkBufferUsageFlagBits bufferUsage, VkBuffer& buffer,
+		VkDeviceMemory& bufferMemory);
 };
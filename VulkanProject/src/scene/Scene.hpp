@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include "scene/Entity.hpp"
 #include "scene/Camera.hpp"
 
@@ -24,6 +25,21 @@ public:
 		return entities.back().get();
 	};
 
+	// Add an entity created outside the scene (its modules are visible from now on)
+	Entity* addEntity(std::unique_ptr<Entity> entity) {
+		entities.push_back(std::move(entity));
+		return entities.back().get();
+	};
+
+	// Remove an entity (and its modules) from the scene
+	void removeEntity(Entity* entity) {
+		auto it = std::find_if(entities.begin(), entities.end(),
+			[entity](const std::unique_ptr<Entity>& e) { return e.get() == entity; });
+		if (it != entities.end()) {
+			entities.erase(it);
+		}
+	}
+
 	// Return a vector with the modules of the specified type in the scene
 	// TODO: search in the children
 	template<typename T>
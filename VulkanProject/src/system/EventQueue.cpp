@@ -0,0 +1,70 @@
+#include "system/EventQueue.hpp"
+
+
+uint32_t EventQueue::getSize() const {
+	uint64_t written = writePosition.load(std::memory_order_acquire);
+	uint64_t read = readPosition.load(std::memory_order_relaxed);
+	return static_cast<uint32_t>(written - read);
+}
+
+void EventQueue::create(uint32_t capacity) {
+	uint64_t cellCount = 1;
+	while (cellCount < capacity) {
+		cellCount *= 2;
+	}
+
+	cells.reset(new Cell[cellCount]);
+	mask = cellCount - 1;
+	for (uint64_t i = 0; i < cellCount; i++) {
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	writePosition.store(0, std::memory_order_relaxed);
+	readPosition.store(0, std::memory_order_release);
+}
+
+bool EventQueue::push(const SDL_Event& event, Uint64 queuedTime) {
+	uint64_t position = writePosition.load(std::memory_order_relaxed);
+	Cell* cell;
+	while (true) {
+		cell = &cells[position & mask];
+		uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+		int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+
+		// free cell: taken if no other writer moved the position first (the position is reloaded if it did)
+		if (difference == 0) {
+			if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+		}
+		// the cell of the previous round is not read yet
+		else if (difference < 0) {
+			return false;
+		}
+		else {
+			position = writePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->queuedEvent.event = event;
+	cell->queuedEvent.queuedTime = queuedTime;
+	cell->sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+bool EventQueue::pop(QueuedEvent& queuedEvent) {
+	uint64_t position = readPosition.load(std::memory_order_relaxed);
+	Cell& cell = cells[position & mask];
+
+	// not written yet (or still being written)
+	if (cell.sequence.load(std::memory_order_acquire) != position + 1) return false;
+
+	queuedEvent = cell.queuedEvent;
+
+	// free for the writers of the next round
+	cell.sequence.store(position + mask + 1, std::memory_order_release);
+	readPosition.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+void EventQueue::cleanup() {
+	cells.reset();
+	mask = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <SDL3/SDL_events.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+
+// Events held by the queue until they are read (a frame of input with a margin)
+const uint32_t DEFAULT_EVENT_QUEUE_CAPACITY = 4096;
+
+// Event and the time it was queued at (SDL_GetTicksNS, the clock of the event timestamps)
+struct QueuedEvent {
+	SDL_Event event;
+	Uint64 queuedTime;
+};
+
+
+// Bounded lock-free queue of events pushed from any thread and read from a single one. Each cell has a sequence number
+// that tells whether it is free to write or ready to read, so the writers only compete for the write position and the
+// reader never waits for them. A full queue rejects the new events
+class EventQueue {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	uint32_t getCapacity() const { return static_cast<uint32_t>(mask + 1); }
+
+	// Events pushed and not read yet (from the reading thread, the ones being pushed meanwhile may be missing)
+	uint32_t getSize() const;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Allocate the cells (the capacity is rounded up to a power of two)
+	void create(uint32_t capacity = DEFAULT_EVENT_QUEUE_CAPACITY);
+
+	// Add the event if there is room (from any thread)
+	bool push(const SDL_Event& event, Uint64 queuedTime);
+
+	// Take the oldest event (from the reading thread)
+	bool pop(QueuedEvent& queuedEvent);
+
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	// the sequence is the position the cell can be written at, or that position + 1 once it is written
+	struct Cell {
+		std::atomic<uint64_t> sequence;
+		QueuedEvent queuedEvent;
+	};
+	std::unique_ptr<Cell[]> cells;
+	uint64_t mask = 0;
+
+	// in different cache lines (written by the writers and by the reader)
+	alignas(64) std::atomic<uint64_t> writePosition{ 0 };
+	alignas(64) std::atomic<uint64_t> readPosition{ 0 };
+};
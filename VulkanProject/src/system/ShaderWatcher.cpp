@@ -0,0 +1,135 @@
+#include "system/ShaderWatcher.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+
+namespace {
+
+#ifdef _WIN32
+	const char PATH_SEPARATOR = ';';
+	const char* COMPILER_NAME = "glslc.exe";
+#else
+	const char PATH_SEPARATOR = ':';
+	const char* COMPILER_NAME = "glslc";
+#endif
+
+	std::filesystem::file_time_type getWriteTime(const std::string& path) {
+		std::error_code error;
+		auto time = std::filesystem::last_write_time(path, error);
+		return error ? std::filesystem::file_time_type::min() : time;
+	}
+
+	// glslc of the Vulkan SDK or the first one in the PATH (empty if there is none)
+	std::string findCompiler() {
+		std::error_code error;
+		if (const char* sdk = std::getenv("VULKAN_SDK")) {
+			for (const char* bin : { "Bin", "bin" }) {
+				std::filesystem::path candidate = std::filesystem::path(sdk) / bin / COMPILER_NAME;
+				if (std::filesystem::exists(candidate, error)) return candidate.string();
+			}
+		}
+
+		if (const char* path = std::getenv("PATH")) {
+			std::string directories = path;
+			size_t start = 0;
+			while (start <= directories.size()) {
+				size_t end = directories.find(PATH_SEPARATOR, start);
+				if (end == std::string::npos) end = directories.size();
+				if (end > start) {
+					std::filesystem::path candidate =
+						std::filesystem::path(directories.substr(start, end - start)) / COMPILER_NAME;
+					if (std::filesystem::exists(candidate, error)) return candidate.string();
+				}
+				start = end + 1;
+			}
+		}
+		return "";
+	}
+}
+
+
+std::vector<std::string> ShaderWatcher::takeChangedShaders() {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<std::string> changed;
+	changed.swap(changedShaders);
+	return changed;
+}
+
+void ShaderWatcher::create(const std::vector<ShaderSource>& shaders, const std::vector<std::string>& spirvPaths,
+	std::chrono::milliseconds interval) {
+
+	this->interval = interval;
+	compilerPath = findCompiler();
+	if (!hasCompiler()) {
+		std::cout << "Shader watcher: glslc not found, only the SPIR-V files are reloaded" << std::endl;
+	}
+
+	// sources first: a compiled SPIR-V file is reported in the same check
+	for (const auto& shader : shaders) {
+		files.push_back({ shader.sourcePath, shader.spirvPath, getWriteTime(shader.sourcePath), shader.defines });
+	}
+	std::vector<std::string> watchedSpirv = spirvPaths;
+	for (const auto& shader : shaders) {
+		watchedSpirv.push_back(shader.spirvPath);
+	}
+	std::sort(watchedSpirv.begin(), watchedSpirv.end());
+	watchedSpirv.erase(std::unique(watchedSpirv.begin(), watchedSpirv.end()), watchedSpirv.end());
+	for (const auto& path : watchedSpirv) {
+		if (!path.empty()) files.push_back({ path, "", getWriteTime(path) });
+	}
+
+	stopping = false;
+	thread = std::thread(&ShaderWatcher::watchLoop, this);
+}
+
+void ShaderWatcher::watchLoop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopRequested.wait_for(lock, interval, [this]() { return stopping; })) {
+		lock.unlock();
+
+		std::vector<std::string> changed;
+		for (auto& file : files) {
+			auto writeTime = getWriteTime(file.path);
+			if (writeTime == file.lastWriteTime) continue;
+			file.lastWriteTime = writeTime;
+
+			bool isSource = !file.spirvPath.empty();
+			if (isSource) {
+				if (hasCompiler() && !compile(file)) {
+					std::cout << "Shader watcher: failed to compile " << file.path << std::endl;
+				}
+			}
+			else {
+				changed.push_back(file.path);
+			}
+		}
+
+		lock.lock();
+		changedShaders.insert(changedShaders.end(), changed.begin(), changed.end());
+	}
+}
+
+bool ShaderWatcher::compile(const WatchedFile& source) {
+	std::string command = "\"" + compilerPath + "\"";
+	for (const auto& define : source.defines) {
+		command += " -D" + define;
+	}
+	command += " \"" + source.path + "\" -o \"" + source.spirvPath + "\"";
+#ifdef _WIN32
+	// cmd removes the outer quotes of the command
+	command = "\"" + command + "\"";
+#endif
+	return std::system(command.c_str()) == 0;
+}
+
+void ShaderWatcher::cleanup() {
+	if (!thread.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	stopRequested.notify_all();
+	thread.join();
+}
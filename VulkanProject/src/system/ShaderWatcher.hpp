@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// GLSL source and the SPIR-V file compiled from it (with the preprocessor macros defined)
+struct ShaderSource {
+	std::string sourcePath;
+	std::string spirvPath;
+	std::vector<std::string> defines;
+};
+
+
+// Background thread that checks the modification time of the shaders. A changed source is compiled again with glslc
+// (from the VULKAN_SDK or the PATH, if there is one) and a changed SPIR-V file is reported to the renderer, which
+// rebuilds the pipelines that use it
+class ShaderWatcher {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	bool hasCompiler() const { return !compilerPath.empty(); }
+
+	// SPIR-V files changed since the last call
+	std::vector<std::string> takeChangedShaders();
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Start watching the shaders (the SPIR-V files of the pipelines can be watched without a source)
+	void create(const std::vector<ShaderSource>& shaders, const std::vector<std::string>& spirvPaths,
+		std::chrono::milliseconds interval);
+
+	// Stop the thread
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	struct WatchedFile {
+		std::string path;
+		std::string spirvPath;		// output of the source (empty for SPIR-V files)
+		std::filesystem::file_time_type lastWriteTime;
+		std::vector<std::string> defines;
+	};
+	std::vector<WatchedFile> files;
+	std::string compilerPath;
+	std::chrono::milliseconds interval;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable stopRequested;
+	bool stopping = false;
+	std::vector<std::string> changedShaders;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	void watchLoop();
+
+	// Compile the source into its SPIR-V file (false if glslc failed)
+	bool compile(const WatchedFile& source);
+};
@@ -0,0 +1,242 @@
+#include "system/WorkerPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+
+namespace {
+
+	// Pool and queue of the worker thread (no pool on the other threads)
+	thread_local const WorkerPool* currentPool = nullptr;
+	thread_local uint32_t currentQueueIndex = 0;
+
+	// A worker waiting on a counter looks for new jobs again after this time
+	const std::chrono::milliseconds COUNTER_POLL_INTERVAL(1);
+}
+
+
+bool WorkerPool::isWorkerThread() const {
+	return currentPool == this;
+}
+
+uint32_t WorkerPool::getQueueIndex() const {
+	return isWorkerThread() ? currentQueueIndex : getThreadCount();
+}
+
+void WorkerPool::create(uint32_t threadCount) {
+	stopping = false;
+	threadCount = std::max(threadCount, 1u);
+
+	// the queues exist before the threads start stealing from them
+	for (uint32_t i = 0; i <= threadCount; i++) {
+		queues.push_back(std::make_unique<JobQueue>());
+	}
+	for (uint32_t i = 0; i < threadCount; i++) {
+		threads.emplace_back(&WorkerPool::workerLoop, this, i);
+	}
+}
+
+void WorkerPool::submit(WorkerTask task, JobCounter* counter) {
+	if (counter != nullptr) counter->count++;
+	pendingJobCount++;
+	push({ std::move(task), counter });
+}
+
+void WorkerPool::submitAfter(JobCounter& dependency, WorkerTask task, JobCounter* counter) {
+	{
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (dependency.count.load() > 0) {
+			// pending from now on, queued by the last job of the dependency
+			if (counter != nullptr) counter->count++;
+			pendingJobCount++;
+			dependency.continuations.emplace_back(std::move(task), counter);
+			return;
+		}
+	}
+	submit(std::move(task), counter);
+}
+
+void WorkerPool::push(Job job) {
+	JobQueue& queue = *queues[getQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	queuedJobCount++;
+
+	// a thread that found no job before the increment is already waiting once the sleep mutex is free
+	if (sleepingThreadCount.load() > 0) {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		jobAvailable.notify_one();
+	}
+}
+
+bool WorkerPool::pop(uint32_t queueIndex, Job& job) {
+	if (queuedJobCount.load() == 0) return false;
+	uint32_t sharedIndex = getThreadCount();
+
+	//-----------------------------------------
+	// OWN QUEUE (the newest job, or the oldest of the shared queue)
+	{
+		JobQueue& queue = *queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			if (queueIndex == sharedIndex) {
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+			}
+			else {
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+			}
+			queuedJobCount--;
+			return true;
+		}
+	}
+
+	//-----------------------------------------
+	// SHARED QUEUE AND STEALING (the oldest job, from the next thread on so the victims are spread)
+	for (uint32_t i = 0; i <= sharedIndex; i++) {
+		uint32_t index = i == 0 ? sharedIndex : (queueIndex + i) % sharedIndex;
+		if (index == queueIndex) continue;
+
+		JobQueue& queue = *queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty()) continue;
+
+		job = std::move(queue.jobs.front());
+		queue.jobs.pop_front();
+		queuedJobCount--;
+		if (index != sharedIndex) stealCount++;
+		return true;
+	}
+	return false;
+}
+
+void WorkerPool::run(Job& job) {
+	job.task();
+	job.task = nullptr;
+
+	if (job.counter != nullptr) {
+		// the waiters check the count under the mutex, so the counter is not destroyed while it is used here
+		std::vector<std::pair<WorkerTask, JobCounter*>> ready;
+		{
+			std::lock_guard<std::mutex> lock(job.counter->mutex);
+			if (--job.counter->count == 0) {
+				ready.swap(job.counter->continuations);
+				job.counter->finished.notify_all();
+			}
+		}
+
+		// already pending, queued before this job stops being pending
+		for (auto& continuation : ready) {
+			push({ std::move(continuation.first), continuation.second });
+		}
+	}
+
+	if (--pendingJobCount == 0) {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		jobsFinished.notify_all();
+	}
+}
+
+void WorkerPool::wait(JobCounter& counter) {
+	uint32_t queueIndex = getQueueIndex();
+	bool workerThread = isWorkerThread();
+
+	std::unique_lock<std::mutex> lock(counter.mutex);
+	while (counter.count.load() > 0) {
+		lock.unlock();
+		Job job;
+		if (workerThread && pop(queueIndex, job)) {
+			run(job);
+			lock.lock();
+			continue;
+		}
+
+		// the remaining jobs are running in other threads
+		lock.lock();
+		if (workerThread) {
+			counter.finished.wait_for(lock, COUNTER_POLL_INTERVAL, [&counter]() { return counter.count.load() == 0; });
+		}
+		else {
+			counter.finished.wait(lock, [&counter]() { return counter.count.load() == 0; });
+		}
+	}
+}
+
+void WorkerPool::wait() {
+	std::unique_lock<std::mutex> lock(sleepMutex);
+	jobsFinished.wait(lock, [this]() { return pendingJobCount.load() == 0; });
+}
+
+void WorkerPool::parallelFor(uint32_t count, uint32_t grainSize, const WorkerRange& body) {
+	grainSize = std::max(grainSize, 1u);
+	uint32_t rangeCount = count / grainSize + (count % grainSize != 0 ? 1 : 0);
+	if (rangeCount == 0) return;
+
+	// the helper jobs can start after the loop is done (they find no range left, so the body is not used)
+	struct Loop {
+		std::atomic<uint32_t> nextRange{ 0 };
+		std::atomic<uint32_t> doneRangeCount{ 0 };
+	};
+	auto loop = std::make_shared<Loop>();
+	const WorkerRange* loopBody = &body;
+	WorkerTask runRanges = [loop, loopBody, count, grainSize, rangeCount]() {
+		for (uint32_t range = loop->nextRange++; range < rangeCount; range = loop->nextRange++) {
+			uint32_t first = range * grainSize;
+			(*loopBody)(first, first + std::min(grainSize, count - first));
+			loop->doneRangeCount++;
+		}
+	};
+
+	uint32_t helperCount = std::min(rangeCount - 1, getThreadCount());
+	for (uint32_t i = 0; i < helperCount; i++) {
+		submit(runRanges);
+	}
+	runRanges();
+
+	// the ranges taken by other threads are already running
+	while (loop->doneRangeCount.load() < rangeCount) {
+		std::this_thread::yield();
+	}
+}
+
+void WorkerPool::workerLoop(uint32_t index) {
+	currentPool = this;
+	currentQueueIndex = index;
+
+	while (true) {
+		Job job;
+		if (pop(index, job)) {
+			run(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingThreadCount++;
+		jobAvailable.wait(lock, [this]() { return stopping.load() || queuedJobCount.load() > 0; });
+		sleepingThreadCount--;
+
+		// the queued jobs are finished before stopping
+		if (stopping.load() && queuedJobCount.load() == 0) return;
+	}
+}
+
+void WorkerPool::cleanup() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	threads.clear();
+	queues.clear();
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+using WorkerTask = std::function<void()>;
+
+// Range [first, last) of the indices of a parallel loop
+using WorkerRange = std::function<void(uint32_t first, uint32_t last)>;
+
+
+// Jobs submitted with the counter and not finished yet. Jobs can be queued to start when it reaches zero, and it can be
+// waited on (it has to be waited on before it is destroyed if jobs were submitted with it)
+class JobCounter {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	uint32_t getCount() const { return count.load(); }
+	bool isDone() const { return count.load() == 0; }
+
+private:
+	friend class WorkerPool;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	std::atomic<uint32_t> count{ 0 };
+
+	// jobs queued when the count reaches zero (with the counter of each one)
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::vector<std::pair<WorkerTask, JobCounter*>> continuations;
+};
+
+
+// Fixed set of threads shared by the subsystems. Each thread has its own queue: the jobs submitted from a job go to the
+// queue of its thread (run newest first, while they are in the cache), the others are shared, and a thread without jobs
+// steals the oldest job of another queue. Jobs do not run in submission order and must not throw (errors have to be
+// stored and reported by the owner of the job)
+class WorkerPool {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	uint32_t getThreadCount() const { return static_cast<uint32_t>(threads.size()); }
+
+	// Jobs submitted and not finished yet (the ones waiting for a counter included)
+	uint32_t getPendingTaskCount() const { return pendingJobCount.load(); }
+
+	// Jobs taken from the queue of another thread since the creation
+	uint64_t getStealCount() const { return stealCount.load(); }
+
+	// Run from a thread of the pool
+	bool isWorkerThread() const;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	// Start the threads (at least one)
+	void create(uint32_t threadCount);
+
+	// Queue a job (the counter is incremented now and decremented when the job finishes)
+	void submit(WorkerTask task, JobCounter* counter = nullptr);
+
+	// Queue a job when the dependency reaches zero (now if it already did)
+	void submitAfter(JobCounter& dependency, WorkerTask task, JobCounter* counter = nullptr);
+
+	// Wait until the counter reaches zero. A worker thread runs other jobs meanwhile, so a job can wait for the jobs it
+	// submitted without blocking its thread
+	void wait(JobCounter& counter);
+
+	// Block until every submitted job finished (not from a job)
+	void wait();
+
+	// Call the body with ranges of up to grain size indices of [0, count) from the worker threads and the calling one,
+	// and return when every range is done
+	void parallelFor(uint32_t count, uint32_t grainSize, const WorkerRange& body);
+
+	// Finish the queued jobs and join the threads
+	void cleanup();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	struct Job {
+		WorkerTask task;
+		JobCounter* counter = nullptr;
+	};
+
+	// Jobs of a thread (taken from the back by it and from the front by the others)
+	struct JobQueue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	// a queue per thread and the shared one last
+	std::vector<std::unique_ptr<JobQueue>> queues;
+	std::vector<std::thread> threads;
+
+	std::atomic<uint32_t> pendingJobCount{ 0 };
+	std::atomic<uint32_t> queuedJobCount{ 0 };
+	std::atomic<uint32_t> sleepingThreadCount{ 0 };
+	std::atomic<uint64_t> stealCount{ 0 };
+	std::atomic<bool> stopping{ false };
+
+	// sleeping threads and waits for every job
+	std::mutex sleepMutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobsFinished;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	void workerLoop(uint32_t index);
+
+	// Add the job to the queue of the calling thread (the shared one if it is not a worker thread)
+	void push(Job job);
+
+	// Take the newest job of the queue, or else the oldest of the shared queue or another thread
+	bool pop(uint32_t queueIndex, Job& job);
+
+	// Run the job and release its counter (queuing the jobs that were waiting for it)
+	void run(Job& job);
+
+	// Index of the queue of the calling thread (the shared queue if it is not a worker thread)
+	uint32_t getQueueIndex() const;
+};
@@ -1,26 +1,159 @@
-#include "eventManagement.hpp"
+#include "system/eventManagement.hpp"
 
-#include <map>
-#include <vector>
+#include <SDL3/SDL_timer.h>
 
+#include <algorithm>
+#include <atomic>
 
-std::map<EventType, std::vector<EventSubscriber>> subscribers;
+
+namespace {
+
+	EventDispatcher dispatcher;
+	EventQueue queue;
+	bool queueStarted = false;
+
+	// statistics since the last reset (the overflow is counted by the threads that generate the events)
+	uint32_t dispatchedCount = 0;
+	std::atomic<uint32_t> overflowCount{ 0 };
+	Uint64 dispatchTimeSum = 0;
+	double latencySum = 0.0;
+	float maxLatency = 0.0f;
+
+	// SDL event filter (called from the thread that generates the event), which keeps the event in the SDL queue only
+	// if the queue is full
+	bool queueEvent(void* userData, SDL_Event* event) {
+		if (queue.push(*event, SDL_GetTicksNS())) return false;
+		overflowCount++;
+		return true;
+	}
+
+	void dispatchEvent(const SDL_Event& event, Uint64 dispatchTime) {
+		float latency = dispatchTime > event.common.timestamp ? (dispatchTime - event.common.timestamp) / 1e6f : 0.0f;
+		latencySum += latency;
+		maxLatency = std::max(maxLatency, latency);
+		dispatcher.dispatch(event);
+	}
+}
+
+
+uint32_t EventDispatcher::getSubscriberCount(EventType type) const {
+	uint32_t pageIndex = type / PAGE_SIZE;
+	if (pageIndex >= pages.size() || !pages[pageIndex]) return 0;
+	return static_cast<uint32_t>((*pages[pageIndex])[type % PAGE_SIZE].size());
+}
+
+void EventDispatcher::addSubscriber(EventType type, EventSubscriber subscriber) {
+	// the subscribers being called are not moved
+	if (dispatchDepth > 0) {
+		pendingSubscribers.emplace_back(type, std::move(subscriber));
+		return;
+	}
+
+	uint32_t pageIndex = type / PAGE_SIZE;
+	if (pageIndex >= pages.size()) pages.resize(pageIndex + 1);
+	if (!pages[pageIndex]) pages[pageIndex] = std::make_unique<SubscriberPage>();
+	(*pages[pageIndex])[type % PAGE_SIZE].push_back(std::move(subscriber));
+}
+
+void EventDispatcher::dispatch(const SDL_Event& event) {
+	uint32_t pageIndex = event.type / PAGE_SIZE;
+	if (pageIndex >= pages.size() || !pages[pageIndex]) return;
+
+	dispatchDepth++;
+	for (const auto& subscriber : (*pages[pageIndex])[event.type % PAGE_SIZE]) {
+		subscriber(event);
+	}
+	dispatchDepth--;
+
+	if (dispatchDepth == 0 && !pendingSubscribers.empty()) {
+		std::vector<std::pair<EventType, EventSubscriber>> added;
+		added.swap(pendingSubscribers);
+		for (auto& subscriber : added) {
+			addSubscriber(subscriber.first, std::move(subscriber.second));
+		}
+	}
+}
 
 void addEventSubscriber(EventType type, EventSubscriber subscriber) {
-	subscribers[type].push_back(subscriber);
+	dispatcher.addSubscriber(type, std::move(subscriber));
 }
 
-static void updateSubscribers(SDL_Event event) {
-	std::vector<EventSubscriber> callbacks = subscribers[event.type];
-	for (auto& update : callbacks)
-		update(event);
+void startEventQueue(uint32_t capacity) {
+	queue.create(capacity);
 
+	// the events already in the SDL queue go first
+	SDL_Event event;
+	while (SDL_PeepEvents(&event, 1, SDL_GETEVENT, SDL_EVENT_FIRST, SDL_EVENT_LAST) > 0) {
+		queue.push(event, SDL_GetTicksNS());
+	}
+	SDL_SetEventFilter(queueEvent, nullptr);
+	queueStarted = true;
 }
 
-void pollEvents() {
+void stopEventQueue() {
+	if (!queueStarted) return;
+
+	// the filter is not running once it is removed
+	SDL_SetEventFilter(nullptr, nullptr);
+	queueStarted = false;
+	queue.cleanup();
+}
+
+void pumpEvents() {
+	SDL_PumpEvents();
+}
 
+uint32_t dispatchEvents() {
+	Uint64 start = SDL_GetTicksNS();
+	uint32_t count = 0;
 	SDL_Event event;
-	while (SDL_PollEvent(&event)) {
-		updateSubscribers(event);
+	if (queueStarted) {
+		uint32_t queuedCount = queue.getSize();
+		QueuedEvent queuedEvent;
+		while (count < queuedCount && queue.pop(queuedEvent)) {
+			dispatchEvent(queuedEvent.event, start);
+			count++;
+		}
+
+		// the events that did not fit (without pumping, the new events go to the queue)
+		while (SDL_PeepEvents(&event, 1, SDL_GETEVENT, SDL_EVENT_FIRST, SDL_EVENT_LAST) > 0) {
+			dispatchEvent(event, start);
+			count++;
+		}
+	}
+	else {
+		while (SDL_PollEvent(&event)) {
+			dispatchEvent(event, start);
+			count++;
+		}
 	}
+
+	dispatchedCount += count;
+	dispatchTimeSum += SDL_GetTicksNS() - start;
+	return count;
+}
+
+void pollEvents() {
+	pumpEvents();
+	dispatchEvents();
+}
+
+EventStats getEventStats() {
+	EventStats stats;
+	stats.dispatchedCount = dispatchedCount;
+	stats.overflowCount = overflowCount.load();
+	if (dispatchedCount > 0) {
+		stats.averageDispatchTime = static_cast<float>(dispatchTimeSum) / dispatchedCount;
+		stats.averageLatency = static_cast<float>(latencySum / dispatchedCount);
+	}
+	stats.maxLatency = maxLatency;
+	return stats;
+}
+
+void resetEventStats() {
+	dispatchedCount = 0;
+	overflowCount = 0;
+	dispatchTimeSum = 0;
+	latencySum = 0.0;
+	maxLatency = 0.0f;
 }
@@ -2,12 +2,79 @@
 
 #include <SDL3/SDL_events.h>
 
+#include <array>
 #include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
 
+#include "system/EventQueue.hpp"
 
-using EventSubscriber = std::function<void(SDL_Event)>;
+
+using EventSubscriber = std::function<void(const SDL_Event&)>;
 using EventType = Uint32;
 
+
+// Subscribers of each event type, in pages of 256 consecutive types created when one of their types is subscribed (the
+// SDL event types are 16 bit). An event finds its subscribers with two indexings and they are called in place
+class EventDispatcher {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	uint32_t getSubscriberCount(EventType type) const;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	void addSubscriber(EventType type, EventSubscriber subscriber);
+
+	// Call the subscribers of the event type (the subscribers added by them meanwhile are added when it returns)
+	void dispatch(const SDL_Event& event);
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	static const uint32_t PAGE_SIZE = 256;
+	using SubscriberPage = std::array<std::vector<EventSubscriber>, PAGE_SIZE>;
+	std::vector<std::unique_ptr<SubscriberPage>> pages;
+
+	uint32_t dispatchDepth = 0;
+	std::vector<std::pair<EventType, EventSubscriber>> pendingSubscribers;
+};
+
+
+// Events dispatched since the last reset (the latency goes from the event timestamp to its dispatch, and the events
+// that did not fit in the queue are dispatched from the SDL queue after the queued ones)
+struct EventStats {
+	uint32_t dispatchedCount = 0;
+	uint32_t overflowCount = 0;
+	float averageDispatchTime = 0.0f;	// nanoseconds per event (subscribers included)
+	float averageLatency = 0.0f;		// milliseconds
+	float maxLatency = 0.0f;
+};
+
+
+// Subscribe to the events of the type (from the main thread)
 void addEventSubscriber(EventType type, EventSubscriber subscriber);
 
+// Queue the SDL events from the thread that generates them, stamped with the time they arrive, instead of keeping them
+// in the SDL queue until they are polled (after the video subsystem is initialized)
+void startEventQueue(uint32_t capacity = DEFAULT_EVENT_QUEUE_CAPACITY);
+
+void stopEventQueue();
+
+// Read the pending OS events (from the main thread). They are only queued, so it can be called often
+void pumpEvents();
+
+// Dispatch the events queued until now to their subscribers (the ones queued by the subscribers wait for the next call)
+uint32_t dispatchEvents();
+
+// Pump and dispatch the events
 void pollEvents();
+
+EventStats getEventStats();
+void resetEventStats();
@@ -0,0 +1,44 @@
+#include "time/FrameProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+std::chrono::nanoseconds FrameProfiler::getAverageFrameTime() const {
+	if (frameCount == 0) return std::chrono::nanoseconds(0);
+	return accumulatedFrameTime / frameCount;
+}
+
+std::chrono::nanoseconds FrameProfiler::getFrameTimeDeviation() const {
+	if (frameCount == 0) return std::chrono::nanoseconds(0);
+	double average = std::chrono::duration<double, std::milli>(getAverageFrameTime()).count();
+	double variance = std::max(squaredFrameTimes / frameCount - average * average, 0.0);
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double, std::milli>(std::sqrt(variance)));
+}
+
+void FrameProfiler::addFrame(std::chrono::nanoseconds frameTime) {
+	double milliseconds = std::chrono::duration<double, std::milli>(frameTime).count();
+	frameCount++;
+	accumulatedFrameTime += frameTime;
+	squaredFrameTimes += milliseconds * milliseconds;
+	maxFrameTime = std::max(maxFrameTime, frameTime);
+	if (frameTime > hitchThreshold) hitchCount++;
+}
+
+void FrameProfiler::addCompileLatency(float latency) {
+	compileCount++;
+	compileLatency += latency;
+	maxCompileLatency = std::max(maxCompileLatency, latency);
+}
+
+void FrameProfiler::reset() {
+	frameCount = 0;
+	accumulatedFrameTime = std::chrono::nanoseconds(0);
+	squaredFrameTimes = 0.0;
+	maxFrameTime = std::chrono::nanoseconds(0);
+	hitchCount = 0;
+
+	compileCount = 0;
+	compileLatency = 0.0f;
+	maxCompileLatency = 0.0f;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+
+// CPU times of the frames of a stats interval (average, deviation, worst and hitches: frames slower than the hitch
+// threshold) and the latency of the background pipeline compilations that finished in the interval (from the request
+// until the pipeline is ready)
+class FrameProfiler {
+public:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// GETTERS AND SETTERS
+
+	void setHitchThreshold(std::chrono::nanoseconds hitchThreshold) { this->hitchThreshold = hitchThreshold; }
+
+	uint32_t getFrameCount() const { return frameCount; }
+	std::chrono::nanoseconds getAverageFrameTime() const;
+	// Standard deviation of the frame times (how stable they are)
+	std::chrono::nanoseconds getFrameTimeDeviation() const;
+	std::chrono::nanoseconds getMaxFrameTime() const { return maxFrameTime; }
+	uint32_t getHitchCount() const { return hitchCount; }
+
+	// Times in milliseconds
+	uint32_t getCompileCount() const { return compileCount; }
+	float getAverageCompileLatency() const { return compileCount > 0 ? compileLatency / compileCount : 0.0f; }
+	float getMaxCompileLatency() const { return maxCompileLatency; }
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// METHODS
+
+	void addFrame(std::chrono::nanoseconds frameTime);
+	void addCompileLatency(float latency);
+
+	// Start a new stats interval
+	void reset();
+
+private:
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CLASS MEMBERS
+
+	std::chrono::nanoseconds hitchThreshold = std::chrono::milliseconds(33);
+
+	uint32_t frameCount = 0;
+	std::chrono::nanoseconds accumulatedFrameTime = std::chrono::nanoseconds(0);
+	double squaredFrameTimes = 0.0;		// in ms^2
+	std::chrono::nanoseconds maxFrameTime = std::chrono::nanoseconds(0);
+	uint32_t hitchCount = 0;
+
+	uint32_t compileCount = 0;
+	float compileLatency = 0.0f;
+	float maxCompileLatency = 0.0f;
+};
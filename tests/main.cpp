@@ -2,11 +2,20 @@
 
 
 const std::string FIRST_PASS_VERT_SHADER_PATH = "../../VulkanProject/assets/shaders/vert.spv";
+const std::string FIRST_PASS_DRAW_CONSTANTS_VERT_SHADER_PATH = "../../VulkanProject/assets/shaders/drawConstantsVert.spv";
 const std::string FIRST_PASS_FRAG_SHADER_PATH = "../../VulkanProject/assets/shaders/frag.spv";
+const std::string FIRST_PASS_BINDLESS_FRAG_SHADER_PATH = "../../VulkanProject/assets/shaders/bindlessFrag.spv";
 
 const std::string SECOND_PASS_VERT_SHADER_PATH = "../../VulkanProject/assets/shaders/secondPassVert.spv";
 const std::string SECOND_PASS_FRAG_SHADER_PATH = "../../VulkanProject/assets/shaders/secondPassFrag.spv";
 
+const std::string MESHLET_CULL_SHADER_PATH = "../../VulkanProject/assets/shaders/meshletCull.spv";
+
+const std::string SHADOW_VERT_SHADER_PATH = "../../VulkanProject/assets/shaders/shadowVert.spv";
+
+// GLSL sources compiled again when they change
+const std::string SHADER_SOURCE_DIRECTORY = "../../VulkanProject/assets/shaders/";
+
 const std::string MODEL_PATH = "../../VulkanProject/assets/models/viking_room/viking_room.obj";
 const std::string TEXTURE_PATH = "../../VulkanProject/assets/models/viking_room/viking_room.png";
 const std::string TEXTURE2_PATH = "../../VulkanProject/assets/models/viking_room/normal_texture_test.png";
@@ -16,10 +25,30 @@ int main() {
 	VulkanApplication& app = VulkanApplication::getInstance();
 	VulkanAppParams params = {};
 	params.firstRenderPassVertShaderPath = FIRST_PASS_VERT_SHADER_PATH;
+	params.firstRenderPassDrawConstantsVertShaderPath = FIRST_PASS_DRAW_CONSTANTS_VERT_SHADER_PATH;
+	params.drawPushConstants = true;
 	params.firstRenderPassFragShaderPath = FIRST_PASS_FRAG_SHADER_PATH;
+	params.firstRenderPassBindlessFragShaderPath = FIRST_PASS_BINDLESS_FRAG_SHADER_PATH;
+	params.bindlessTextures = true;
+	params.bakeTextures = true;
+	params.textureStreaming = true;
+	params.asyncModelCount = 24;
 	params.secondRenderPassVertShaderPath = SECOND_PASS_VERT_SHADER_PATH;
 	params.secondRenderPassFragShaderPath = SECOND_PASS_FRAG_SHADER_PATH;
+	params.meshletCullShaderPath = MESHLET_CULL_SHADER_PATH;
+	params.shadowVertShaderPath = SHADOW_VERT_SHADER_PATH;
+	params.shaderHotReload = true;
+	params.shaderSources = {
+		{ SHADER_SOURCE_DIRECTORY + "shader.vert", FIRST_PASS_VERT_SHADER_PATH },
+		{ SHADER_SOURCE_DIRECTORY + "shader.vert", FIRST_PASS_DRAW_CONSTANTS_VERT_SHADER_PATH, { "DRAW_CONSTANTS" } },
+		{ SHADER_SOURCE_DIRECTORY + "shader.frag", FIRST_PASS_FRAG_SHADER_PATH },
+		{ SHADER_SOURCE_DIRECTORY + "shader.frag", FIRST_PASS_BINDLESS_FRAG_SHADER_PATH, { "BINDLESS" } },
+		{ SHADER_SOURCE_DIRECTORY + "secondPass.vert", SECOND_PASS_VERT_SHADER_PATH },
+		{ SHADER_SOURCE_DIRECTORY + "secondPass.frag", SECOND_PASS_FRAG_SHADER_PATH },
+		{ SHADER_SOURCE_DIRECTORY + "shadow.vert", SHADOW_VERT_SHADER_PATH }
+	};
 	params.modelPath = MODEL_PATH;
+	params.pointLightCount = 1024;
 	std::vector<TexturePaths> textures(1);
 	textures[0].albedoPath = TEXTURE_PATH;
 	textures[0].normalPath = TEXTURE2_PATH;
@@ -0,0 +1,99 @@
+#include "system/EventQueue.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "unitTests.hpp"
+
+
+namespace {
+
+	// Key event of a producer (the queued time is the number of the event)
+	SDL_Event createEvent(uint32_t producer) {
+		SDL_Event event{};
+		event.type = SDL_EVENT_KEY_DOWN;
+		event.key.which = producer;
+		return event;
+	}
+}
+
+
+void testEventQueue() {
+
+	//--------------------------------------------------------
+	// CAPACITY (rounded up to a power of two)
+	EventQueue queue;
+	queue.create(5);
+	CHECK(queue.getCapacity() == 8);
+	CHECK(queue.getSize() == 0);
+
+	QueuedEvent queuedEvent;
+	CHECK(!queue.pop(queuedEvent));
+
+	//--------------------------------------------------------
+	// OVERFLOW (a full queue rejects the event and keeps the others)
+	for (uint64_t i = 0; i < 8; i++) {
+		CHECK(queue.push(createEvent(0), i));
+	}
+	CHECK(queue.getSize() == 8);
+	CHECK(!queue.push(createEvent(0), 8));
+	CHECK(queue.getSize() == 8);
+
+	// a read event makes room for one more
+	CHECK(queue.pop(queuedEvent) && queuedEvent.queuedTime == 0);
+	CHECK(queue.push(createEvent(0), 8));
+	CHECK(!queue.push(createEvent(0), 9));
+
+	// in the order they were pushed
+	bool ordered = true;
+	for (uint64_t i = 1; i <= 8; i++) {
+		ordered = queue.pop(queuedEvent) && queuedEvent.queuedTime == i && ordered;
+	}
+	CHECK(ordered);
+	CHECK(!queue.pop(queuedEvent));
+	CHECK(queue.getSize() == 0);
+	queue.cleanup();
+
+	//--------------------------------------------------------
+	// SEVERAL PRODUCERS (each event is read once, in the order of its producer)
+	const uint32_t PRODUCER_COUNT = 4;
+	const uint32_t EVENTS_PER_PRODUCER = 50000;
+	queue.create(256);
+
+	std::vector<std::thread> producers;
+	for (uint32_t p = 0; p < PRODUCER_COUNT; p++) {
+		producers.emplace_back([&queue, p]() {
+			for (uint32_t i = 0; i < EVENTS_PER_PRODUCER; i++) {
+				// a full queue is retried
+				while (!queue.push(createEvent(p), i)) {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	std::vector<uint32_t> nextEvents(PRODUCER_COUNT, 0);
+	uint32_t wrongEvents = 0;
+	for (uint32_t received = 0; received < PRODUCER_COUNT * EVENTS_PER_PRODUCER;) {
+		if (!queue.pop(queuedEvent)) continue;
+		uint32_t producer = queuedEvent.event.key.which;
+		if (queuedEvent.event.type != SDL_EVENT_KEY_DOWN || producer >= PRODUCER_COUNT ||
+			queuedEvent.queuedTime != nextEvents[producer]) {
+			wrongEvents++;
+		}
+		else {
+			nextEvents[producer]++;
+		}
+		received++;
+	}
+	for (auto& producer : producers) {
+		producer.join();
+	}
+
+	CHECK(wrongEvents == 0);
+	for (uint32_t nextEvent : nextEvents) {
+		CHECK(nextEvent == EVENTS_PER_PRODUCER);
+	}
+	CHECK(!queue.pop(queuedEvent));
+	queue.cleanup();
+}
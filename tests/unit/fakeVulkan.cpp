@@ -0,0 +1,119 @@
+// Vulkan functions used by the tested classes, without a device. Each created object gets a new handle, so the tests
+// can tell whether a cache created an object or returned one it had
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "context/Device.hpp"
+#include "render/uniform/ShadowAtlasManager.hpp"
+#include "unitTests.hpp"
+
+
+namespace {
+
+	uint64_t lastHandle = 0;
+	uint32_t objectCount = 0;
+
+	// host memory behind each fake allocation (mapped by vkMapMemory)
+	std::unordered_map<VkDeviceMemory, std::vector<uint8_t>> memoryData;
+
+	template<typename Handle>
+	Handle createFakeHandle() {
+		objectCount++;
+		return (Handle)(uintptr_t)++lastHandle;
+	}
+}
+
+
+uint32_t getFakeObjectCount() {
+	return objectCount;
+}
+
+
+//--------------------------------------------------------
+// DEVICE (instead of Device.cpp, which needs the whole application)
+
+VkPhysicalDeviceProperties Device::getPhysicalDeviceProperties() {
+	VkPhysicalDeviceProperties properties{};
+	properties.limits.maxSamplerAllocationCount = 4000;
+	properties.limits.maxSamplerAnisotropy = 16.0f;
+	return properties;
+}
+
+void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags, VkMemoryPropertyFlags, VkBuffer& buffer,
+	VkDeviceMemory& bufferMemory) {
+	buffer = createFakeHandle<VkBuffer>();
+	bufferMemory = createFakeHandle<VkDeviceMemory>();
+	memoryData[bufferMemory].resize(size);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkDeviceWaitIdle(VkDevice) {
+	return VK_SUCCESS;
+}
+
+
+//--------------------------------------------------------
+// BUFFERS
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyBuffer(VkDevice, VkBuffer, const VkAllocationCallbacks*) {
+	objectCount--;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize,
+	VkMemoryMapFlags, void** data) {
+	*data = memoryData[memory].data() + offset;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*) {
+	memoryData.erase(memory);
+	objectCount--;
+}
+
+
+//--------------------------------------------------------
+// SHADOW ATLAS (instead of ShadowAtlasManager.cpp, the tests give no atlas to the light buffers)
+
+int32_t ShadowAtlasManager::getFirstTile(const Light*) const {
+	return -1;
+}
+
+
+//--------------------------------------------------------
+// LAYOUTS
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorSetLayout(VkDevice, const VkDescriptorSetLayoutCreateInfo*,
+	const VkAllocationCallbacks*, VkDescriptorSetLayout* setLayout) {
+	*setLayout = createFakeHandle<VkDescriptorSetLayout>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorSetLayout(VkDevice, VkDescriptorSetLayout, const VkAllocationCallbacks*) {
+	objectCount--;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreatePipelineLayout(VkDevice, const VkPipelineLayoutCreateInfo*,
+	const VkAllocationCallbacks*, VkPipelineLayout* pipelineLayout) {
+	*pipelineLayout = createFakeHandle<VkPipelineLayout>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineLayout(VkDevice, VkPipelineLayout, const VkAllocationCallbacks*) {
+	objectCount--;
+}
+
+
+//--------------------------------------------------------
+// SAMPLERS
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSampler(VkDevice, const VkSamplerCreateInfo*, const VkAllocationCallbacks*,
+	VkSampler* sampler) {
+	*sampler = createFakeHandle<VkSampler>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySampler(VkDevice, VkSampler, const VkAllocationCallbacks*) {
+	objectCount--;
+}
@@ -0,0 +1,91 @@
+#include "render/pipeline/LayoutCache.hpp"
+
+#include "unitTests.hpp"
+
+
+namespace {
+
+	VkDescriptorSetLayoutBinding createBinding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stages,
+		uint32_t count = 1) {
+		VkDescriptorSetLayoutBinding layoutBinding{};
+		layoutBinding.binding = binding;
+		layoutBinding.descriptorType = type;
+		layoutBinding.descriptorCount = count;
+		layoutBinding.stageFlags = stages;
+		return layoutBinding;
+	}
+
+	// Uniform buffer of the vertex shader and texture of the fragment shader
+	DescriptorSetLayoutKey createKey() {
+		DescriptorSetLayoutKey key;
+		key.bindings.push_back(createBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT));
+		key.bindings.push_back(createBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT));
+		return key;
+	}
+
+	bool sameHash(const DescriptorSetLayoutKey& a, const DescriptorSetLayoutKey& b) {
+		return std::hash<DescriptorSetLayoutKey>()(a) == std::hash<DescriptorSetLayoutKey>()(b);
+	}
+}
+
+
+void testLayoutCache() {
+
+	//--------------------------------------------------------
+	// KEYS OF EQUAL BINDINGS
+	DescriptorSetLayoutKey key = createKey();
+	CHECK(key == createKey());
+	CHECK(sameHash(key, createKey()));
+
+	//--------------------------------------------------------
+	// KEYS OF DIFFERENT BINDINGS
+	DescriptorSetLayoutKey otherStages = createKey();
+	otherStages.bindings[1].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+	CHECK(!(key == otherStages));
+	CHECK(!sameHash(key, otherStages));
+
+	DescriptorSetLayoutKey otherCount = createKey();
+	otherCount.bindings[1].descriptorCount = 8;
+	CHECK(!(key == otherCount));
+	CHECK(!sameHash(key, otherCount));
+
+	DescriptorSetLayoutKey withFlags = createKey();
+	withFlags.bindingFlags = { 0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT };
+	DescriptorSetLayoutKey otherFlags = createKey();
+	otherFlags.bindingFlags = { 0, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT };
+	CHECK(!(key == withFlags));
+	CHECK(!(withFlags == otherFlags));
+	CHECK(!sameHash(withFlags, otherFlags));
+
+	//--------------------------------------------------------
+	// LAYOUTS OF THE CACHE (the bindings in another order are the same layout, with their flags)
+	Device device;
+	LayoutCache layoutCache;
+	layoutCache.create(device);
+	uint32_t objectCount = getFakeObjectCount();
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings = createKey().bindings;
+	std::vector<VkDescriptorSetLayoutBinding> reversedBindings = { bindings[1], bindings[0] };
+	VkDescriptorSetLayout layout = layoutCache.getDescriptorSetLayout(bindings);
+	CHECK(layoutCache.getDescriptorSetLayout(reversedBindings) == layout);
+	CHECK(layoutCache.getDescriptorSetLayoutCount() == 1);
+	CHECK(layoutCache.getCacheHitCount() == 1);
+
+	VkDescriptorSetLayout flagsLayout = layoutCache.getDescriptorSetLayout(bindings,
+		{ 0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT });
+	CHECK(flagsLayout != layout);
+	CHECK(layoutCache.getDescriptorSetLayout(reversedBindings, { VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT, 0 }) ==
+		flagsLayout);
+	CHECK(layoutCache.getDescriptorSetLayout(reversedBindings, { 0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT }) !=
+		flagsLayout);
+	CHECK(layoutCache.getDescriptorSetLayoutCount() == 3);
+
+	// pipeline layouts of the same set layouts
+	VkPipelineLayout pipelineLayout = layoutCache.getPipelineLayout({ layout }, {});
+	CHECK(layoutCache.getPipelineLayout({ layout }, {}) == pipelineLayout);
+	CHECK(layoutCache.getPipelineLayout({ flagsLayout }, {}) != pipelineLayout);
+	CHECK(getFakeObjectCount() == objectCount + 5);
+
+	layoutCache.cleanup();
+	CHECK(getFakeObjectCount() == objectCount);
+}
@@ -0,0 +1,115 @@
+#include "render/uniform/LightBufferManager.hpp"
+
+#include <memory>
+
+#include "scene/Model.hpp"
+#include "unitTests.hpp"
+
+
+namespace {
+
+	// Point light of radius 1 in a new child of the scene
+	Light* addLight(Entity& scene, glm::vec3 position) {
+		scene.children.push_back(std::make_unique<Entity>());
+		Entity* entity = scene.children.back().get();
+		entity->transform.position = position;
+		Light* light = entity->addModule<Light>();
+		light->setRadius(1.0f);
+		return light;
+	}
+}
+
+
+void testLightBufferManager() {
+	Device device;
+	Entity scene;
+	const VkExtent2D extent = { 1280, 720 };
+
+	// the camera is at the origin and looks to +Y
+	Camera* camera = scene.addModule<Camera>();
+	camera->init(extent);
+
+	Light* a = addLight(scene, glm::vec3(-1.0f, 4.0f, 0.0f));
+	Light* b = addLight(scene, glm::vec3(0.0f, 5.0f, 0.0f));
+	Light* c = addLight(scene, glm::vec3(1.0f, 6.0f, 0.5f));
+	Light* behind = addLight(scene, glm::vec3(0.0f, -5.0f, 0.0f));
+	Light* sun = addLight(scene, glm::vec3(0.0f));
+	sun->setType(LIGHT_TYPE_DIRECTIONAL);
+
+	uint32_t objectCount = getFakeObjectCount();
+	LightBufferManager lightBuffers;
+	lightBuffers.createBuffers(device, 2);
+
+	//--------------------------------------------------------
+	// SLOTS (in order of arrival, directional lights are ignored)
+	lightBuffers.updateBuffers(0, { a, b, c, sun }, *camera, extent);
+	CHECK(lightBuffers.getLightCount() == 3);
+	CHECK(lightBuffers.getLightSlot(a) == 0);
+	CHECK(lightBuffers.getLightSlot(b) == 1);
+	CHECK(lightBuffers.getLightSlot(c) == 2);
+	CHECK(lightBuffers.getLightSlot(sun) == UINT32_MAX);
+	CHECK(lightBuffers.getUploadedLightCount() == 3);
+	CHECK(!lightBuffers.wereBuffersRecreated());
+
+	// each set of buffers has its own copy of the lights
+	lightBuffers.updateBuffers(1, { a, b, c, sun }, *camera, extent);
+	CHECK(lightBuffers.getUploadedLightCount() == 3);
+
+	// only the changed lights are written, the slots do not depend on the order of the lights
+	lightBuffers.updateBuffers(0, { c, sun, b, a }, *camera, extent);
+	CHECK(lightBuffers.getUploadedLightCount() == 0);
+	CHECK(lightBuffers.getLightSlot(a) == 0 && lightBuffers.getLightSlot(b) == 1 && lightBuffers.getLightSlot(c) == 2);
+
+	b->setColor(glm::vec3(1.0f));
+	lightBuffers.updateBuffers(0, { a, b, c }, *camera, extent);
+	CHECK(lightBuffers.getUploadedLightCount() == 1);
+	lightBuffers.updateBuffers(0, { a, b, c }, *camera, extent);
+	CHECK(lightBuffers.getUploadedLightCount() == 0);
+
+	//--------------------------------------------------------
+	// REMOVAL (the last light fills the hole)
+	lightBuffers.updateBuffers(0, { b, c }, *camera, extent);
+	CHECK(lightBuffers.getLightCount() == 2);
+	CHECK(lightBuffers.getLightSlot(a) == UINT32_MAX);
+	CHECK(lightBuffers.getLightSlot(c) == 0);
+	CHECK(lightBuffers.getLightSlot(b) == 1);
+	CHECK(lightBuffers.getUploadedLightCount() == 1);
+
+	// a light added again gets the next free slot
+	lightBuffers.updateBuffers(0, { a, b, c }, *camera, extent);
+	CHECK(lightBuffers.getLightSlot(a) == 2);
+	CHECK(lightBuffers.getUploadedLightCount() == 1);
+
+	//--------------------------------------------------------
+	// CLUSTER ASSIGNMENT (light indices of each light, none for the lights outside the frustum)
+	lightBuffers.updateBuffers(0, { a }, *camera, extent);
+	uint32_t indicesA = lightBuffers.getAssignedLightIndexCount();
+	lightBuffers.updateBuffers(0, { b }, *camera, extent);
+	uint32_t indicesB = lightBuffers.getAssignedLightIndexCount();
+	CHECK(indicesA > 0 && indicesB > 0);
+
+	lightBuffers.updateBuffers(0, { a, b, behind }, *camera, extent);
+	CHECK(lightBuffers.getLightCount() == 3);
+	CHECK(lightBuffers.getAssignedLightIndexCount() == indicesA + indicesB);
+
+	//--------------------------------------------------------
+	// GROWTH (the new buffers are written completely)
+	std::vector<Light*> lights;
+	for (uint32_t i = 0; i < INITIAL_LIGHT_CAPACITY + 1; i++) {
+		lights.push_back(addLight(scene, glm::vec3(0.0f, 2.0f + i * 0.05f, 0.0f)));
+	}
+	lightBuffers.updateBuffers(0, lights, *camera, extent);
+	CHECK(lightBuffers.wereBuffersRecreated());
+	CHECK(lightBuffers.getLightCapacity() >= lights.size());
+	CHECK(lightBuffers.getLightCount() == lights.size());
+	CHECK(lightBuffers.getUploadedLightCount() == lights.size());
+
+	lightBuffers.updateBuffers(0, lights, *camera, extent);
+	CHECK(!lightBuffers.wereBuffersRecreated());
+	CHECK(lightBuffers.getUploadedLightCount() == 0);
+	lightBuffers.updateBuffers(1, lights, *camera, extent);
+	CHECK(lightBuffers.getUploadedLightCount() == lights.size());
+
+	lightBuffers.cleanup();
+	CHECK(getFakeObjectCount() == objectCount);
+}
@@ -0,0 +1,159 @@
+#include "asset/meshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "asset/meshSimplifier.hpp"
+#include "asset/meshletBuilder.hpp"
+#include "unitTests.hpp"
+
+
+namespace {
+
+	// More vertices than a 16 bit index can address
+	const uint32_t GRID_QUADS_PER_SIDE = 260;
+	// Grid of the simplifier (its cost grows faster than the triangles)
+	const uint32_t SIMPLIFIED_GRID_QUADS_PER_SIDE = 64;
+
+	// Wavy grid of quadsPerSide x quadsPerSide quads (its triangles row by row)
+	void createGrid(uint32_t quadsPerSide, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+		uint32_t side = quadsPerSide + 1;
+		for (uint32_t y = 0; y < side; y++) {
+			for (uint32_t x = 0; x < side; x++) {
+				Vertex vertex{};
+				vertex.texCoord = glm::vec2(x, y) / static_cast<float>(quadsPerSide);
+				vertex.pos = glm::vec3(vertex.texCoord * 10.0f, std::sin(vertex.texCoord.x * 20.0f) * 0.5f);
+				vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+				vertices.push_back(vertex);
+			}
+		}
+		for (uint32_t y = 0; y < quadsPerSide; y++) {
+			for (uint32_t x = 0; x < quadsPerSide; x++) {
+				uint32_t corner = y * side + x;
+				indices.insert(indices.end(), { corner, corner + 1, corner + side + 1 });
+				indices.insert(indices.end(), { corner, corner + side + 1, corner + side });
+			}
+		}
+	}
+
+	// Triangles of the index list rotated to start with their smallest index and sorted (the same triangles in any order
+	// give the same list)
+	std::vector<std::array<uint32_t, 3>> sortTriangles(const std::vector<uint32_t>& indices) {
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			std::array<uint32_t, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// True if the subsets cover the range one after another, their indices relative to their vertex offset are below
+	// windowSize and they give back the original indices
+	bool checkSubsets(const std::vector<uint32_t>& indices, uint32_t firstIndex, uint32_t indexCount, uint32_t windowSize,
+		const std::vector<MeshSubset>& subsets) {
+		uint32_t nextIndex = firstIndex;
+		for (const MeshSubset& subset : subsets) {
+			if (subset.firstIndex != nextIndex || subset.indexCount == 0 || subset.indexCount % 3 != 0) return false;
+			for (uint32_t i = subset.firstIndex; i < subset.firstIndex + subset.indexCount; i++) {
+				int64_t relative = static_cast<int64_t>(indices[i]) - subset.vertexOffset;
+				if (relative < 0 || relative >= windowSize) return false;
+				if (static_cast<uint32_t>(relative) + subset.vertexOffset != indices[i]) return false;
+			}
+			nextIndex += subset.indexCount;
+		}
+		return nextIndex == firstIndex + indexCount;
+	}
+}
+
+
+void testMeshOptimizer() {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	createGrid(GRID_QUADS_PER_SIDE, vertices, indices);
+	CHECK(vertices.size() > SHORT_INDEX_VERTEX_LIMIT);
+
+	// the order of the loader
+	indices = optimizeVertexCache(indices, vertices.size());
+	optimizeVertexFetch(vertices, indices);
+	uint32_t indexCount = static_cast<uint32_t>(indices.size());
+	CHECK(indexCount == GRID_QUADS_PER_SIDE * GRID_QUADS_PER_SIDE * 6);
+	CHECK(computeAcmr(indices, vertices.size()) < 1.0f);
+
+	//--------------------------------------------------------
+	// 16 BIT SPLIT (subsets with their indices relative to a window of vertices)
+	std::vector<MeshSubset> subsets;
+	CHECK(splitByVertexWindow(indices, 0, indexCount, SHORT_INDEX_VERTEX_LIMIT, subsets));
+	CHECK(subsets.size() > 1);
+	CHECK(checkSubsets(indices, 0, indexCount, SHORT_INDEX_VERTEX_LIMIT, subsets));
+
+	// a range of the index list with small windows (the subsets are appended)
+	std::vector<MeshSubset> rangeSubsets = { MeshSubset{} };
+	uint32_t rangeFirst = indexCount / 2 / 3 * 3;
+	CHECK(splitByVertexWindow(indices, rangeFirst, indexCount - rangeFirst, 4096, rangeSubsets));
+	CHECK(rangeSubsets.size() > 2);
+	rangeSubsets.erase(rangeSubsets.begin());
+	CHECK(checkSubsets(indices, rangeFirst, indexCount - rangeFirst, 4096, rangeSubsets));
+
+	// a triangle wider than the window does not fit
+	std::vector<MeshSubset> failedSubsets;
+	CHECK(!splitByVertexWindow({ 0, 1, 2, 0, 1, SHORT_INDEX_VERTEX_LIMIT }, 0, 6, SHORT_INDEX_VERTEX_LIMIT,
+		failedSubsets));
+	CHECK(splitByVertexWindow(indices, 0, 0, SHORT_INDEX_VERTEX_LIMIT, failedSubsets));
+	CHECK(failedSubsets.empty());
+
+	//--------------------------------------------------------
+	// SIMPLIFIER (the target is reached with valid triangles of the same vertices)
+	std::vector<Vertex> gridVertices;
+	std::vector<uint32_t> gridIndices;
+	createGrid(SIMPLIFIED_GRID_QUADS_PER_SIDE, gridVertices, gridIndices);
+	size_t targetIndexCount = gridIndices.size() / 4 / 3 * 3;
+	float error = -1.0f;
+	std::vector<uint32_t> lodIndices = simplifyMesh(gridVertices, gridIndices, targetIndexCount,
+		std::numeric_limits<float>::max(), error);
+	CHECK(!lodIndices.empty() && lodIndices.size() <= targetIndexCount && lodIndices.size() % 3 == 0);
+	CHECK(error >= 0.0f && error < 0.5f);
+
+	bool validTriangles = true;
+	for (size_t i = 0; i < lodIndices.size(); i += 3) {
+		uint32_t a = lodIndices[i], b = lodIndices[i + 1], c = lodIndices[i + 2];
+		validTriangles = validTriangles && a < gridVertices.size() && b < gridVertices.size() &&
+			c < gridVertices.size() && a != b && b != c && a != c;
+	}
+	CHECK(validTriangles);
+
+	// no error allowed: nothing is collapsed on the curved surface
+	std::vector<uint32_t> exactIndices = simplifyMesh(gridVertices, gridIndices, targetIndexCount, 0.0f, error);
+	CHECK(exactIndices.size() > targetIndexCount);
+
+	//--------------------------------------------------------
+	// MESHLETS (every triangle once, within the limits and inside the bounding sphere)
+	std::vector<uint32_t> meshletIndices;
+	std::vector<Meshlet> meshlets = buildMeshlets(vertices, indices, meshletIndices);
+	CHECK(sortTriangles(meshletIndices) == sortTriangles(indices));
+
+	uint32_t nextIndex = 0;
+	bool withinLimits = true;
+	bool insideBounds = true;
+	for (const Meshlet& meshlet : meshlets) {
+		withinLimits = withinLimits && meshlet.firstIndex == nextIndex && meshlet.triangleCount > 0 &&
+			meshlet.triangleCount <= MESHLET_MAX_TRIANGLES;
+
+		std::vector<uint32_t> meshletVertices(meshletIndices.begin() + meshlet.firstIndex,
+			meshletIndices.begin() + meshlet.firstIndex + meshlet.triangleCount * 3);
+		for (uint32_t vertex : meshletVertices) {
+			insideBounds = insideBounds &&
+				glm::length(vertices[vertex].pos - meshlet.center) <= meshlet.radius * 1.001f + 1e-5f;
+		}
+		std::sort(meshletVertices.begin(), meshletVertices.end());
+		size_t vertexCount = std::unique(meshletVertices.begin(), meshletVertices.end()) - meshletVertices.begin();
+		withinLimits = withinLimits && vertexCount <= MESHLET_MAX_VERTICES;
+		nextIndex += meshlet.triangleCount * 3;
+	}
+	CHECK(withinLimits);
+	CHECK(insideBounds);
+	CHECK(nextIndex == meshletIndices.size());
+}
@@ -0,0 +1,84 @@
+#include "render/image/SamplerCache.hpp"
+
+#include "unitTests.hpp"
+
+
+namespace {
+
+	// Trilinear sampler with anisotropic filtering
+	VkSamplerCreateInfo createSamplerInfo() {
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.anisotropyEnable = VK_TRUE;
+		samplerInfo.maxAnisotropy = 16.0f;
+		samplerInfo.maxLod = 10.0f;
+		return samplerInfo;
+	}
+
+	bool sameKey(const VkSamplerCreateInfo& a, const VkSamplerCreateInfo& b) {
+		SamplerKey keyA(a);
+		SamplerKey keyB(b);
+		return keyA == keyB && std::hash<SamplerKey>()(keyA) == std::hash<SamplerKey>()(keyB);
+	}
+}
+
+
+void testSamplerCache() {
+
+	//--------------------------------------------------------
+	// KEYS (the values ignored by Vulkan are not part of them)
+	VkSamplerCreateInfo samplerInfo = createSamplerInfo();
+	CHECK(sameKey(samplerInfo, createSamplerInfo()));
+
+	VkSamplerCreateInfo withoutAnisotropy = createSamplerInfo();
+	withoutAnisotropy.anisotropyEnable = VK_FALSE;
+	VkSamplerCreateInfo otherAnisotropy = withoutAnisotropy;
+	otherAnisotropy.maxAnisotropy = 4.0f;
+	CHECK(sameKey(withoutAnisotropy, otherAnisotropy));
+	otherAnisotropy.anisotropyEnable = VK_TRUE;
+	CHECK(!sameKey(samplerInfo, otherAnisotropy));
+
+	VkSamplerCreateInfo compareOp = createSamplerInfo();
+	compareOp.compareOp = VK_COMPARE_OP_LESS;
+	CHECK(sameKey(samplerInfo, compareOp));
+	compareOp.compareEnable = VK_TRUE;
+	CHECK(!sameKey(samplerInfo, compareOp));
+
+	VkSamplerCreateInfo otherMaxLod = createSamplerInfo();
+	otherMaxLod.maxLod = 4.0f;
+	CHECK(!sameKey(samplerInfo, otherMaxLod));
+
+	//--------------------------------------------------------
+	// REFERENCES (a sampler is destroyed with its last reference)
+	Device device;
+	SamplerCache samplerCache;
+	samplerCache.create(device);
+	uint32_t objectCount = getFakeObjectCount();
+
+	VkSampler sampler = samplerCache.acquire(samplerInfo);
+	CHECK(samplerCache.acquire(createSamplerInfo()) == sampler);
+	VkSampler otherSampler = samplerCache.acquire(otherMaxLod);
+	CHECK(otherSampler != sampler);
+	CHECK(samplerCache.getSamplerCount() == 2);
+	CHECK(samplerCache.getReferenceCount() == 3);
+	CHECK(samplerCache.getCacheHitCount() == 1);
+
+	samplerCache.release(sampler);
+	CHECK(samplerCache.getSamplerCount() == 2);
+	CHECK(samplerCache.getReferenceCount() == 2);
+	samplerCache.release(sampler);
+	CHECK(samplerCache.getSamplerCount() == 1);
+	CHECK(getFakeObjectCount() == objectCount + 1);
+
+	// released samplers are created again
+	CHECK(samplerCache.acquire(samplerInfo) != VK_NULL_HANDLE);
+	CHECK(samplerCache.getSamplerCount() == 2);
+	CHECK(getFakeObjectCount() == objectCount + 2);
+
+	samplerCache.cleanup();
+	CHECK(samplerCache.getSamplerCount() == 0);
+	CHECK(getFakeObjectCount() == objectCount);
+}
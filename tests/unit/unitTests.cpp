@@ -0,0 +1,37 @@
+#include "unitTests.hpp"
+
+#include <iostream>
+
+
+namespace {
+
+	uint32_t failedCheckCount = 0;
+
+	// Run a test and report whether its checks passed
+	void runTest(const char* name, void (*test)()) {
+		uint32_t failedBefore = failedCheckCount;
+		test();
+		std::cout << (failedCheckCount == failedBefore ? "PASSED " : "FAILED ") << name << std::endl;
+	}
+}
+
+
+void checkCondition(bool passed, const char* condition, const char* file, int line) {
+	if (passed) return;
+	failedCheckCount++;
+	std::cout << file << ":" << line << ": check failed: " << condition << std::endl;
+}
+
+
+int main() {
+	runTest("event queue", testEventQueue);
+	runTest("layout cache", testLayoutCache);
+	runTest("light buffer manager", testLightBufferManager);
+	runTest("mesh optimizer", testMeshOptimizer);
+	runTest("sampler cache", testSamplerCache);
+	runTest("vertex encoder", testVertexEncoder);
+	runTest("worker pool", testWorkerPool);
+
+	std::cout << failedCheckCount << " failed checks" << std::endl;
+	return failedCheckCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Record a failed condition with its location (the test goes on with the next checks)
+#define CHECK(condition) checkCondition((condition), #condition, __FILE__, __LINE__)
+
+void checkCondition(bool passed, const char* condition, const char* file, int line);
+
+
+// Objects created by the fake Vulkan functions (see fakeVulkan.cpp)
+uint32_t getFakeObjectCount();
+
+
+//--------------------------------------------------------
+// TESTS (one function per subject)
+
+void testEventQueue();
+void testLayoutCache();
+void testLightBufferManager();
+void testMeshOptimizer();
+void testSamplerCache();
+void testVertexEncoder();
+void testWorkerPool();
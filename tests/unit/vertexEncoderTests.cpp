@@ -0,0 +1,70 @@
+#include "asset/vertexEncoder.hpp"
+
+#include <cmath>
+
+#include "unitTests.hpp"
+
+
+namespace {
+
+	const uint32_t SPHERE_RINGS = 32;
+	const uint32_t SPHERE_SEGMENTS = 64;
+
+	// Vertices of a sphere away from the origin, with every normal direction and texture coordinates in [0, 1]
+	std::vector<Vertex> createSphere(glm::vec3 center, float radius) {
+		std::vector<Vertex> vertices;
+		for (uint32_t ring = 0; ring <= SPHERE_RINGS; ring++) {
+			float polar = glm::pi<float>() * ring / SPHERE_RINGS;
+			for (uint32_t segment = 0; segment <= SPHERE_SEGMENTS; segment++) {
+				float azimuth = 2.0f * glm::pi<float>() * segment / SPHERE_SEGMENTS;
+				Vertex vertex{};
+				vertex.normal = glm::vec3(std::sin(polar) * std::cos(azimuth), std::sin(polar) * std::sin(azimuth),
+					std::cos(polar));
+				vertex.pos = center + vertex.normal * radius;
+				vertex.texCoord = glm::vec2(static_cast<float>(segment) / SPHERE_SEGMENTS,
+					static_cast<float>(ring) / SPHERE_RINGS);
+				vertices.push_back(vertex);
+			}
+		}
+		return vertices;
+	}
+}
+
+
+void testVertexEncoder() {
+
+	//--------------------------------------------------------
+	// PRECISION COMPARED WITH THE FLOAT LAYOUT
+	std::vector<Vertex> vertices = createSphere(glm::vec3(100.0f, -20.0f, 5.0f), 10.0f);
+	VertexQuantization quantization = computeVertexQuantization(vertices);
+	VertexPackingError error;
+	std::vector<PackedVertex> packed = packVertices(vertices, quantization, error);
+	CHECK(packed.size() == vertices.size());
+
+	// half a 16 bit step on each axis (with some margin for the float rounding), a small fraction of a degree for the
+	// 16 bit octahedral normals and half a half float step below 1 on each texture coordinate
+	float maxPositionError = 0.5f / 65535.0f * glm::length(quantization.scale) * 1.01f;
+	CHECK(error.position <= maxPositionError);
+	CHECK(error.normalAngle <= 0.1f);
+	CHECK(error.texCoord <= std::sqrt(2.0f) / 4096.0f);
+
+	// the reported errors are the largest ones of the decoded vertices
+	float positionError = 0.0f;
+	for (size_t i = 0; i < vertices.size(); i++) {
+		Vertex decoded = decodeVertex(packed[i], quantization);
+		positionError = std::max(positionError, glm::length(decoded.pos - vertices[i].pos));
+		CHECK(glm::dot(decoded.normal, vertices[i].normal) > 0.9999f);
+	}
+	CHECK(positionError == error.position);
+
+	//--------------------------------------------------------
+	// QUANTIZATION RANGE (flat meshes keep a valid scale)
+	std::vector<Vertex> flatVertices = vertices;
+	for (Vertex& vertex : flatVertices) {
+		vertex.pos.z = 5.0f;
+	}
+	VertexQuantization flatQuantization = computeVertexQuantization(flatVertices);
+	CHECK(flatQuantization.scale.z == 1.0f);
+	packVertices(flatVertices, flatQuantization, error);
+	CHECK(error.position <= 0.5f / 65535.0f * glm::length(flatQuantization.scale) * 1.01f);
+}
@@ -0,0 +1,118 @@
+#include "system/WorkerPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "unitTests.hpp"
+
+
+void testWorkerPool() {
+	WorkerPool pool;
+	pool.create(std::max(std::thread::hardware_concurrency(), 4u));
+
+	//--------------------------------------------------------
+	// TINY JOBS SUBMITTED FROM SEVERAL THREADS AT ONCE (with the same counter)
+	const uint32_t SUBMIT_THREAD_COUNT = 4;
+	const uint32_t JOBS_PER_SUBMIT_THREAD = 25000;
+	std::atomic<uint32_t> externalSum{ 0 };
+	JobCounter externalJobs;
+	std::vector<std::thread> submitThreads;
+	for (uint32_t t = 0; t < SUBMIT_THREAD_COUNT; t++) {
+		submitThreads.emplace_back([&]() {
+			for (uint32_t i = 0; i < JOBS_PER_SUBMIT_THREAD; i++) {
+				pool.submit([&externalSum]() { externalSum++; }, &externalJobs);
+			}
+		});
+	}
+	for (auto& thread : submitThreads) {
+		thread.join();
+	}
+	pool.wait(externalJobs);
+	CHECK(externalJobs.isDone());
+	CHECK(externalSum.load() == SUBMIT_THREAD_COUNT * JOBS_PER_SUBMIT_THREAD);
+
+	//--------------------------------------------------------
+	// JOBS THAT WAIT FOR THE JOBS THEY SUBMIT (stolen by the other threads meanwhile)
+	const uint32_t PARENT_COUNT = 64;
+	const uint32_t CHILD_COUNT = 256;
+	std::atomic<uint32_t> childSum{ 0 };
+	std::atomic<uint32_t> parentErrors{ 0 };
+	JobCounter parents;
+	for (uint32_t p = 0; p < PARENT_COUNT; p++) {
+		pool.submit([&]() {
+			std::atomic<uint32_t> children{ 0 };
+			JobCounter childJobs;
+			for (uint32_t c = 0; c < CHILD_COUNT; c++) {
+				pool.submit([&children]() { children++; }, &childJobs);
+			}
+			pool.wait(childJobs);
+			if (children.load() != CHILD_COUNT) parentErrors++;
+			childSum += children.load();
+		}, &parents);
+	}
+	pool.wait(parents);
+	CHECK(parentErrors.load() == 0);
+	CHECK(childSum.load() == PARENT_COUNT * CHILD_COUNT);
+
+	//--------------------------------------------------------
+	// CHAINS OF DEPENDENT JOBS (a stage starts when every job of the previous one is finished)
+	const uint32_t STAGE_COUNT = 100;
+	const uint32_t JOBS_PER_STAGE = 16;
+	std::vector<JobCounter> stages(STAGE_COUNT);
+	std::vector<std::atomic<uint32_t>> finishedJobs(STAGE_COUNT);
+	std::atomic<uint32_t> orderErrors{ 0 };
+	for (uint32_t stage = 0; stage < STAGE_COUNT; stage++) {
+		for (uint32_t i = 0; i < JOBS_PER_STAGE; i++) {
+			WorkerTask job = [&, stage]() {
+				if (stage > 0 && finishedJobs[stage - 1].load() != JOBS_PER_STAGE) orderErrors++;
+				finishedJobs[stage]++;
+			};
+			if (stage == 0) pool.submit(job, &stages[stage]);
+			else pool.submitAfter(stages[stage - 1], job, &stages[stage]);
+		}
+	}
+	for (auto& stage : stages) {
+		pool.wait(stage);
+	}
+	CHECK(orderErrors.load() == 0);
+	CHECK(std::all_of(finishedJobs.begin(), finishedJobs.end(),
+		[](const std::atomic<uint32_t>& count) { return count.load() == JOBS_PER_STAGE; }));
+
+	// a dependency already finished queues the job at once
+	std::atomic<uint32_t> lateJobs{ 0 };
+	JobCounter lateCounter;
+	pool.submitAfter(stages.back(), [&lateJobs]() { lateJobs++; }, &lateCounter);
+	pool.wait(lateCounter);
+	CHECK(lateJobs.load() == 1);
+
+	//--------------------------------------------------------
+	// PARALLEL LOOPS RUN FROM JOBS AT ONCE (each index visited once, with ranges that do not divide the count)
+	const uint32_t LOOP_COUNT = 8;
+	const uint32_t LOOP_SIZE = 100000;
+	std::vector<std::vector<uint32_t>> visits(LOOP_COUNT, std::vector<uint32_t>(LOOP_SIZE, 0));
+	JobCounter loops;
+	for (uint32_t l = 0; l < LOOP_COUNT; l++) {
+		pool.submit([&, l]() {
+			pool.parallelFor(LOOP_SIZE, 7 + l * 100, [&visits, l](uint32_t first, uint32_t last) {
+				for (uint32_t i = first; i < last; i++) {
+					visits[l][i]++;
+				}
+			});
+		}, &loops);
+	}
+	pool.wait(loops);
+	for (const auto& loopVisits : visits) {
+		CHECK(std::all_of(loopVisits.begin(), loopVisits.end(), [](uint32_t count) { return count == 1; }));
+	}
+
+	// empty loops do not call the body
+	bool emptyCalled = false;
+	pool.parallelFor(0, 64, [&emptyCalled](uint32_t first, uint32_t last) { emptyCalled = true; });
+	CHECK(!emptyCalled);
+
+	pool.wait();
+	CHECK(pool.getPendingTaskCount() == 0);
+	pool.cleanup();
+}